@@ -0,0 +1,92 @@
+//WavAsync.cpp
+
+
+#include <cstdio>
+
+#include "WavAsync.hpp"
+
+
+static const char *UNINITIALIZED_MSG = "Attempt to call WavThreadPoolEngine class method before calling initialize().\n";
+
+
+WavThreadPoolEngine::WavThreadPoolEngine() {
+    _stopping = false;
+    _initialized = false;
+}
+
+
+WavThreadPoolEngine::~WavThreadPoolEngine() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _workQueued.notify_all();
+    for (size_t i = 0; i < _threads.size(); i++) {
+        _threads[i].join();
+    }
+}
+
+
+bool WavThreadPoolEngine::initialize(uint32_t numThreads) {
+
+    if (_initialized) {
+        fprintf(stderr, "Error: Thread pool engine already initialized.\n");
+        return false;
+    }
+
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+    if (numThreads == 0) {
+        numThreads = 1;
+    }
+
+    for (uint32_t i = 0; i < numThreads; i++) {
+        _threads.push_back(std::thread(&WavThreadPoolEngine::runWorker, this));
+    }
+    _initialized = true;
+
+    return true;
+}
+
+
+bool WavThreadPoolEngine::submit(void (*work)(void *context),
+                                 void *context) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopping) {
+            return false;
+        }
+        WorkItem item;
+        item.work = work;
+        item.context = context;
+        _queue.push_back(item);
+    }
+    _workQueued.notify_one();
+
+    return true;
+}
+
+
+void WavThreadPoolEngine::runWorker() {
+
+    while (true) {
+        WorkItem item;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workQueued.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+            if (_queue.empty()) {
+                return; //Stopping, and nothing left to run
+            }
+            item = _queue.front();
+            _queue.pop_front();
+        }
+        item.work(item.context);
+    }
+}
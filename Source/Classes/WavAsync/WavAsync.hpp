@@ -0,0 +1,125 @@
+//WavAsync.hpp
+
+#ifndef __WAV_ASYNC_HPP__
+#define __WAV_ASYNC_HPP__
+
+#include <condition_variable>
+#include <cstdint> //For uint8_t, etc.
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+
+//Runs blocking reader and writer calls off the caller's thread, for the async variants
+//(WavReader::readFramesAsync(), WavWriter::writeAsync(), ...). Implement submit() to plug in
+//another engine, e.g. one that hands work to an existing executor.
+class WavAsyncEngine {
+
+public:
+
+    virtual ~WavAsyncEngine() {}
+
+    //Arrange for work(context) to run soon on some other thread; false if it can't be queued
+    virtual bool submit(void (*work)(void *context),
+                        void *context) = 0;
+};
+
+
+//A fixed set of threads taking work from one queue. Each operation blocks one of them while it
+//runs, so numThreads bounds the I/O in flight; any number more can be queued.
+class WavThreadPoolEngine : public WavAsyncEngine {
+
+public:
+
+    WavThreadPoolEngine();
+
+    //Runs whatever is still queued, then joins the threads
+    ~ WavThreadPoolEngine();
+
+    bool initialize(uint32_t numThreads = 0); //0: one per hardware thread
+
+    bool submit(void (*work)(void *context),
+                void *context);
+
+
+private:
+
+    typedef struct {
+        void (*work)(void *context);
+        void *context;
+    } WorkItem;
+
+    void runWorker();
+
+    std::mutex _mutex;
+    std::condition_variable _workQueued;
+    std::deque<WorkItem> _queue;
+    std::vector<std::thread> _threads;
+    bool _stopping;
+    bool _initialized;
+};
+
+
+#if defined(__cpp_impl_coroutine)
+
+//What the async calls return: co_await it for the blocking call's bool result. The call runs on
+//the engine, and the awaiting coroutine resumes on the engine thread that ran it. With no engine
+//(nullptr) the call runs inline and the coroutine doesn't suspend.
+//The library itself is C++11; this part is only seen by C++20 code.
+class WavAsyncOperation {
+
+public:
+
+    WavAsyncOperation(WavAsyncEngine *engine,
+                      std::function<bool()> operation) :
+            _pEngine(engine),
+            _operation(std::move(operation)),
+            _result(false) {
+    }
+
+    bool await_ready() {
+        if (!_pEngine) {
+            _result = _operation();
+            return true;
+        }
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        _handle = handle;
+        if (!_pEngine->submit(&WavAsyncOperation::run, this)) {
+            _result = _operation(); //Couldn't queue; run it here and carry on without suspending
+            return false;
+        }
+        return true; //Nothing may touch *this from here on; run() may already have resumed the coroutine
+    }
+
+    bool await_resume() {
+        return _result;
+    }
+
+
+private:
+
+    static void run(void *context) {
+        WavAsyncOperation *self = (WavAsyncOperation *) context;
+        self->_result = self->_operation();
+        self->_handle.resume();
+    }
+
+    WavAsyncEngine *_pEngine;
+    std::function<bool()> _operation;
+    bool _result;
+    std::coroutine_handle<> _handle;
+};
+
+#endif //__cpp_impl_coroutine
+
+
+#endif //__WAV_ASYNC_HPP__
@@ -0,0 +1,340 @@
+//WavBlockCache.cpp
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring> //memcpy()
+
+#include "WavBlockCache.hpp"
+#include "WavFileIo.hpp"
+#include "WavSampleConverter.hpp"
+
+
+static const char *UNINITIALIZED_MSG = "Attempt to call WavBlockCache class method before calling initialize().\n";
+
+
+//splitmix64's finalizer: every input bit affects every output bit, so both the maps' low bits
+//and the shard choice's high bits are well spread
+static uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+size_t WavBlockCache::BlockKeyHash::operator()(const BlockKey &key) const {
+    return (size_t) mix64(key.pathKey ^ ((uint64_t) key.blockIndex << 8) ^ key.sampleFormat);
+}
+
+
+bool WavBlockCache::BlockKeyEqual::operator()(const BlockKey &a, const BlockKey &b) const {
+    return a.pathKey == b.pathKey && a.blockIndex == b.blockIndex && a.sampleFormat == b.sampleFormat;
+}
+
+
+WavBlockCache::WavBlockCache() {
+    _pShards = nullptr;
+    _numShards = 0;
+    _framesPerBlock = 0;
+    _maxNumBytesPerShard = 0;
+    _initialized = false;
+}
+
+
+WavBlockCache::~WavBlockCache() {
+    if (_pShards) {
+        clear();
+        delete[] _pShards;
+        _pShards = nullptr;
+    }
+}
+
+
+bool WavBlockCache::initialize(uint32_t framesPerBlock,
+                               uint64_t maxNumBytes,
+                               uint32_t numShards) {
+
+    if (_initialized) {
+        fprintf(stderr, "Error: Block cache already initialized.\n");
+        return false;
+    }
+
+    if (framesPerBlock == 0 || numShards == 0) {
+        fprintf(stderr, "Error: Block cache needs at least one frame per block and one shard.\n");
+        return false;
+    }
+
+    _pShards = new Shard[numShards];
+    for (uint32_t i = 0; i < numShards; i++) {
+        _pShards[i].numBytes = 0;
+        _pShards[i].numHits = 0;
+        _pShards[i].numMisses = 0;
+        _pShards[i].numEvictions = 0;
+    }
+    _numShards = numShards;
+    _framesPerBlock = framesPerBlock;
+    _maxNumBytesPerShard = maxNumBytes / numShards;
+    _initialized = true;
+
+    return true;
+}
+
+
+//FNV-1a; no allocation, unlike hashing a std::string
+uint64_t WavBlockCache::pathKey(const char *filePath) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const char *c = filePath; *c; c++) {
+        hash = (hash ^ (uint8_t) *c) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+
+uint64_t WavBlockCache::layoutKey(WavReader *wavReader) {
+    return ((uint64_t) wavReader->getDataOffset() << 32 | wavReader->getSampleDataSize()) ^
+           ((uint64_t) wavReader->getNumChannels() << 60) ^
+           ((uint64_t) wavReader->getSampleFormat() << 52);
+}
+
+
+bool WavBlockCache::blockMatches(const Block *block,
+                                 const FileVersion *version) {
+    return block->layoutKey == version->layoutKey &&
+           block->mtimeNanos == version->mtimeNanos &&
+           block->fileSize == version->fileSize &&
+           block->filePath == version->filePath;
+}
+
+
+WavBlockCache::Shard *WavBlockCache::shardFor(const BlockKey *key) {
+    return &_pShards[(BlockKeyHash()(*key) >> 32) % _numShards];
+}
+
+
+bool WavBlockCache::readFramesToInt16s(WavReader *wavReader,
+                                       uint32_t startFrame,
+                                       uint32_t numFrames,
+                                       int16_t int16Samples[]) {
+
+    return readFrames(wavReader, startFrame, numFrames, WAV_SAMPLE_FORMAT_INT16, (uint8_t *) int16Samples);
+}
+
+
+bool WavBlockCache::readFramesToFloats(WavReader *wavReader,
+                                       uint32_t startFrame,
+                                       uint32_t numFrames,
+                                       float floatSamples[]) {
+
+    return readFrames(wavReader, startFrame, numFrames, WAV_SAMPLE_FORMAT_FLOAT32, (uint8_t *) floatSamples);
+}
+
+
+bool WavBlockCache::readFrames(WavReader *wavReader,
+                               uint32_t startFrame,
+                               uint32_t numFrames,
+                               WavSampleFormat sampleFormat,
+                               uint8_t samples[]) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    const uint32_t numSamples = wavReader->getNumSamples();
+    if (startFrame > numSamples || numFrames > numSamples - startFrame) {
+        fprintf(stderr, "Error: Frames to read are out of range.\n");
+        return false;
+    }
+
+    //Blocks from an older version of the file, or from another path with the same hash, don't match
+    FileVersion version;
+    version.filePath = wavReader->getReadFilePath();
+    version.layoutKey = layoutKey(wavReader);
+    if (!wavStatFile(version.filePath, &version.mtimeNanos, &version.fileSize)) {
+        fprintf(stderr, "File: %s doesn't exist.\n", version.filePath);
+        return false;
+    }
+
+    const uint32_t frameSize = wavReader->getNumChannels() * wavSampleFormatByteDepth(sampleFormat);
+    BlockKey key;
+    key.pathKey = pathKey(version.filePath);
+    key.sampleFormat = sampleFormat;
+
+    uint32_t frameIndex = startFrame;
+    while (numFrames > 0) {
+
+        key.blockIndex = frameIndex / _framesPerBlock;
+        const uint32_t frameInBlock = frameIndex % _framesPerBlock;
+        const uint32_t numBlockFrames = (_framesPerBlock - frameInBlock < numFrames) ?
+                                        _framesPerBlock - frameInBlock : numFrames;
+        Shard *shard = shardFor(&key);
+
+        //Hits are copied out under the shard's lock, so eviction can't free the block mid-copy
+        bool hit = false;
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            auto it = shard->blocks.find(key);
+            if (it != shard->blocks.end() && blockMatches(it->second, &version)) {
+                Block *block = it->second;
+                memcpy(samples, block->pSamples + (size_t) frameInBlock * frameSize, (size_t) numBlockFrames * frameSize);
+                shard->lru.splice(shard->lru.end(), shard->lru, block->lruPosition);
+                shard->numHits++;
+                hit = true;
+            } else {
+                if (it != shard->blocks.end()) {
+                    removeBlock(shard, it->second); //Stale, or another file's
+                }
+                shard->numMisses++;
+            }
+        }
+
+        //Misses are read and decoded without the lock held
+        if (!hit) {
+            Block *block = decodeBlock(wavReader, &key, &version);
+            if (!block) {
+                return false;
+            }
+            memcpy(samples, block->pSamples + (size_t) frameInBlock * frameSize, (size_t) numBlockFrames * frameSize);
+
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            if (shard->blocks.count(key) || block->numBytes > _maxNumBytesPerShard) {
+                //Another thread got there first, or the block alone is over budget
+                free(block->pSamples);
+                delete block;
+            } else {
+                shard->blocks[key] = block;
+                block->lruPosition = shard->lru.insert(shard->lru.end(), block);
+                shard->numBytes += block->numBytes;
+                while (shard->numBytes > _maxNumBytesPerShard) {
+                    removeBlock(shard, shard->lru.front());
+                    shard->numEvictions++;
+                }
+            }
+        }
+
+        samples += (size_t) numBlockFrames * frameSize;
+        frameIndex += numBlockFrames;
+        numFrames -= numBlockFrames;
+    }
+
+    return true;
+}
+
+
+//Read and decode one whole block (shorter at the end of the file) through the reader: int16 as
+//readDataToInt16s() does it, floats as WavReader::blocks<float>() does
+WavBlockCache::Block *WavBlockCache::decodeBlock(WavReader *wavReader,
+                                                 const BlockKey *key,
+                                                 const FileVersion *version) {
+
+    const uint32_t firstFrame = key->blockIndex * _framesPerBlock;
+    const uint32_t numSamples = wavReader->getNumSamples();
+    const uint32_t numFrames = (numSamples - firstFrame < _framesPerBlock) ? numSamples - firstFrame : _framesPerBlock;
+    const uint32_t numValues = numFrames * wavReader->getNumChannels();
+    const uint32_t numSrcBytes = numValues * wavReader->getByteDepth();
+    const WavSampleFormat sampleFormat = (WavSampleFormat) key->sampleFormat;
+    const bool isInt16 = (sampleFormat == WAV_SAMPLE_FORMAT_INT16);
+
+    Block *block = new Block();
+    block->key = *key;
+    block->filePath = version->filePath;
+    block->mtimeNanos = version->mtimeNanos;
+    block->fileSize = version->fileSize;
+    block->layoutKey = version->layoutKey;
+    block->numBytes = numValues * wavSampleFormatByteDepth(sampleFormat);
+    block->pSamples = (uint8_t *) malloc(block->numBytes);
+    uint8_t *srcSamples = isInt16 ? nullptr : (uint8_t *) malloc(numSrcBytes);
+    if (!block->pSamples || (!isInt16 && !srcSamples)) {
+        fprintf(stderr, "Error: Unable to allocate cache block.\n");
+        free(srcSamples);
+        free(block->pSamples);
+        delete block;
+        return nullptr;
+    }
+
+    bool ok = wavReader->seekToFrame(firstFrame);
+    if (ok && isInt16) {
+        ok = wavReader->readDataToInt16s((int16_t *) block->pSamples, numFrames);
+    } else if (ok) {
+        ok = wavReader->readData(srcSamples, numSrcBytes) &&
+             wavConvertSamples(srcSamples, wavReader->getSampleFormat(), block->pSamples, sampleFormat, numValues);
+    }
+    free(srcSamples);
+    if (!ok) {
+        fprintf(stderr, "Error: Problem reading block into cache.\n");
+        free(block->pSamples);
+        delete block;
+        return nullptr;
+    }
+
+    return block;
+}
+
+
+void WavBlockCache::removeBlock(Shard *shard, Block *block) {
+    shard->blocks.erase(block->key);
+    shard->lru.erase(block->lruPosition);
+    shard->numBytes -= block->numBytes;
+    free(block->pSamples);
+    delete block;
+}
+
+
+void WavBlockCache::invalidateFile(const char *filePath) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return;
+    }
+
+    const uint64_t key = pathKey(filePath);
+    for (uint32_t i = 0; i < _numShards; i++) {
+        Shard *shard = &_pShards[i];
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->lru.begin(); it != shard->lru.end();) {
+            Block *block = *it++;
+            if (block->key.pathKey == key && block->filePath == filePath) {
+                removeBlock(shard, block);
+            }
+        }
+    }
+}
+
+
+void WavBlockCache::clear() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return;
+    }
+
+    for (uint32_t i = 0; i < _numShards; i++) {
+        Shard *shard = &_pShards[i];
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        while (!shard->lru.empty()) {
+            removeBlock(shard, shard->lru.front());
+        }
+    }
+}
+
+
+bool WavBlockCache::getStats(WavBlockCacheStats *stats) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (uint32_t i = 0; i < _numShards; i++) {
+        Shard *shard = &_pShards[i];
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats->numHits += shard->numHits;
+        stats->numMisses += shard->numMisses;
+        stats->numEvictions += shard->numEvictions;
+        stats->numBytes += shard->numBytes;
+        stats->numBlocks += (uint32_t) shard->blocks.size();
+    }
+
+    return true;
+}
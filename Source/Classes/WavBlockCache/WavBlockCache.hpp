@@ -0,0 +1,138 @@
+//WavBlockCache.hpp
+
+#ifndef __WAV_BLOCK_CACHE_HPP__
+#define __WAV_BLOCK_CACHE_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "WavReader.hpp"
+
+
+typedef struct {
+    uint64_t numHits; //Blocks found in the cache
+    uint64_t numMisses; //Blocks read and decoded
+    uint64_t numEvictions;
+    uint64_t numBytes; //Decoded samples held
+    uint32_t numBlocks;
+} WavBlockCacheStats;
+
+
+//Decoded sample blocks kept in memory for workloads that reread the same regions (scrubbing,
+//training data loaders). Blocks are framesPerBlock frames, aligned to multiples of framesPerBlock,
+//and held as int16 or float32, whichever a read asks for, decoded exactly as readDataToInt16s()
+//and WavReader::blocks<float>() decode them. Blocks are spread over shards by hash,
+//each with its own lock and LRU list and an equal share of the byte budget, so threads reading
+//different blocks rarely wait on each other. Thread-safe; each reader is still used by one thread.
+class WavBlockCache {
+
+public:
+
+    WavBlockCache();
+
+    ~ WavBlockCache();
+
+    bool initialize(uint32_t framesPerBlock,
+                    uint64_t maxNumBytes,
+                    uint32_t numShards = 16);
+
+    //Frames [startFrame, startFrame + numFrames) of wavReader's file, channels interleaved.
+    //Missing blocks are read through wavReader, which must have had prepareToRead() called;
+    //doing so moves its read position. The file is stat()ed on each call, so blocks of a file
+    //that has since been rewritten (new modification time or size) are read again.
+    bool readFramesToInt16s(WavReader *wavReader,
+                            uint32_t startFrame,
+                            uint32_t numFrames,
+                            int16_t int16Samples[]);
+
+    bool readFramesToFloats(WavReader *wavReader,
+                            uint32_t startFrame,
+                            uint32_t numFrames,
+                            float floatSamples[]);
+
+    //Drop every block of one file (as named when it was read), e.g. to free its memory
+    void invalidateFile(const char *filePath);
+
+    void clear();
+
+    bool getStats(WavBlockCacheStats *stats);
+
+
+private:
+
+    typedef struct {
+        uint64_t pathKey; //Hash of the file path; paths that collide are told apart by Block::filePath
+        uint32_t blockIndex;
+        uint32_t sampleFormat; //WAV_SAMPLE_FORMAT_INT16 or WAV_SAMPLE_FORMAT_FLOAT32
+    } BlockKey;
+
+    //Which version of which file a block was decoded from
+    typedef struct {
+        const char *filePath;
+        int64_t mtimeNanos;
+        uint64_t fileSize;
+        uint64_t layoutKey;
+    } FileVersion;
+
+    struct BlockKeyHash {
+        size_t operator()(const BlockKey &key) const;
+    };
+
+    struct BlockKeyEqual {
+        bool operator()(const BlockKey &a, const BlockKey &b) const;
+    };
+
+    typedef struct Block {
+        BlockKey key;
+        std::string filePath;
+        int64_t mtimeNanos; //The file's, when decoded
+        uint64_t fileSize;
+        uint64_t layoutKey; //Data offset, size and format, when decoded
+        uint8_t *pSamples;
+        uint32_t numBytes;
+        std::list<struct Block *>::iterator lruPosition;
+    } Block;
+
+    typedef struct {
+        std::mutex mutex;
+        std::unordered_map<BlockKey, Block *, BlockKeyHash, BlockKeyEqual> blocks;
+        std::list<Block *> lru; //Least recently used first
+        uint64_t numBytes;
+        uint64_t numHits;
+        uint64_t numMisses;
+        uint64_t numEvictions;
+    } Shard;
+
+    bool readFrames(WavReader *wavReader,
+                    uint32_t startFrame,
+                    uint32_t numFrames,
+                    WavSampleFormat sampleFormat,
+                    uint8_t samples[]);
+
+    Block *decodeBlock(WavReader *wavReader,
+                       const BlockKey *key,
+                       const FileVersion *version);
+
+    static bool blockMatches(const Block *block,
+                             const FileVersion *version);
+
+    Shard *shardFor(const BlockKey *key);
+
+    void removeBlock(Shard *shard, Block *block); //Call with shard->mutex held
+
+    static uint64_t pathKey(const char *filePath);
+
+    static uint64_t layoutKey(WavReader *wavReader);
+
+    Shard *_pShards;
+    uint32_t _numShards;
+    uint32_t _framesPerBlock;
+    uint64_t _maxNumBytesPerShard;
+    bool _initialized;
+};
+
+
+#endif //__WAV_BLOCK_CACHE_HPP__
@@ -0,0 +1,308 @@
+//WavBufferPool.cpp
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#include <malloc.h> //_aligned_malloc()
+#endif
+
+#include "WavBufferPool.hpp"
+
+
+static const char *UNINITIALIZED_MSG = "Attempt to call WavBufferPool class method before calling initialize().\n";
+
+
+//WavBufferBlock
+
+WavBufferBlock::WavBufferBlock() {
+    _pData = nullptr;
+    _capacity = 0;
+    _size = 0;
+    _refCount.store(0, std::memory_order_relaxed);
+    _pPool = nullptr;
+    _pNextFree = nullptr;
+}
+
+
+uint8_t *WavBufferBlock::getData() const {
+    return _pData;
+}
+
+
+uint32_t WavBufferBlock::getCapacity() const {
+    return _capacity;
+}
+
+
+uint32_t WavBufferBlock::getSize() const {
+    return _size;
+}
+
+
+bool WavBufferBlock::setSize(uint32_t size) {
+
+    if (size > _capacity) {
+        fprintf(stderr, "Error: Block size exceeds block capacity.\n");
+        return false;
+    }
+
+    _size = size;
+
+    return true;
+}
+
+
+void WavBufferBlock::retain() {
+    _refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void WavBufferBlock::release() {
+
+    //acq_rel so that every holder's writes to the block happen-before its reuse
+    if (_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        _pPool->giveBack(this);
+    }
+}
+
+
+//WavBufferPool
+
+WavBufferPool::WavBufferPool() {
+    _pMemory = nullptr;
+    _memorySize = 0;
+    _memoryIsMapped = false;
+    _usesHugePages = false;
+    _pBlocks = nullptr;
+    _pFreeList = nullptr;
+    _blockSize = 0;
+    _numBlocks = 0;
+    _numFreeBlocks = 0;
+    _initialized = false;
+}
+
+
+WavBufferPool::~WavBufferPool() {
+    if (_initialized && _numFreeBlocks != _numBlocks) {
+        fprintf(stderr, "Error: WavBufferPool destroyed with %d blocks still in use.\n", _numBlocks - _numFreeBlocks);
+    }
+    freeMemory();
+}
+
+
+void WavBufferPool::freeMemory() {
+
+    delete[] _pBlocks;
+    _pBlocks = nullptr;
+
+    if (_pMemory) {
+#if defined(__unix__) || defined(__APPLE__)
+        if (_memoryIsMapped) {
+            munmap(_pMemory, _memorySize);
+        } else {
+            free(_pMemory);
+        }
+#elif defined(_WIN32)
+        _aligned_free(_pMemory);
+#else
+        free(_pMemory);
+#endif
+        _pMemory = nullptr;
+    }
+
+    _pFreeList = nullptr;
+    _numFreeBlocks = 0;
+    _initialized = false;
+}
+
+
+bool WavBufferPool::initialize(uint32_t blockSize,
+                               uint32_t numBlocks,
+                               bool useHugePages) {
+
+    if (blockSize == 0 || numBlocks == 0) {
+        fprintf(stderr, "Error: Block size and number of blocks must be non-zero.\n");
+        return false;
+    }
+
+    if (_initialized && _numFreeBlocks != _numBlocks) {
+        fprintf(stderr, "Error: Can't re-initialize WavBufferPool while blocks are in use.\n");
+        return false;
+    }
+    freeMemory();
+
+    //Every block starts on a page boundary
+    const uint64_t blockStride = ((uint64_t) blockSize + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    _memorySize = blockStride * numBlocks;
+    _memoryIsMapped = false;
+    _usesHugePages = false;
+
+#if defined(__unix__) || defined(__APPLE__)
+    if (useHugePages) {
+        _memorySize = (_memorySize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#if defined(MAP_HUGETLB)
+        void *p = mmap(nullptr, _memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            _pMemory = (uint8_t *) p;
+            _memoryIsMapped = true;
+            _usesHugePages = true;
+        }
+#endif
+        if (!_pMemory) {
+            //No reserved huge pages; fall back to ordinary pages, with a transparent huge page hint
+            void *q = mmap(nullptr, _memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (q != MAP_FAILED) {
+                _pMemory = (uint8_t *) q;
+                _memoryIsMapped = true;
+#if defined(MADV_HUGEPAGE)
+                _usesHugePages = madvise(q, _memorySize, MADV_HUGEPAGE) == 0;
+#endif
+            }
+        }
+    }
+#endif
+
+    if (!_pMemory) {
+#if defined(_WIN32)
+        _pMemory = (uint8_t *) _aligned_malloc((size_t) _memorySize, BLOCK_ALIGNMENT);
+#else
+        void *p = nullptr;
+        if (posix_memalign(&p, BLOCK_ALIGNMENT, _memorySize) != 0) {
+            p = nullptr;
+        }
+        _pMemory = (uint8_t *) p;
+#endif
+    }
+
+    _pBlocks = new(std::nothrow) WavBufferBlock[numBlocks];
+    if (!_pMemory || !_pBlocks) {
+        fprintf(stderr, "Error: Unable to allocate buffer pool memory.\n");
+        freeMemory();
+        return false;
+    }
+
+    //Thread blocks onto the free list in address order
+    _pFreeList = nullptr;
+    for (uint32_t i = numBlocks; i > 0; i--) {
+        WavBufferBlock *block = &_pBlocks[i - 1];
+        block->_pData = _pMemory + (i - 1) * blockStride;
+        block->_capacity = blockSize;
+        block->_pPool = this;
+        block->_pNextFree = _pFreeList;
+        _pFreeList = block;
+    }
+
+    _blockSize = blockSize;
+    _numBlocks = numBlocks;
+    _numFreeBlocks = numBlocks;
+    _initialized = true;
+
+    return true;
+}
+
+
+WavBufferBlock *WavBufferPool::acquire() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    WavBufferBlock *block = _pFreeList;
+    if (block) {
+        _pFreeList = block->_pNextFree;
+        _numFreeBlocks--;
+        block->_pNextFree = nullptr;
+        block->_size = 0;
+        block->_refCount.store(1, std::memory_order_relaxed);
+    }
+
+    return block;
+}
+
+
+WavBufferBlock *WavBufferPool::acquireWait() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_pFreeList) {
+        _blockReleased.wait(lock);
+    }
+    WavBufferBlock *block = _pFreeList;
+    _pFreeList = block->_pNextFree;
+    _numFreeBlocks--;
+    block->_pNextFree = nullptr;
+    block->_size = 0;
+    block->_refCount.store(1, std::memory_order_relaxed);
+
+    return block;
+}
+
+
+void WavBufferPool::giveBack(WavBufferBlock *block) {
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        block->_pNextFree = _pFreeList;
+        _pFreeList = block;
+        _numFreeBlocks++;
+    }
+    _blockReleased.notify_one();
+}
+
+
+
+//Accessors
+
+uint32_t WavBufferPool::getBlockSize() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _blockSize;
+}
+
+
+uint32_t WavBufferPool::getNumBlocks() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _numBlocks;
+}
+
+
+uint32_t WavBufferPool::getNumFreeBlocks() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numFreeBlocks;
+}
+
+
+bool WavBufferPool::getUsesHugePages() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    return _usesHugePages;
+}
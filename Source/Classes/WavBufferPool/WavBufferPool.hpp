@@ -0,0 +1,110 @@
+//WavBufferPool.hpp
+
+#ifndef __WAV_BUFFER_POOL_HPP__
+#define __WAV_BUFFER_POOL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint> //For uint8_t, etc.
+#include <mutex>
+
+
+class WavBufferPool;
+
+
+//One fixed-capacity block of sample data, handed out by a WavBufferPool.
+//Reference counted: whoever holds the block calls retain() before passing it on (e.g. from
+//a reader thread to a writer thread) and release() when done; the last release() returns it
+//to the pool. The bytes never move, so no one copies them to keep them alive.
+class WavBufferBlock {
+
+public:
+
+    uint8_t *getData() const;
+
+    uint32_t getCapacity() const;
+
+    //Number of valid bytes, as set by whoever filled the block
+    uint32_t getSize() const;
+
+    bool setSize(uint32_t size);
+
+    void retain();
+
+    void release();
+
+
+private:
+
+    friend class WavBufferPool;
+
+    WavBufferBlock();
+
+    uint8_t *_pData;
+    uint32_t _capacity;
+    uint32_t _size;
+    std::atomic<uint32_t> _refCount;
+    WavBufferPool *_pPool;
+    WavBufferBlock *_pNextFree;
+};
+
+
+//Fixed set of equally sized blocks carved out of one allocation, each page-aligned (so also
+//cache-line aligned, and usable for O_DIRECT I/O). Optionally backed by huge pages: explicit
+//MAP_HUGETLB pages if the system has them reserved, else transparent huge pages where supported.
+//After initialize(), acquiring and releasing blocks never touches the allocator.
+class WavBufferPool {
+
+public:
+
+    WavBufferPool();
+
+    ~ WavBufferPool();
+
+    bool initialize(uint32_t blockSize,
+                    uint32_t numBlocks,
+                    bool useHugePages = false);
+
+    //Returns a block with one reference, or nullptr when every block is in use
+    WavBufferBlock *acquire();
+
+    //As acquire(), but waits for a block to be released rather than failing
+    WavBufferBlock *acquireWait();
+
+    uint32_t getBlockSize();
+
+    uint32_t getNumBlocks();
+
+    uint32_t getNumFreeBlocks();
+
+    //True if the blocks were mapped with MAP_HUGETLB or advised as transparent huge pages
+    bool getUsesHugePages();
+
+
+private:
+
+    friend class WavBufferBlock;
+
+    void giveBack(WavBufferBlock *block);
+
+    void freeMemory();
+
+    static const uint32_t BLOCK_ALIGNMENT = 4096;
+    static const uint32_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    std::mutex _mutex;
+    std::condition_variable _blockReleased;
+    uint8_t *_pMemory;
+    uint64_t _memorySize;
+    bool _memoryIsMapped; //mmap() rather than posix_memalign() (_aligned_malloc() on Windows)
+    bool _usesHugePages;
+    WavBufferBlock *_pBlocks;
+    WavBufferBlock *_pFreeList;
+    uint32_t _blockSize;
+    uint32_t _numBlocks;
+    uint32_t _numFreeBlocks;
+    bool _initialized;
+};
+
+
+#endif //__WAV_BUFFER_POOL_HPP__
@@ -0,0 +1,169 @@
+//WavCounters.cpp
+
+
+#include <cstring> //memset()
+
+#include "WavCounters.hpp"
+
+
+std::mutex WavCounters::_registryMutex;
+WavCounters *WavCounters::_pFirstInstance = nullptr;
+WavCounterSnapshot WavCounters::_globalBaseline;
+WavCounters WavCounters::_global;
+
+
+WavCounters::WavCounters() {
+
+    _pPrevInstance = nullptr;
+    _pNextInstance = nullptr;
+
+    if (this == &_global) {
+        return; //Static storage is already zeroed, and instances may have folded into it already
+    }
+
+    _numOpens.store(0, std::memory_order_relaxed);
+    _numReadCalls.store(0, std::memory_order_relaxed);
+    _numWriteCalls.store(0, std::memory_order_relaxed);
+    _numSeeks.store(0, std::memory_order_relaxed);
+    _bytesRead.store(0, std::memory_order_relaxed);
+    _bytesWritten.store(0, std::memory_order_relaxed);
+    _framesConverted.store(0, std::memory_order_relaxed);
+    _ioNanos.store(0, std::memory_order_relaxed);
+    _conversionNanos.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < WAV_LATENCY_HISTOGRAM_NUM_BUCKETS; i++) {
+        _readLatencyHistogram[i].store(0, std::memory_order_relaxed);
+        _writeLatencyHistogram[i].store(0, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    _pNextInstance = _pFirstInstance;
+    if (_pFirstInstance) {
+        _pFirstInstance->_pPrevInstance = this;
+    }
+    _pFirstInstance = this;
+}
+
+
+WavCounters::~WavCounters() {
+
+    if (this == &_global) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    moveTo(&_global);
+    if (_pPrevInstance) {
+        _pPrevInstance->_pNextInstance = _pNextInstance;
+    } else {
+        _pFirstInstance = _pNextInstance;
+    }
+    if (_pNextInstance) {
+        _pNextInstance->_pPrevInstance = _pPrevInstance;
+    }
+}
+
+
+WavCounters *WavCounters::global() {
+    return &_global;
+}
+
+
+uint32_t WavCounters::latencyBucket(uint64_t nanos) {
+
+    uint64_t micros = nanos / 1000;
+    uint32_t bucket = 0;
+    while (micros > 0 && bucket < WAV_LATENCY_HISTOGRAM_NUM_BUCKETS - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+
+void WavCounters::addTo(WavCounterSnapshot *snapshot) const {
+
+    snapshot->numOpens += _numOpens.load(std::memory_order_relaxed);
+    snapshot->numReadCalls += _numReadCalls.load(std::memory_order_relaxed);
+    snapshot->numWriteCalls += _numWriteCalls.load(std::memory_order_relaxed);
+    snapshot->numSeeks += _numSeeks.load(std::memory_order_relaxed);
+    snapshot->bytesRead += _bytesRead.load(std::memory_order_relaxed);
+    snapshot->bytesWritten += _bytesWritten.load(std::memory_order_relaxed);
+    snapshot->framesConverted += _framesConverted.load(std::memory_order_relaxed);
+    snapshot->ioNanos += _ioNanos.load(std::memory_order_relaxed);
+    snapshot->conversionNanos += _conversionNanos.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < WAV_LATENCY_HISTOGRAM_NUM_BUCKETS; i++) {
+        snapshot->readLatencyHistogram[i] += _readLatencyHistogram[i].load(std::memory_order_relaxed);
+        snapshot->writeLatencyHistogram[i] += _writeLatencyHistogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+
+//Exchanging each counter for zero loses nothing added concurrently by the instance's owner
+void WavCounters::moveTo(WavCounters *counters) {
+
+    Counter WavCounters::*const fields[] = {
+            &WavCounters::_numOpens,
+            &WavCounters::_numReadCalls,
+            &WavCounters::_numWriteCalls,
+            &WavCounters::_numSeeks,
+            &WavCounters::_bytesRead,
+            &WavCounters::_bytesWritten,
+            &WavCounters::_framesConverted,
+            &WavCounters::_ioNanos,
+            &WavCounters::_conversionNanos
+    };
+    for (uint32_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        (counters->*fields[i]).fetch_add((this->*fields[i]).exchange(0, std::memory_order_relaxed),
+                                         std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < WAV_LATENCY_HISTOGRAM_NUM_BUCKETS; i++) {
+        counters->_readLatencyHistogram[i].fetch_add(_readLatencyHistogram[i].exchange(0, std::memory_order_relaxed),
+                                                     std::memory_order_relaxed);
+        counters->_writeLatencyHistogram[i].fetch_add(_writeLatencyHistogram[i].exchange(0, std::memory_order_relaxed),
+                                                      std::memory_order_relaxed);
+    }
+}
+
+
+void WavCounters::snapshot(WavCounterSnapshot *snapshot) const {
+
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    if (this != &_global) {
+        addTo(snapshot);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    addTo(snapshot);
+    for (const WavCounters *counters = _pFirstInstance; counters; counters = counters->_pNextInstance) {
+        counters->addTo(snapshot);
+    }
+
+    //Totals only grow, so they never drop below the baseline
+    const uint64_t *baseline = (const uint64_t *) &_globalBaseline;
+    uint64_t *totals = (uint64_t *) snapshot;
+    for (size_t i = 0; i < sizeof(WavCounterSnapshot) / sizeof(uint64_t); i++) {
+        totals[i] -= baseline[i];
+    }
+}
+
+
+void WavCounters::reset() {
+
+    if (this == &_global) {
+        WavCounterSnapshot totals;
+        snapshot(&totals);
+        std::lock_guard<std::mutex> lock(_registryMutex);
+        const uint64_t *newBaseline = (const uint64_t *) &totals;
+        uint64_t *baseline = (uint64_t *) &_globalBaseline;
+        for (size_t i = 0; i < sizeof(WavCounterSnapshot) / sizeof(uint64_t); i++) {
+            baseline[i] += newBaseline[i];
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_registryMutex);
+    moveTo(&_global);
+}
@@ -0,0 +1,160 @@
+//WavCounters.hpp
+
+#ifndef __WAV_COUNTERS_HPP__
+#define __WAV_COUNTERS_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint> //For uint8_t, etc.
+#include <mutex>
+
+
+//I/O and conversion counters kept by every WavReader/WavWriter, and summed process-wide.
+//Updates are relaxed atomic adds to the instance's own counters only, so threads working on
+//different files never share a cache line; the process-wide totals are summed when read.
+//They're safe to leave on in production; build with
+//WAV_ENABLE_COUNTERS=0 (CMake option of the same name) to compile every update out.
+//The class layout doesn't depend on the flag, so code built either way can be mixed.
+#ifndef WAV_ENABLE_COUNTERS
+#define WAV_ENABLE_COUNTERS 1
+#endif
+
+
+//Latency histograms use power-of-two microsecond buckets:
+//  bucket 0: < 1us;  bucket i: [2^(i-1), 2^i) us;  last bucket: everything longer
+const uint32_t WAV_LATENCY_HISTOGRAM_NUM_BUCKETS = 24;
+
+
+typedef struct {
+    uint64_t numOpens;
+    uint64_t numReadCalls;          //fread() calls, i.e. upper bound on read syscalls
+    uint64_t numWriteCalls;         //fwrite() calls
+    uint64_t numSeeks;              //fseek()/rewind() calls, including subchunk searches
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+    uint64_t framesConverted;       //Frames passed through a sample format conversion
+    uint64_t ioNanos;               //Time inside read/write calls
+    uint64_t conversionNanos;       //Time converting between sample formats
+    uint64_t readLatencyHistogram[WAV_LATENCY_HISTOGRAM_NUM_BUCKETS];
+    uint64_t writeLatencyHistogram[WAV_LATENCY_HISTOGRAM_NUM_BUCKETS];
+} WavCounterSnapshot;
+
+
+//Instances can't be copied or moved (their counters are atomics, and each is registered for
+//global() by address), which makes WavReader and WavWriter, which hold one, non-copyable too.
+class WavCounters {
+
+public:
+
+    WavCounters();
+
+    //Folds this instance's counts into the process-wide totals
+    ~ WavCounters();
+
+    WavCounters(const WavCounters &) = delete;
+
+    WavCounters &operator=(const WavCounters &) = delete;
+
+    //Process-wide totals: its snapshot() sums every live instance and every destroyed one, and
+    //its reset() starts the totals over from zero
+    static WavCounters *global();
+
+    //Monotonic clock for timing the work being counted; 0 when counters are compiled out
+    static inline uint64_t now() {
+#if WAV_ENABLE_COUNTERS
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        return 0;
+#endif
+    }
+
+    inline void addOpen() {
+#if WAV_ENABLE_COUNTERS
+        add(&WavCounters::_numOpens, 1);
+#endif
+    }
+
+    inline void addSeek() {
+#if WAV_ENABLE_COUNTERS
+        add(&WavCounters::_numSeeks, 1);
+#endif
+    }
+
+    inline void addRead(uint64_t numBytes, uint64_t startNanos) {
+#if WAV_ENABLE_COUNTERS
+        addIo(&WavCounters::_numReadCalls, &WavCounters::_bytesRead, &WavCounters::_readLatencyHistogram,
+              numBytes, now() - startNanos);
+#endif
+    }
+
+    inline void addWrite(uint64_t numBytes, uint64_t startNanos) {
+#if WAV_ENABLE_COUNTERS
+        addIo(&WavCounters::_numWriteCalls, &WavCounters::_bytesWritten, &WavCounters::_writeLatencyHistogram,
+              numBytes, now() - startNanos);
+#endif
+    }
+
+    inline void addConversion(uint64_t numFrames, uint64_t startNanos) {
+#if WAV_ENABLE_COUNTERS
+        add(&WavCounters::_framesConverted, numFrames);
+        add(&WavCounters::_conversionNanos, now() - startNanos);
+#endif
+    }
+
+    //Not a consistent cut across fields while other threads are updating; each field is exact
+    void snapshot(WavCounterSnapshot *snapshot) const;
+
+    //Instance only; the process-wide totals keep what this instance already counted
+    void reset();
+
+
+private:
+
+    typedef std::atomic<uint64_t> Counter;
+    typedef Counter Histogram[WAV_LATENCY_HISTOGRAM_NUM_BUCKETS];
+
+    static uint32_t latencyBucket(uint64_t nanos);
+
+    inline void add(Counter WavCounters::*counter, uint64_t value) {
+        (this->*counter).fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline void addIo(Counter WavCounters::*numCalls, Counter WavCounters::*numBytes,
+                      Histogram WavCounters::*histogram, uint64_t bytes, uint64_t nanos) {
+        add(numCalls, 1);
+        add(numBytes, bytes);
+        add(&WavCounters::_ioNanos, nanos);
+        (this->*histogram)[latencyBucket(nanos)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addTo(WavCounterSnapshot *snapshot) const;
+
+    void moveTo(WavCounters *counters); //Add this instance's counts to counters, and zero them
+
+    //Every instance but _global is on this list, guarded by _registryMutex. _global's own counters
+    //hold what instances counted before being reset or destroyed; the process-wide totals are
+    //those plus the live instances', less _globalBaseline (the totals at the last global reset).
+    static std::mutex _registryMutex;
+    static WavCounters *_pFirstInstance;
+    static WavCounterSnapshot _globalBaseline;
+    static WavCounters _global;
+
+    WavCounters *_pPrevInstance;
+    WavCounters *_pNextInstance;
+
+    Counter _numOpens;
+    Counter _numReadCalls;
+    Counter _numWriteCalls;
+    Counter _numSeeks;
+    Counter _bytesRead;
+    Counter _bytesWritten;
+    Counter _framesConverted;
+    Counter _ioNanos;
+    Counter _conversionNanos;
+    Histogram _readLatencyHistogram;
+    Histogram _writeLatencyHistogram;
+};
+
+
+#endif //__WAV_COUNTERS_HPP__
@@ -0,0 +1,132 @@
+//WavFileCopy.cpp
+
+
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <unistd.h> //copy_file_range(), lseek()
+#include <sys/sendfile.h>
+#endif
+
+#include "WavFileCopy.hpp"
+#include "WavFileIo.hpp"
+
+
+static const uint32_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+
+//Positional on both sides, so offsets past 2 GB work where fseek()'s long wouldn't reach them
+static bool copyFileRangeBuffered(FILE *srcFile,
+                                  uint64_t srcOffset,
+                                  FILE *destFile,
+                                  uint64_t destOffset,
+                                  uint64_t numBytes) {
+
+    uint8_t *buffer = (uint8_t *) malloc(COPY_BUFFER_SIZE);
+    if (!buffer) {
+        fprintf(stderr, "Error: Unable to allocate copy buffer.\n");
+        return false;
+    }
+
+    bool ok = true;
+    while (numBytes > 0) {
+        uint32_t numToCopy = (numBytes < COPY_BUFFER_SIZE) ? (uint32_t) numBytes : COPY_BUFFER_SIZE;
+        if (!wavReadAt(srcFile, srcOffset, buffer, numToCopy) ||
+            !wavWriteAt(destFile, destOffset, buffer, numToCopy)) {
+            fprintf(stderr, "Error: Problem copying file range.\n");
+            ok = false;
+            break;
+        }
+        srcOffset += numToCopy;
+        destOffset += numToCopy;
+        numBytes -= numToCopy;
+    }
+
+    free(buffer);
+
+    return ok;
+}
+
+
+//Leave destFile's position just past the copied range, whichever way it was copied
+static bool seekPastCopiedRange(FILE *destFile, uint64_t destEndOffset) {
+
+    if (!wavSeekFile(destFile, destEndOffset)) {
+        fprintf(stderr, "Error: Problem seeking past copied range.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool wavCopyFileRangeBuffered(FILE *srcFile,
+                              uint64_t srcOffset,
+                              FILE *destFile,
+                              uint64_t destOffset,
+                              uint64_t numBytes) {
+
+    if (fflush(destFile) != 0) {
+        fprintf(stderr, "Error: Problem flushing destination, while copying file range.\n");
+        return false;
+    }
+
+    return copyFileRangeBuffered(srcFile, srcOffset, destFile, destOffset, numBytes) &&
+           seekPastCopiedRange(destFile, destOffset + numBytes);
+}
+
+
+bool wavCopyFileRange(FILE *srcFile,
+                      uint64_t srcOffset,
+                      FILE *destFile,
+                      uint64_t destOffset,
+                      uint64_t numBytes) {
+
+    if (fflush(destFile) != 0) {
+        fprintf(stderr, "Error: Problem flushing destination, while copying file range.\n");
+        return false;
+    }
+
+#if defined(__linux__)
+    const int srcFd = fileno(srcFile);
+    const int destFd = fileno(destFile);
+    off_t srcPos = (off_t) srcOffset;
+    off_t destPos = (off_t) destOffset;
+    uint64_t numRemaining = numBytes;
+
+#if !defined(__ANDROID__)
+    //Kernel-side copy; the filesystem may share extents instead of copying
+    while (numRemaining > 0) {
+        ssize_t numCopied = copy_file_range(srcFd, &srcPos, destFd, &destPos, (size_t) numRemaining, 0);
+        if (numCopied <= 0) {
+            break; //Unsupported here (EXDEV, ENOSYS, EINVAL...) or EOF; fall through with what's left
+        }
+        numRemaining -= (uint64_t) numCopied;
+    }
+#endif
+
+    //sendfile() writes at the destination's file offset
+    if (numRemaining > 0 && lseek(destFd, destPos, SEEK_SET) == destPos) {
+        while (numRemaining > 0) {
+            ssize_t numCopied = sendfile(destFd, srcFd, &srcPos, (size_t) numRemaining);
+            if (numCopied <= 0) {
+                break;
+            }
+            destPos += numCopied;
+            numRemaining -= (uint64_t) numCopied;
+        }
+    }
+
+    if (numRemaining > 0 &&
+        !copyFileRangeBuffered(srcFile, (uint64_t) srcPos, destFile, (uint64_t) destPos, numRemaining)) {
+        return false;
+    }
+#else
+    if (!copyFileRangeBuffered(srcFile, srcOffset, destFile, destOffset, numBytes)) {
+        return false;
+    }
+#endif
+
+    //Resynchronize the FILE with the descriptor's new position
+    return seekPastCopiedRange(destFile, destOffset + numBytes);
+}
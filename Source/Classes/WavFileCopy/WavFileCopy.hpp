@@ -0,0 +1,30 @@
+//WavFileCopy.hpp
+
+#ifndef __WAV_FILE_COPY_HPP__
+#define __WAV_FILE_COPY_HPP__
+
+#include <cstdio> //For FILE
+#include <cstdint> //For uint8_t, etc.
+
+
+//Copy numBytes from srcFile at srcOffset to destFile at destOffset without passing the
+//bytes through user space where the platform allows it: copy_file_range() (which also
+//shares extents on filesystems that support reflinks), then sendfile(), then a buffered
+//pread/fwrite loop. Neither FILE's position is relied on; destFile is left positioned just
+//past the copied range. Any buffered output on destFile is flushed first.
+bool wavCopyFileRange(FILE *srcFile,
+                      uint64_t srcOffset,
+                      FILE *destFile,
+                      uint64_t destOffset,
+                      uint64_t numBytes);
+
+//The portable path wavCopyFileRange() falls back to: positional reads and writes through a
+//user-space buffer. Same contract as wavCopyFileRange().
+bool wavCopyFileRangeBuffered(FILE *srcFile,
+                              uint64_t srcOffset,
+                              FILE *destFile,
+                              uint64_t destOffset,
+                              uint64_t numBytes);
+
+
+#endif //__WAV_FILE_COPY_HPP__
@@ -0,0 +1,280 @@
+//WavFileIo.cpp
+
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE //fallocate()
+#endif
+
+#include <fcntl.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h> //ftruncate()
+#endif
+#include <sys/stat.h>
+
+#include "WavFileIo.hpp"
+
+
+bool wavPreallocateFile(FILE *file,
+                        uint64_t offset,
+                        uint64_t numBytes) {
+
+    if (!file || numBytes == 0) {
+        return false;
+    }
+
+#if defined(__linux__)
+    return fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, (off_t) offset, (off_t) numBytes) == 0;
+#elif defined(__APPLE__)
+    //Relative to the current end of file; try for one contiguous extent first
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0 || (uint64_t) st.st_size > offset + numBytes) {
+        return false;
+    }
+    fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t) (offset + numBytes - st.st_size), 0};
+    if (fcntl(fileno(file), F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        return fcntl(fileno(file), F_PREALLOCATE, &store) != -1;
+    }
+    return true;
+#else
+    (void) offset;
+    return false;
+#endif
+}
+
+
+bool wavTruncateFile(FILE *file,
+                     uint64_t size) {
+
+    if (!file) {
+        return false;
+    }
+
+    if (fflush(file) != 0) {
+        fprintf(stderr, "Error: Problem flushing file before truncating.\n");
+        return false;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    if (ftruncate(fileno(file), (off_t) size) != 0) {
+        perror("Error: Problem truncating file");
+        return false;
+    }
+    return true;
+#else
+    (void) size;
+    return false;
+#endif
+}
+
+
+bool wavWriteAt(FILE *file,
+                uint64_t offset,
+                const void *data,
+                uint32_t numBytes) {
+
+    if (!file) {
+        return false;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    const uint8_t *bytes = (const uint8_t *) data;
+    while (numBytes > 0) {
+        ssize_t n = pwrite(fileno(file), bytes, numBytes, (off_t) offset);
+        if (n <= 0) {
+            perror("Error: Problem writing at file offset");
+            return false;
+        }
+        bytes += n;
+        offset += (uint64_t) n;
+        numBytes -= (uint32_t) n;
+    }
+    return true;
+#else
+    //No positional writes; seek, write and restore the position instead
+    uint64_t position = 0;
+    if (!wavTellFile(file, &position)) {
+        return false;
+    }
+    bool ok = fflush(file) == 0 &&
+              wavSeekFile(file, offset) &&
+              fwrite(data, 1, numBytes, file) == numBytes;
+    return wavSeekFile(file, position) && ok;
+#endif
+}
+
+
+bool wavReadAt(FILE *file,
+               uint64_t offset,
+               void *data,
+               uint32_t numBytes) {
+
+    if (!file) {
+        return false;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    uint8_t *bytes = (uint8_t *) data;
+    while (numBytes > 0) {
+        ssize_t n = pread(fileno(file), bytes, numBytes, (off_t) offset);
+        if (n <= 0) {
+            if (n < 0) {
+                perror("Error: Problem reading at file offset");
+            }
+            return false;
+        }
+        bytes += n;
+        offset += (uint64_t) n;
+        numBytes -= (uint32_t) n;
+    }
+    return true;
+#else
+    //No positional reads; seek, read and restore the position instead
+    uint64_t position = 0;
+    if (!wavTellFile(file, &position)) {
+        return false;
+    }
+    bool ok = wavSeekFile(file, offset) &&
+              fread(data, 1, numBytes, file) == numBytes;
+    return wavSeekFile(file, position) && ok;
+#endif
+}
+
+
+bool wavSeekFile(FILE *file,
+                 uint64_t offset) {
+
+    if (!file) {
+        return false;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    return fseeko(file, (off_t) offset, SEEK_SET) == 0;
+#elif defined(_WIN32)
+    return _fseeki64(file, (__int64) offset, SEEK_SET) == 0;
+#else
+    return offset <= 0x7FFFFFFF && fseek(file, (long) offset, SEEK_SET) == 0;
+#endif
+}
+
+
+bool wavTellFile(FILE *file,
+                 uint64_t *offset) {
+
+    if (!file || !offset) {
+        return false;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    const int64_t position = (int64_t) ftello(file);
+#elif defined(_WIN32)
+    const int64_t position = (int64_t) _ftelli64(file);
+#else
+    const int64_t position = (int64_t) ftell(file);
+#endif
+    if (position < 0) {
+        return false;
+    }
+    *offset = (uint64_t) position;
+
+    return true;
+}
+
+
+bool wavGetFileSize(FILE *file,
+                    uint64_t *size) {
+
+    if (!file || !size) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (_fstat64(_fileno(file), &st) != 0) {
+        return false;
+    }
+#else
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) {
+        return false;
+    }
+#endif
+    *size = (uint64_t) st.st_size;
+
+    return true;
+}
+
+
+bool wavStatFile(const char *filePath,
+                 int64_t *mtimeNanos,
+                 uint64_t *fileSize) {
+
+    if (!filePath || !mtimeNanos || !fileSize) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (_stat64(filePath, &st) != 0) {
+        return false;
+    }
+    *mtimeNanos = (int64_t) st.st_mtime * 1000000000;
+#else
+    struct stat st;
+    if (stat(filePath, &st) != 0) {
+        return false;
+    }
+#if defined(__APPLE__)
+    *mtimeNanos = (int64_t) st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(__unix__)
+    *mtimeNanos = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    *mtimeNanos = (int64_t) st.st_mtime * 1000000000;
+#endif
+#endif
+    *fileSize = (uint64_t) st.st_size;
+
+    return true;
+}
+
+
+bool wavSyncFileData(FILE *file) {
+
+    if (!file) {
+        return false;
+    }
+
+    if (fflush(file) != 0) {
+        fprintf(stderr, "Error: Problem flushing file before syncing.\n");
+        return false;
+    }
+
+#if defined(__linux__)
+    return fdatasync(fileno(file)) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    return fsync(fileno(file)) == 0;
+#else
+    return true;
+#endif
+}
+
+
+bool wavAdviseWillNeed(FILE *file,
+                       uint64_t offset,
+                       uint64_t numBytes) {
+
+    if (!file || numBytes == 0) {
+        return false;
+    }
+
+#if defined(__linux__)
+    return posix_fadvise(fileno(file), (off_t) offset, (off_t) numBytes, POSIX_FADV_WILLNEED) == 0;
+#elif defined(__APPLE__)
+    struct radvisory advice;
+    advice.ra_offset = (off_t) offset;
+    advice.ra_count = (numBytes < 0x7FFFFFFF) ? (int) numBytes : 0x7FFFFFFF;
+    return fcntl(fileno(file), F_RDADVISE, &advice) != -1;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,69 @@
+//WavFileIo.hpp
+
+#ifndef __WAV_FILE_IO_HPP__
+#define __WAV_FILE_IO_HPP__
+
+#include <cstdio> //For FILE
+#include <cstdint> //For uint8_t, etc.
+
+
+//Reserve disk space for [offset, offset + numBytes) without changing the file's size, so a
+//file later written sequentially into that range is laid out contiguously. Uses fallocate()
+//with FALLOC_FL_KEEP_SIZE on Linux and F_PREALLOCATE on macOS. Returns false where neither is
+//available or the filesystem refuses; the file is unchanged and still usable in that case.
+bool wavPreallocateFile(FILE *file,
+                        uint64_t offset,
+                        uint64_t numBytes);
+
+//Flush any buffered output, then set the file's size. Also releases space reserved past the
+//new end of file by wavPreallocateFile(), even if the size doesn't change.
+bool wavTruncateFile(FILE *file,
+                     uint64_t size);
+
+//Write numBytes at offset with pwrite(). Neither the FILE's position nor its buffer is touched,
+//so call fflush() first if buffered output could overlap the range.
+bool wavWriteAt(FILE *file,
+                uint64_t offset,
+                const void *data,
+                uint32_t numBytes);
+
+//Read numBytes at offset with pread(); as wavWriteAt(), the FILE's position and buffer are left
+//alone, so one FILE can serve positional reads from several threads alongside its sequential ones
+bool wavReadAt(FILE *file,
+               uint64_t offset,
+               void *data,
+               uint32_t numBytes);
+
+//fseek() to an absolute offset, without fseek()'s long (32 bits on some platforms) limiting
+//the offset to 2 GB: fseeko() on POSIX, _fseeki64() on Windows
+bool wavSeekFile(FILE *file,
+                 uint64_t offset);
+
+//ftell() to match wavSeekFile(): ftello() on POSIX, _ftelli64() on Windows
+bool wavTellFile(FILE *file,
+                 uint64_t *offset);
+
+//The file's size from fstat(), as a 64-bit value; unlike ftell() after fseek(SEEK_END), correct
+//past 2 GB where long is 32 bits. Output still buffered in the FILE isn't counted.
+bool wavGetFileSize(FILE *file,
+                    uint64_t *size);
+
+//The modification time (nanoseconds since the epoch, to whatever precision the platform keeps)
+//and size of the file at filePath, for caches to tell whether it changed since they read it
+bool wavStatFile(const char *filePath,
+                 int64_t *mtimeNanos,
+                 uint64_t *fileSize);
+
+//Flush buffered output and wait until the file's data is on stable storage (fdatasync(),
+//or fsync() where that's unavailable)
+bool wavSyncFileData(FILE *file);
+
+//Hint that [offset, offset + numBytes) will be read soon, so the kernel starts reading it in
+//the background: posix_fadvise(POSIX_FADV_WILLNEED) on Linux, F_RDADVISE on macOS.
+//Purely advisory; returns false if the hint couldn't be given.
+bool wavAdviseWillNeed(FILE *file,
+                       uint64_t offset,
+                       uint64_t numBytes);
+
+
+#endif //__WAV_FILE_IO_HPP__
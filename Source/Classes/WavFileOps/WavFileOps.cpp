@@ -0,0 +1,425 @@
+//WavFileOps.cpp
+
+
+#include <cstdio>
+#include <cstring> //strcmp()
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+#include "WavFileOps.hpp"
+
+
+static const uint64_t MAX_UINT32 = 4294967295;
+
+
+//JSON string, escaping what JSON requires
+static void writeJsonString(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        const unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+
+//By path, or (where inode numbers mean something) by identity, so "dir/./a.wav" and hard links match
+static bool isSameFile(const char *filePathA, const char *filePathB) {
+    if (!strcmp(filePathA, filePathB)) {
+        return true;
+    }
+#if defined(_WIN32)
+    return false;
+#else
+    struct stat stA;
+    struct stat stB;
+    return stat(filePathA, &stA) == 0 && stat(filePathB, &stB) == 0 &&
+           stA.st_dev == stB.st_dev && stA.st_ino == stB.st_ino;
+#endif
+}
+
+
+bool WavFileOps::formatsMatch(WavReader *a, WavReader *b) {
+    return a->getSampleRate() == b->getSampleRate() &&
+           a->getNumChannels() == b->getNumChannels() &&
+           a->getSampleFormat() == b->getSampleFormat() &&
+           a->getAudioFormat() == b->getAudioFormat() &&
+           a->getIsBigEndian() == b->getIsBigEndian();
+}
+
+
+bool WavFileOps::concatenate(const char *const inFilePaths[],
+                             uint32_t numInFiles,
+                             const char *outFilePath) {
+
+    if (!inFilePaths || numInFiles == 0) {
+        fprintf(stderr, "Error: No input files to concatenate.\n");
+        return false;
+    }
+
+    //Verify every input up front, before creating the output; an output that is one of the
+    //inputs would be truncated before it's read
+    for (uint32_t i = 0; i < numInFiles; i++) {
+        if (isSameFile(inFilePaths[i], outFilePath)) {
+            fprintf(stderr, "Error: Output file is also an input file: %s\n", outFilePath);
+            return false;
+        }
+    }
+    WavReader first;
+    if (!first.initialize(inFilePaths[0])) {
+        fprintf(stderr, "Error: Unable to read input file: %s\n", inFilePaths[0]);
+        return false;
+    }
+    if (first.getAudioFormat() == AUDIO_FORMAT_IMA_ADPCM) {
+        fprintf(stderr, "Error: IMA ADPCM files can't be concatenated without decoding: %s\n", inFilePaths[0]);
+        return false;
+    }
+    uint64_t totalSampleDataSize = first.getSampleDataSize();
+    for (uint32_t i = 1; i < numInFiles; i++) {
+        WavReader wr;
+        if (!wr.initialize(inFilePaths[i])) {
+            fprintf(stderr, "Error: Unable to read input file: %s\n", inFilePaths[i]);
+            return false;
+        }
+        if (!formatsMatch(&first, &wr)) {
+            fprintf(stderr, "Error: Input file format doesn't match the first input: %s\n", inFilePaths[i]);
+            return false;
+        }
+        totalSampleDataSize += wr.getSampleDataSize();
+    }
+    if (totalSampleDataSize > MAX_UINT32) {
+        fprintf(stderr, "Error: Concatenated sample data would exceed the 4GB wav limit.\n");
+        return false;
+    }
+
+    WavWriter ww;
+    if (!ww.initialize(outFilePath,
+                       first.getSampleRate(),
+                       first.getNumChannels(),
+                       first.getSampleFormat()) ||
+        !ww.setBigEndian(first.getIsBigEndian())) { //The copied bytes keep their byte order
+        fprintf(stderr, "Error: Unable to initialize output file: %s\n", outFilePath);
+        return false;
+    }
+
+    const uint32_t frameSize = first.getNumChannels() * first.getByteDepth();
+    if (!ww.startWriting((uint32_t) (totalSampleDataSize / frameSize))) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numInFiles; i++) {
+        WavReader wr;
+        if (!wr.initialize(inFilePaths[i]) ||
+            !ww.writeDataFromFile(inFilePaths[i], wr.getDataOffset(), wr.getSampleDataSize())) {
+            fprintf(stderr, "Error: Problem copying sample data from: %s\n", inFilePaths[i]);
+            ww.finishWriting();
+            return false;
+        }
+    }
+
+    return ww.finishWriting();
+}
+
+
+//wavReader must be initialized on the source; only its (read-only) accessors are used,
+//so one reader can serve several threads
+bool WavFileOps::extractRegion(WavReader *wavReader, const WavExtractRegion *region) {
+
+    if (wavReader->getAudioFormat() == AUDIO_FORMAT_IMA_ADPCM) {
+        fprintf(stderr, "Error: Regions of IMA ADPCM files can't be copied without decoding: %s\n", region->outFilePath);
+        return false;
+    }
+
+    //WavWriter truncates its file, so writing over the source would lose the frames to copy
+    if (isSameFile(wavReader->getReadFilePath(), region->outFilePath)) {
+        fprintf(stderr, "Error: Output file is also the input file: %s\n", region->outFilePath);
+        return false;
+    }
+
+    const uint32_t numSamples = wavReader->getNumSamples();
+    if (region->startFrame > numSamples || region->numFrames > numSamples - region->startFrame) {
+        fprintf(stderr, "Error: Extract region is out of range for: %s\n", region->outFilePath);
+        return false;
+    }
+
+    WavWriter ww;
+    if (!ww.initialize(region->outFilePath,
+                       wavReader->getSampleRate(),
+                       wavReader->getNumChannels(),
+                       wavReader->getSampleFormat()) ||
+        !ww.setBigEndian(wavReader->getIsBigEndian())) {
+        fprintf(stderr, "Error: Unable to initialize output file: %s\n", region->outFilePath);
+        return false;
+    }
+
+    if (!ww.startWriting(region->numFrames)) {
+        return false;
+    }
+
+    const uint32_t frameSize = wavReader->getNumChannels() * wavReader->getByteDepth();
+    if (!ww.writeDataFromFile(wavReader->getReadFilePath(),
+                              wavReader->getDataOffset() + (uint64_t) region->startFrame * frameSize,
+                              region->numFrames * frameSize)) {
+        fprintf(stderr, "Error: Problem copying sample data to: %s\n", region->outFilePath);
+        ww.finishWriting();
+        return false;
+    }
+
+    return ww.finishWriting();
+}
+
+
+bool WavFileOps::extract(const char *inFilePath,
+                         const char *outFilePath,
+                         uint32_t startFrame,
+                         uint32_t numFrames) {
+
+    WavReader wr;
+    if (!wr.initialize(inFilePath)) {
+        fprintf(stderr, "Error: Unable to read input file: %s\n", inFilePath);
+        return false;
+    }
+
+    WavExtractRegion region;
+    region.outFilePath = outFilePath;
+    region.startFrame = startFrame;
+    region.numFrames = numFrames;
+
+    return extractRegion(&wr, &region);
+}
+
+
+bool WavFileOps::extractBatch(const char *inFilePath,
+                              const WavExtractRegion regions[],
+                              uint32_t numRegions,
+                              uint32_t numThreads) {
+
+    //Parse the source header once, for every region
+    WavReader wr;
+    if (!wr.initialize(inFilePath)) {
+        fprintf(stderr, "Error: Unable to read input file: %s\n", inFilePath);
+        return false;
+    }
+
+    return extractRegions(&wr, regions, numRegions, numThreads);
+}
+
+
+bool WavFileOps::extractRegions(WavReader *wavReader,
+                                const WavExtractRegion regions[],
+                                uint32_t numRegions,
+                                uint32_t numThreads) {
+
+    //Check every output before writing any, so a batch that names the source writes nothing
+    for (uint32_t i = 0; i < numRegions; i++) {
+        if (isSameFile(wavReader->getReadFilePath(), regions[i].outFilePath)) {
+            fprintf(stderr, "Error: Output file is also the input file: %s\n", regions[i].outFilePath);
+            return false;
+        }
+    }
+
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+    if (numThreads == 0 || numThreads > numRegions) {
+        numThreads = (numRegions > 0) ? numRegions : 1;
+    }
+
+    std::atomic<uint32_t> nextRegion(0);
+    std::atomic<uint32_t> numFailed(0);
+    auto worker = [&]() {
+        for (uint32_t i = nextRegion++; i < numRegions; i = nextRegion++) {
+            if (!extractRegion(wavReader, &regions[i])) {
+                numFailed++;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < numThreads; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    return numFailed == 0;
+}
+
+
+bool WavFileOps::splitAtCuePoints(const char *inFilePath,
+                                  const char *outFilePrefix,
+                                  const char *manifestFilePath,
+                                  uint32_t numThreads) {
+
+    WavReader wr;
+    if (!wr.initialize(inFilePath)) {
+        fprintf(stderr, "Error: Unable to read input file: %s\n", inFilePath);
+        return false;
+    }
+
+    std::vector<WavCuePoint> cuePoints(wr.getNumCuePoints());
+    uint32_t numCuePoints = 0;
+    if (cuePoints.empty() || !wr.getCuePoints(cuePoints.data(), (uint32_t) cuePoints.size(), &numCuePoints) ||
+        numCuePoints == 0) {
+        fprintf(stderr, "Error: No cue points to split at in: %s\n", inFilePath);
+        return false;
+    }
+
+    //Cue points needn't be stored in order; ones at or past the end start no segment
+    const uint32_t numSamples = wr.getNumSamples();
+    std::stable_sort(cuePoints.begin(), cuePoints.begin() + numCuePoints,
+                     [](const WavCuePoint &a, const WavCuePoint &b) { return a.frameIndex < b.frameIndex; });
+
+    std::vector<WavFrameRange> ranges;
+    std::vector<const char *> labels;
+    if (cuePoints[0].frameIndex > 0) {
+        ranges.push_back({0, (cuePoints[0].frameIndex < numSamples) ? cuePoints[0].frameIndex : numSamples});
+        labels.push_back("");
+    }
+    for (uint32_t i = 0; i < numCuePoints && cuePoints[i].frameIndex < numSamples; i++) {
+        if (i + 1 < numCuePoints && cuePoints[i + 1].frameIndex == cuePoints[i].frameIndex) {
+            continue; //Several cue points at one frame: the last one's segment
+        }
+        const uint32_t endFrame = (i + 1 < numCuePoints && cuePoints[i + 1].frameIndex < numSamples) ?
+                                  cuePoints[i + 1].frameIndex : numSamples;
+        ranges.push_back({cuePoints[i].frameIndex, endFrame - cuePoints[i].frameIndex});
+        labels.push_back(cuePoints[i].label);
+    }
+
+    return split(&wr, ranges.data(), labels.data(), (uint32_t) ranges.size(),
+                 outFilePrefix, manifestFilePath, numThreads);
+}
+
+
+bool WavFileOps::splitFrameRanges(const char *inFilePath,
+                                  const WavFrameRange ranges[],
+                                  uint32_t numRanges,
+                                  const char *outFilePrefix,
+                                  const char *manifestFilePath,
+                                  uint32_t numThreads) {
+
+    WavReader wr;
+    if (!wr.initialize(inFilePath)) {
+        fprintf(stderr, "Error: Unable to read input file: %s\n", inFilePath);
+        return false;
+    }
+
+    return split(&wr, ranges, nullptr, numRanges, outFilePrefix, manifestFilePath, numThreads);
+}
+
+
+bool WavFileOps::splitFixedDuration(const char *inFilePath,
+                                    uint32_t framesPerSegment,
+                                    const char *outFilePrefix,
+                                    const char *manifestFilePath,
+                                    uint32_t numThreads) {
+
+    if (framesPerSegment == 0) {
+        fprintf(stderr, "Error: Segments must be at least one frame long.\n");
+        return false;
+    }
+
+    WavReader wr;
+    if (!wr.initialize(inFilePath)) {
+        fprintf(stderr, "Error: Unable to read input file: %s\n", inFilePath);
+        return false;
+    }
+
+    const uint32_t numSamples = wr.getNumSamples();
+    std::vector<WavFrameRange> ranges;
+    for (uint32_t startFrame = 0; startFrame < numSamples; startFrame += framesPerSegment) {
+        const uint32_t numFrames = (numSamples - startFrame < framesPerSegment) ? numSamples - startFrame : framesPerSegment;
+        ranges.push_back({startFrame, numFrames});
+        if (numFrames < framesPerSegment) {
+            break; //Also keeps startFrame from wrapping
+        }
+    }
+
+    return split(&wr, ranges.data(), nullptr, (uint32_t) ranges.size(), outFilePrefix, manifestFilePath, numThreads);
+}
+
+
+bool WavFileOps::split(WavReader *wavReader,
+                       const WavFrameRange ranges[],
+                       const char *const labels[],
+                       uint32_t numRanges,
+                       const char *outFilePrefix,
+                       const char *manifestFilePath,
+                       uint32_t numThreads) {
+
+    //Fail once up front rather than once per segment
+    if (wavReader->getAudioFormat() == AUDIO_FORMAT_IMA_ADPCM) {
+        fprintf(stderr, "Error: IMA ADPCM files can't be split without decoding: %s\n", wavReader->getReadFilePath());
+        return false;
+    }
+
+    std::vector<std::string> outFilePaths(numRanges);
+    std::vector<WavExtractRegion> regions(numRanges);
+    for (uint32_t i = 0; i < numRanges; i++) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "%04u.wav", i + 1);
+        outFilePaths[i] = std::string(outFilePrefix) + suffix;
+        regions[i].outFilePath = outFilePaths[i].c_str();
+        regions[i].startFrame = ranges[i].startFrame;
+        regions[i].numFrames = ranges[i].numFrames;
+    }
+
+    if (!extractRegions(wavReader, regions.data(), numRanges, numThreads)) {
+        fprintf(stderr, "Error: Problem writing segments of: %s\n", wavReader->getReadFilePath());
+        return false;
+    }
+
+    return !manifestFilePath || writeManifest(wavReader, regions.data(), labels, numRanges, manifestFilePath);
+}
+
+
+bool WavFileOps::writeManifest(WavReader *wavReader,
+                               const WavExtractRegion regions[],
+                               const char *const labels[],
+                               uint32_t numRegions,
+                               const char *manifestFilePath) {
+
+    FILE *f = fopen(manifestFilePath, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Unable to open manifest file: %s\n", manifestFilePath);
+        return false;
+    }
+
+    fprintf(f, "{\"source\": ");
+    writeJsonString(f, wavReader->getReadFilePath());
+    fprintf(f, ", \"sampleRate\": %u, \"numChannels\": %u, \"segments\": [",
+            wavReader->getSampleRate(), wavReader->getNumChannels());
+    for (uint32_t i = 0; i < numRegions; i++) {
+        fprintf(f, "%s\n{\"path\": ", (i > 0) ? "," : "");
+        writeJsonString(f, regions[i].outFilePath);
+        fprintf(f, ", \"startFrame\": %u, \"numFrames\": %u", regions[i].startFrame, regions[i].numFrames);
+        if (labels) {
+            fprintf(f, ", \"label\": ");
+            writeJsonString(f, labels[i]);
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n]}\n");
+
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Problem writing manifest file: %s\n", manifestFilePath);
+    }
+
+    return ok;
+}
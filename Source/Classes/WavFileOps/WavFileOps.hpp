@@ -0,0 +1,105 @@
+//WavFileOps.hpp
+
+#ifndef __WAV_FILE_OPS_HPP__
+#define __WAV_FILE_OPS_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavReader.hpp"
+#include "WavWriter.hpp"
+
+
+typedef struct {
+    const char *outFilePath;
+    uint32_t startFrame;
+    uint32_t numFrames;
+} WavExtractRegion;
+
+
+typedef struct {
+    uint32_t startFrame;
+    uint32_t numFrames;
+} WavFrameRange;
+
+
+//Whole-file operations that move sample data without decoding it.
+//Headers are generated by WavWriter; sample bytes are copied kernel-side where possible.
+class WavFileOps {
+
+public:
+
+    //Join files that share sample rate, channel count and sample format, in order. outFilePath
+    //mustn't be one of the inputs.
+    static bool concatenate(const char *const inFilePaths[],
+                            uint32_t numInFiles,
+                            const char *outFilePath);
+
+    //Copy frames [startFrame, startFrame + numFrames) into a new file with a fresh header.
+    //Here and below, no output may be the input file.
+    static bool extract(const char *inFilePath,
+                        const char *outFilePath,
+                        uint32_t startFrame,
+                        uint32_t numFrames);
+
+    //Extract many regions from one source, numThreads at a time (0: one per hardware thread).
+    //Returns false if any region failed; the others are still written.
+    static bool extractBatch(const char *inFilePath,
+                             const WavExtractRegion regions[],
+                             uint32_t numRegions,
+                             uint32_t numThreads = 0);
+
+    //Split one file into segments written in parallel as extractBatch() does, to
+    //outFilePrefix0001.wav, outFilePrefix0002.wav, ... If manifestFilePath isn't nullptr, a JSON
+    //list of the segments (path, first frame, frame count, label) is written there once they all are.
+
+    //One segment from each cue point to the next (labels from LIST/adtl), plus one from the
+    //start of the file to the first cue point, if that isn't at frame 0
+    static bool splitAtCuePoints(const char *inFilePath,
+                                 const char *outFilePrefix,
+                                 const char *manifestFilePath = nullptr,
+                                 uint32_t numThreads = 0);
+
+    //One segment per range, in the order given; ranges may overlap or leave gaps
+    static bool splitFrameRanges(const char *inFilePath,
+                                 const WavFrameRange ranges[],
+                                 uint32_t numRanges,
+                                 const char *outFilePrefix,
+                                 const char *manifestFilePath = nullptr,
+                                 uint32_t numThreads = 0);
+
+    //Consecutive segments of framesPerSegment frames (e.g. 30 * sample rate); the last may be shorter
+    static bool splitFixedDuration(const char *inFilePath,
+                                   uint32_t framesPerSegment,
+                                   const char *outFilePrefix,
+                                   const char *manifestFilePath = nullptr,
+                                   uint32_t numThreads = 0);
+
+
+private:
+
+    static bool formatsMatch(WavReader *a, WavReader *b);
+
+    static bool extractRegion(WavReader *wavReader, const WavExtractRegion *region);
+
+    static bool extractRegions(WavReader *wavReader,
+                               const WavExtractRegion regions[],
+                               uint32_t numRegions,
+                               uint32_t numThreads);
+
+    static bool split(WavReader *wavReader,
+                      const WavFrameRange ranges[],
+                      const char *const labels[], //nullptr, or one per range
+                      uint32_t numRanges,
+                      const char *outFilePrefix,
+                      const char *manifestFilePath,
+                      uint32_t numThreads);
+
+    static bool writeManifest(WavReader *wavReader,
+                              const WavExtractRegion regions[],
+                              const char *const labels[],
+                              uint32_t numRegions,
+                              const char *manifestFilePath);
+};
+
+
+#endif //__WAV_FILE_OPS_HPP__
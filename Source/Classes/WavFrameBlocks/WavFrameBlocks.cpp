@@ -0,0 +1,171 @@
+//WavFrameBlocks.cpp
+
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "WavFrameBlocks.hpp"
+#include "WavReader.hpp"
+#include "WavSampleConverter.hpp"
+
+
+WavFrameBlockReader::WavFrameBlockReader(WavReader *wavReader,
+                                         uint32_t numFramesPerBlock,
+                                         WavFrameBlockType type) {
+    _pWavReader = wavReader;
+    _type = type;
+    _numFramesPerBlock = numFramesPerBlock;
+    _numChannels = 0;
+    _frameSize = 0;
+    _numFramesLeft = 0;
+    _firstFrame = 0;
+    _numFrames = 0;
+    _pRawBuffer = nullptr;
+    _pBuffer = nullptr;
+    _started = false;
+    _failed = false;
+}
+
+
+WavFrameBlockReader::WavFrameBlockReader(WavFrameBlockReader &&other) {
+    _pWavReader = other._pWavReader;
+    _type = other._type;
+    _numFramesPerBlock = other._numFramesPerBlock;
+    _numChannels = other._numChannels;
+    _frameSize = other._frameSize;
+    _numFramesLeft = other._numFramesLeft;
+    _firstFrame = other._firstFrame;
+    _numFrames = other._numFrames;
+    _pRawBuffer = other._pRawBuffer;
+    _pBuffer = other._pBuffer;
+    _started = other._started;
+    _failed = other._failed;
+    other._pRawBuffer = nullptr;
+    other._pBuffer = nullptr;
+    other._started = false;
+}
+
+
+WavFrameBlockReader::~WavFrameBlockReader() {
+    if (_started) {
+        _pWavReader->finishReading();
+    }
+    free(_pRawBuffer);
+    free(_pBuffer);
+}
+
+
+bool WavFrameBlockReader::start() {
+
+    if (_started) {
+        fprintf(stderr, "Error: A frame block range can only be iterated once.\n");
+        _failed = true;
+        return false;
+    }
+
+    if (!_pWavReader || _numFramesPerBlock == 0) {
+        fprintf(stderr, "Error: Frame blocks need a reader and at least one frame per block.\n");
+        _failed = true;
+        return false;
+    }
+
+    _numChannels = _pWavReader->getNumChannels();
+    _frameSize = _numChannels * _pWavReader->getByteDepth();
+    _numFramesLeft = _pWavReader->getNumSamples();
+    if (_frameSize == 0) {
+        _failed = true;
+        return false;
+    }
+
+    //Never larger than the data, so short files don't pay for a big block
+    uint32_t maxNumFrames = (_numFramesLeft < _numFramesPerBlock) ? _numFramesLeft : _numFramesPerBlock;
+    uint32_t sampleSize = (_type == WAV_FRAME_BLOCK_RAW) ? _frameSize / _numChannels :
+                          (_type == WAV_FRAME_BLOCK_INT16) ? sizeof(int16_t) : sizeof(float);
+    _pBuffer = malloc((size_t) (maxNumFrames ? maxNumFrames : 1) * _numChannels * sampleSize);
+    if (_type == WAV_FRAME_BLOCK_FLOAT32) {
+        _pRawBuffer = (uint8_t *) malloc((size_t) (maxNumFrames ? maxNumFrames : 1) * _frameSize);
+    }
+    if (!_pBuffer || (_type == WAV_FRAME_BLOCK_FLOAT32 && !_pRawBuffer)) {
+        fprintf(stderr, "Error: Unable to allocate frame block buffer.\n");
+        _failed = true;
+        return false;
+    }
+
+    if (!_pWavReader->prepareToRead()) {
+        _failed = true;
+        return false;
+    }
+    _started = true;
+    _firstFrame = 0;
+    _numFrames = 0;
+
+    return next();
+}
+
+
+bool WavFrameBlockReader::next() {
+
+    _firstFrame += _numFrames;
+    _numFrames = 0;
+    if (_numFramesLeft == 0 || _failed) {
+        return false;
+    }
+
+    const uint32_t numFrames = (_numFramesLeft < _numFramesPerBlock) ? _numFramesLeft : _numFramesPerBlock;
+    bool ok = false;
+    switch (_type) {
+        case WAV_FRAME_BLOCK_RAW:
+            ok = _pWavReader->readData((uint8_t *) _pBuffer, numFrames * _frameSize);
+            break;
+        case WAV_FRAME_BLOCK_INT16:
+            ok = _pWavReader->readDataToInt16s((int16_t *) _pBuffer, numFrames);
+            break;
+        case WAV_FRAME_BLOCK_FLOAT32:
+            ok = _pWavReader->readData(_pRawBuffer, numFrames * _frameSize) &&
+                 wavDecodeToFloats(_pRawBuffer,
+                                   _pWavReader->getSampleFormat(),
+                                   (float *) _pBuffer,
+                                   numFrames * _numChannels);
+            break;
+    }
+    if (!ok) {
+        _failed = true;
+        return false;
+    }
+
+    _numFrames = numFrames;
+    _numFramesLeft -= numFrames;
+
+    //Let the kernel fetch the next block while the caller works on this one
+    if (_numFramesLeft > 0) {
+        uint32_t numNextFrames = (_numFramesLeft < _numFramesPerBlock) ? _numFramesLeft : _numFramesPerBlock;
+        _pWavReader->prefetch(numNextFrames * _frameSize);
+    }
+
+    return true;
+}
+
+
+const void *WavFrameBlockReader::getSamples() {
+    return _pBuffer;
+}
+
+
+uint32_t WavFrameBlockReader::getNumFrames() {
+    return _numFrames;
+}
+
+
+uint32_t WavFrameBlockReader::getNumChannels() {
+    return _numChannels;
+}
+
+
+uint32_t WavFrameBlockReader::getFirstFrame() {
+    return _firstFrame;
+}
+
+
+bool WavFrameBlockReader::getFailed() {
+    return _failed;
+}
@@ -0,0 +1,168 @@
+//WavFrameBlocks.hpp
+
+#ifndef __WAV_FRAME_BLOCKS_HPP__
+#define __WAV_FRAME_BLOCKS_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+#include <utility> //std::move()
+
+
+class WavReader;
+
+
+//Sample type a block is decoded to
+typedef enum {
+    WAV_FRAME_BLOCK_RAW = 0, //Wav-format bytes, as stored
+    WAV_FRAME_BLOCK_INT16 = 1,
+    WAV_FRAME_BLOCK_FLOAT32 = 2 //Full scale is [-1.0, 1.0)
+} WavFrameBlockType;
+
+
+template <typename T>
+struct WavFrameBlockTraits; //Only uint8_t, int16_t and float are supported
+
+template <>
+struct WavFrameBlockTraits<uint8_t> {
+    static const WavFrameBlockType TYPE = WAV_FRAME_BLOCK_RAW;
+};
+
+template <>
+struct WavFrameBlockTraits<int16_t> {
+    static const WavFrameBlockType TYPE = WAV_FRAME_BLOCK_INT16;
+};
+
+template <>
+struct WavFrameBlockTraits<float> {
+    static const WavFrameBlockType TYPE = WAV_FRAME_BLOCK_FLOAT32;
+};
+
+
+//One block of frames, channels interleaved. pSamples points into the range's buffer and is
+//only valid until the iterator advances.
+template <typename T>
+struct WavFrameBlock {
+    const T *pSamples;
+    uint32_t numFrames; //numFramesPerBlock, except for a short final block
+    uint32_t numChannels;
+    uint32_t firstFrame; //Index of the block's first frame in the file
+};
+
+
+//Type-independent half of WavFrameBlocks: owns the buffer and does the reading and decoding
+class WavFrameBlockReader {
+
+public:
+
+    WavFrameBlockReader(WavReader *wavReader,
+                        uint32_t numFramesPerBlock,
+                        WavFrameBlockType type);
+
+    WavFrameBlockReader(WavFrameBlockReader &&other);
+
+    ~ WavFrameBlockReader();
+
+    //prepareToRead(), then read the first block
+    bool start();
+
+    //Read and decode the next block; false at the end of the data or on error
+    bool next();
+
+    const void *getSamples();
+
+    uint32_t getNumFrames();
+
+    uint32_t getNumChannels();
+
+    uint32_t getFirstFrame();
+
+    //True if iteration stopped on an error rather than at the end of the data
+    bool getFailed();
+
+
+private:
+
+    WavFrameBlockReader(const WavFrameBlockReader &);
+
+    WavFrameBlockReader &operator=(const WavFrameBlockReader &);
+
+    WavReader *_pWavReader;
+    WavFrameBlockType _type;
+    uint32_t _numFramesPerBlock;
+    uint32_t _numChannels;
+    uint32_t _frameSize; //Wav-format bytes per frame
+    uint32_t _numFramesLeft;
+    uint32_t _firstFrame;
+    uint32_t _numFrames;
+    uint8_t *_pRawBuffer; //Wav-format bytes; only needed to decode floats
+    void *_pBuffer;
+    bool _started;
+    bool _failed;
+};
+
+
+//Range over a reader's sample data, numFramesPerBlock frames at a time; see WavReader::blocks()
+template <typename T>
+class WavFrameBlocks {
+
+public:
+
+    class Iterator {
+
+    public:
+
+        Iterator(WavFrameBlockReader *blockReader) {
+            _pBlockReader = blockReader;
+        }
+
+        WavFrameBlock<T> operator*() const {
+            WavFrameBlock<T> block;
+            block.pSamples = (const T *) _pBlockReader->getSamples();
+            block.numFrames = _pBlockReader->getNumFrames();
+            block.numChannels = _pBlockReader->getNumChannels();
+            block.firstFrame = _pBlockReader->getFirstFrame();
+            return block;
+        }
+
+        Iterator &operator++() {
+            if (!_pBlockReader->next()) {
+                _pBlockReader = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return _pBlockReader != other._pBlockReader;
+        }
+
+    private:
+
+        WavFrameBlockReader *_pBlockReader; //nullptr once past the end
+    };
+
+    WavFrameBlocks(WavReader *wavReader,
+                   uint32_t numFramesPerBlock) : _blockReader(wavReader, numFramesPerBlock,
+                                                              WavFrameBlockTraits<T>::TYPE) {
+    }
+
+    WavFrameBlocks(WavFrameBlocks &&other) : _blockReader(std::move(other._blockReader)) {
+    }
+
+    Iterator begin() {
+        return Iterator(_blockReader.start() ? &_blockReader : nullptr);
+    }
+
+    Iterator end() {
+        return Iterator(nullptr);
+    }
+
+    bool getFailed() {
+        return _blockReader.getFailed();
+    }
+
+private:
+
+    WavFrameBlockReader _blockReader;
+};
+
+
+#endif //__WAV_FRAME_BLOCKS_HPP__
@@ -20,7 +20,7 @@
 
 
 typedef struct {
-    char chunkId[4];             //"RIFF"
+    char chunkId[4];             //"RIFF", or "RIFX" if every field and sample is big-endian
     uint32_t fileSizeLess8;
     char formatName[4];          //"WAV"
 } RiffHeader;
@@ -38,7 +38,7 @@ const uint32_t SUBCHUNK_HEADER_SIZE = sizeof(SubchunkHeader);  //Total size of s
 typedef struct {
     char formatSubchunkId[4];    //"fmt "
     uint32_t formatSubchunkSize;     //Number of bytes following this field
-    uint16_t audioFormat;            //1 for PCM, 3 for Float
+    uint16_t audioFormat;            //1 for PCM, 3 for Float, 6 for A-law, 7 for mu-law, 0x11 for IMA ADPCM
     uint16_t numChannels;            //1 or 2
     uint32_t sampleRate;             //8000, 44100, etc.
     uint32_t byteRate;               // == sampleRate * numChannels * (bitsPerSample / 8)
@@ -51,6 +51,17 @@ const uint32_t FORMAT_SUBCHUNK_SIZE = sizeof(FormatSubchunk);  //Total size of f
 
 const uint8_t AUDIO_FORMAT_FLOAT = 3;
 const uint8_t AUDIO_FORMAT_INT = 1;
+const uint8_t AUDIO_FORMAT_ALAW = 6;
+const uint8_t AUDIO_FORMAT_MULAW = 7;
+const uint8_t AUDIO_FORMAT_IMA_ADPCM = 0x11;
+
+
+//Follows the format subchunk's fields for IMA ADPCM, making formatSubchunkSize 20
+typedef struct {
+    uint16_t extraSize;              //2: the size of what follows
+    uint16_t framesPerBlock;         //Samples per channel in each blockAlign-sized block
+} ImaAdpcmFormatExtension;
+const uint32_t IMA_ADPCM_FORMAT_EXTENSION_SIZE = sizeof(ImaAdpcmFormatExtension);
 
 
 //Supposedly required for IEEE floating-point PCM format; see:
@@ -64,4 +75,26 @@ const uint32_t FACT_SUBCHUNK_SIZE = sizeof(FactSubchunk); //Total size of fact s
 
 
 
+//The structs above overlay little-endian (RIFF) bytes on a little-endian host.
+//For RIFX files, every numeric field passes through these on its way in or out.
+inline uint16_t wavByteOrder16(uint16_t value, bool bigEndian) {
+    return bigEndian ? (uint16_t) ((value >> 8) | (value << 8)) : value;
+}
+
+inline uint32_t wavByteOrder32(uint32_t value, bool bigEndian) {
+    return bigEndian ? ((value >> 24) | ((value >> 8) & 0x0000FF00) | ((value << 8) & 0x00FF0000) | (value << 24)) : value;
+}
+
+inline void wavByteOrderFormatSubchunk(FormatSubchunk *fsc, bool bigEndian) {
+    fsc->formatSubchunkSize = wavByteOrder32(fsc->formatSubchunkSize, bigEndian);
+    fsc->audioFormat = wavByteOrder16(fsc->audioFormat, bigEndian);
+    fsc->numChannels = wavByteOrder16(fsc->numChannels, bigEndian);
+    fsc->sampleRate = wavByteOrder32(fsc->sampleRate, bigEndian);
+    fsc->byteRate = wavByteOrder32(fsc->byteRate, bigEndian);
+    fsc->blockAlign = wavByteOrder16(fsc->blockAlign, bigEndian);
+    fsc->bitsPerSample = wavByteOrder16(fsc->bitsPerSample, bigEndian);
+}
+
+
+
 #endif //__WAV_HEADER_HPP__
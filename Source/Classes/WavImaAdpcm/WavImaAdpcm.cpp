@@ -0,0 +1,220 @@
+//WavImaAdpcm.cpp
+
+
+#include <cstring> //memcpy()
+#include <cstdio>
+
+#include "WavImaAdpcm.hpp"
+
+
+static const uint32_t BLOCK_HEADER_SIZE = 4; //Per channel: int16 first sample, uint8 step index, uint8 reserved
+static const uint32_t GROUP_SIZE = 4; //Bytes per channel per group of 8 samples
+static const int32_t MAX_STEP_INDEX = 88;
+static const uint32_t MAX_NUM_CHANNELS = 8;
+
+static const int32_t INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int32_t STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+
+uint32_t wavImaAdpcmFramesPerBlock(uint32_t blockAlign, uint32_t numChannels) {
+
+    if (numChannels == 0 || blockAlign % (GROUP_SIZE * numChannels) != 0 ||
+        blockAlign <= BLOCK_HEADER_SIZE * numChannels) {
+        return 0;
+    }
+
+    //The header holds one sample; every other byte holds two
+    return 1 + (blockAlign / numChannels - BLOCK_HEADER_SIZE) * 2;
+}
+
+
+uint32_t wavImaAdpcmDefaultBlockAlign(uint32_t sampleRate, uint32_t numChannels) {
+
+    uint32_t blockAlign = 256 * numChannels;
+    for (uint32_t rate = 11025; rate < sampleRate && blockAlign < 32768; rate *= 2) {
+        blockAlign *= 2;
+    }
+
+    return blockAlign;
+}
+
+
+//Reference decoder step, with the bit tests turned into masks so there are no branches to mispredict
+static inline int32_t decodeNibble(WavImaAdpcmState *state, uint32_t nibble) {
+
+    const int32_t step = STEP_TABLE[state->stepIndex];
+    int32_t diff = step >> 3;
+    diff += step & -(int32_t) ((nibble >> 2) & 1);
+    diff += (step >> 1) & -(int32_t) ((nibble >> 1) & 1);
+    diff += (step >> 2) & -(int32_t) (nibble & 1);
+    const int32_t sign = -(int32_t) ((nibble >> 3) & 1);
+    diff = (diff ^ sign) - sign;
+
+    int32_t predictor = state->predictor + diff;
+    predictor = (predictor > 32767) ? 32767 : predictor;
+    predictor = (predictor < -32768) ? -32768 : predictor;
+    state->predictor = predictor;
+
+    int32_t stepIndex = state->stepIndex + INDEX_TABLE[nibble];
+    stepIndex = (stepIndex < 0) ? 0 : stepIndex;
+    stepIndex = (stepIndex > MAX_STEP_INDEX) ? MAX_STEP_INDEX : stepIndex;
+    state->stepIndex = stepIndex;
+
+    return predictor;
+}
+
+
+static inline uint32_t encodeNibble(WavImaAdpcmState *state, int32_t sample) {
+
+    int32_t step = STEP_TABLE[state->stepIndex];
+    int32_t diff = sample - state->predictor;
+    uint32_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 1;
+    }
+
+    //Track exactly what a decoder will reconstruct
+    decodeNibble(state, nibble);
+
+    return nibble;
+}
+
+
+//Each channel's samples form one serial dependency chain, so the channels are decoded side by
+//side: with NUM_CHANNELS fixed the inner loop unrolls and the chains overlap in the pipeline.
+//NUM_CHANNELS 0 takes the channel count at run time.
+template<uint32_t NUM_CHANNELS>
+static void decodeGroups(const uint8_t *data,
+                         uint32_t numGroups,
+                         uint32_t numChannels,
+                         WavImaAdpcmState *states,
+                         int16_t *samples) {
+
+    const uint32_t nc = NUM_CHANNELS ? NUM_CHANNELS : numChannels;
+    for (size_t g = 0; g < numGroups; g++) {
+        const uint8_t *group = data + g * GROUP_SIZE * nc;
+        int16_t *dest = samples + g * 8 * nc;
+        for (uint32_t k = 0; k < 8; k++) {
+            for (uint32_t ch = 0; ch < nc; ch++) {
+                const uint32_t nibble = (group[ch * GROUP_SIZE + k / 2] >> ((k & 1) * 4)) & 0x0F;
+                dest[k * nc + ch] = (int16_t) decodeNibble(&states[ch], nibble);
+            }
+        }
+    }
+}
+
+
+bool wavImaAdpcmDecodeBlock(const uint8_t block[],
+                            uint32_t blockSize,
+                            uint32_t numChannels,
+                            int16_t samples[],
+                            uint32_t *numFrames) {
+
+    if (numChannels == 0 || numChannels > MAX_NUM_CHANNELS) {
+        fprintf(stderr, "Error: Unsupported number of IMA ADPCM channels.\n");
+        return false;
+    }
+
+    if (blockSize < BLOCK_HEADER_SIZE * numChannels) {
+        fprintf(stderr, "Error: IMA ADPCM block is too short for its headers.\n");
+        return false;
+    }
+
+    WavImaAdpcmState states[MAX_NUM_CHANNELS];
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        const uint8_t *header = block + ch * BLOCK_HEADER_SIZE;
+        int16_t first;
+        memcpy(&first, header, sizeof(int16_t));
+        states[ch].predictor = first;
+        states[ch].stepIndex = (header[2] > MAX_STEP_INDEX) ? MAX_STEP_INDEX : header[2];
+        samples[ch] = first;
+    }
+
+    const uint8_t *data = block + BLOCK_HEADER_SIZE * numChannels;
+    const uint32_t numGroups = (blockSize - BLOCK_HEADER_SIZE * numChannels) / (GROUP_SIZE * numChannels);
+    int16_t *dest = samples + numChannels;
+    switch (numChannels) {
+        case 1:
+            decodeGroups<1>(data, numGroups, 1, states, dest);
+            break;
+        case 2:
+            decodeGroups<2>(data, numGroups, 2, states, dest);
+            break;
+        default:
+            decodeGroups<0>(data, numGroups, numChannels, states, dest);
+            break;
+    }
+
+    *numFrames = 1 + numGroups * 8;
+
+    return true;
+}
+
+
+bool wavImaAdpcmEncodeBlock(const int16_t samples[],
+                            uint32_t numChannels,
+                            WavImaAdpcmState states[],
+                            uint8_t block[],
+                            uint32_t blockAlign) {
+
+    if (wavImaAdpcmFramesPerBlock(blockAlign, numChannels) == 0) {
+        fprintf(stderr, "Error: Invalid IMA ADPCM block size.\n");
+        return false;
+    }
+
+    //The first frame goes into the headers verbatim; the step index carries over from the last block
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        WavImaAdpcmState *state = &states[ch];
+        state->stepIndex = (state->stepIndex < 0) ? 0 :
+                           (state->stepIndex > MAX_STEP_INDEX) ? MAX_STEP_INDEX : state->stepIndex;
+        state->predictor = samples[ch];
+        uint8_t *header = block + ch * BLOCK_HEADER_SIZE;
+        memcpy(header, &samples[ch], sizeof(int16_t));
+        header[2] = (uint8_t) state->stepIndex;
+        header[3] = 0;
+    }
+
+    const uint32_t numGroups = (blockAlign - BLOCK_HEADER_SIZE * numChannels) / (GROUP_SIZE * numChannels);
+    const int16_t *src = samples + numChannels;
+    uint8_t *data = block + BLOCK_HEADER_SIZE * numChannels;
+    for (size_t g = 0; g < numGroups; g++) {
+        for (uint32_t ch = 0; ch < numChannels; ch++) {
+            uint8_t *group = data + (g * numChannels + ch) * GROUP_SIZE;
+            for (uint32_t k = 0; k < 8; k += 2) {
+                const uint32_t low = encodeNibble(&states[ch], src[(g * 8 + k) * numChannels + ch]);
+                const uint32_t high = encodeNibble(&states[ch], src[(g * 8 + k + 1) * numChannels + ch]);
+                group[k / 2] = (uint8_t) (low | (high << 4));
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,46 @@
+//WavImaAdpcm.hpp
+
+#ifndef __WAV_IMA_ADPCM_HPP__
+#define __WAV_IMA_ADPCM_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+
+//IMA ADPCM (WAVE_FORMAT_IMA_ADPCM) block codec: 4 bits per sample, about 4:1 against 16-bit PCM.
+//Every block starts with a 4-byte header per channel holding the first sample and the step index,
+//so blocks decode independently of each other; that is what allows seeking by block.
+//After the headers, the channels take turns with 4 bytes (8 samples, low nibble first) each.
+
+//Decoder/encoder state for one channel
+typedef struct {
+    int32_t predictor; //Last 16-bit sample value
+    int32_t stepIndex; //0-88
+} WavImaAdpcmState;
+
+
+//Frames per block for a given block size (the fmt subchunk's blockAlign); 0 if the size can't hold a block
+uint32_t wavImaAdpcmFramesPerBlock(uint32_t blockAlign,
+                                   uint32_t numChannels);
+
+//256 bytes per channel up to 11025 Hz, doubling with each doubling of the sample rate, as common encoders do
+uint32_t wavImaAdpcmDefaultBlockAlign(uint32_t sampleRate,
+                                      uint32_t numChannels);
+
+//Decode one block of blockSize bytes into interleaved int16 frames. A short final block
+//(blockSize < blockAlign) decodes its whole 8-sample groups; numFrames receives the count.
+bool wavImaAdpcmDecodeBlock(const uint8_t block[],
+                            uint32_t blockSize,
+                            uint32_t numChannels,
+                            int16_t samples[], //wavImaAdpcmFramesPerBlock() frames, channels interleaved
+                            uint32_t *numFrames);
+
+//Encode wavImaAdpcmFramesPerBlock(blockAlign, numChannels) interleaved frames into one block.
+//states carries each channel's step index from block to block; zero it before the first block.
+bool wavImaAdpcmEncodeBlock(const int16_t samples[],
+                            uint32_t numChannels,
+                            WavImaAdpcmState states[], //One per channel
+                            uint8_t block[],
+                            uint32_t blockAlign);
+
+
+#endif //__WAV_IMA_ADPCM_HPP__
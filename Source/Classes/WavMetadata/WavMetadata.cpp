@@ -0,0 +1,311 @@
+//WavMetadata.cpp
+
+
+#include <cstring> //memcpy(), memset()
+
+#include "WavMetadata.hpp"
+#include "WavHeader.hpp"
+
+
+static const uint32_t CUE_POINT_SIZE = 24; //dwName, dwPosition, fccChunk, dwChunkStart, dwBlockStart, dwSampleOffset
+
+//bext field offsets
+static const uint32_t BEXT_DESCRIPTION = 0;
+static const uint32_t BEXT_ORIGINATOR = 256;
+static const uint32_t BEXT_ORIGINATOR_REFERENCE = 288;
+static const uint32_t BEXT_ORIGINATION_DATE = 320;
+static const uint32_t BEXT_ORIGINATION_TIME = 330;
+static const uint32_t BEXT_TIME_REFERENCE_LOW = 338;
+static const uint32_t BEXT_TIME_REFERENCE_HIGH = 342;
+static const uint32_t BEXT_VERSION = 346;
+static const uint32_t BEXT_UMID = 348;
+static const uint32_t BEXT_LOUDNESS_VALUE = 412;
+static const uint32_t BEXT_NUM_LOUDNESS_FIELDS = 5;
+
+static const uint32_t SMPL_HEADER_SIZE = 36; //Nine dwords, dwSampleLoops the eighth
+static const uint32_t SMPL_LOOP_SIZE = 24; //Six dwords
+
+//Payloads with no multi-byte fields; the same bytes in either byte order
+static const char *BYTE_ORDER_FREE_IDS[] = {"iXML", "axml", "inst", "id3 ", "ID3 ", "_PMX", "JUNK", "junk", "PAD "};
+static const uint32_t NUM_BYTE_ORDER_FREE_IDS = sizeof(BYTE_ORDER_FREE_IDS) / sizeof(BYTE_ORDER_FREE_IDS[0]);
+
+
+static uint32_t readUint32(const uint8_t *p, bool bigEndian) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return wavByteOrder32(value, bigEndian);
+}
+
+
+static uint16_t readUint16(const uint8_t *p, bool bigEndian) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return wavByteOrder16(value, bigEndian);
+}
+
+
+static void swapUint32(uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    value = wavByteOrder32(value, true);
+    memcpy(p, &value, sizeof(value));
+}
+
+
+static void swapUint16(uint8_t *p) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    value = wavByteOrder16(value, true);
+    memcpy(p, &value, sizeof(value));
+}
+
+
+//Fixed-width text field, which is NUL-padded but needn't be NUL-terminated
+static void copyText(char dest[], uint32_t maxLength, const uint8_t *src, uint32_t srcLength) {
+    uint32_t n = 0;
+    while (n < srcLength && n + 1 < maxLength && src[n] != 0) {
+        dest[n] = (char) src[n];
+        n++;
+    }
+    dest[n] = 0;
+}
+
+
+//Calls visit(id, payload, size) for each subchunk of a LIST payload, after its 4-byte type;
+//stops at the first one that runs past the end or when visit() returns false
+template<class Visit>
+static void forEachListSubchunk(const uint8_t listData[], uint32_t listSize, bool bigEndian, Visit visit) {
+    uint32_t offset = 4;
+    while (offset + SUBCHUNK_HEADER_SIZE <= listSize) {
+        const uint8_t *header = listData + offset;
+        const uint32_t size = readUint32(header + 4, bigEndian);
+        if (size > listSize - offset - SUBCHUNK_HEADER_SIZE) {
+            return;
+        }
+        if (!visit((const char *) header, header + SUBCHUNK_HEADER_SIZE, size)) {
+            return;
+        }
+        offset += SUBCHUNK_HEADER_SIZE + size + (size & 1);
+    }
+}
+
+
+bool wavParseInfoText(const uint8_t listData[],
+                      uint32_t listSize,
+                      bool bigEndian,
+                      const char infoId[4],
+                      char text[],
+                      uint32_t maxTextLength) {
+
+    if (listSize < 4 || memcmp(listData, "INFO", 4) != 0 || maxTextLength == 0) {
+        return false;
+    }
+
+    bool found = false;
+    forEachListSubchunk(listData, listSize, bigEndian, [&](const char *id, const uint8_t *data, uint32_t size) {
+        if (memcmp(id, infoId, 4) != 0) {
+            return true;
+        }
+        copyText(text, maxTextLength, data, size);
+        found = true;
+        return false;
+    });
+
+    return found;
+}
+
+
+bool wavParseBroadcastExtension(const uint8_t bextData[],
+                                uint32_t bextSize,
+                                uint32_t subchunkSize,
+                                bool bigEndian,
+                                WavBroadcastExtension *bext) {
+
+    //Version 0 files stop short of the loudness fields, but every version reserves the full size
+    if (bextSize < BEXT_FIXED_SIZE || subchunkSize < BEXT_FIXED_SIZE) {
+        return false;
+    }
+
+    memset(bext, 0, sizeof(*bext));
+    copyText(bext->description, sizeof(bext->description), bextData + BEXT_DESCRIPTION, 256);
+    copyText(bext->originator, sizeof(bext->originator), bextData + BEXT_ORIGINATOR, 32);
+    copyText(bext->originatorReference, sizeof(bext->originatorReference), bextData + BEXT_ORIGINATOR_REFERENCE, 32);
+    copyText(bext->originationDate, sizeof(bext->originationDate), bextData + BEXT_ORIGINATION_DATE, 10);
+    copyText(bext->originationTime, sizeof(bext->originationTime), bextData + BEXT_ORIGINATION_TIME, 8);
+    bext->timeReference = (uint64_t) readUint32(bextData + BEXT_TIME_REFERENCE_HIGH, bigEndian) << 32 |
+                          readUint32(bextData + BEXT_TIME_REFERENCE_LOW, bigEndian);
+    bext->version = readUint16(bextData + BEXT_VERSION, bigEndian);
+    memcpy(bext->umid, bextData + BEXT_UMID, sizeof(bext->umid));
+    if (bext->version >= 2) {
+        const uint8_t *p = bextData + BEXT_LOUDNESS_VALUE;
+        bext->loudnessValue = (int16_t) readUint16(p, bigEndian);
+        bext->loudnessRange = (int16_t) readUint16(p + 2, bigEndian);
+        bext->maxTruePeakLevel = (int16_t) readUint16(p + 4, bigEndian);
+        bext->maxMomentaryLoudness = (int16_t) readUint16(p + 6, bigEndian);
+        bext->maxShortTermLoudness = (int16_t) readUint16(p + 8, bigEndian);
+    }
+    bext->codingHistorySize = subchunkSize - BEXT_FIXED_SIZE;
+
+    return true;
+}
+
+
+uint32_t wavParseNumCuePoints(const uint8_t cueData[],
+                              uint32_t cueSize,
+                              bool bigEndian) {
+
+    if (cueSize < sizeof(uint32_t)) {
+        return 0;
+    }
+
+    //Trust the stated count only as far as the payload backs it up
+    const uint32_t numCuePoints = readUint32(cueData, bigEndian);
+    const uint32_t maxNumCuePoints = (cueSize - sizeof(uint32_t)) / CUE_POINT_SIZE;
+
+    return (numCuePoints < maxNumCuePoints) ? numCuePoints : maxNumCuePoints;
+}
+
+
+uint32_t wavParseCuePoints(const uint8_t cueData[],
+                           uint32_t cueSize,
+                           bool bigEndian,
+                           WavCuePoint cuePoints[],
+                           uint32_t maxNumCuePoints) {
+
+    uint32_t numCuePoints = wavParseNumCuePoints(cueData, cueSize, bigEndian);
+    if (numCuePoints > maxNumCuePoints) {
+        numCuePoints = maxNumCuePoints;
+    }
+
+    for (uint32_t i = 0; i < numCuePoints; i++) {
+        const uint8_t *p = cueData + sizeof(uint32_t) + i * CUE_POINT_SIZE;
+        cuePoints[i].cuePointId = readUint32(p, bigEndian);
+        cuePoints[i].frameIndex = readUint32(p + 20, bigEndian);
+        cuePoints[i].label[0] = 0;
+    }
+
+    return numCuePoints;
+}
+
+
+void wavParseCueLabels(const uint8_t adtlData[],
+                       uint32_t adtlSize,
+                       bool bigEndian,
+                       WavCuePoint cuePoints[],
+                       uint32_t numCuePoints) {
+
+    if (adtlSize < 4 || memcmp(adtlData, "adtl", 4) != 0) {
+        return;
+    }
+
+    forEachListSubchunk(adtlData, adtlSize, bigEndian, [&](const char *id, const uint8_t *data, uint32_t size) {
+        if (memcmp(id, "labl", 4) != 0 || size < sizeof(uint32_t)) {
+            return true;
+        }
+        const uint32_t cuePointId = readUint32(data, bigEndian);
+        for (uint32_t i = 0; i < numCuePoints; i++) {
+            if (cuePoints[i].cuePointId == cuePointId) {
+                copyText(cuePoints[i].label, sizeof(cuePoints[i].label),
+                         data + sizeof(uint32_t), size - sizeof(uint32_t));
+            }
+        }
+        return true;
+    });
+}
+
+
+//Every nested subchunk size, and in adtl the cue point ids (labl, note) and ltxt's fields.
+//INFO entries are text.
+static void swapListByteOrder(uint8_t listData[], uint32_t listSize, bool srcBigEndian) {
+
+    const bool isAdtl = listSize >= 4 && memcmp(listData, "adtl", 4) == 0;
+    uint32_t offset = 4;
+    while (offset + SUBCHUNK_HEADER_SIZE <= listSize) {
+        uint8_t *header = listData + offset;
+        uint8_t *data = header + SUBCHUNK_HEADER_SIZE;
+        const uint32_t size = readUint32(header + 4, srcBigEndian);
+        const uint32_t fitSize = (size < listSize - offset - SUBCHUNK_HEADER_SIZE) ?
+                                 size : listSize - offset - SUBCHUNK_HEADER_SIZE;
+        swapUint32(header + 4);
+        if (isAdtl && (!memcmp(header, "labl", 4) || !memcmp(header, "note", 4)) && fitSize >= 4) {
+            swapUint32(data); //dwName
+        } else if (isAdtl && !memcmp(header, "ltxt", 4) && fitSize >= 20) {
+            swapUint32(data); //dwName
+            swapUint32(data + 4); //dwSampleLength
+            for (uint32_t field = 12; field < 20; field += 2) { //wCountry, wLanguage, wDialect, wCodePage
+                swapUint16(data + field);
+            }
+        }
+        if (size > fitSize) {
+            return;
+        }
+        offset += SUBCHUNK_HEADER_SIZE + size + (size & 1);
+    }
+}
+
+
+bool wavSwapSubchunkByteOrder(const char subchunkId[4],
+                              uint8_t subchunkData[],
+                              uint32_t subchunkSize,
+                              bool srcBigEndian) {
+
+    for (uint32_t i = 0; i < NUM_BYTE_ORDER_FREE_IDS; i++) {
+        if (!memcmp(subchunkId, BYTE_ORDER_FREE_IDS[i], 4)) {
+            return true;
+        }
+    }
+
+    if (!memcmp(subchunkId, "LIST", 4)) {
+        swapListByteOrder(subchunkData, subchunkSize, srcBigEndian);
+        return true;
+    }
+
+    if (!memcmp(subchunkId, "cue ", 4)) {
+        const uint32_t numCuePoints = wavParseNumCuePoints(subchunkData, subchunkSize, srcBigEndian);
+        if (subchunkSize >= sizeof(uint32_t)) {
+            swapUint32(subchunkData);
+        }
+        for (uint32_t i = 0; i < numCuePoints; i++) {
+            uint8_t *p = subchunkData + sizeof(uint32_t) + i * CUE_POINT_SIZE;
+            for (uint32_t field = 0; field < CUE_POINT_SIZE; field += 4) {
+                if (field != 8) { //fccChunk is a four-character code
+                    swapUint32(p + field);
+                }
+            }
+        }
+        return true;
+    }
+
+    //Text apart from the time reference (two dwords, low first in either order), version and
+    //loudness; loudness is reserved (zero) before version 2, so it's swapped regardless
+    if (!memcmp(subchunkId, "bext", 4)) {
+        if (subchunkSize >= BEXT_VERSION + 2) {
+            swapUint32(subchunkData + BEXT_TIME_REFERENCE_LOW);
+            swapUint32(subchunkData + BEXT_TIME_REFERENCE_HIGH);
+            swapUint16(subchunkData + BEXT_VERSION);
+        }
+        if (subchunkSize >= BEXT_LOUDNESS_VALUE + BEXT_NUM_LOUDNESS_FIELDS * 2) {
+            for (uint32_t i = 0; i < BEXT_NUM_LOUDNESS_FIELDS; i++) {
+                swapUint16(subchunkData + BEXT_LOUDNESS_VALUE + i * 2);
+            }
+        }
+        return true;
+    }
+
+    //Nine dwords, then dwSampleLoops loops of six dwords, then opaque sampler data
+    if (!memcmp(subchunkId, "smpl", 4)) {
+        if (subchunkSize < SMPL_HEADER_SIZE) {
+            return true;
+        }
+        const uint32_t numLoops = readUint32(subchunkData + 28, srcBigEndian);
+        const uint32_t maxNumLoops = (subchunkSize - SMPL_HEADER_SIZE) / SMPL_LOOP_SIZE;
+        const uint32_t numDwords = (SMPL_HEADER_SIZE +
+                                    ((numLoops < maxNumLoops) ? numLoops : maxNumLoops) * SMPL_LOOP_SIZE) / 4;
+        for (uint32_t i = 0; i < numDwords; i++) {
+            swapUint32(subchunkData + i * 4);
+        }
+        return true;
+    }
+
+    return false;
+}
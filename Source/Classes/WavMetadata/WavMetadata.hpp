@@ -0,0 +1,101 @@
+//WavMetadata.hpp
+
+#ifndef __WAV_METADATA_HPP__
+#define __WAV_METADATA_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+
+//Metadata subchunks: where they are (from WavReader's header walk) and parsers for the common ones.
+//The parsers take a subchunk's payload as read from the file; bigEndian is set for RIFX files.
+//See:
+// https://tech.ebu.ch/docs/tech/tech3285.pdf (bext)
+// http://www.gallery.co.uk/ixml/ (iXML)
+// https://www.recordingblogs.com/wiki/cue-chunk-of-a-wave-file (cue, LIST/adtl/labl)
+
+
+//One subchunk as found by the header walk; only its header (and a LIST's type) has been read
+typedef struct {
+    char subchunkId[4];
+    char listType[4];                //For LIST subchunks, the first 4 payload bytes, e.g. "INFO" or "adtl"; else zeros
+    uint32_t dataOffset;             //Of the payload, i.e. just past the subchunk header
+    uint32_t dataSize;               //Payload bytes, excluding any pad byte
+} WavSubchunkInfo;
+
+
+//Broadcast Wave Format extension, decoded to native byte order. Strings are NUL-terminated.
+typedef struct {
+    char description[257];
+    char originator[33];
+    char originatorReference[33];
+    char originationDate[11];        //yyyy-mm-dd
+    char originationTime[9];         //hh:mm:ss
+    uint64_t timeReference;          //First sample's position, in samples since midnight
+    uint16_t version;
+    uint8_t umid[64];
+    int16_t loudnessValue;           //Version 2 and later; LUFS x 100
+    int16_t loudnessRange;           //LU x 100
+    int16_t maxTruePeakLevel;        //dBTP x 100
+    int16_t maxMomentaryLoudness;    //LUFS x 100
+    int16_t maxShortTermLoudness;    //LUFS x 100
+    uint32_t codingHistorySize;      //Bytes of coding history text after the fixed fields; read it with readSubchunkData()
+} WavBroadcastExtension;
+const uint32_t BEXT_FIXED_SIZE = 602; //Fields before the coding history
+
+
+//One cue point, with its label from the LIST/adtl chunk if there is one
+typedef struct {
+    uint32_t cuePointId;
+    uint32_t frameIndex;             //dwSampleOffset: the frame the cue marks
+    char label[128];                 //NUL-terminated, truncated if longer; empty if unlabeled
+} WavCuePoint;
+
+
+//Find infoId (e.g. "INAM" title, "IART" artist, "ICMT" comment) in a LIST/INFO payload, which
+//starts with "INFO". Copies at most maxTextLength - 1 characters and a terminating NUL.
+bool wavParseInfoText(const uint8_t listData[],
+                      uint32_t listSize,
+                      bool bigEndian,
+                      const char infoId[4],
+                      char text[],
+                      uint32_t maxTextLength);
+
+//bextSize may be just BEXT_FIXED_SIZE; the coding history isn't looked at
+bool wavParseBroadcastExtension(const uint8_t bextData[],
+                                uint32_t bextSize,
+                                uint32_t subchunkSize, //Whole payload, to size the coding history
+                                bool bigEndian,
+                                WavBroadcastExtension *bext);
+
+//Number of cue points a cue payload declares (or fewer, if it's truncated). Only the first 4
+//bytes of cueData are looked at; cueSize is the whole payload's.
+uint32_t wavParseNumCuePoints(const uint8_t cueData[],
+                              uint32_t cueSize,
+                              bool bigEndian);
+
+//Cue points in file order, labels cleared; returns the number written to cuePoints
+uint32_t wavParseCuePoints(const uint8_t cueData[],
+                           uint32_t cueSize,
+                           bool bigEndian,
+                           WavCuePoint cuePoints[],
+                           uint32_t maxNumCuePoints);
+
+//Fill in labels from a LIST/adtl payload (starting with "adtl"), matching labl subchunks by cue point id
+void wavParseCueLabels(const uint8_t adtlData[],
+                       uint32_t adtlSize,
+                       bool bigEndian,
+                       WavCuePoint cuePoints[],
+                       uint32_t numCuePoints);
+
+
+//Reverse the byte order of a payload's multi-byte fields in place, to copy it between RIFF and
+//RIFX files; srcBigEndian is the order it's in now. Knows LIST (INFO and adtl), cue, bext and smpl,
+//and payloads that are only bytes or text (iXML, axml, inst, ID3, XMP, padding), which are left
+//as they are. False for any other subchunk: its layout is unknown, so it can't be converted.
+bool wavSwapSubchunkByteOrder(const char subchunkId[4],
+                              uint8_t subchunkData[],
+                              uint32_t subchunkSize,
+                              bool srcBigEndian);
+
+
+#endif //__WAV_METADATA_HPP__
@@ -0,0 +1,559 @@
+//WavOverview.cpp
+
+
+#include <cmath>
+#include <cstring> //memset()
+#include <cstdlib>
+#include <cstdio>
+#include <cfloat> //FLT_MAX
+
+#include "WavOverview.hpp"
+#include "WavSampleConverter.hpp"
+
+
+static const char *UNINITIALIZED_MSG = "Attempt to call WavOverview class method before calling build() or readFromFile().\n";
+
+static const uint32_t OVERVIEW_FILE_VERSION = 1;
+
+static const uint32_t DEFAULT_FRAMES_PER_BIN[] = {256, 4096, 65536};
+static const uint32_t DEFAULT_NUM_LEVELS = sizeof(DEFAULT_FRAMES_PER_BIN) / sizeof(uint32_t);
+
+static const float BIN_FULL_SCALE_AS_FLOAT32 = 32767.0f;
+
+static const uint32_t IO_BLOCK_NUM_BINS = 4096; //Bins packed or unpacked per fread()/fwrite()
+
+
+static int16_t quantizeToBin(float value) {
+    if (!(value == value)) { //NaN
+        return 0;
+    }
+    float scaled = value * BIN_FULL_SCALE_AS_FLOAT32;
+    if (scaled > BIN_FULL_SCALE_AS_FLOAT32) {
+        return 32767;
+    }
+    if (scaled < -BIN_FULL_SCALE_AS_FLOAT32) {
+        return -32767;
+    }
+    return (int16_t) lrintf(scaled);
+}
+
+
+//The sidecar is little-endian and packed on every host, so fields go through these
+//rather than fwrite()ing the structs
+static void putUint16(uint8_t *dest, uint16_t value) {
+    dest[0] = (uint8_t) value;
+    dest[1] = (uint8_t) (value >> 8);
+}
+
+
+static void putUint32(uint8_t *dest, uint32_t value) {
+    dest[0] = (uint8_t) value;
+    dest[1] = (uint8_t) (value >> 8);
+    dest[2] = (uint8_t) (value >> 16);
+    dest[3] = (uint8_t) (value >> 24);
+}
+
+
+static uint16_t getUint16(const uint8_t *src) {
+    return (uint16_t) (src[0] | (src[1] << 8));
+}
+
+
+static uint32_t getUint32(const uint8_t *src) {
+    return (uint32_t) src[0] | ((uint32_t) src[1] << 8) | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+}
+
+
+WavOverview::WavOverview() {
+    _numLevels = 0;
+    for (uint32_t i = 0; i < MAX_NUM_LEVELS; i++) {
+        _pBins[i] = nullptr;
+        _pAccumulators[i] = nullptr;
+    }
+    _initialized = false;
+}
+
+
+WavOverview::~WavOverview() {
+    freeLevels();
+}
+
+
+void WavOverview::freeLevels() {
+
+    for (uint32_t i = 0; i < MAX_NUM_LEVELS; i++) {
+        if (_pBins[i]) {
+            free(_pBins[i]);
+            _pBins[i] = nullptr;
+        }
+        if (_pAccumulators[i]) {
+            free(_pAccumulators[i]);
+            _pAccumulators[i] = nullptr;
+        }
+    }
+    _numLevels = 0;
+    _initialized = false;
+}
+
+
+bool WavOverview::allocateLevels(const uint32_t framesPerBin[], uint32_t numLevels) {
+
+    if (numLevels == 0 || numLevels > MAX_NUM_LEVELS) {
+        fprintf(stderr, "Error: Number of overview levels must be between 1 and %d.\n", MAX_NUM_LEVELS);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numLevels; i++) {
+        if (framesPerBin[i] == 0 || (i > 0 && framesPerBin[i] % framesPerBin[i - 1])) {
+            fprintf(stderr, "Error: Each level's frames-per-bin must be a multiple of the previous level's.\n");
+            return false;
+        }
+    }
+
+    freeLevels();
+
+    for (uint32_t i = 0; i < numLevels; i++) {
+        _framesPerBin[i] = framesPerBin[i];
+        _numBins[i] = (uint32_t) (((uint64_t) _numFrames + framesPerBin[i] - 1) / framesPerBin[i]);
+        _numBinsFilled[i] = 0;
+        _pBins[i] = (WavOverviewBin *) malloc(((size_t) _numBins[i] * _numChannels + 1) * sizeof(WavOverviewBin));
+        _pAccumulators[i] = (BinAccumulator *) malloc(_numChannels * sizeof(BinAccumulator));
+        if (!_pBins[i] || !_pAccumulators[i]) {
+            fprintf(stderr, "Error: Unable to allocate overview level.\n");
+            freeLevels();
+            return false;
+        }
+        resetAccumulators(_pAccumulators[i]);
+    }
+    _numLevels = numLevels;
+
+    return true;
+}
+
+
+void WavOverview::resetAccumulators(BinAccumulator acc[]) {
+
+    for (uint32_t ch = 0; ch < _numChannels; ch++) {
+        acc[ch].min = FLT_MAX;
+        acc[ch].max = -FLT_MAX;
+        acc[ch].sumSquares = 0.0;
+        acc[ch].numFrames = 0;
+    }
+}
+
+
+//Store a completed bin, then merge it into the next-coarser level
+void WavOverview::addBin(uint32_t level, const BinAccumulator acc[]) {
+
+    if (_numBinsFilled[level] < _numBins[level]) {
+        WavOverviewBin *bins = &_pBins[level][(size_t) _numBinsFilled[level] * _numChannels];
+        for (uint32_t ch = 0; ch < _numChannels; ch++) {
+            bins[ch].min = quantizeToBin(acc[ch].min);
+            bins[ch].max = quantizeToBin(acc[ch].max);
+            bins[ch].rms = (uint16_t) quantizeToBin((float) sqrt(acc[ch].sumSquares / acc[ch].numFrames));
+        }
+        _numBinsFilled[level]++;
+    }
+
+    if (level + 1 >= _numLevels) {
+        return;
+    }
+
+    BinAccumulator *next = _pAccumulators[level + 1];
+    for (uint32_t ch = 0; ch < _numChannels; ch++) {
+        next[ch].min = (acc[ch].min < next[ch].min) ? acc[ch].min : next[ch].min;
+        next[ch].max = (acc[ch].max > next[ch].max) ? acc[ch].max : next[ch].max;
+        next[ch].sumSquares += acc[ch].sumSquares;
+        next[ch].numFrames += acc[ch].numFrames;
+    }
+    if (next[0].numFrames >= _framesPerBin[level + 1]) {
+        addBin(level + 1, next);
+        resetAccumulators(next);
+    }
+}
+
+
+bool WavOverview::build(WavReader *wavReader) {
+    return build(wavReader, DEFAULT_FRAMES_PER_BIN, DEFAULT_NUM_LEVELS);
+}
+
+
+bool WavOverview::build(WavReader *wavReader,
+                        const uint32_t framesPerBin[],
+                        uint32_t numLevels) {
+
+    if (!wavReader) {
+        fprintf(stderr, "Error: WavReader is NULL.\n");
+        return false;
+    }
+
+    const WavSampleFormat format = wavReader->getSampleFormat();
+    if (format == WAV_SAMPLE_FORMAT_INVALID) {
+        fprintf(stderr, "Error: WavReader not initialized, or unsupported sample format.\n");
+        return false;
+    }
+
+    _numChannels = wavReader->getNumChannels();
+    _sampleRate = wavReader->getSampleRate();
+    _numFrames = wavReader->getNumSamples();
+
+    if (!allocateLevels(framesPerBin, numLevels)) {
+        return false;
+    }
+
+    if (!wavReader->prepareToRead()) {
+        fprintf(stderr, "Error: Problem preparing to read, while building overview.\n");
+        freeLevels();
+        return false;
+    }
+
+    const uint32_t frameSize = _numChannels * wavReader->getByteDepth();
+    uint8_t *sampleData = (uint8_t *) malloc(READ_BLOCK_NUM_FRAMES * frameSize);
+    float *floatSamples = (float *) malloc(READ_BLOCK_NUM_FRAMES * _numChannels * sizeof(float));
+    if (!sampleData || !floatSamples) {
+        fprintf(stderr, "Error: Unable to allocate overview read buffers.\n");
+        free(sampleData);
+        free(floatSamples);
+        wavReader->finishReading();
+        freeLevels();
+        return false;
+    }
+
+    BinAccumulator *acc = _pAccumulators[0];
+    const uint32_t framesPerFinestBin = _framesPerBin[0];
+    bool ok = true;
+    uint32_t frame = 0;
+    while (frame < _numFrames) {
+
+        const uint32_t numBlockFrames =
+                (_numFrames - frame < READ_BLOCK_NUM_FRAMES) ? _numFrames - frame : READ_BLOCK_NUM_FRAMES;
+        if (!wavReader->readData(sampleData, numBlockFrames * frameSize)) {
+            fprintf(stderr, "Error: Problem reading data, while building overview.\n");
+            ok = false;
+            break;
+        }
+        wavDecodeToFloats(sampleData, format, floatSamples, numBlockFrames * _numChannels);
+
+        uint32_t i = 0;
+        while (i < numBlockFrames) {
+            //Run to the end of the block or of the current finest bin, whichever comes first
+            uint32_t runFrames = framesPerFinestBin - acc[0].numFrames;
+            if (runFrames > numBlockFrames - i) {
+                runFrames = numBlockFrames - i;
+            }
+
+            for (uint32_t ch = 0; ch < _numChannels; ch++) {
+                const float *values = &floatSamples[i * _numChannels + ch];
+                float mn = acc[ch].min;
+                float mx = acc[ch].max;
+                double sumSquares = 0.0;
+                for (uint32_t j = 0; j < runFrames; j++) {
+                    float x = values[j * _numChannels];
+                    mn = (x < mn) ? x : mn;
+                    mx = (x > mx) ? x : mx;
+                    sumSquares += (double) x * x;
+                }
+                acc[ch].min = mn;
+                acc[ch].max = mx;
+                acc[ch].sumSquares += sumSquares;
+                acc[ch].numFrames += runFrames;
+            }
+            i += runFrames;
+
+            if (acc[0].numFrames == framesPerFinestBin) {
+                addBin(0, acc);
+                resetAccumulators(acc);
+            }
+        }
+
+        frame += numBlockFrames;
+    }
+
+    free(sampleData);
+    free(floatSamples);
+    wavReader->finishReading();
+
+    if (!ok) {
+        freeLevels();
+        return false;
+    }
+
+    //Flush partial bins at the tail, finest first so each cascades into the next
+    for (uint32_t level = 0; level < _numLevels; level++) {
+        if (_pAccumulators[level][0].numFrames > 0) {
+            addBin(level, _pAccumulators[level]);
+            resetAccumulators(_pAccumulators[level]);
+        }
+    }
+
+    _initialized = true;
+
+    return true;
+}
+
+
+bool WavOverview::writeToFile(const char *overviewFilePath) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    FILE *f = fopen(overviewFilePath, "wb");
+    if (!f) {
+        fprintf(stderr, "Error: Unable to open overview file for writing.\n");
+        return false;
+    }
+
+    uint8_t fh[WAV_OVERVIEW_FILE_HEADER_SIZE];
+    memcpy(fh, "WOVW", 4);
+    putUint32(fh + 4, OVERVIEW_FILE_VERSION);
+    putUint32(fh + 8, _numChannels);
+    putUint32(fh + 12, _sampleRate);
+    putUint32(fh + 16, _numFrames);
+    putUint32(fh + 20, _numLevels);
+    bool ok = fwrite(fh, WAV_OVERVIEW_FILE_HEADER_SIZE, 1, f) == 1;
+
+    for (uint32_t i = 0; ok && i < _numLevels; i++) {
+        uint8_t lh[WAV_OVERVIEW_LEVEL_HEADER_SIZE];
+        putUint32(lh, _framesPerBin[i]);
+        putUint32(lh + 4, _numBins[i]);
+        ok = fwrite(lh, WAV_OVERVIEW_LEVEL_HEADER_SIZE, 1, f) == 1;
+    }
+
+    uint8_t *packedBins = (uint8_t *) malloc(IO_BLOCK_NUM_BINS * WAV_OVERVIEW_BIN_SIZE);
+    if (!packedBins) {
+        ok = false;
+    }
+    for (uint32_t i = 0; ok && i < _numLevels; i++) {
+        const size_t numBinValues = (size_t) _numBins[i] * _numChannels;
+        for (size_t b = 0; ok && b < numBinValues; b += IO_BLOCK_NUM_BINS) {
+            const size_t numBlockBins = (numBinValues - b < IO_BLOCK_NUM_BINS) ? numBinValues - b : IO_BLOCK_NUM_BINS;
+            for (size_t j = 0; j < numBlockBins; j++) {
+                const WavOverviewBin *bin = &_pBins[i][b + j];
+                uint8_t *dest = &packedBins[j * WAV_OVERVIEW_BIN_SIZE];
+                putUint16(dest, (uint16_t) bin->min);
+                putUint16(dest + 2, (uint16_t) bin->max);
+                putUint16(dest + 4, bin->rms);
+            }
+            ok = fwrite(packedBins, WAV_OVERVIEW_BIN_SIZE, numBlockBins, f) == numBlockBins;
+        }
+    }
+    free(packedBins);
+
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Problem writing overview file.\n");
+    }
+
+    return ok;
+}
+
+
+bool WavOverview::readFromFile(const char *overviewFilePath) {
+
+    FILE *f = fopen(overviewFilePath, "rb");
+    if (!f) {
+        fprintf(stderr, "Error: Unable to open overview file for reading.\n");
+        return false;
+    }
+
+    uint8_t fh[WAV_OVERVIEW_FILE_HEADER_SIZE];
+    if (fread(fh, WAV_OVERVIEW_FILE_HEADER_SIZE, 1, f) != 1 ||
+        memcmp(fh, "WOVW", 4) ||
+        getUint32(fh + 4) != OVERVIEW_FILE_VERSION ||
+        getUint32(fh + 8) == 0 ||
+        getUint32(fh + 20) == 0 || getUint32(fh + 20) > MAX_NUM_LEVELS) {
+        fprintf(stderr, "Error: Not a valid overview file.\n");
+        fclose(f);
+        return false;
+    }
+    const uint32_t numLevels = getUint32(fh + 20);
+
+    uint32_t framesPerBin[MAX_NUM_LEVELS];
+    uint32_t numBins[MAX_NUM_LEVELS];
+    for (uint32_t i = 0; i < numLevels; i++) {
+        uint8_t lh[WAV_OVERVIEW_LEVEL_HEADER_SIZE];
+        if (fread(lh, WAV_OVERVIEW_LEVEL_HEADER_SIZE, 1, f) != 1) {
+            fprintf(stderr, "Error: Problem reading overview level header.\n");
+            fclose(f);
+            return false;
+        }
+        framesPerBin[i] = getUint32(lh);
+        numBins[i] = getUint32(lh + 4);
+    }
+
+    _numChannels = getUint32(fh + 8);
+    _sampleRate = getUint32(fh + 12);
+    _numFrames = getUint32(fh + 16);
+    if (!allocateLevels(framesPerBin, numLevels)) {
+        fclose(f);
+        return false;
+    }
+
+    uint8_t *packedBins = (uint8_t *) malloc(IO_BLOCK_NUM_BINS * WAV_OVERVIEW_BIN_SIZE);
+    bool ok = packedBins != nullptr;
+    for (uint32_t i = 0; ok && i < _numLevels; i++) {
+        const size_t numBinValues = (size_t) _numBins[i] * _numChannels;
+        ok = numBins[i] == _numBins[i];
+        for (size_t b = 0; ok && b < numBinValues; b += IO_BLOCK_NUM_BINS) {
+            const size_t numBlockBins = (numBinValues - b < IO_BLOCK_NUM_BINS) ? numBinValues - b : IO_BLOCK_NUM_BINS;
+            ok = fread(packedBins, WAV_OVERVIEW_BIN_SIZE, numBlockBins, f) == numBlockBins;
+            for (size_t j = 0; ok && j < numBlockBins; j++) {
+                WavOverviewBin *bin = &_pBins[i][b + j];
+                const uint8_t *src = &packedBins[j * WAV_OVERVIEW_BIN_SIZE];
+                bin->min = (int16_t) getUint16(src);
+                bin->max = (int16_t) getUint16(src + 2);
+                bin->rms = getUint16(src + 4);
+            }
+        }
+        _numBinsFilled[i] = _numBins[i];
+    }
+    free(packedBins);
+    if (!ok) {
+        fprintf(stderr, "Error: Problem reading overview bins.\n");
+        fclose(f);
+        freeLevels();
+        return false;
+    }
+
+    fclose(f);
+    _initialized = true;
+
+    return true;
+}
+
+
+bool WavOverview::query(uint32_t startFrame,
+                        uint32_t numFrames,
+                        uint32_t numPixels,
+                        WavOverviewPoint points[]) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (numPixels == 0 || numFrames == 0 || startFrame >= _numFrames) {
+        fprintf(stderr, "Error: Empty or out-of-range overview query.\n");
+        return false;
+    }
+
+    if (numFrames > _numFrames - startFrame) {
+        numFrames = _numFrames - startFrame;
+    }
+
+    //Coarsest level that still gives at least one bin per pixel
+    const double framesPerPixel = (double) numFrames / numPixels;
+    uint32_t level = 0;
+    while (level + 1 < _numLevels && _framesPerBin[level + 1] <= framesPerPixel) {
+        level++;
+    }
+
+    const uint32_t framesPerBin = _framesPerBin[level];
+    const WavOverviewBin *bins = _pBins[level];
+    for (uint32_t p = 0; p < numPixels; p++) {
+
+        uint64_t pixelStart = startFrame + ((uint64_t) numFrames * p) / numPixels;
+        uint64_t pixelEnd = startFrame + ((uint64_t) numFrames * (p + 1)) / numPixels;
+        uint32_t firstBin = (uint32_t) (pixelStart / framesPerBin);
+        uint32_t endBin = (uint32_t) ((pixelEnd + framesPerBin - 1) / framesPerBin);
+        if (endBin <= firstBin) {
+            endBin = firstBin + 1;
+        }
+        if (endBin > _numBins[level]) {
+            endBin = _numBins[level];
+        }
+
+        for (uint32_t ch = 0; ch < _numChannels; ch++) {
+            int32_t mn = 32767;
+            int32_t mx = -32767;
+            double sumSquares = 0.0;
+            for (uint32_t b = firstBin; b < endBin; b++) {
+                const WavOverviewBin *bin = &bins[(size_t) b * _numChannels + ch];
+                mn = (bin->min < mn) ? bin->min : mn;
+                mx = (bin->max > mx) ? bin->max : mx;
+                sumSquares += (double) bin->rms * bin->rms;
+            }
+            WavOverviewPoint *point = &points[p * _numChannels + ch];
+            point->min = mn / BIN_FULL_SCALE_AS_FLOAT32;
+            point->max = mx / BIN_FULL_SCALE_AS_FLOAT32;
+            point->rms = (float) (sqrt(sumSquares / (endBin - firstBin)) / BIN_FULL_SCALE_AS_FLOAT32);
+        }
+    }
+
+    return true;
+}
+
+
+
+//Accessors
+
+
+
+uint32_t WavOverview::getNumChannels() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _numChannels;
+}
+
+
+uint32_t WavOverview::getSampleRate() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _sampleRate;
+}
+
+
+uint32_t WavOverview::getNumFrames() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _numFrames;
+}
+
+
+uint32_t WavOverview::getNumLevels() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _numLevels;
+}
+
+
+uint32_t WavOverview::getFramesPerBin(uint32_t level) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return (level < _numLevels) ? _framesPerBin[level] : 0;
+}
+
+
+uint32_t WavOverview::getNumBins(uint32_t level) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return (level < _numLevels) ? _numBins[level] : 0;
+}
@@ -0,0 +1,129 @@
+//WavOverview.hpp
+
+#ifndef __WAV_OVERVIEW_HPP__
+#define __WAV_OVERVIEW_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavReader.hpp"
+
+
+//Multi-resolution min/max/RMS summary of a wav file, for drawing waveforms at any zoom
+//level without touching the audio. Built in one streaming pass; saved as a binary sidecar.
+//
+//Sidecar layout, each field little-endian and packed whatever the host:
+//  WavOverviewFileHeader
+//  WavOverviewLevelHeader x numLevels
+//  WavOverviewBin x (numBins * numChannels), for each level in turn; channels interleaved
+//The *_SIZE constants are the on-disk sizes.
+
+
+typedef struct {
+    char fileId[4];          //"WOVW"
+    uint32_t version;
+    uint32_t numChannels;
+    uint32_t sampleRate;
+    uint32_t numFrames;
+    uint32_t numLevels;
+} WavOverviewFileHeader;
+const uint32_t WAV_OVERVIEW_FILE_HEADER_SIZE = 24;
+
+
+typedef struct {
+    uint32_t framesPerBin;
+    uint32_t numBins;
+} WavOverviewLevelHeader;
+const uint32_t WAV_OVERVIEW_LEVEL_HEADER_SIZE = 8;
+
+
+//One channel of one bin, quantized to 16 bits; full scale is +/-32767
+typedef struct {
+    int16_t min;
+    int16_t max;
+    uint16_t rms;
+} WavOverviewBin;
+const uint32_t WAV_OVERVIEW_BIN_SIZE = 6;
+
+
+//Query result for one channel of one pixel; full scale is [-1.0, 1.0]
+typedef struct {
+    float min;
+    float max;
+    float rms;
+} WavOverviewPoint;
+
+
+class WavOverview {
+
+public:
+
+    WavOverview();
+
+    ~ WavOverview();
+
+    //Build with the default pyramid of 256, 4096 and 65536 frames per bin
+    bool build(WavReader *wavReader);
+
+    //Each level's framesPerBin must be a multiple of the previous level's
+    bool build(WavReader *wavReader,
+               const uint32_t framesPerBin[],
+               uint32_t numLevels);
+
+    bool writeToFile(const char *overviewFilePath);
+
+    bool readFromFile(const char *overviewFilePath);
+
+    //Summarize frames [startFrame, startFrame + numFrames) into numPixels columns.
+    //points holds numPixels * numChannels entries, channels interleaved.
+    bool query(uint32_t startFrame,
+               uint32_t numFrames,
+               uint32_t numPixels,
+               WavOverviewPoint points[]);
+
+    uint32_t getNumChannels();
+
+    uint32_t getSampleRate();
+
+    uint32_t getNumFrames();
+
+    uint32_t getNumLevels();
+
+    uint32_t getFramesPerBin(uint32_t level);
+
+    uint32_t getNumBins(uint32_t level);
+
+
+private:
+
+    typedef struct {
+        float min;
+        float max;
+        double sumSquares;
+        uint32_t numFrames;
+    } BinAccumulator;
+
+    bool allocateLevels(const uint32_t framesPerBin[], uint32_t numLevels);
+
+    void freeLevels();
+
+    void addBin(uint32_t level, const BinAccumulator acc[]); //One accumulator per channel
+
+    void resetAccumulators(BinAccumulator acc[]);
+
+    static const uint32_t MAX_NUM_LEVELS = 8;
+    static const uint32_t READ_BLOCK_NUM_FRAMES = 4096;
+
+    uint32_t _numChannels;
+    uint32_t _sampleRate;
+    uint32_t _numFrames;
+    uint32_t _numLevels;
+    uint32_t _framesPerBin[MAX_NUM_LEVELS];
+    uint32_t _numBins[MAX_NUM_LEVELS];
+    uint32_t _numBinsFilled[MAX_NUM_LEVELS];
+    WavOverviewBin *_pBins[MAX_NUM_LEVELS];
+    BinAccumulator *_pAccumulators[MAX_NUM_LEVELS]; //numChannels per level; used while building
+    bool _initialized;
+};
+
+
+#endif //__WAV_OVERVIEW_HPP__
@@ -6,6 +6,10 @@
 #include <cstdio>
 
 #include "WavReader.hpp"
+#include "WavFileIo.hpp"
+#include "WavImaAdpcm.hpp"
+#include "WavSampleConverter.hpp"
+#include "WavTrace.hpp"
 
 
 static const uint16_t TWO_POW_7_AS_UINT16 = 128;
@@ -18,38 +22,78 @@ static const double TWO_POW_15_LESS1_AS_FLOAT64 = 32768.0 - 1.0;
 
 static const uint32_t TWO_POW_16_AS_UINT32 = 65536;
 
+static const uint64_t MAX_UINT32 = 4294967295;
+
+static const uint32_t INT16_READ_BLOCK_SIZE = 4096; //Max bytes read per pass in readDataToInt16s()
+static const uint32_t PLANAR_READ_BLOCK_SIZE = 16384; //Max bytes read per pass in readFramesPlanar()
+static const uint32_t INITIAL_SUBCHUNK_CAPACITY = 16;
+
 
 static const char *UNINITIALIZED_MSG = "Attempt to call WavReader class method before calling initialize().\n";
 
 
 WavReader::WavReader() {
+    readFile = nullptr;
+    _pSignalStats = nullptr;
+    _bigEndian = false;
+    _pImaAdpcmBlock = nullptr;
+    _pImaAdpcmFrames = nullptr;
+    _pSubchunks = nullptr;
+    _numSubchunks = 0;
+    _subchunkCapacity = 0;
+    _pAsyncEngine = nullptr;
     _initialized = false;
 }
 
 
 WavReader::~WavReader() {
+    if (readFile) {
+        fclose(readFile);
+        readFile = nullptr;
+    }
+    freeImaAdpcmBuffers();
+    free(_pSubchunks);
+    _pSubchunks = nullptr;
+}
+
+
+void WavReader::freeImaAdpcmBuffers() {
+    free(_pImaAdpcmBlock);
+    _pImaAdpcmBlock = nullptr;
+    free(_pImaAdpcmFrames);
+    _pImaAdpcmFrames = nullptr;
 }
 
 
 bool WavReader::initialize(const char *readFilePath) {
 
-    //Test for file existence...
-    FILE *f = fopen(readFilePath, "r");
+    //Open once; readMetadata() and later reads carry on with this handle
+    FILE *f = fopen(readFilePath, "rb");
     if (!f) {
         fprintf(stderr, "File: %s doesn't exist.\n", readFilePath);
         return false;
     }
-    fclose(f);
+    _counters.addOpen();
 
-    //Set member vars
+    //Re-initializing; don't leak the previous file's handle
+    if (readFile) {
+        fclose(readFile);
+    }
+    readFile = f;
 
     this->_pReadFilePath = (char *) readFilePath;
-    this->readFile = nullptr;
+    freeImaAdpcmBuffers();
 
     this->_initialized = true; //Set *before* call to readMetadata()
     bool verifies = readMetadata(); //Sets remaining member variables
     this->_initialized = verifies; //Update *after* call to readMetadata()
 
+    //Not every failure path in readMetadata() closes the file
+    if (!verifies && readFile) {
+        fclose(readFile);
+        readFile = nullptr;
+    }
+
     return verifies;
 }
 
@@ -61,6 +105,8 @@ bool WavReader::openFile() {
         return false;
     }
 
+    WAV_TRACE_SCOPE("WavReader::openFile");
+
     if (!readFile) {
         readFile = fopen(_pReadFilePath, "rb");
         if (readFile == NULL) {
@@ -68,8 +114,10 @@ bool WavReader::openFile() {
             readFile = nullptr;
             return false;
         }
+        _counters.addOpen();
     } else {
         rewind(readFile);
+        _counters.addSeek();
     }
 
     return true;
@@ -107,73 +155,110 @@ bool WavReader::closeFile(const char *errorMessage) {
 }
 
 
-bool WavReader::findSubchunk(const char *subchunkId, uint32_t *subchunkSize) {
+//Record where every subchunk is, reading only the headers (and each LIST's type). Stops at the end
+//of the file, at bytes that can't be a subchunk header, or after a data subchunk whose size is unset
+//or runs past the end, as in an unfinalized recording, whose samples run to the end of the file.
+bool WavReader::walkSubchunks() {
 
-    if (!_initialized) {
-        fprintf(stderr, "%s", UNINITIALIZED_MSG);
-        return false;
-    }
+    WAV_TRACE_SCOPE("WavReader::walkSubchunks");
 
-    if (!openFile()) {
-        return false;
-    }
+    _numSubchunks = 0;
 
-    //Skip over RIFF header
-    if (fseek(readFile, RIFF_HEADER_SIZE, SEEK_CUR)) {
-        closeFile("Error: Problem while skipping over RIFF header.\n");
+    //fstat() and positional reads, so files past 2 GB parse where long is 32 bits
+    uint64_t fileSize = 0;
+    if (!wavGetFileSize(readFile, &fileSize)) {
+        closeFile("Error: Problem finding the file size.");
         return false;
     }
 
-    while (true) {
+    uint64_t offset = RIFF_HEADER_SIZE;
+    while (offset + SUBCHUNK_HEADER_SIZE <= fileSize && offset + SUBCHUNK_HEADER_SIZE <= MAX_UINT32) {
 
-        size_t numToRead = 1;
-        size_t numRead = 0;
-        uint8_t subchunkHeaderData[SUBCHUNK_HEADER_SIZE];
-        numRead = fread(subchunkHeaderData, SUBCHUNK_HEADER_SIZE, 1, readFile);
-        if (numRead < numToRead) {
-            if (feof(readFile)) {
-                fprintf(stderr, "Error: Reached end of file without finding subchunk: %s\n", subchunkId);
-                closeFile();
-                return false;
-            }
-            fprintf(stderr, "Error: Problem reading subchunk: %s\n", subchunkId);
-            closeFile();
+        uint8_t subchunkHeaderData[SUBCHUNK_HEADER_SIZE + 4]; //And a LIST's type
+        const uint32_t numToRead = (offset + sizeof(subchunkHeaderData) <= fileSize) ?
+                                   sizeof(subchunkHeaderData) : SUBCHUNK_HEADER_SIZE;
+        uint64_t startNanos = WavCounters::now();
+        if (!wavReadAt(readFile, offset, subchunkHeaderData, numToRead)) {
+            closeFile("Error: Problem reading subchunk header.");
             return false;
         }
+        _counters.addRead(numToRead, startNanos);
 
         SubchunkHeader *sch = (SubchunkHeader *) subchunkHeaderData;
-        bool subchunkFound = !strncmp(sch->subchunkId, subchunkId, 4);
-        if (subchunkFound) {
-            //Set size to pass back
-            *subchunkSize = sch->subchunkSize;
-            //Rewind to the beginning of the subchunk, i.e. including the header
-            if (fseek(readFile, -(int) SUBCHUNK_HEADER_SIZE, SEEK_CUR)) {
-                fprintf(stderr, "Error: Problem advancing to subchunk: %s\n", subchunkId);
-                closeFile();
-                return false;
-            }
-            return true;
+        bool isSubchunkId = true;
+        for (uint32_t i = 0; i < 4; i++) {
+            isSubchunkId = isSubchunkId && sch->subchunkId[i] >= ' ' && sch->subchunkId[i] <= '~';
+        }
+        if (!isSubchunkId) {
+            break; //Trailing junk
         }
 
-        //Subchunk not found; advance to next subchunk
-        if (fseek(readFile, sch->subchunkSize, SEEK_CUR)) {
-            if (feof(readFile)) {
-                fprintf(stderr, "Error: End of file reached without finding subchunk: %s\n", subchunkId);
-                closeFile();
-                return false;
-            } else {
-                closeFile("Error: Problem while advancing to the next subchunk");
-                return false;
-            }
+        WavSubchunkInfo info;
+        memcpy(info.subchunkId, sch->subchunkId, 4);
+        memset(info.listType, 0, 4);
+        info.dataOffset = (uint32_t) (offset + SUBCHUNK_HEADER_SIZE);
+        info.dataSize = wavByteOrder32(sch->subchunkSize, _bigEndian);
+        const uint64_t endOfSubchunk = offset + SUBCHUNK_HEADER_SIZE + info.dataSize;
+        const bool isData = !strncmp(info.subchunkId, "data", 4);
+
+        if (endOfSubchunk > fileSize && !isData) {
+            break; //Truncated; not worth offering
+        }
+        if (!strncmp(info.subchunkId, "LIST", 4) && info.dataSize >= 4) {
+            memcpy(info.listType, subchunkHeaderData + SUBCHUNK_HEADER_SIZE, 4);
         }
+        if (!addSubchunkInfo(&info)) {
+            closeFile();
+            return false;
+        }
+
+        if (isData && (info.dataSize == 0 || endOfSubchunk > fileSize)) {
+            break;
+        }
+        offset = endOfSubchunk + (info.dataSize & 1); //RIFF pads odd-sized subchunks to an even length
     }
 
-    return false;
+    return true;
+}
+
+
+bool WavReader::addSubchunkInfo(const WavSubchunkInfo *subchunkInfo) {
+
+    if (_numSubchunks == _subchunkCapacity) {
+        const uint32_t capacity = _subchunkCapacity ? 2 * _subchunkCapacity : INITIAL_SUBCHUNK_CAPACITY;
+        WavSubchunkInfo *subchunks = (WavSubchunkInfo *) realloc(_pSubchunks, capacity * sizeof(WavSubchunkInfo));
+        if (!subchunks) {
+            fprintf(stderr, "Error: Unable to allocate subchunk table.\n");
+            return false;
+        }
+        _pSubchunks = subchunks;
+        _subchunkCapacity = capacity;
+    }
+
+    _pSubchunks[_numSubchunks++] = *subchunkInfo;
+
+    return true;
+}
+
+
+const WavSubchunkInfo *WavReader::lookUpSubchunk(const char subchunkId[4],
+                                                 const char listType[4]) {
+
+    for (uint32_t i = 0; i < _numSubchunks; i++) {
+        const WavSubchunkInfo *info = &_pSubchunks[i];
+        if (!strncmp(info->subchunkId, subchunkId, 4) && (!listType || !strncmp(info->listType, listType, 4))) {
+            return info;
+        }
+    }
+
+    return nullptr;
 }
 
 
 bool WavReader::readMetadata() {
 
+    WAV_TRACE_SCOPE("WavReader::readMetadata");
+
 //    if (!_initialized) {
 //        fprintf(stderr, "%s", UNINITIALIZED_MSG);
 //        return false;
@@ -188,32 +273,50 @@ bool WavReader::readMetadata() {
     uint8_t riffHeaderData[RIFF_HEADER_SIZE];
     size_t numToRead = 1;
     size_t numRead = 0;
+    uint64_t startNanos = WavCounters::now();
     numRead = fread(riffHeaderData, RIFF_HEADER_SIZE, 1, readFile);
+    _counters.addRead(numRead * RIFF_HEADER_SIZE, startNanos);
     if (numRead < numToRead) {
         closeFile("Error: Problem reading RIFF header.");
         return false;
     }
     RiffHeader *rh = (RiffHeader *) riffHeaderData;
-    if (strncmp(rh->chunkId, "RIFF", 4)) {
+    if (!strncmp(rh->chunkId, "RIFF", 4)) {
+        _bigEndian = false;
+    } else if (!strncmp(rh->chunkId, "RIFX", 4)) {
+        _bigEndian = true;
+    } else {
         closeFile("Error: RIFF header not included at start.");
         return false;
     }
 
+    if (!walkSubchunks()) {
+        return false;
+    }
+
     //Read format subchunk
-    uint32_t subchunkSize = 0;
-    if (!findSubchunk("fmt ", &subchunkSize)) {
+    const WavSubchunkInfo *formatInfo = lookUpSubchunk("fmt ", nullptr);
+    if (!formatInfo) {
         closeFile("Error: Unable find 'fmt ' subchunk.");
         return false;
     }
+    _counters.addSeek();
+    if (!wavSeekFile(readFile, formatInfo->dataOffset - SUBCHUNK_HEADER_SIZE)) {
+        closeFile("Error: Problem advancing to format subchunk.");
+        return false;
+    }
     uint8_t formatSubchunkData[FORMAT_SUBCHUNK_SIZE];
     numToRead = 1;
     numRead = 0;
+    startNanos = WavCounters::now();
     numRead = fread(formatSubchunkData, FORMAT_SUBCHUNK_SIZE, 1, readFile);
+    _counters.addRead(numRead * FORMAT_SUBCHUNK_SIZE, startNanos);
     if (numRead < numToRead) {
         closeFile("Error: Problem reading format subchunk.");
         return false;
     }
     FormatSubchunk *fsc = (FormatSubchunk *) formatSubchunkData;
+    wavByteOrderFormatSubchunk(fsc, _bigEndian);
 
     //Parse format subchunk
     if (strncmp(fsc->formatSubchunkId, "fmt ", 4)) {
@@ -221,14 +324,20 @@ bool WavReader::readMetadata() {
         return false;
     }
 
-    if (fsc->audioFormat == AUDIO_FORMAT_INT) {
+    if (fsc->audioFormat == AUDIO_FORMAT_INT ||
+        fsc->audioFormat == AUDIO_FORMAT_ALAW ||
+        fsc->audioFormat == AUDIO_FORMAT_MULAW ||
+        fsc->audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
         _samplesAreInts = true;
     } else if (fsc->audioFormat == AUDIO_FORMAT_FLOAT) {
         _samplesAreInts = false;
     } else {
-        closeFile("Error: Audio format must be WAVE_FORMAT_PCM or WAVE_FORMAT_IEEE_FLOAT.");
+        closeFile("Error: Audio format must be WAVE_FORMAT_PCM, WAVE_FORMAT_IEEE_FLOAT, WAVE_FORMAT_ALAW, WAVE_FORMAT_MULAW or WAVE_FORMAT_IMA_ADPCM.");
         return false;
     }
+    _audioFormat = fsc->audioFormat;
+    _blockAlign = fsc->blockAlign;
+    _framesPerBlock = 1;
 
     _numChannels = fsc->numChannels;
     if (!(_numChannels == 1 || _numChannels == 2)) {
@@ -242,6 +351,14 @@ bool WavReader::readMetadata() {
         return false;
     }
 
+    if (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        if (_bigEndian) {
+            closeFile("Error: IMA ADPCM is only supported in RIFF (little-endian) files.");
+            return false;
+        }
+        return readImaAdpcmFormat(fsc);
+    }
+
     _byteDepth = fsc->bitsPerSample / 8;
     if (!((_samplesAreInts && (_byteDepth == 1 || _byteDepth == 2 || _byteDepth == 3 || _byteDepth == 4)) ||
           (!_samplesAreInts && (_byteDepth == 4 || _byteDepth == 8)))) {
@@ -250,12 +367,19 @@ bool WavReader::readMetadata() {
         return false;
     }
 
-    subchunkSize = 0;
-    if (!findSubchunk("data", &subchunkSize)) {
+    _sampleFormat = wavSampleFormatFromAudioFormat(fsc->audioFormat, _byteDepth);
+    if (_sampleFormat == WAV_SAMPLE_FORMAT_INVALID) {
+        closeFile("Error: A-law and mu-law samples must be 8 bits.");
+        return false;
+    }
+
+    const WavSubchunkInfo *dataInfo = lookUpSubchunk("data", nullptr);
+    if (!dataInfo) {
         closeFile("Error: Data subchunk not found.");
         return false;
     }
-    _sampleDataSize = subchunkSize;
+    _sampleDataSize = dataInfo->dataSize;
+    _dataOffset = dataInfo->dataOffset;
 
     if (fsc->blockAlign != _numChannels * _byteDepth) {
         closeFile("Error: block alignment doesn't match number of channels + bit depth.");
@@ -263,6 +387,73 @@ bool WavReader::readMetadata() {
     }
 
     _numSamples = _sampleDataSize / fsc->blockAlign;
+    _encodedDataSize = _sampleDataSize;
+
+    return true;
+}
+
+
+//Rest of readMetadata() for IMA ADPCM; the file is positioned just past the format subchunk's PCM fields
+bool WavReader::readImaAdpcmFormat(const FormatSubchunk *fsc) {
+
+    ImaAdpcmFormatExtension extension;
+    uint64_t startNanos = WavCounters::now();
+    if (fsc->bitsPerSample != 4 ||
+        fsc->formatSubchunkSize < FORMAT_SUBCHUNK_SIZE - SUBCHUNK_HEADER_SIZE + IMA_ADPCM_FORMAT_EXTENSION_SIZE ||
+        fread(&extension, IMA_ADPCM_FORMAT_EXTENSION_SIZE, 1, readFile) < 1) {
+        closeFile("Error: Invalid IMA ADPCM format subchunk.");
+        return false;
+    }
+    _counters.addRead(IMA_ADPCM_FORMAT_EXTENSION_SIZE, startNanos);
+
+    _framesPerBlock = wavImaAdpcmFramesPerBlock(_blockAlign, _numChannels);
+    if (_framesPerBlock == 0 || extension.framesPerBlock != _framesPerBlock) {
+        closeFile("Error: IMA ADPCM block size doesn't match its frames per block.");
+        return false;
+    }
+
+    //Decoded on the fly; to everything downstream the file is 16-bit PCM
+    _byteDepth = 2;
+    _sampleFormat = WAV_SAMPLE_FORMAT_INT16;
+
+    const WavSubchunkInfo *dataInfo = lookUpSubchunk("data", nullptr);
+    if (!dataInfo) {
+        closeFile("Error: Data subchunk not found.");
+        return false;
+    }
+    _encodedDataSize = dataInfo->dataSize;
+    _dataOffset = dataInfo->dataOffset;
+
+    //Whole blocks, plus the whole 8-frame groups of a short last block
+    const uint32_t channelsHeaderSize = 4 * _numChannels;
+    const uint32_t lastBlockSize = _encodedDataSize % _blockAlign;
+    uint64_t numFrames = (uint64_t) (_encodedDataSize / _blockAlign) * _framesPerBlock;
+    if (lastBlockSize >= channelsHeaderSize) {
+        numFrames += 1 + (lastBlockSize - channelsHeaderSize) / channelsHeaderSize * 8;
+    }
+
+    //The fact subchunk has the exact count, excluding the padding in the last block
+    const WavSubchunkInfo *factInfo = lookUpSubchunk("fact", nullptr);
+    uint32_t numSamplesPerChannel = 0;
+    if (factInfo && factInfo->dataSize >= sizeof(uint32_t) &&
+        readAt(factInfo->dataOffset, &numSamplesPerChannel, sizeof(uint32_t)) && numSamplesPerChannel < numFrames) {
+        numFrames = numSamplesPerChannel;
+    }
+
+    if (numFrames * _numChannels * _byteDepth > MAX_UINT32) {
+        closeFile("Error: Decoded IMA ADPCM data would exceed the 4GB wav limit.");
+        return false;
+    }
+    _numSamples = (uint32_t) numFrames;
+    _sampleDataSize = _numSamples * _numChannels * _byteDepth;
+
+    _pImaAdpcmBlock = (uint8_t *) malloc(_blockAlign);
+    _pImaAdpcmFrames = (int16_t *) malloc((size_t) _framesPerBlock * _numChannels * sizeof(int16_t));
+    if (!_pImaAdpcmBlock || !_pImaAdpcmFrames) {
+        freeImaAdpcmBuffers();
+        closeFile("Error: Unable to allocate IMA ADPCM buffers.");
+        return false;
+    }
 
     return true;
 }
@@ -278,25 +469,126 @@ bool WavReader::prepareToRead() {
         return false;
     }
 
-    //Open file
-    if (!openFile()) {
+    WAV_TRACE_SCOPE("WavReader::prepareToRead");
+
+    //Open file, unless it's still open from initialize() or an earlier read
+    if (!readFile && !openFile()) {
         closeFile("Error: Unable to open file, while preparing to read data.");
         return false;
     }
 
-    //Find data subchunk
-    uint32_t subchunkSize = 0;
-    if (!findSubchunk("data", &subchunkSize)) {
-        closeFile("Error: Unable to find data subchunk, while preparing to read data.");
+    //Straight to the sample data; the header walk already found it
+    _counters.addSeek();
+    if (!wavSeekFile(readFile, _dataOffset)) {
+        closeFile("Error: Unable to advance to the sample data.\n");
+        return false;
+    }
+
+    _numImaAdpcmFrames = 0;
+    _imaAdpcmFrameIndex = 0;
+    _nextBlockIndex = 0;
+
+    return true;
+}
+
+
+bool WavReader::seekToFrame(uint32_t frameIndex) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
         return false;
     }
 
-    //Advance past data subchunk header, to the sample data
-    if (fseek(readFile, SUBCHUNK_HEADER_SIZE, SEEK_CUR)) {
-        closeFile("Error: Unable to advance past data subchunk header.\n");
+    if (!readFile) {
+        fprintf(stderr, "Error: Call prepareToRead() before seekToFrame().\n");
         return false;
     }
 
+    if (frameIndex > _numSamples) {
+        fprintf(stderr, "Error: Frame index is past the end of the sample data.\n");
+        return false;
+    }
+
+    //For PCM a block is one frame
+    const uint32_t blockIndex = frameIndex / _framesPerBlock;
+    _counters.addSeek();
+    if (!wavSeekFile(readFile, _dataOffset + (uint64_t) blockIndex * _blockAlign)) {
+        closeFile("Error: Unable to seek to frame.");
+        return false;
+    }
+
+    if (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        _nextBlockIndex = blockIndex;
+        _numImaAdpcmFrames = 0;
+        _imaAdpcmFrameIndex = 0;
+        const uint32_t frameInBlock = frameIndex % _framesPerBlock;
+        if (frameInBlock > 0) {
+            if (!decodeNextImaAdpcmBlock()) {
+                return false;
+            }
+            _imaAdpcmFrameIndex = frameInBlock;
+        }
+    }
+
+    return true;
+}
+
+
+//Read and decode the block at _nextBlockIndex; the file is positioned at its start
+bool WavReader::decodeNextImaAdpcmBlock() {
+
+    const uint64_t blockOffset = (uint64_t) _nextBlockIndex * _blockAlign;
+    if (blockOffset >= _encodedDataSize) {
+        closeFile("Error: Reached end of IMA ADPCM data.");
+        return false;
+    }
+    const uint32_t blockSize = (_encodedDataSize - blockOffset < _blockAlign) ?
+                               (uint32_t) (_encodedDataSize - blockOffset) : _blockAlign;
+
+    uint64_t startNanos = WavCounters::now();
+    size_t numRead = fread(_pImaAdpcmBlock, 1, blockSize, readFile);
+    _counters.addRead(numRead, startNanos);
+    if (numRead < blockSize) {
+        closeFile("Error: Problem reading IMA ADPCM block.");
+        return false;
+    }
+
+    WAV_TRACE_SCOPE_BYTES("WavReader::decodeImaAdpcm", blockSize);
+    startNanos = WavCounters::now();
+    uint32_t numFrames = 0;
+    if (!wavImaAdpcmDecodeBlock(_pImaAdpcmBlock, blockSize, _numChannels, _pImaAdpcmFrames, &numFrames)) {
+        closeFile("Error: Problem decoding IMA ADPCM block.");
+        return false;
+    }
+    _counters.addConversion(numFrames, startNanos);
+
+    _numImaAdpcmFrames = numFrames;
+    _imaAdpcmFrameIndex = 0;
+    _nextBlockIndex++;
+
+    return true;
+}
+
+
+//Hand out decoded frames, decoding a block whenever the last one runs out
+bool WavReader::readImaAdpcmFrames(uint8_t sampleData[],
+                                   uint32_t numFrames) {
+
+    const uint32_t frameSize = _numChannels * sizeof(int16_t);
+    uint32_t numDone = 0;
+    while (numDone < numFrames) {
+        if (_imaAdpcmFrameIndex == _numImaAdpcmFrames && !decodeNextImaAdpcmBlock()) {
+            return false;
+        }
+        const uint32_t numAvailable = _numImaAdpcmFrames - _imaAdpcmFrameIndex;
+        const uint32_t n = (numFrames - numDone < numAvailable) ? numFrames - numDone : numAvailable;
+        memcpy(sampleData + (uint64_t) numDone * frameSize,
+               _pImaAdpcmFrames + (uint64_t) _imaAdpcmFrameIndex * _numChannels,
+               (size_t) n * frameSize);
+        _imaAdpcmFrameIndex += n;
+        numDone += n;
+    }
+
     return true;
 }
 
@@ -310,32 +602,72 @@ bool WavReader::readData(uint8_t sampleData[],
         return false;
     }
 
+    WAV_TRACE_SCOPE_BYTES("WavReader::readData", sampleDataSize);
+
     if (this->_sampleDataSize < sampleDataSize) {
         closeFile("Error: Suppled _sampleDataSize larger than available data");
         return false;
     }
 
-    if (_sampleDataSize % (_byteDepth * _numChannels) > 0) {
+    if (sampleDataSize % (_byteDepth * _numChannels) > 0) {
         closeFile("Error: Suppled _sampleDataSize doesn't fall evenly on a sample boundary.");
         return false;
     }
 
-    size_t numToRead = 1;
-    size_t numRead = 0;
-    numRead = fread((char *) sampleData, 1, _sampleDataSize, readFile);
-    if (numRead < numToRead) {
-        if (feof(readFile)) {
-            closeFile("Error: Reached end of file while reading data");
+    if (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        if (!readImaAdpcmFrames(sampleData, sampleDataSize / (_byteDepth * _numChannels))) {
             return false;
         }
-        closeFile("Error: Problem reading data");
-        return false;
+    } else {
+        size_t numToRead = sampleDataSize;
+        size_t numRead = 0;
+        uint64_t startNanos = WavCounters::now();
+        numRead = fread((char *) sampleData, 1, sampleDataSize, readFile);
+        _counters.addRead(numRead, startNanos);
+        if (numRead < numToRead) {
+            if (feof(readFile)) {
+                closeFile("Error: Reached end of file while reading data");
+                return false;
+            }
+            closeFile("Error: Problem reading data");
+            return false;
+        }
+        //RIFX: swap in place while the block is in cache, ahead of any conversion that reads it
+        if (_bigEndian) {
+            wavSwapSampleBytes(sampleData, _sampleFormat, sampleData, sampleDataSize / _byteDepth);
+        }
+    }
+
+    //Fold into statistics while the bytes are still in cache
+    if (_pSignalStats) {
+        _pSignalStats->accumulate(sampleData, sampleDataSize);
     }
 
     return true;
 }
 
 
+bool WavReader::readData(WavBufferBlock *block,
+                         uint32_t sampleDataSize) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (!block || sampleDataSize > block->getCapacity()) {
+        fprintf(stderr, "Error: Sample data doesn't fit in the supplied block.\n");
+        return false;
+    }
+
+    if (!readData(block->getData(), sampleDataSize)) {
+        return false;
+    }
+
+    return block->setSize(sampleDataSize);
+}
+
+
 //Presumes a file opened for binary reading, with file pointer at first byte of sample data
 bool WavReader::readDataToInt16s(int16_t int16Samples[], //channels interleaved; length = numInt16Samples * numChannels
                                  const uint32_t numInt16Samples) {
@@ -351,27 +683,126 @@ bool WavReader::readDataToInt16s(int16_t int16Samples[], //channels interleaved;
         return false;
     }
 
+    //Read a block of frames at a time, converting each block while it's in cache
+    const uint32_t frameSize = _numChannels * _byteDepth;
+    const uint32_t framesPerBlock = INT16_READ_BLOCK_SIZE / frameSize;
+    const bool isCompanded = _sampleFormat == WAV_SAMPLE_FORMAT_ALAW || _sampleFormat == WAV_SAMPLE_FORMAT_MULAW;
+    uint8_t sampleBytes[INT16_READ_BLOCK_SIZE];
     int16_t sampleCh1 = 0;
     int16_t sampleCh2 = 0;
-    const uint32_t numBytes = (_numChannels * _byteDepth);
-    uint8_t sampleBytes[numBytes];
-    for (uint32_t i = 0; i < numInt16Samples; i++) {
-        readData(sampleBytes, numBytes);
-        readInt16SampleFromArray(sampleBytes,
-                                 numBytes,
-                                 0, //sampleIndex
-                                 sampleCh1,
-                                 sampleCh2);
-        int16Samples[i * _numChannels] = sampleCh1;
-        if (_numChannels == 2) {
-            int16Samples[i * _numChannels + 1] = sampleCh2;
+    uint32_t i = 0;
+    while (i < numInt16Samples) {
+        const uint32_t numFrames = (numInt16Samples - i < framesPerBlock) ? numInt16Samples - i : framesPerBlock;
+        if (!readData(sampleBytes, numFrames * frameSize)) {
+            return false;
+        }
+        WAV_TRACE_SCOPE_BYTES("WavReader::convertToInt16s", numFrames * frameSize);
+        uint64_t startNanos = WavCounters::now();
+        if (isCompanded) {
+            //Table lookup for the whole block
+            wavConvertSamples(sampleBytes, _sampleFormat,
+                              (uint8_t *) (int16Samples + i * _numChannels), WAV_SAMPLE_FORMAT_INT16,
+                              numFrames * _numChannels);
+            i += numFrames;
+            _counters.addConversion(numFrames, startNanos);
+            continue;
+        }
+        for (uint32_t j = 0; j < numFrames; j++, i++) {
+            readInt16SampleFromArray(sampleBytes,
+                                     numFrames * frameSize,
+                                     j, //sampleIndex
+                                     sampleCh1,
+                                     sampleCh2);
+            int16Samples[i * _numChannels] = sampleCh1;
+            if (_numChannels == 2) {
+                int16Samples[i * _numChannels + 1] = sampleCh2;
+            }
+        }
+        _counters.addConversion(numFrames, startNanos);
+    }
+
+    return true;
+}
+
+
+//Presumes a file opened for binary reading, with file pointer at first byte of sample data
+bool WavReader::readFramesPlanar(float *const channels[], //one array of numFrames values per channel
+                                 uint32_t numFrames) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    const uint32_t frameSize = _numChannels * _byteDepth;
+    if ((uint64_t) numFrames * frameSize > _sampleDataSize) {
+        closeFile("Error: Suppled numFrames to large for available data");
+        return false;
+    }
+
+    //Read a block of frames at a time, deinterleaving each block while it's in cache
+    const WavSampleFormat format = _sampleFormat;
+    const uint32_t framesPerBlock = PLANAR_READ_BLOCK_SIZE / frameSize;
+    uint8_t sampleBytes[PLANAR_READ_BLOCK_SIZE];
+    float *blockChannels[2];
+    uint32_t i = 0;
+    while (i < numFrames) {
+        const uint32_t numBlockFrames = (numFrames - i < framesPerBlock) ? numFrames - i : framesPerBlock;
+        if (!readData(sampleBytes, numBlockFrames * frameSize)) {
+            return false;
+        }
+        WAV_TRACE_SCOPE_BYTES("WavReader::convertToPlanar", numBlockFrames * frameSize);
+        uint64_t startNanos = WavCounters::now();
+        for (uint32_t ch = 0; ch < _numChannels; ch++) {
+            blockChannels[ch] = channels[ch] + i;
+        }
+        if (!wavDecodeToPlanarFloats(sampleBytes, format, blockChannels, _numChannels, numBlockFrames)) {
+            closeFile("Error: Problem converting sample data to planar floats.");
+            return false;
         }
+        _counters.addConversion(numBlockFrames, startNanos);
+        i += numBlockFrames;
     }
 
     return true;
 }
 
 
+bool WavReader::prefetch(uint32_t numBytes) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (!readFile) {
+        fprintf(stderr, "Error: Call prepareToRead() before prefetch().\n");
+        return false;
+    }
+
+    //Only sample data still to be read; before prepareToRead() the file is still in the header
+    const uint64_t dataEnd = (uint64_t) _dataOffset + _encodedDataSize;
+    uint64_t position = 0;
+    if (numBytes == 0 ||
+        !wavTellFile(readFile, &position) ||
+        position < _dataOffset ||
+        position >= dataEnd) {
+        return false;
+    }
+
+    //numBytes is in decoded terms; IMA ADPCM blocks are about a quarter of that on disk
+    uint64_t numFileBytes = numBytes;
+    if (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        numFileBytes = numFileBytes * _blockAlign / ((uint64_t) _framesPerBlock * _numChannels * _byteDepth) + _blockAlign;
+    }
+    if (numFileBytes > dataEnd - position) {
+        numFileBytes = dataEnd - position;
+    }
+
+    return wavAdviseWillNeed(readFile, position, numFileBytes);
+}
+
+
 bool WavReader::finishReading() {
 
     if (!_initialized) {
@@ -388,6 +819,49 @@ bool WavReader::finishReading() {
 }
 
 
+bool WavReader::setAsyncEngine(WavAsyncEngine *asyncEngine) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    _pAsyncEngine = asyncEngine;
+
+    return true;
+}
+
+
+bool WavReader::getCounters(WavCounterSnapshot *snapshot) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    _counters.snapshot(snapshot);
+
+    return true;
+}
+
+
+bool WavReader::setSignalStats(WavSignalStats *signalStats) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (signalStats && !signalStats->initialize(_numChannels, _sampleFormat)) {
+        return false;
+    }
+
+    _pSignalStats = signalStats;
+
+    return true;
+}
+
+
 //Read sample from in-memory wav data array
 bool WavReader::readInt16SampleFromArray(const uint8_t sampleData[],
                                          uint32_t sampleDataSize,
@@ -408,6 +882,15 @@ bool WavReader::readInt16SampleFromArray(const uint8_t sampleData[],
         return false;
     }
 
+    if (_sampleFormat == WAV_SAMPLE_FORMAT_ALAW || _sampleFormat == WAV_SAMPLE_FORMAT_MULAW) {
+        int16_t values[2] = {0, 0};
+        wavConvertSamples(sampleData + sampleIndex * sampleBlockSize, _sampleFormat,
+                          (uint8_t *) values, WAV_SAMPLE_FORMAT_INT16, _numChannels);
+        int16SampleCh1 = values[0];
+        int16SampleCh2 = values[1];
+        return true;
+    }
+
     switch (sampleBlockSize) {
 
         case 1: { //int8 mono
@@ -612,6 +1095,17 @@ bool WavReader::getSamplesAreInts() {
 }
 
 
+WavSampleFormat WavReader::getSampleFormat() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return WAV_SAMPLE_FORMAT_INVALID;
+    }
+
+    return _sampleFormat;
+}
+
+
 uint32_t WavReader::getByteDepth() {
 
     if (!_initialized) {
@@ -634,3 +1128,306 @@ uint32_t WavReader::getSampleDataSize() {
 }
 
 
+uint16_t WavReader::getAudioFormat() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _audioFormat;
+}
+
+
+uint32_t WavReader::getFramesPerBlock() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _framesPerBlock;
+}
+
+
+bool WavReader::getIsBigEndian() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    return _bigEndian;
+}
+
+
+uint32_t WavReader::getDataOffset() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    return _dataOffset;
+}
+
+
+
+//Metadata subchunks
+
+bool WavReader::readAt(uint64_t offset,
+                       void *data,
+                       uint32_t numBytes) {
+
+    FILE *f = readFile;
+    if (!f) {
+        f = fopen(_pReadFilePath, "rb");
+        if (!f) {
+            fprintf(stderr, "Error: Unable to open input file for reading.\n");
+            return false;
+        }
+        _counters.addOpen();
+    }
+
+    uint64_t startNanos = WavCounters::now();
+    bool ok = wavReadAt(f, offset, data, numBytes);
+    _counters.addRead(ok ? numBytes : 0, startNanos);
+
+    if (f != readFile) {
+        fclose(f);
+    }
+
+    return ok;
+}
+
+
+uint8_t *WavReader::readSubchunkPayload(const WavSubchunkInfo *subchunkInfo,
+                                        uint32_t numBytes) {
+
+    uint8_t *payload = (uint8_t *) malloc((size_t) numBytes + 1);
+    if (!payload) {
+        fprintf(stderr, "Error: Unable to allocate subchunk buffer.\n");
+        return nullptr;
+    }
+
+    if (!readAt(subchunkInfo->dataOffset, payload, numBytes)) {
+        fprintf(stderr, "Error: Problem reading subchunk: %.4s\n", subchunkInfo->subchunkId);
+        free(payload);
+        return nullptr;
+    }
+
+    return payload;
+}
+
+
+uint32_t WavReader::getNumSubchunks() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _numSubchunks;
+}
+
+
+bool WavReader::getSubchunkInfo(uint32_t subchunkIndex,
+                                WavSubchunkInfo *subchunkInfo) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (subchunkIndex >= _numSubchunks) {
+        fprintf(stderr, "Error: Subchunk index out of range.\n");
+        return false;
+    }
+
+    *subchunkInfo = _pSubchunks[subchunkIndex];
+
+    return true;
+}
+
+
+bool WavReader::findSubchunkInfo(const char subchunkId[4],
+                                 const char listType[4],
+                                 WavSubchunkInfo *subchunkInfo) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    const WavSubchunkInfo *info = lookUpSubchunk(subchunkId, listType);
+    if (!info) {
+        return false;
+    }
+    *subchunkInfo = *info;
+
+    return true;
+}
+
+
+bool WavReader::readSubchunkData(const WavSubchunkInfo *subchunkInfo,
+                                 uint8_t subchunkData[]) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    WAV_TRACE_SCOPE_BYTES("WavReader::readSubchunkData", subchunkInfo->dataSize);
+
+    if (!readAt(subchunkInfo->dataOffset, subchunkData, subchunkInfo->dataSize)) {
+        fprintf(stderr, "Error: Problem reading subchunk: %.4s\n", subchunkInfo->subchunkId);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavReader::getInfoText(const char infoId[4],
+                            char text[],
+                            uint32_t maxTextLength) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    //There's usually one LIST/INFO, but nothing stops a file having several
+    for (uint32_t i = 0; i < _numSubchunks; i++) {
+        const WavSubchunkInfo *info = &_pSubchunks[i];
+        if (strncmp(info->subchunkId, "LIST", 4) || strncmp(info->listType, "INFO", 4)) {
+            continue;
+        }
+        uint8_t *listData = readSubchunkPayload(info, info->dataSize);
+        if (!listData) {
+            return false;
+        }
+        bool found = wavParseInfoText(listData, info->dataSize, _bigEndian, infoId, text, maxTextLength);
+        free(listData);
+        if (found) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool WavReader::getBroadcastExtension(WavBroadcastExtension *bext) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    const WavSubchunkInfo *info = lookUpSubchunk("bext", nullptr);
+    if (!info || info->dataSize < BEXT_FIXED_SIZE) {
+        return false;
+    }
+
+    uint8_t bextData[BEXT_FIXED_SIZE];
+    if (!readAt(info->dataOffset, bextData, BEXT_FIXED_SIZE)) {
+        fprintf(stderr, "Error: Problem reading bext subchunk.\n");
+        return false;
+    }
+
+    return wavParseBroadcastExtension(bextData, BEXT_FIXED_SIZE, info->dataSize, _bigEndian, bext);
+}
+
+
+uint32_t WavReader::getIXmlSize() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    const WavSubchunkInfo *info = lookUpSubchunk("iXML", nullptr);
+
+    return info ? info->dataSize : 0;
+}
+
+
+bool WavReader::readIXml(char xml[],
+                         uint32_t maxXmlLength) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    const WavSubchunkInfo *info = lookUpSubchunk("iXML", nullptr);
+    if (!info || maxXmlLength == 0) {
+        return false;
+    }
+
+    const uint32_t numBytes = (info->dataSize < maxXmlLength) ? info->dataSize : maxXmlLength - 1;
+    if (!readAt(info->dataOffset, xml, numBytes)) {
+        fprintf(stderr, "Error: Problem reading iXML subchunk.\n");
+        return false;
+    }
+    xml[numBytes] = 0;
+
+    return true;
+}
+
+
+uint32_t WavReader::getNumCuePoints() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    const WavSubchunkInfo *info = lookUpSubchunk("cue ", nullptr);
+    uint8_t countData[sizeof(uint32_t)];
+    if (!info || info->dataSize < sizeof(countData) || !readAt(info->dataOffset, countData, sizeof(countData))) {
+        return 0;
+    }
+
+    return wavParseNumCuePoints(countData, info->dataSize, _bigEndian);
+}
+
+
+bool WavReader::getCuePoints(WavCuePoint cuePoints[],
+                             uint32_t maxNumCuePoints,
+                             uint32_t *numCuePoints) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    *numCuePoints = 0;
+    const WavSubchunkInfo *cueInfo = lookUpSubchunk("cue ", nullptr);
+    if (!cueInfo) {
+        return true;
+    }
+
+    uint8_t *cueData = readSubchunkPayload(cueInfo, cueInfo->dataSize);
+    if (!cueData) {
+        return false;
+    }
+    *numCuePoints = wavParseCuePoints(cueData, cueInfo->dataSize, _bigEndian, cuePoints, maxNumCuePoints);
+    free(cueData);
+
+    for (uint32_t i = 0; i < _numSubchunks; i++) {
+        const WavSubchunkInfo *info = &_pSubchunks[i];
+        if (strncmp(info->subchunkId, "LIST", 4) || strncmp(info->listType, "adtl", 4)) {
+            continue;
+        }
+        uint8_t *adtlData = readSubchunkPayload(info, info->dataSize);
+        if (!adtlData) {
+            return false;
+        }
+        wavParseCueLabels(adtlData, info->dataSize, _bigEndian, cuePoints, *numCuePoints);
+        free(adtlData);
+    }
+
+    return true;
+}
@@ -7,6 +7,13 @@
 #include <cstdint> //For uint8_t, etc.
 
 #include "WavHeader.hpp"
+#include "WavSampleConverter.hpp"
+#include "WavSignalStats.hpp"
+#include "WavCounters.hpp"
+#include "WavBufferPool.hpp"
+#include "WavFrameBlocks.hpp"
+#include "WavMetadata.hpp"
+#include "WavAsync.hpp"
 
 
 class WavReader {
@@ -24,11 +31,36 @@ public:
     bool readData(uint8_t sampleData[], //WAV format bytes
                   uint32_t _sampleDataSize);
 
+    //Read into a pool block, setting the block's size; sampleDataSize must fit its capacity
+    bool readData(WavBufferBlock *block,
+                  uint32_t sampleDataSize);
+
     bool readDataToInt16s(int16_t int16Samples[], //channels interleaved; length = numInt16Samples * numChannels
                           uint32_t numInt16Samples);
 
+    //Decode straight into one float array per channel; full scale is [-1.0, 1.0)
+    bool readFramesPlanar(float *const channels[], //numChannels arrays of numFrames values
+                          uint32_t numFrames);
+
+    //Position the next read at frameIndex (after prepareToRead()). IMA ADPCM files seek to the
+    //block holding the frame and decode that one block, so any frame is reachable in one block's work.
+    bool seekToFrame(uint32_t frameIndex);
+
+    //Ask the OS to start reading the next numBytes of sample data in the background; advisory only.
+    //False, with the read position untouched, if no sample data is left to read or the OS can't.
+    bool prefetch(uint32_t numBytes);
+
     bool finishReading();
 
+    //Iterate over the sample data in blocks of numFramesPerBlock frames, decoded to T (float or
+    //int16_t; uint8_t for raw wav-format bytes), through one reused buffer:
+    //    for (auto block : wavReader.blocks<float>(4096)) { ... block.pSamples, block.numFrames ... }
+    //Calls prepareToRead() when iteration begins and finishReading() when the range is destroyed.
+    template <typename T>
+    WavFrameBlocks<T> blocks(uint32_t numFramesPerBlock) {
+        return WavFrameBlocks<T>(this, numFramesPerBlock);
+    }
+
     //Read int16 sample from an in-memory array of wav-format sample data
     bool readInt16SampleFromArray(const uint8_t sampleData[], //wav-format sample data
                                   uint32_t _sampleDataSize,
@@ -36,6 +68,12 @@ public:
                                   int16_t &int16SampleCh1,
                                   int16_t &int16SampleCh2);
 
+    //Update signalStats on every block read from now on; nullptr detaches
+    bool setSignalStats(WavSignalStats *signalStats);
+
+    //I/O and conversion done by this reader so far; see WavCounters::global() for process-wide totals
+    bool getCounters(WavCounterSnapshot *snapshot);
+
     const char *getReadFilePath();
 
     uint32_t getSampleRate();
@@ -44,12 +82,90 @@ public:
 
     uint32_t getNumChannels();
 
-    bool getSamplesAreInts();
+    bool getSamplesAreInts(); //True for integer PCM and for A-law/mu-law codes
+
+    //On-disk encoding, distinguishing A-law and mu-law from 8-bit PCM
+    WavSampleFormat getSampleFormat();
 
     uint32_t getByteDepth();
 
     uint32_t getSampleDataSize();
 
+    //Byte offset of the first sample in the file, i.e. just past the data subchunk header
+    uint32_t getDataOffset();
+
+    //The format subchunk's audioFormat. IMA ADPCM files are decoded as they are read and otherwise
+    //look like 16-bit PCM (byte depth, sample format, sample data size), but their on-disk bytes
+    //can't be copied as PCM.
+    uint16_t getAudioFormat();
+
+    //Frames per independently decodable block: 1 for PCM, float and G.711
+    uint32_t getFramesPerBlock();
+
+    //True for a RIFX file. Its samples are byte-swapped as they are read, so readData() and the
+    //conversions still see RIFF byte order; only getDataOffset()-based raw copies see the difference.
+    bool getIsBigEndian();
+
+    //Metadata subchunks. initialize() only records where each subchunk is (getNumSubchunks(),
+    //getSubchunkInfo()); their payloads are read when asked for, so probing a file costs the same
+    //however much iXML or coding history it carries.
+
+    uint32_t getNumSubchunks(); //All subchunks found, fmt and data included, in file order
+
+    bool getSubchunkInfo(uint32_t subchunkIndex,
+                         WavSubchunkInfo *subchunkInfo);
+
+    //First subchunk with this id (and, if listType isn't nullptr, this LIST type); false if none
+    bool findSubchunkInfo(const char subchunkId[4],
+                          const char listType[4],
+                          WavSubchunkInfo *subchunkInfo);
+
+    //Read a subchunk's whole payload (subchunkInfo->dataSize bytes) with a positional read,
+    //leaving any incremental read where it was
+    bool readSubchunkData(const WavSubchunkInfo *subchunkInfo,
+                          uint8_t subchunkData[]);
+
+    //A LIST/INFO entry such as "INAM" (title), "IART" (artist) or "ICMT" (comment); false if absent
+    bool getInfoText(const char infoId[4],
+                     char text[], //NUL-terminated, truncated to maxTextLength - 1 characters
+                     uint32_t maxTextLength);
+
+    //Reads only the fixed-size fields, not the coding history
+    bool getBroadcastExtension(WavBroadcastExtension *bext);
+
+    uint32_t getIXmlSize(); //0 if there's no iXML subchunk
+
+    bool readIXml(char xml[], //NUL-terminated; needs getIXmlSize() + 1 bytes for the whole document
+                  uint32_t maxXmlLength);
+
+    uint32_t getNumCuePoints();
+
+    //Cue points in file order, labeled from LIST/adtl where there are labl subchunks
+    bool getCuePoints(WavCuePoint cuePoints[],
+                      uint32_t maxNumCuePoints,
+                      uint32_t *numCuePoints);
+
+    //Engine for the async reads; nullptr (the default) runs them inline
+    bool setAsyncEngine(WavAsyncEngine *asyncEngine);
+
+#if defined(__cpp_impl_coroutine)
+    //C++20: bool ok = co_await wavReader.readFramesAsync(...); readData() or readFramesPlanar()
+    //on the async engine. One read in flight per reader, as with the blocking calls.
+    WavAsyncOperation readFramesAsync(uint8_t sampleData[], //WAV format bytes
+                                      uint32_t numFrames) {
+        return WavAsyncOperation(_pAsyncEngine, [this, sampleData, numFrames]() {
+            return readData(sampleData, numFrames * _numChannels * _byteDepth);
+        });
+    }
+
+    WavAsyncOperation readFramesAsync(float *const channels[],
+                                      uint32_t numFrames) {
+        return WavAsyncOperation(_pAsyncEngine, [this, channels, numFrames]() {
+            return readFramesPlanar(channels, numFrames);
+        });
+    }
+#endif
+
 
 private:
     bool readMetadata();
@@ -60,7 +176,30 @@ private:
 
     bool closeFile(const char *errorMessage);
 
-    bool findSubchunk(const char *subchunkId, uint32_t *subchunkSize);
+    bool walkSubchunks();
+
+    bool addSubchunkInfo(const WavSubchunkInfo *subchunkInfo);
+
+    const WavSubchunkInfo *lookUpSubchunk(const char subchunkId[4],
+                                          const char listType[4]);
+
+    //Positional read that works whether or not the file is open for incremental reads
+    bool readAt(uint64_t offset,
+                void *data,
+                uint32_t numBytes);
+
+    //First numBytes of a payload in a malloc()ed buffer (one byte bigger, so an empty payload still gets one)
+    uint8_t *readSubchunkPayload(const WavSubchunkInfo *subchunkInfo,
+                                 uint32_t numBytes);
+
+    bool readImaAdpcmFormat(const FormatSubchunk *fsc);
+
+    bool readImaAdpcmFrames(uint8_t sampleData[], //Decoded int16 frames
+                            uint32_t numFrames);
+
+    bool decodeNextImaAdpcmBlock();
+
+    void freeImaAdpcmBuffers();
 
     char *_pReadFilePath;
     FILE *readFile;
@@ -71,7 +210,25 @@ private:
     uint32_t _numChannels;
     bool _samplesAreInts; //False if samples are 32 or 64-bit floating point values
     uint32_t _byteDepth; //Number of significant bytes required to represent a single channel of a sample
+    WavSampleFormat _sampleFormat;
+    bool _bigEndian; //RIFX rather than RIFF
+    uint16_t _audioFormat;
+    uint32_t _blockAlign; //Bytes per block: one frame, or one IMA ADPCM block
+    uint32_t _framesPerBlock;
+    uint32_t _encodedDataSize; //Size of the data subchunk on disk
+    uint8_t *_pImaAdpcmBlock; //Raw block being decoded
+    int16_t *_pImaAdpcmFrames; //Its decoded frames
+    uint32_t _numImaAdpcmFrames; //Decoded frames in _pImaAdpcmFrames
+    uint32_t _imaAdpcmFrameIndex; //Next of those to hand out
+    uint32_t _nextBlockIndex; //Block that decodeNextImaAdpcmBlock() reads
     uint32_t _sampleDataSize;
+    uint32_t _dataOffset;
+    WavSubchunkInfo *_pSubchunks; //From the header walk; payloads aren't read until asked for
+    uint32_t _numSubchunks;
+    uint32_t _subchunkCapacity;
+    WavSignalStats *_pSignalStats;
+    WavAsyncEngine *_pAsyncEngine;
+    WavCounters _counters; //Not copyable, so neither is the reader
     bool _initialized;
 };
 
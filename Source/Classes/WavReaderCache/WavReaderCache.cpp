@@ -0,0 +1,195 @@
+//WavReaderCache.cpp
+
+
+#include <cstdio>
+#include <cstring> //memset()
+#include <vector>
+
+#include "WavReaderCache.hpp"
+#include "WavFileIo.hpp"
+
+
+static const char *UNINITIALIZED_MSG = "Attempt to call WavReaderCache class method before calling initialize().\n";
+
+
+WavReaderCache::WavReaderCache() {
+    _maxNumOpenReaders = 0;
+    _numOpenReaders = 0;
+    memset(&_stats, 0, sizeof(_stats));
+    _initialized = false;
+}
+
+
+//Readers still in use are closed too; release them all first
+WavReaderCache::~WavReaderCache() {
+    for (auto it = _entriesByReader.begin(); it != _entriesByReader.end(); ++it) {
+        delete it->second;
+    }
+}
+
+
+bool WavReaderCache::initialize(uint32_t maxNumOpenReaders) {
+
+    if (maxNumOpenReaders == 0) {
+        fprintf(stderr, "Error: The reader cache needs room for at least one reader.\n");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_initialized) {
+        fprintf(stderr, "Error: Reader cache already initialized.\n");
+        return false;
+    }
+
+    _maxNumOpenReaders = maxNumOpenReaders;
+    _initialized = true;
+
+    return true;
+}
+
+
+WavReader *WavReaderCache::acquire(const char *filePath) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return nullptr;
+    }
+
+    //Outside the lock; a file that changes after this is caught by the next acquire()
+    int64_t mtimeNanos = 0;
+    uint64_t fileSize = 0;
+    if (!wavStatFile(filePath, &mtimeNanos, &fileSize)) {
+        fprintf(stderr, "File: %s doesn't exist.\n", filePath);
+        return nullptr;
+    }
+
+    const std::string key(filePath);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto range = _entriesByPath.equal_range(key);
+        std::vector<Entry *> staleEntries;
+        for (auto it = range.first; it != range.second; ++it) {
+            Entry *entry = it->second;
+            if (entry->inUse) {
+                continue;
+            }
+            if (entry->mtimeNanos != mtimeNanos || entry->fileSize != fileSize) {
+                staleEntries.push_back(entry);
+                continue;
+            }
+            entry->inUse = true;
+            _idleEntries.erase(entry->idlePosition);
+            _stats.numHits++;
+            _stats.numReadersInUse++;
+            return &entry->reader;
+        }
+        for (size_t i = 0; i < staleEntries.size(); i++) {
+            removeEntry(staleEntries[i]);
+            _stats.numInvalidations++;
+        }
+        _stats.numMisses++;
+
+        if (_numOpenReaders >= _maxNumOpenReaders) {
+            if (_idleEntries.empty()) {
+                fprintf(stderr, "Error: Every reader in the cache is in use.\n");
+                return nullptr;
+            }
+            removeEntry(_idleEntries.front());
+            _stats.numEvictions++;
+        }
+        _numOpenReaders++; //Hold the slot while opening, without the lock
+    }
+
+    Entry *entry = new Entry();
+    entry->filePath = key;
+    entry->mtimeNanos = mtimeNanos;
+    entry->fileSize = fileSize;
+    entry->inUse = true;
+    if (!entry->reader.initialize(entry->filePath.c_str())) {
+        delete entry;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _numOpenReaders--;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entriesByPath.insert(std::make_pair(key, entry));
+    _entriesByReader[&entry->reader] = entry;
+    _stats.numReadersInUse++;
+
+    return &entry->reader;
+}
+
+
+void WavReaderCache::release(WavReader *wavReader) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _entriesByReader.find(wavReader);
+    if (it == _entriesByReader.end() || !it->second->inUse) {
+        fprintf(stderr, "Error: Released reader wasn't acquired from this cache.\n");
+        return;
+    }
+
+    //Don't let the next user update this user's statistics
+    Entry *entry = it->second;
+    entry->reader.setSignalStats(nullptr);
+    entry->inUse = false;
+    entry->idlePosition = _idleEntries.insert(_idleEntries.end(), entry);
+    _stats.numReadersInUse--;
+}
+
+
+void WavReaderCache::removeEntry(Entry *entry) {
+
+    _idleEntries.erase(entry->idlePosition);
+    auto range = _entriesByPath.equal_range(entry->filePath);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == entry) {
+            _entriesByPath.erase(it);
+            break;
+        }
+    }
+    _entriesByReader.erase(&entry->reader);
+    _numOpenReaders--;
+
+    delete entry; //Closes the file
+}
+
+
+void WavReaderCache::clear() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    while (!_idleEntries.empty()) {
+        removeEntry(_idleEntries.front());
+    }
+}
+
+
+bool WavReaderCache::getStats(WavReaderCacheStats *stats) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    *stats = _stats;
+    stats->numOpenReaders = _numOpenReaders;
+
+    return true;
+}
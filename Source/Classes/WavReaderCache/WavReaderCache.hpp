@@ -0,0 +1,79 @@
+//WavReaderCache.hpp
+
+#ifndef __WAV_READER_CACHE_HPP__
+#define __WAV_READER_CACHE_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "WavReader.hpp"
+
+
+typedef struct {
+    uint64_t numHits;
+    uint64_t numMisses;
+    uint64_t numInvalidations; //Cached readers dropped because their file's mtime or size changed
+    uint64_t numEvictions; //Idle readers closed to make room
+    uint32_t numOpenReaders; //Idle and in use; each holds one open file
+    uint32_t numReadersInUse;
+} WavReaderCacheStats;
+
+
+//Initialized WavReaders kept open for reuse, for services that open the same files over and over.
+//A repeat acquire() of an unchanged file costs a hash lookup and a stat(): no open, no header
+//walk, and the reader's subchunk table and parsed format come along.
+//
+//Each reader is used by one thread at a time; acquire() hands out an idle one, or opens another
+//if every reader for that path is busy. At most maxNumOpenReaders are open at once; the least
+//recently released idle reader is closed to make room. Thread-safe.
+class WavReaderCache {
+
+public:
+
+    WavReaderCache();
+
+    ~ WavReaderCache();
+
+    bool initialize(uint32_t maxNumOpenReaders);
+
+    //An initialized reader for filePath, or nullptr if the file can't be read or every slot holds
+    //a reader in use. Call prepareToRead() before reading, as usual, but release() the reader
+    //rather than calling finishReading(), which would close its file.
+    WavReader *acquire(const char *filePath);
+
+    void release(WavReader *wavReader);
+
+    //Close every idle reader
+    void clear();
+
+    bool getStats(WavReaderCacheStats *stats);
+
+
+private:
+
+    typedef struct Entry {
+        WavReader reader;
+        std::string filePath; //The reader points into this
+        int64_t mtimeNanos;
+        uint64_t fileSize;
+        bool inUse;
+        std::list<struct Entry *>::iterator idlePosition; //In _idleEntries, while not in use
+    } Entry;
+
+    void removeEntry(Entry *entry); //Call with _mutex held; entry must be idle
+
+    std::mutex _mutex;
+    std::unordered_multimap<std::string, Entry *> _entriesByPath;
+    std::unordered_map<WavReader *, Entry *> _entriesByReader;
+    std::list<Entry *> _idleEntries; //Least recently released first
+    uint32_t _maxNumOpenReaders;
+    uint32_t _numOpenReaders; //Including slots reserved by acquire() while it opens a reader
+    WavReaderCacheStats _stats;
+    bool _initialized;
+};
+
+
+#endif //__WAV_READER_CACHE_HPP__
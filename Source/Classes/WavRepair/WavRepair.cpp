@@ -0,0 +1,357 @@
+//WavRepair.cpp
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring> //memcmp()
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dirent.h>
+#include <strings.h> //strcasecmp()
+#endif
+
+#include "WavRepair.hpp"
+#include "WavHeader.hpp"
+#include "WavFileIo.hpp"
+
+
+static const uint64_t MAX_UINT32 = 4294967295;
+
+
+//Written after the data by some recorders and editors; only these are looked for past an
+//untrusted data size, so stray sample bytes are unlikely to pass for a subchunk header
+static const char *const TRAILING_SUBCHUNK_IDS[] = {
+        "fact", "LIST", "cue ", "bext", "iXML", "axml", "smpl", "inst", "id3 ", "ID3 ", "_PMX", "JUNK", "junk", "PAD "
+};
+
+
+static bool isTrailingSubchunkId(const char id[4]) {
+    for (size_t i = 0; i < sizeof(TRAILING_SUBCHUNK_IDS) / sizeof(TRAILING_SUBCHUNK_IDS[0]); i++) {
+        if (memcmp(id, TRAILING_SUBCHUNK_IDS[i], 4) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void WavRepair::readSubchunkFields(FILE *file,
+                                   const SubchunkHeader *header,
+                                   uint64_t offset,
+                                   bool bigEndian,
+                                   HeaderFields *fields) {
+
+    if (memcmp(header->subchunkId, "fmt ", 4) == 0) {
+        FormatSubchunk fmt;
+        if (wavReadAt(file, offset, &fmt, FORMAT_SUBCHUNK_SIZE)) {
+            wavByteOrderFormatSubchunk(&fmt, bigEndian);
+            fields->blockAlign = fmt.blockAlign;
+            ImaAdpcmFormatExtension extension;
+            if (fmt.audioFormat == AUDIO_FORMAT_IMA_ADPCM &&
+                header->subchunkSize >= FORMAT_SUBCHUNK_SIZE - SUBCHUNK_HEADER_SIZE + IMA_ADPCM_FORMAT_EXTENSION_SIZE &&
+                wavReadAt(file, offset + FORMAT_SUBCHUNK_SIZE, &extension, IMA_ADPCM_FORMAT_EXTENSION_SIZE)) {
+                extension.framesPerBlock = wavByteOrder16(extension.framesPerBlock, bigEndian);
+                if (extension.framesPerBlock > 0) {
+                    fields->framesPerBlock = extension.framesPerBlock;
+                }
+            }
+        }
+    } else if (memcmp(header->subchunkId, "fact", 4) == 0 && header->subchunkSize >= sizeof(uint32_t)) {
+        uint32_t numFrames;
+        if (wavReadAt(file, offset + SUBCHUNK_HEADER_SIZE, &numFrames, sizeof(uint32_t))) {
+            fields->factOffset = offset + SUBCHUNK_HEADER_SIZE;
+            fields->factNumFrames = wavByteOrder32(numFrames, bigEndian);
+        }
+    }
+}
+
+
+bool WavRepair::trailingSubchunksFit(FILE *file,
+                                     uint64_t offset,
+                                     uint64_t fileSize,
+                                     bool bigEndian,
+                                     HeaderFields *fields) {
+
+    //Only take the fields once the whole tail is known to parse
+    HeaderFields tailFields = *fields;
+    while (offset < fileSize) {
+        SubchunkHeader sch;
+        if (offset + SUBCHUNK_HEADER_SIZE > fileSize ||
+            !wavReadAt(file, offset, &sch, SUBCHUNK_HEADER_SIZE)) {
+            return false;
+        }
+        for (int i = 0; i < 4; i++) {
+            if (sch.subchunkId[i] < ' ' || sch.subchunkId[i] > '~') {
+                return false;
+            }
+        }
+        sch.subchunkSize = wavByteOrder32(sch.subchunkSize, bigEndian);
+        readSubchunkFields(file, &sch, offset, bigEndian, &tailFields);
+        offset += SUBCHUNK_HEADER_SIZE + (uint64_t) sch.subchunkSize + (sch.subchunkSize & 1);
+    }
+
+    if (offset != fileSize) {
+        return false;
+    }
+    *fields = tailFields;
+
+    return true;
+}
+
+
+uint64_t WavRepair::findTrailingSubchunks(FILE *file,
+                                          uint64_t dataOffset,
+                                          uint64_t fileSize,
+                                          bool bigEndian,
+                                          HeaderFields *fields) {
+
+    const uint64_t scanStart = (fileSize - dataOffset > TRAILING_SCAN_SIZE) ? fileSize - TRAILING_SCAN_SIZE : dataOffset;
+    const uint32_t scanSize = (uint32_t) (fileSize - scanStart);
+    uint8_t *tail = (uint8_t *) malloc(scanSize + 1);
+    if (!tail || !wavReadAt(file, scanStart, tail, scanSize)) {
+        free(tail);
+        return fileSize;
+    }
+
+    //Working back from the end of the file: the subchunk ending exactly where the previous one
+    //starts (or at end of file), starting an even number of bytes after the data, as padding leaves it
+    uint64_t end = fileSize;
+    bool found = true;
+    while (found) {
+        found = false;
+        for (uint64_t offset = end - SUBCHUNK_HEADER_SIZE; offset >= scanStart && offset + SUBCHUNK_HEADER_SIZE <= end; offset--) {
+            if ((offset - dataOffset) & 1) {
+                continue;
+            }
+            SubchunkHeader sch;
+            memcpy(&sch, tail + (offset - scanStart), SUBCHUNK_HEADER_SIZE);
+            sch.subchunkSize = wavByteOrder32(sch.subchunkSize, bigEndian);
+            const uint64_t subchunkEnd = offset + SUBCHUNK_HEADER_SIZE + sch.subchunkSize;
+            if (isTrailingSubchunkId(sch.subchunkId) &&
+                (subchunkEnd + (sch.subchunkSize & 1) == end || (end == fileSize && subchunkEnd == end))) {
+                readSubchunkFields(file, &sch, offset, bigEndian, fields);
+                end = offset;
+                found = end >= scanStart + SUBCHUNK_HEADER_SIZE;
+                break;
+            }
+            if (offset == scanStart) {
+                break;
+            }
+        }
+    }
+    free(tail);
+
+    return end;
+}
+
+
+bool WavRepair::repair(const char *filePath,
+                       WavRepairResult *result,
+                       bool dryRun) {
+
+    WavRepairResult r;
+    memset(&r, 0, sizeof(r));
+    if (result) {
+        *result = r;
+    }
+
+    FILE *file = fopen(filePath, dryRun ? "rb" : "r+b");
+    if (!file) {
+        fprintf(stderr, "Error: Unable to open file: %s\n", filePath);
+        return false;
+    }
+
+    //Positional reads and fstat() throughout, so offsets past 2 GB work where long is 32 bits
+    RiffHeader riff;
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0 ||
+        (uint64_t) st.st_size < RIFF_HEADER_SIZE ||
+        !wavReadAt(file, 0, &riff, RIFF_HEADER_SIZE) ||
+        (memcmp(riff.chunkId, "RIFF", 4) != 0 && memcmp(riff.chunkId, "RIFX", 4) != 0) ||
+        memcmp(riff.formatName, "WAVE", 4) != 0) {
+        fprintf(stderr, "Error: Not a RIFF/WAVE file: %s\n", filePath);
+        fclose(file);
+        return false;
+    }
+    const bool bigEndian = memcmp(riff.chunkId, "RIFX", 4) == 0;
+    const uint64_t fileSize = (uint64_t) st.st_size;
+
+    //Walk the subchunks up to "data"; whether anything after it can be walked depends on its size
+    HeaderFields fields;
+    memset(&fields, 0, sizeof(fields));
+    fields.framesPerBlock = 1;
+    uint64_t offset = RIFF_HEADER_SIZE;
+    uint64_t dataOffset = 0; //Of the sample data
+    uint32_t dataSize = 0;
+    while (!dataOffset && offset + SUBCHUNK_HEADER_SIZE <= fileSize) {
+        SubchunkHeader sch;
+        if (!wavReadAt(file, offset, &sch, SUBCHUNK_HEADER_SIZE)) {
+            break;
+        }
+        sch.subchunkSize = wavByteOrder32(sch.subchunkSize, bigEndian);
+
+        if (memcmp(sch.subchunkId, "data", 4) == 0) {
+            dataOffset = offset + SUBCHUNK_HEADER_SIZE;
+            dataSize = sch.subchunkSize;
+        } else {
+            readSubchunkFields(file, &sch, offset, bigEndian, &fields);
+        }
+
+        offset += SUBCHUNK_HEADER_SIZE + (uint64_t) sch.subchunkSize + (sch.subchunkSize & 1);
+    }
+
+    if (!fields.blockAlign || !dataOffset || dataOffset > fileSize) {
+        fprintf(stderr, "Error: No format or data subchunk found: %s\n", filePath);
+        fclose(file);
+        return false;
+    }
+
+    //A stated data size is kept only if it fits and whatever follows it parses as subchunks.
+    //Otherwise (zero, stale from a checkpoint, or past the end) the data runs to end of file, or
+    //to any known subchunks found chained to the end of the file.
+    const uint64_t available = fileSize - dataOffset;
+    const uint64_t statedDataEnd = dataOffset + dataSize + (dataSize & 1);
+    uint64_t newDataSize = dataSize;
+    uint64_t newFileSizeLess8 = fileSize - 8;
+    if (dataSize == 0 || dataSize > available ||
+        (statedDataEnd < fileSize && !trailingSubchunksFit(file, statedDataEnd, fileSize, bigEndian, &fields))) {
+        const uint64_t trailingOffset = findTrailingSubchunks(file, dataOffset, fileSize, bigEndian, &fields);
+        if (trailingOffset < fileSize) {
+            //The data fills the gap, less its pad byte if that's what makes it whole frames. (With
+            //one-byte frames a pad byte can't be told from a sample, so it's kept.)
+            newDataSize = trailingOffset - dataOffset;
+            if (newDataSize % fields.blockAlign && newDataSize > 0 && (newDataSize - 1) % fields.blockAlign == 0) {
+                newDataSize--;
+            }
+            if (newDataSize > MAX_UINT32) {
+                newDataSize = MAX_UINT32;
+            }
+        } else {
+            newDataSize = (available < MAX_UINT32) ? available : MAX_UINT32;
+            newDataSize -= newDataSize % fields.blockAlign;
+            //The data now ends the RIFF chunk; a leftover partial frame falls outside it
+            uint64_t dataEnd = dataOffset + newDataSize + (newDataSize & 1);
+            newFileSizeLess8 = ((dataEnd < fileSize) ? dataEnd : fileSize) - 8;
+        }
+    }
+    if (newFileSizeLess8 > MAX_UINT32) {
+        newFileSizeLess8 = MAX_UINT32;
+    }
+    uint32_t newNumFrames = (uint32_t) (newDataSize / fields.blockAlign * fields.framesPerBlock);
+    //An IMA ADPCM file's last block is padded; a fact count that ends within it is already right
+    if (fields.framesPerBlock > 1 && fields.factOffset &&
+        fields.factNumFrames <= newNumFrames && fields.factNumFrames + fields.framesPerBlock > newNumFrames) {
+        newNumFrames = fields.factNumFrames;
+    }
+
+    r.oldDataSize = dataSize;
+    r.newDataSize = (uint32_t) newDataSize;
+    r.numFrames = newNumFrames;
+    r.needsRepair = newDataSize != dataSize ||
+                    newFileSizeLess8 != wavByteOrder32(riff.fileSizeLess8, bigEndian) ||
+                    (fields.factOffset && fields.factNumFrames != newNumFrames);
+
+    bool ok = true;
+    if (r.needsRepair && !dryRun) {
+        const uint32_t fileSizeLess8 = wavByteOrder32((uint32_t) newFileSizeLess8, bigEndian);
+        const uint32_t dataSize32 = wavByteOrder32((uint32_t) newDataSize, bigEndian);
+        const uint32_t numFrames32 = wavByteOrder32(newNumFrames, bigEndian);
+        ok = wavWriteAt(file, 4, &fileSizeLess8, sizeof(uint32_t)) &&
+             wavWriteAt(file, dataOffset - sizeof(uint32_t), &dataSize32, sizeof(uint32_t)) &&
+             (!fields.factOffset || wavWriteAt(file, fields.factOffset, &numFrames32, sizeof(uint32_t)));
+        r.wasRepaired = ok;
+        if (!ok) {
+            fprintf(stderr, "Error: Problem patching header: %s\n", filePath);
+        }
+    }
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (result) {
+        *result = r;
+    }
+
+    return ok;
+}
+
+
+bool WavRepair::repairDirectory(const char *dirPath,
+                                uint32_t *numRepaired,
+                                uint32_t numThreads,
+                                bool dryRun) {
+
+    if (numRepaired) {
+        *numRepaired = 0;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    DIR *dir = opendir(dirPath);
+    if (!dir) {
+        fprintf(stderr, "Error: Unable to open directory: %s\n", dirPath);
+        return false;
+    }
+
+    std::vector<std::string> filePaths;
+    for (struct dirent *entry = readdir(dir); entry; entry = readdir(dir)) {
+        size_t nameLength = strlen(entry->d_name);
+        if (nameLength < 4 || strcasecmp(entry->d_name + nameLength - 4, ".wav") != 0) {
+            continue;
+        }
+        std::string filePath = std::string(dirPath) + "/" + entry->d_name;
+        struct stat st;
+        if (stat(filePath.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            filePaths.push_back(filePath);
+        }
+    }
+    closedir(dir);
+
+    const uint32_t numFiles = (uint32_t) filePaths.size();
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+    if (numThreads == 0 || numThreads > numFiles) {
+        numThreads = (numFiles > 0) ? numFiles : 1;
+    }
+
+    //Each file is a handful of small reads and writes, so threads mostly overlap I/O latency
+    std::atomic<uint32_t> nextFile(0);
+    std::atomic<uint32_t> numFailed(0);
+    std::atomic<uint32_t> numPatched(0);
+    auto worker = [&]() {
+        for (uint32_t i = nextFile++; i < numFiles; i = nextFile++) {
+            WavRepairResult r;
+            if (!repair(filePaths[i].c_str(), &r, dryRun)) {
+                numFailed++;
+            } else if (r.wasRepaired || (dryRun && r.needsRepair)) {
+                numPatched++;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < numThreads; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    if (numRepaired) {
+        *numRepaired = numPatched;
+    }
+
+    return numFailed == 0;
+#else
+    (void) numThreads;
+    (void) dryRun;
+    fprintf(stderr, "Error: Repairing a whole directory isn't supported on this platform: %s\n", dirPath);
+    return false;
+#endif
+}
@@ -0,0 +1,84 @@
+//WavRepair.hpp
+
+#ifndef __WAV_REPAIR_HPP__
+#define __WAV_REPAIR_HPP__
+
+#include <cstdio> //For FILE
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavHeader.hpp"
+
+
+typedef struct {
+    bool wasRepaired; //False if the header was already consistent (or dryRun was set)
+    bool needsRepair;
+    uint32_t oldDataSize;
+    uint32_t newDataSize;
+    uint32_t numFrames; //Whole frames in the data subchunk after repair
+} WavRepairResult;
+
+
+//Recovers files whose header was never finalized, e.g. a recording cut off by a crash or power
+//loss, leaving zero or stale RIFF/data (and fact) size fields.
+//RIFX (big-endian) files are handled too.
+//The subchunks are walked to find "fmt " and "data". A stated data size is kept if it fits and the
+//subchunks after it (e.g. a trailing fact or LIST) parse; they're walked too. Otherwise the sample
+//data runs to the end of the file, rounded down to whole frames, or to the first of any known
+//subchunks (fact, LIST, cue, ...) found chained to the end of the file within its last
+//TRAILING_SCAN_SIZE bytes. Only the size fields are rewritten, in place with positional writes;
+//the sample data is never copied.
+class WavRepair {
+
+public:
+
+    //Check one file and patch it if needed; result may be nullptr
+    static bool repair(const char *filePath,
+                       WavRepairResult *result = nullptr,
+                       bool dryRun = false);
+
+    //repair() every .wav file in a directory (not recursive), numThreads at a time
+    //(0: one per hardware thread). Returns false if any file couldn't be parsed or patched;
+    //the others are still repaired. Unix and macOS only; elsewhere it fails with a message.
+    static bool repairDirectory(const char *dirPath,
+                                uint32_t *numRepaired = nullptr,
+                                uint32_t numThreads = 0,
+                                bool dryRun = false);
+
+
+    static const uint32_t TRAILING_SCAN_SIZE = 1024 * 1024;
+
+
+private:
+
+    //Header fields gathered from the subchunks, wherever they are
+    typedef struct {
+        uint16_t blockAlign;
+        uint32_t framesPerBlock; //More than one only for IMA ADPCM
+        uint64_t factOffset; //Of the fact subchunk's numSamplesPerChannel field; 0 if there's none
+        uint32_t factNumFrames;
+    } HeaderFields;
+
+    //Note fmt or fact fields from the subchunk whose header is at offset
+    static void readSubchunkFields(FILE *file,
+                                   const SubchunkHeader *header, //Size already in host order
+                                   uint64_t offset,
+                                   bool bigEndian,
+                                   HeaderFields *fields);
+
+    //True if [offset, fileSize) is a whole number of well-formed subchunks, e.g. a fact after the data
+    static bool trailingSubchunksFit(FILE *file,
+                                     uint64_t offset,
+                                     uint64_t fileSize,
+                                     bool bigEndian,
+                                     HeaderFields *fields);
+
+    //Where the known subchunks chained to the end of the file begin; fileSize if there are none
+    static uint64_t findTrailingSubchunks(FILE *file,
+                                          uint64_t dataOffset,
+                                          uint64_t fileSize,
+                                          bool bigEndian,
+                                          HeaderFields *fields);
+};
+
+
+#endif //__WAV_REPAIR_HPP__
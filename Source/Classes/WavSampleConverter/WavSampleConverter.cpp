@@ -0,0 +1,961 @@
+//WavSampleConverter.cpp
+
+
+#include <cmath> //floor()
+#include <cstring> //memcpy()
+#include <cstdio>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h> //_mm_shuffle_epi8()
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "WavSampleConverter.hpp"
+
+
+static const float INV_TWO_POW_7_AS_FLOAT32 = 1.0f / 128.0f;
+static const float INV_TWO_POW_15_AS_FLOAT32 = 1.0f / 32768.0f;
+static const float INV_TWO_POW_23_AS_FLOAT32 = 1.0f / 8388608.0f;
+static const double INV_TWO_POW_31_AS_FLOAT64 = 1.0 / 2147483648.0;
+
+
+//G.711 decode tables: each 8-bit code's 16-bit linear value (ITU-T G.711 reference decoders)
+static const int16_t ALAW_TO_INT16[256] = {
+     -5504,  -5248,  -6016,  -5760,  -4480,  -4224,  -4992,  -4736,
+     -7552,  -7296,  -8064,  -7808,  -6528,  -6272,  -7040,  -6784,
+     -2752,  -2624,  -3008,  -2880,  -2240,  -2112,  -2496,  -2368,
+     -3776,  -3648,  -4032,  -3904,  -3264,  -3136,  -3520,  -3392,
+    -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+    -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+    -11008, -10496, -12032, -11520,  -8960,  -8448,  -9984,  -9472,
+    -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+      -344,   -328,   -376,   -360,   -280,   -264,   -312,   -296,
+      -472,   -456,   -504,   -488,   -408,   -392,   -440,   -424,
+       -88,    -72,   -120,   -104,    -24,     -8,    -56,    -40,
+      -216,   -200,   -248,   -232,   -152,   -136,   -184,   -168,
+     -1376,  -1312,  -1504,  -1440,  -1120,  -1056,  -1248,  -1184,
+     -1888,  -1824,  -2016,  -1952,  -1632,  -1568,  -1760,  -1696,
+      -688,   -656,   -752,   -720,   -560,   -528,   -624,   -592,
+      -944,   -912,  -1008,   -976,   -816,   -784,   -880,   -848,
+      5504,   5248,   6016,   5760,   4480,   4224,   4992,   4736,
+      7552,   7296,   8064,   7808,   6528,   6272,   7040,   6784,
+      2752,   2624,   3008,   2880,   2240,   2112,   2496,   2368,
+      3776,   3648,   4032,   3904,   3264,   3136,   3520,   3392,
+     22016,  20992,  24064,  23040,  17920,  16896,  19968,  18944,
+     30208,  29184,  32256,  31232,  26112,  25088,  28160,  27136,
+     11008,  10496,  12032,  11520,   8960,   8448,   9984,   9472,
+     15104,  14592,  16128,  15616,  13056,  12544,  14080,  13568,
+       344,    328,    376,    360,    280,    264,    312,    296,
+       472,    456,    504,    488,    408,    392,    440,    424,
+        88,     72,    120,    104,     24,      8,     56,     40,
+       216,    200,    248,    232,    152,    136,    184,    168,
+      1376,   1312,   1504,   1440,   1120,   1056,   1248,   1184,
+      1888,   1824,   2016,   1952,   1632,   1568,   1760,   1696,
+       688,    656,    752,    720,    560,    528,    624,    592,
+       944,    912,   1008,    976,    816,    784,    880,    848
+};
+
+
+static const int16_t MULAW_TO_INT16[256] = {
+    -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+    -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+    -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+    -11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+     -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+     -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+     -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+     -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+     -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+     -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+      -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+      -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+      -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+      -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+      -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+       -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+     32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+     23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+     15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+     11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+      7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+      5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+      3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+      2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+      1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+      1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+       876,    844,    812,    780,    748,    716,    684,    652,
+       620,    588,    556,    524,    492,    460,    428,    396,
+       372,    356,    340,    324,    308,    292,    276,    260,
+       244,    228,    212,    196,    180,    164,    148,    132,
+       120,    112,    104,     96,     88,     80,     72,     64,
+        56,     48,     40,     32,     24,     16,      8,      0
+};
+
+
+WavSampleFormat wavSampleFormat(bool samplesAreInts, uint32_t byteDepth) {
+
+    if (samplesAreInts) {
+        switch (byteDepth) {
+            case 1:
+                return WAV_SAMPLE_FORMAT_UINT8;
+            case 2:
+                return WAV_SAMPLE_FORMAT_INT16;
+            case 3:
+                return WAV_SAMPLE_FORMAT_INT24;
+            case 4:
+                return WAV_SAMPLE_FORMAT_INT32;
+            default:
+                return WAV_SAMPLE_FORMAT_INVALID;
+        }
+    }
+
+    switch (byteDepth) {
+        case 4:
+            return WAV_SAMPLE_FORMAT_FLOAT32;
+        case 8:
+            return WAV_SAMPLE_FORMAT_FLOAT64;
+        default:
+            return WAV_SAMPLE_FORMAT_INVALID;
+    }
+}
+
+
+WavSampleFormat wavSampleFormatFromAudioFormat(uint16_t audioFormat, uint32_t byteDepth) {
+
+    switch (audioFormat) {
+        case AUDIO_FORMAT_INT:
+            return wavSampleFormat(true, byteDepth);
+        case AUDIO_FORMAT_FLOAT:
+            return wavSampleFormat(false, byteDepth);
+        case AUDIO_FORMAT_ALAW:
+            return (byteDepth == 1) ? WAV_SAMPLE_FORMAT_ALAW : WAV_SAMPLE_FORMAT_INVALID;
+        case AUDIO_FORMAT_MULAW:
+            return (byteDepth == 1) ? WAV_SAMPLE_FORMAT_MULAW : WAV_SAMPLE_FORMAT_INVALID;
+        default:
+            return WAV_SAMPLE_FORMAT_INVALID;
+    }
+}
+
+
+uint16_t wavSampleFormatAudioFormat(WavSampleFormat format) {
+
+    switch (format) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+        case WAV_SAMPLE_FORMAT_INT16:
+        case WAV_SAMPLE_FORMAT_INT24:
+        case WAV_SAMPLE_FORMAT_INT32:
+            return AUDIO_FORMAT_INT;
+        case WAV_SAMPLE_FORMAT_FLOAT32:
+        case WAV_SAMPLE_FORMAT_FLOAT64:
+            return AUDIO_FORMAT_FLOAT;
+        case WAV_SAMPLE_FORMAT_ALAW:
+            return AUDIO_FORMAT_ALAW;
+        case WAV_SAMPLE_FORMAT_MULAW:
+            return AUDIO_FORMAT_MULAW;
+        default:
+            return 0;
+    }
+}
+
+
+uint32_t wavSampleFormatByteDepth(WavSampleFormat format) {
+
+    switch (format) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+        case WAV_SAMPLE_FORMAT_ALAW:
+        case WAV_SAMPLE_FORMAT_MULAW:
+            return 1;
+        case WAV_SAMPLE_FORMAT_INT16:
+            return 2;
+        case WAV_SAMPLE_FORMAT_INT24:
+            return 3;
+        case WAV_SAMPLE_FORMAT_INT32:
+        case WAV_SAMPLE_FORMAT_FLOAT32:
+            return 4;
+        case WAV_SAMPLE_FORMAT_FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+
+//Each loop below is a straight, branch-free pass over contiguous memory so the
+//compiler can vectorize it; memcpy() loads avoid unaligned/aliasing access.
+bool wavDecodeToFloats(const uint8_t sampleData[],
+                       WavSampleFormat format,
+                       float floatSamples[],
+                       uint32_t numValues) {
+
+    switch (format) {
+
+        case WAV_SAMPLE_FORMAT_UINT8: {
+            //8-bit data is unsigned, centered on 128
+            for (uint32_t i = 0; i < numValues; i++) {
+                floatSamples[i] = ((int32_t) sampleData[i] - 128) * INV_TWO_POW_7_AS_FLOAT32;
+            }
+            break;
+        }
+
+        case WAV_SAMPLE_FORMAT_INT16: {
+            for (uint32_t i = 0; i < numValues; i++) {
+                int16_t value;
+                memcpy(&value, sampleData + i * 2, sizeof(int16_t));
+                floatSamples[i] = value * INV_TWO_POW_15_AS_FLOAT32;
+            }
+            break;
+        }
+
+        case WAV_SAMPLE_FORMAT_INT24: {
+            for (uint32_t i = 0; i < numValues; i++) {
+                const uint8_t *bytes = sampleData + i * 3;
+                //Assemble in the top 24 bits, then arithmetic-shift for sign extension
+                int32_t value = (int32_t) (((uint32_t) bytes[0] << 8) |
+                                           ((uint32_t) bytes[1] << 16) |
+                                           ((uint32_t) bytes[2] << 24)) >> 8;
+                floatSamples[i] = value * INV_TWO_POW_23_AS_FLOAT32;
+            }
+            break;
+        }
+
+        case WAV_SAMPLE_FORMAT_INT32: {
+            for (uint32_t i = 0; i < numValues; i++) {
+                int32_t value;
+                memcpy(&value, sampleData + i * 4, sizeof(int32_t));
+                floatSamples[i] = (float) (value * INV_TWO_POW_31_AS_FLOAT64);
+            }
+            break;
+        }
+
+        case WAV_SAMPLE_FORMAT_FLOAT32: {
+            memcpy(floatSamples, sampleData, numValues * sizeof(float));
+            break;
+        }
+
+        case WAV_SAMPLE_FORMAT_FLOAT64: {
+            for (uint32_t i = 0; i < numValues; i++) {
+                double value;
+                memcpy(&value, sampleData + i * 8, sizeof(double));
+                floatSamples[i] = (float) value;
+            }
+            break;
+        }
+
+        case WAV_SAMPLE_FORMAT_ALAW: {
+            for (uint32_t i = 0; i < numValues; i++) {
+                floatSamples[i] = ALAW_TO_INT16[sampleData[i]] * INV_TWO_POW_15_AS_FLOAT32;
+            }
+            break;
+        }
+
+        case WAV_SAMPLE_FORMAT_MULAW: {
+            for (uint32_t i = 0; i < numValues; i++) {
+                floatSamples[i] = MULAW_TO_INT16[sampleData[i]] * INV_TWO_POW_15_AS_FLOAT32;
+            }
+            break;
+        }
+
+        default: {
+            fprintf(stderr, "Error: Unsupported sample format.\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+//Fused format-to-format kernels.
+//Each format gets a traits struct; the kernel templates instantiate one tight loop per
+//(source, destination) pair, so no intermediate buffer is written between decode and encode.
+
+static inline int32_t saturatingShiftRight(int32_t value, uint32_t shift) {
+    //Round to nearest; rounding up from the largest code saturates instead of wrapping
+    int64_t rounded = ((int64_t) value + ((int64_t) 1 << (shift - 1))) >> shift;
+    int64_t maxValue = ((int64_t) 1 << (31 - shift)) - 1;
+    return (int32_t) ((rounded > maxValue) ? maxValue : rounded);
+}
+
+static inline int64_t roundAndClamp(double value, int64_t minValue, int64_t maxValue) {
+    //Selects rather than branches, so loops calling this can still be vectorized
+    double rounded = floor(value + 0.5);
+    rounded = (rounded < (double) minValue) ? (double) minValue : rounded;
+    rounded = (rounded > (double) maxValue) ? (double) maxValue : rounded;
+    rounded = (value == value) ? rounded : 0.0; //NaN
+    return (int64_t) rounded;
+}
+
+
+struct UInt8Traits {
+    static const uint32_t SIZE = 1;
+
+    static inline int32_t decodeInt32(const uint8_t *p) {
+        return (int32_t) ((uint32_t) ((int32_t) p[0] - 128) << 24);
+    }
+
+    static inline void encodeInt32(uint8_t *p, int32_t value) {
+        p[0] = (uint8_t) (saturatingShiftRight(value, 24) + 128);
+    }
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        return ((int32_t) p[0] - 128) * (1.0 / 128.0);
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        return ((int32_t) p[0] - 128) * INV_TWO_POW_7_AS_FLOAT32;
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        p[0] = (uint8_t) (roundAndClamp(value * 128.0, -128, 127) + 128);
+    }
+};
+
+
+struct Int16Traits {
+    static const uint32_t SIZE = 2;
+
+    static inline int32_t decodeInt32(const uint8_t *p) {
+        int16_t value;
+        memcpy(&value, p, sizeof(int16_t));
+        return (int32_t) ((uint32_t) (int32_t) value << 16);
+    }
+
+    static inline void encodeInt32(uint8_t *p, int32_t value) {
+        int16_t v = (int16_t) saturatingShiftRight(value, 16);
+        memcpy(p, &v, sizeof(int16_t));
+    }
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        int16_t value;
+        memcpy(&value, p, sizeof(int16_t));
+        return value * (1.0 / 32768.0);
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        int16_t value;
+        memcpy(&value, p, sizeof(int16_t));
+        return value * INV_TWO_POW_15_AS_FLOAT32;
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        int16_t v = (int16_t) roundAndClamp(value * 32768.0, -32768, 32767);
+        memcpy(p, &v, sizeof(int16_t));
+    }
+};
+
+
+struct Int24Traits {
+    static const uint32_t SIZE = 3;
+
+    static inline int32_t decodeInt32(const uint8_t *p) {
+        return (int32_t) (((uint32_t) p[0] << 8) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 24));
+    }
+
+    static inline void encodeInt32(uint8_t *p, int32_t value) {
+        uint32_t v = (uint32_t) saturatingShiftRight(value, 8);
+        p[0] = (uint8_t) v;
+        p[1] = (uint8_t) (v >> 8);
+        p[2] = (uint8_t) (v >> 16);
+    }
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        return (decodeInt32(p) >> 8) * (1.0 / 8388608.0);
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        return (decodeInt32(p) >> 8) * INV_TWO_POW_23_AS_FLOAT32;
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        uint32_t v = (uint32_t) roundAndClamp(value * 8388608.0, -8388608, 8388607);
+        p[0] = (uint8_t) v;
+        p[1] = (uint8_t) (v >> 8);
+        p[2] = (uint8_t) (v >> 16);
+    }
+};
+
+
+struct Int32Traits {
+    static const uint32_t SIZE = 4;
+
+    static inline int32_t decodeInt32(const uint8_t *p) {
+        int32_t value;
+        memcpy(&value, p, sizeof(int32_t));
+        return value;
+    }
+
+    static inline void encodeInt32(uint8_t *p, int32_t value) {
+        memcpy(p, &value, sizeof(int32_t));
+    }
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        return decodeInt32(p) * INV_TWO_POW_31_AS_FLOAT64;
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        return (float) decodeFloat64(p);
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        int32_t v = (int32_t) roundAndClamp(value * 2147483648.0, INT32_MIN, INT32_MAX);
+        memcpy(p, &v, sizeof(int32_t));
+    }
+};
+
+
+struct Float32Traits {
+    static const uint32_t SIZE = 4;
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        float value;
+        memcpy(&value, p, sizeof(float));
+        return value;
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        float value;
+        memcpy(&value, p, sizeof(float));
+        return value;
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        float v = (float) value;
+        memcpy(p, &v, sizeof(float));
+    }
+};
+
+
+struct Float64Traits {
+    static const uint32_t SIZE = 8;
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        double value;
+        memcpy(&value, p, sizeof(double));
+        return value;
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        return (float) decodeFloat64(p);
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        memcpy(p, &value, sizeof(double));
+    }
+};
+
+
+//G.711 encoders, after the ITU-T reference: the segment is the position of the magnitude's
+//highest set bit, found with a count-leading-zeros instruction rather than a table search
+
+static inline uint32_t highestBitIndex(uint32_t value) { //value must be non-zero
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - (uint32_t) __builtin_clz(value);
+#else
+    uint32_t index = 0;
+    while (value >>= 1) {
+        index++;
+    }
+    return index;
+#endif
+}
+
+static inline uint8_t alawFromInt16(int16_t value) {
+    //13-bit magnitude; negative values use one's complement, so -32768 maps to 4095
+    int32_t linear = value >> 3;
+    uint8_t mask = (linear >= 0) ? 0xD5 : 0x55;
+    uint32_t magnitude = (uint32_t) ((linear >= 0) ? linear : -linear - 1);
+    uint32_t segment = highestBitIndex(magnitude | 0x1F) - 4; //0-7
+    uint32_t mantissa = (magnitude >> ((segment > 1) ? segment : 1)) & 0x0F;
+    return (uint8_t) (((segment << 4) | mantissa) ^ mask);
+}
+
+static inline uint8_t mulawFromInt16(int16_t value) {
+    //14-bit magnitude plus bias, clipped to the top of the last segment
+    int32_t linear = value >> 2;
+    uint8_t mask = (linear >= 0) ? 0xFF : 0x7F;
+    uint32_t magnitude = (uint32_t) ((linear >= 0) ? linear : -linear) + 0x21;
+    magnitude = (magnitude > 0x1FFF) ? 0x1FFF : magnitude;
+    uint32_t segment = highestBitIndex(magnitude) - 5; //0-7
+    uint32_t mantissa = (magnitude >> (segment + 1)) & 0x0F;
+    return (uint8_t) (((segment << 4) | mantissa) ^ mask);
+}
+
+
+struct ALawTraits {
+    static const uint32_t SIZE = 1;
+
+    static inline int32_t decodeInt32(const uint8_t *p) {
+        return (int32_t) ((uint32_t) (int32_t) ALAW_TO_INT16[p[0]] << 16);
+    }
+
+    static inline void encodeInt32(uint8_t *p, int32_t value) {
+        p[0] = alawFromInt16((int16_t) saturatingShiftRight(value, 16));
+    }
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        return ALAW_TO_INT16[p[0]] * (1.0 / 32768.0);
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        return ALAW_TO_INT16[p[0]] * INV_TWO_POW_15_AS_FLOAT32;
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        p[0] = alawFromInt16((int16_t) roundAndClamp(value * 32768.0, -32768, 32767));
+    }
+};
+
+
+struct MuLawTraits {
+    static const uint32_t SIZE = 1;
+
+    static inline int32_t decodeInt32(const uint8_t *p) {
+        return (int32_t) ((uint32_t) (int32_t) MULAW_TO_INT16[p[0]] << 16);
+    }
+
+    static inline void encodeInt32(uint8_t *p, int32_t value) {
+        p[0] = mulawFromInt16((int16_t) saturatingShiftRight(value, 16));
+    }
+
+    static inline double decodeFloat64(const uint8_t *p) {
+        return MULAW_TO_INT16[p[0]] * (1.0 / 32768.0);
+    }
+
+    static inline float decodeFloat32(const uint8_t *p) {
+        return MULAW_TO_INT16[p[0]] * INV_TWO_POW_15_AS_FLOAT32;
+    }
+
+    static inline void encodeFloat64(uint8_t *p, double value) {
+        p[0] = mulawFromInt16((int16_t) roundAndClamp(value * 32768.0, -32768, 32767));
+    }
+};
+
+
+template<class Src, class Dest>
+static void convertIntKernel(const uint8_t *src, uint8_t *dest, uint32_t numValues) {
+    for (size_t i = 0; i < numValues; i++) {
+        Dest::encodeInt32(dest + i * Dest::SIZE, Src::decodeInt32(src + i * Src::SIZE));
+    }
+}
+
+
+template<class Src, class Dest>
+static void convertFloatKernel(const uint8_t *src, uint8_t *dest, uint32_t numValues) {
+    for (size_t i = 0; i < numValues; i++) {
+        Dest::encodeFloat64(dest + i * Dest::SIZE, Src::decodeFloat64(src + i * Src::SIZE));
+    }
+}
+
+
+template<class Src>
+static bool convertFromIntFormat(const uint8_t *src, uint8_t *dest, WavSampleFormat destFormat, uint32_t numValues) {
+    switch (destFormat) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+            convertIntKernel<Src, UInt8Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT16:
+            convertIntKernel<Src, Int16Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT24:
+            convertIntKernel<Src, Int24Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT32:
+            convertIntKernel<Src, Int32Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT32:
+            convertFloatKernel<Src, Float32Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT64:
+            convertFloatKernel<Src, Float64Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_ALAW:
+            convertIntKernel<Src, ALawTraits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_MULAW:
+            convertIntKernel<Src, MuLawTraits>(src, dest, numValues);
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+template<class Src>
+static bool convertFromFloatFormat(const uint8_t *src, uint8_t *dest, WavSampleFormat destFormat, uint32_t numValues) {
+    switch (destFormat) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+            convertFloatKernel<Src, UInt8Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT16:
+            convertFloatKernel<Src, Int16Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT24:
+            convertFloatKernel<Src, Int24Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT32:
+            convertFloatKernel<Src, Int32Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT32:
+            convertFloatKernel<Src, Float32Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT64:
+            convertFloatKernel<Src, Float64Traits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_ALAW:
+            convertFloatKernel<Src, ALawTraits>(src, dest, numValues);
+            return true;
+        case WAV_SAMPLE_FORMAT_MULAW:
+            convertFloatKernel<Src, MuLawTraits>(src, dest, numValues);
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+bool wavConvertSamples(const uint8_t srcSampleData[],
+                       WavSampleFormat srcFormat,
+                       uint8_t destSampleData[],
+                       WavSampleFormat destFormat,
+                       uint32_t numValues) {
+
+    if (srcFormat == destFormat && srcFormat != WAV_SAMPLE_FORMAT_INVALID) {
+        memmove(destSampleData, srcSampleData, (size_t) numValues * wavSampleFormatByteDepth(srcFormat));
+        return true;
+    }
+
+    bool ok = false;
+    switch (srcFormat) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+            ok = convertFromIntFormat<UInt8Traits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        case WAV_SAMPLE_FORMAT_INT16:
+            ok = convertFromIntFormat<Int16Traits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        case WAV_SAMPLE_FORMAT_INT24:
+            ok = convertFromIntFormat<Int24Traits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        case WAV_SAMPLE_FORMAT_INT32:
+            ok = convertFromIntFormat<Int32Traits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        case WAV_SAMPLE_FORMAT_FLOAT32:
+            ok = convertFromFloatFormat<Float32Traits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        case WAV_SAMPLE_FORMAT_FLOAT64:
+            ok = convertFromFloatFormat<Float64Traits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        case WAV_SAMPLE_FORMAT_ALAW:
+            ok = convertFromIntFormat<ALawTraits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        case WAV_SAMPLE_FORMAT_MULAW:
+            ok = convertFromIntFormat<MuLawTraits>(srcSampleData, destSampleData, destFormat, numValues);
+            break;
+        default:
+            break;
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Error: Unsupported sample format conversion.\n");
+    }
+
+    return ok;
+}
+
+
+
+//Planar kernels.
+//Mono and stereo get dedicated loops that walk frame by frame, so each frame's channels are
+//(de)interleaved in registers as they are converted: with a constant stride the compiler turns
+//the accesses into vector loads plus shuffles. Other channel counts take the generic loop.
+//size_t indices: with uint32_t ones the byte offsets may wrap, which blocks vectorization.
+
+template<class Format>
+static void decodeMonoKernel(const uint8_t *src, float *dest, uint32_t numFrames) {
+    for (size_t i = 0; i < numFrames; i++) {
+        dest[i] = Format::decodeFloat32(src + i * Format::SIZE);
+    }
+}
+
+
+template<class Format>
+static void decodeStereoKernel(const uint8_t *src, float *left, float *right, uint32_t numFrames) {
+    for (size_t i = 0; i < numFrames; i++) {
+        left[i] = Format::decodeFloat32(src + (2 * i) * Format::SIZE);
+        right[i] = Format::decodeFloat32(src + (2 * i + 1) * Format::SIZE);
+    }
+}
+
+
+template<class Format>
+static void decodePlanarKernelGeneric(const uint8_t *src, float *const channels[], uint32_t numChannels, uint32_t numFrames) {
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        float *dest = channels[ch];
+        for (size_t i = 0; i < numFrames; i++) {
+            dest[i] = Format::decodeFloat32(src + (i * numChannels + ch) * Format::SIZE);
+        }
+    }
+}
+
+
+template<class Format>
+static void encodeMonoKernel(const float *src, uint8_t *dest, uint32_t numFrames) {
+    for (size_t i = 0; i < numFrames; i++) {
+        Format::encodeFloat64(dest + i * Format::SIZE, src[i]);
+    }
+}
+
+
+template<class Format>
+static void encodeStereoKernel(const float *left, const float *right, uint8_t *dest, uint32_t numFrames) {
+    for (size_t i = 0; i < numFrames; i++) {
+        Format::encodeFloat64(dest + (2 * i) * Format::SIZE, left[i]);
+        Format::encodeFloat64(dest + (2 * i + 1) * Format::SIZE, right[i]);
+    }
+}
+
+
+template<class Format>
+static void encodePlanarKernelGeneric(const float *const channels[], uint32_t numChannels, uint8_t *dest, uint32_t numFrames) {
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        const float *src = channels[ch];
+        for (size_t i = 0; i < numFrames; i++) {
+            Format::encodeFloat64(dest + (i * numChannels + ch) * Format::SIZE, src[i]);
+        }
+    }
+}
+
+
+template<class Format>
+static void decodePlanar(const uint8_t *src, float *const channels[], uint32_t numChannels, uint32_t numFrames) {
+    switch (numChannels) {
+        case 1:
+            decodeMonoKernel<Format>(src, channels[0], numFrames);
+            break;
+        case 2:
+            decodeStereoKernel<Format>(src, channels[0], channels[1], numFrames);
+            break;
+        default:
+            decodePlanarKernelGeneric<Format>(src, channels, numChannels, numFrames);
+            break;
+    }
+}
+
+
+template<class Format>
+static void encodePlanar(const float *const channels[], uint32_t numChannels, uint8_t *dest, uint32_t numFrames) {
+    switch (numChannels) {
+        case 1:
+            encodeMonoKernel<Format>(channels[0], dest, numFrames);
+            break;
+        case 2:
+            encodeStereoKernel<Format>(channels[0], channels[1], dest, numFrames);
+            break;
+        default:
+            encodePlanarKernelGeneric<Format>(channels, numChannels, dest, numFrames);
+            break;
+    }
+}
+
+
+bool wavDecodeToPlanarFloats(const uint8_t sampleData[],
+                             WavSampleFormat format,
+                             float *const channels[],
+                             uint32_t numChannels,
+                             uint32_t numFrames) {
+
+    switch (format) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+            decodePlanar<UInt8Traits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT16:
+            decodePlanar<Int16Traits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT24:
+            decodePlanar<Int24Traits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT32:
+            decodePlanar<Int32Traits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT32:
+            decodePlanar<Float32Traits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT64:
+            decodePlanar<Float64Traits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_ALAW:
+            decodePlanar<ALawTraits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_MULAW:
+            decodePlanar<MuLawTraits>(sampleData, channels, numChannels, numFrames);
+            return true;
+        default:
+            fprintf(stderr, "Error: Unsupported sample format.\n");
+            return false;
+    }
+}
+
+
+bool wavEncodeFromPlanarFloats(const float *const channels[],
+                               uint32_t numChannels,
+                               uint8_t sampleData[],
+                               WavSampleFormat format,
+                               uint32_t numFrames) {
+
+    switch (format) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+            encodePlanar<UInt8Traits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT16:
+            encodePlanar<Int16Traits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT24:
+            encodePlanar<Int24Traits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_INT32:
+            encodePlanar<Int32Traits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT32:
+            encodePlanar<Float32Traits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_FLOAT64:
+            encodePlanar<Float64Traits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_ALAW:
+            encodePlanar<ALawTraits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        case WAV_SAMPLE_FORMAT_MULAW:
+            encodePlanar<MuLawTraits>(channels, numChannels, sampleData, numFrames);
+            return true;
+        default:
+            fprintf(stderr, "Error: Unsupported sample format.\n");
+            return false;
+    }
+}
+
+
+//Byte order kernels, for RIFX (big-endian) sample data.
+//Sixteen bytes at a time: one byte shuffle with SSSE3 or NEON, byte shifts plus word shuffles
+//with plain SSE2. 24-bit values don't fill a vector evenly, so with SSSE3 they go sixteen at a
+//time through three registers, each output register gathered from the inputs it overlaps;
+//elsewhere they take the scalar loop.
+
+template<uint32_t SIZE>
+static inline void swapValue(const uint8_t *src, uint8_t *dest) {
+    uint8_t value[SIZE];
+    for (uint32_t i = 0; i < SIZE; i++) {
+        value[i] = src[SIZE - 1 - i];
+    }
+    memcpy(dest, value, SIZE);
+}
+
+#if defined(__SSSE3__)
+template<uint32_t SIZE>
+static inline void swapVector(const uint8_t *src, uint8_t *dest) {
+    const __m128i mask = (SIZE == 2) ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) :
+                         (SIZE == 4) ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12) :
+                                       _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    __m128i v = _mm_loadu_si128((const __m128i *) src);
+    _mm_storeu_si128((__m128i *) dest, _mm_shuffle_epi8(v, mask));
+}
+
+//48 bytes: sixteen 24-bit values. Mask entries of -128 select zero, so each part can be OR'd in.
+static inline void swapVectors24(const uint8_t *src, uint8_t *dest) {
+    const __m128i v0 = _mm_loadu_si128((const __m128i *) src);
+    const __m128i v1 = _mm_loadu_si128((const __m128i *) (src + 16));
+    const __m128i v2 = _mm_loadu_si128((const __m128i *) (src + 32));
+    const __m128i out0 =
+            _mm_or_si128(_mm_shuffle_epi8(v0, _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -128)),
+                         _mm_shuffle_epi8(v1, _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128,
+                                                            -128, -128, -128, -128, -128, -128, -128, 1)));
+    const __m128i out1 =
+            _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, _mm_setr_epi8(-128, 15, -128, -128, -128, -128, -128, -128,
+                                                                         -128, -128, -128, -128, -128, -128, -128, -128)),
+                                      _mm_shuffle_epi8(v1, _mm_setr_epi8(0, -128, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -128, 15))),
+                         _mm_shuffle_epi8(v2, _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128,
+                                                            -128, -128, -128, -128, -128, -128, 0, -128)));
+    const __m128i out2 =
+            _mm_or_si128(_mm_shuffle_epi8(v1, _mm_setr_epi8(14, -128, -128, -128, -128, -128, -128, -128,
+                                                            -128, -128, -128, -128, -128, -128, -128, -128)),
+                         _mm_shuffle_epi8(v2, _mm_setr_epi8(-128, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13)));
+    _mm_storeu_si128((__m128i *) dest, out0);
+    _mm_storeu_si128((__m128i *) (dest + 16), out1);
+    _mm_storeu_si128((__m128i *) (dest + 32), out2);
+}
+#elif defined(__SSE2__)
+template<uint32_t SIZE>
+static inline void swapVector(const uint8_t *src, uint8_t *dest) {
+    __m128i v = _mm_loadu_si128((const __m128i *) src);
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)); //Bytes within each 16-bit word
+    if (SIZE == 4) {
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1); //Then words within each 32-bit value
+    } else if (SIZE == 8) {
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B); //Then words within each 64-bit value
+    }
+    _mm_storeu_si128((__m128i *) dest, v);
+}
+#elif defined(__ARM_NEON)
+template<uint32_t SIZE>
+static inline void swapVector(const uint8_t *src, uint8_t *dest) {
+    uint8x16_t v = vld1q_u8(src);
+    v = (SIZE == 2) ? vrev16q_u8(v) : (SIZE == 4) ? vrev32q_u8(v) : vrev64q_u8(v);
+    vst1q_u8(dest, v);
+}
+#endif
+
+template<uint32_t SIZE>
+static void swapKernel(const uint8_t *src, uint8_t *dest, size_t numValues) {
+
+    const size_t numBytes = numValues * SIZE;
+    size_t i = 0;
+#if defined(__SSSE3__)
+    if (SIZE == 3) {
+        for (; i + 48 <= numBytes; i += 48) {
+            swapVectors24(src + i, dest + i);
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    if (SIZE != 3) {
+        for (; i + 16 <= numBytes; i += 16) {
+            swapVector<SIZE>(src + i, dest + i);
+        }
+    }
+#endif
+    for (; i < numBytes; i += SIZE) {
+        swapValue<SIZE>(src + i, dest + i);
+    }
+}
+
+
+bool wavSwapSampleBytes(const uint8_t srcSampleData[],
+                        WavSampleFormat format,
+                        uint8_t destSampleData[],
+                        uint32_t numValues) {
+
+    switch (wavSampleFormatByteDepth(format)) {
+        case 1:
+            if (srcSampleData != destSampleData) {
+                memmove(destSampleData, srcSampleData, numValues);
+            }
+            return true;
+        case 2:
+            swapKernel<2>(srcSampleData, destSampleData, numValues);
+            return true;
+        case 3:
+            swapKernel<3>(srcSampleData, destSampleData, numValues);
+            return true;
+        case 4:
+            swapKernel<4>(srcSampleData, destSampleData, numValues);
+            return true;
+        case 8:
+            swapKernel<8>(srcSampleData, destSampleData, numValues);
+            return true;
+        default:
+            fprintf(stderr, "Error: Unsupported sample format.\n");
+            return false;
+    }
+}
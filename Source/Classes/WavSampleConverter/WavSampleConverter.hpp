@@ -0,0 +1,77 @@
+//WavSampleConverter.hpp
+
+#ifndef __WAV_SAMPLE_CONVERTER_HPP__
+#define __WAV_SAMPLE_CONVERTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavHeader.hpp"
+
+
+//On-disk encoding of a single channel of a sample
+typedef enum {
+    WAV_SAMPLE_FORMAT_UINT8 = 0,
+    WAV_SAMPLE_FORMAT_INT16 = 1,
+    WAV_SAMPLE_FORMAT_INT24 = 2,
+    WAV_SAMPLE_FORMAT_INT32 = 3,
+    WAV_SAMPLE_FORMAT_FLOAT32 = 4,
+    WAV_SAMPLE_FORMAT_FLOAT64 = 5,
+    WAV_SAMPLE_FORMAT_ALAW = 6, //G.711 A-law, 8-bit companded
+    WAV_SAMPLE_FORMAT_MULAW = 7, //G.711 mu-law, 8-bit companded
+    WAV_SAMPLE_FORMAT_INVALID = 8
+} WavSampleFormat;
+
+
+//Maps the (samplesAreInts, byteDepth) pair used by WavReader/WavWriter to a linear PCM sample format
+WavSampleFormat wavSampleFormat(bool samplesAreInts, uint32_t byteDepth);
+
+//Maps a format subchunk's audioFormat and byte depth to a sample format, and back
+WavSampleFormat wavSampleFormatFromAudioFormat(uint16_t audioFormat, uint32_t byteDepth);
+
+uint16_t wavSampleFormatAudioFormat(WavSampleFormat format);
+
+uint32_t wavSampleFormatByteDepth(WavSampleFormat format);
+
+//Decode wav-format values to floats; full scale is [-1.0, 1.0)
+//numValues counts single-channel values, i.e. numFrames * numChannels
+bool wavDecodeToFloats(const uint8_t sampleData[], //wav-format sample data
+                       WavSampleFormat format,
+                       float floatSamples[],
+                       uint32_t numValues);
+
+//Convert wav-format values from one sample format to another in a single pass.
+//Int-to-int conversions go through 32-bit integers and are exact when widening;
+//anything involving float goes through float64. Narrowing rounds and saturates.
+//A-law and mu-law decode through 256-entry tables and encode from 16-bit linear values.
+bool wavConvertSamples(const uint8_t srcSampleData[],
+                       WavSampleFormat srcFormat,
+                       uint8_t destSampleData[],
+                       WavSampleFormat destFormat,
+                       uint32_t numValues);
+
+//Decode interleaved wav-format frames straight into one float array per channel
+//(deinterleave fused with the decode). channels[ch] receives numFrames values.
+bool wavDecodeToPlanarFloats(const uint8_t sampleData[], //wav-format sample data
+                             WavSampleFormat format,
+                             float *const channels[],
+                             uint32_t numChannels,
+                             uint32_t numFrames);
+
+//Encode one float array per channel straight into interleaved wav-format frames
+//(interleave fused with the encode). Rounds and saturates like wavConvertSamples().
+bool wavEncodeFromPlanarFloats(const float *const channels[],
+                               uint32_t numChannels,
+                               uint8_t sampleData[], //wav-format sample data
+                               WavSampleFormat format,
+                               uint32_t numFrames);
+
+
+//Reverse the byte order of every value: RIFX (big-endian) sample data to RIFF order, or back.
+//srcSampleData and destSampleData may be the same array. 8-bit formats are left as they are.
+bool wavSwapSampleBytes(const uint8_t srcSampleData[],
+                        WavSampleFormat format,
+                        uint8_t destSampleData[],
+                        uint32_t numValues);
+
+
+#endif //__WAV_SAMPLE_CONVERTER_HPP__
@@ -0,0 +1,283 @@
+//WavSignalStats.cpp
+
+
+#include <cmath>
+#include <cstdio>
+#include <cfloat> //FLT_MAX
+
+#include "WavSignalStats.hpp"
+
+
+static const char *UNINITIALIZED_MSG = "Attempt to call WavSignalStats class method before calling initialize().\n";
+
+
+WavSignalStats::WavSignalStats() {
+    _pAccumulators = nullptr;
+    _initialized = false;
+}
+
+
+WavSignalStats::~WavSignalStats() {
+    if (_pAccumulators) {
+        delete[] _pAccumulators;
+        _pAccumulators = nullptr;
+    }
+}
+
+
+bool WavSignalStats::initialize(uint32_t numChannels,
+                                WavSampleFormat format) {
+
+    if (numChannels == 0) {
+        fprintf(stderr, "Error: Number of channels must be at least 1.\n");
+        return false;
+    }
+
+    uint32_t byteDepth = wavSampleFormatByteDepth(format);
+    if (byteDepth == 0) {
+        fprintf(stderr, "Error: Unsupported sample format.\n");
+        return false;
+    }
+
+    if (_pAccumulators) {
+        delete[] _pAccumulators;
+        _pAccumulators = nullptr;
+    }
+    _pAccumulators = new ChannelAccumulator[numChannels];
+
+    this->_numChannels = numChannels;
+    this->_format = format;
+    this->_frameSize = numChannels * byteDepth;
+
+    //Integer formats can't reach +1.0; treat their largest code as clipped
+    switch (format) {
+        case WAV_SAMPLE_FORMAT_UINT8:
+            _clipHigh = 127.0f / 128.0f;
+            break;
+        case WAV_SAMPLE_FORMAT_INT16:
+            _clipHigh = 32767.0f / 32768.0f;
+            break;
+        case WAV_SAMPLE_FORMAT_INT24:
+            _clipHigh = 8388607.0f / 8388608.0f;
+            break;
+        case WAV_SAMPLE_FORMAT_INT32:
+            _clipHigh = (float) (2147483647.0 / 2147483648.0); //Rounds to 1.0 in float32
+            break;
+        case WAV_SAMPLE_FORMAT_ALAW:
+            _clipHigh = 32256.0f / 32768.0f; //Largest decoded A-law magnitude
+            break;
+        case WAV_SAMPLE_FORMAT_MULAW:
+            _clipHigh = 32124.0f / 32768.0f; //Largest decoded mu-law magnitude
+            break;
+        default:
+            _clipHigh = 1.0f;
+            break;
+    }
+
+    this->_initialized = true;
+    reset();
+
+    return true;
+}
+
+
+void WavSignalStats::reset() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return;
+    }
+
+    for (uint32_t ch = 0; ch < _numChannels; ch++) {
+        ChannelAccumulator *acc = &_pAccumulators[ch];
+        acc->numValues = 0;
+        acc->min = FLT_MAX;
+        acc->max = -FLT_MAX;
+        acc->sum = 0.0;
+        acc->sumSquares = 0.0;
+        acc->numFinite = 0;
+        acc->numClipped = 0;
+        acc->numNaNs = 0;
+        acc->numInfs = 0;
+    }
+}
+
+
+bool WavSignalStats::accumulate(const uint8_t sampleData[],
+                                uint32_t sampleDataSize) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (sampleDataSize % _frameSize) {
+        fprintf(stderr, "Error: Sample data size doesn't divide evenly by sample block size.\n");
+        return false;
+    }
+
+    const uint32_t framesPerPass = SCRATCH_NUM_VALUES / _numChannels;
+    uint32_t numFrames = sampleDataSize / _frameSize;
+    const uint8_t *src = sampleData;
+
+    while (numFrames > 0) {
+        uint32_t passFrames = (numFrames < framesPerPass) ? numFrames : framesPerPass;
+
+        //Decode once, into a buffer small enough to stay in L1 for the per-channel passes
+        wavDecodeToFloats(src, _format, _scratch, passFrames * _numChannels);
+
+        for (uint32_t ch = 0; ch < _numChannels; ch++) {
+            if (_numChannels == 1) {
+                accumulateChannel(_scratch, passFrames, &_pAccumulators[ch]);
+            } else {
+                //De-interleave through a small stack buffer so the accumulate loop sees contiguous values
+                float channelValues[SCRATCH_NUM_VALUES / 2];
+                for (uint32_t i = 0; i < passFrames; i++) {
+                    channelValues[i] = _scratch[i * _numChannels + ch];
+                }
+                accumulateChannel(channelValues, passFrames, &_pAccumulators[ch]);
+            }
+        }
+
+        src += passFrames * _frameSize;
+        numFrames -= passFrames;
+    }
+
+    return true;
+}
+
+
+//Four independent lanes break the add/min/max dependency chains so the loop
+//maps onto 128-bit SIMD (SSE2/NEON) without needing -ffast-math.
+void WavSignalStats::accumulateChannel(const float values[], uint32_t numFrames, ChannelAccumulator *acc) {
+
+    //Non-finite values are rare; detect them up front and take the careful path
+    uint32_t numNonFinite = 0;
+    for (uint32_t i = 0; i < numFrames; i++) {
+        numNonFinite += !((values[i] - values[i]) == 0.0f); //NaN for both NaN and +/-Inf
+    }
+    if (numNonFinite) {
+        accumulateChannelSlow(values, numFrames, acc);
+        return;
+    }
+
+    float mn[4] = {acc->min, acc->min, acc->min, acc->min};
+    float mx[4] = {acc->max, acc->max, acc->max, acc->max};
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    double sumSq[4] = {0.0, 0.0, 0.0, 0.0};
+    uint32_t clipped[4] = {0, 0, 0, 0};
+    const float clipHigh = _clipHigh;
+
+    uint32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            float x = values[i + lane];
+            mn[lane] = (x < mn[lane]) ? x : mn[lane];
+            mx[lane] = (x > mx[lane]) ? x : mx[lane];
+            sum[lane] += x;
+            sumSq[lane] += (double) x * x;
+            clipped[lane] += (x >= clipHigh) | (x <= -1.0f);
+        }
+    }
+    for (; i < numFrames; i++) {
+        float x = values[i];
+        mn[0] = (x < mn[0]) ? x : mn[0];
+        mx[0] = (x > mx[0]) ? x : mx[0];
+        sum[0] += x;
+        sumSq[0] += (double) x * x;
+        clipped[0] += (x >= clipHigh) | (x <= -1.0f);
+    }
+
+    for (uint32_t lane = 0; lane < 4; lane++) {
+        acc->min = (mn[lane] < acc->min) ? mn[lane] : acc->min;
+        acc->max = (mx[lane] > acc->max) ? mx[lane] : acc->max;
+        acc->sum += sum[lane];
+        acc->sumSquares += sumSq[lane];
+        acc->numClipped += clipped[lane];
+    }
+    acc->numValues += numFrames;
+    acc->numFinite += numFrames;
+}
+
+
+void WavSignalStats::accumulateChannelSlow(const float values[], uint32_t numFrames, ChannelAccumulator *acc) {
+
+    for (uint32_t i = 0; i < numFrames; i++) {
+        float x = values[i];
+        acc->numValues++;
+        if (std::isnan(x)) {
+            acc->numNaNs++;
+            continue;
+        }
+        if (std::isinf(x)) {
+            acc->numInfs++;
+            acc->numClipped++;
+            continue;
+        }
+        acc->min = (x < acc->min) ? x : acc->min;
+        acc->max = (x > acc->max) ? x : acc->max;
+        acc->sum += x;
+        acc->sumSquares += (double) x * x;
+        acc->numFinite++;
+        acc->numClipped += (x >= _clipHigh) || (x <= -1.0f);
+    }
+}
+
+
+bool WavSignalStats::getChannelStats(uint32_t channel, WavChannelStats &channelStats) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (channel >= _numChannels) {
+        fprintf(stderr, "Error: Channel index out of range.\n");
+        return false;
+    }
+
+    const ChannelAccumulator *acc = &_pAccumulators[channel];
+    channelStats.numValues = acc->numValues;
+    channelStats.numClipped = acc->numClipped;
+    channelStats.numNaNs = acc->numNaNs;
+    channelStats.numInfs = acc->numInfs;
+
+    if (acc->numFinite == 0) {
+        channelStats.min = 0.0f;
+        channelStats.max = 0.0f;
+        channelStats.peak = 0.0f;
+        channelStats.rms = 0.0;
+        channelStats.dcOffset = 0.0;
+        return true;
+    }
+
+    channelStats.min = acc->min;
+    channelStats.max = acc->max;
+    channelStats.peak = (-acc->min > acc->max) ? -acc->min : acc->max;
+    channelStats.rms = sqrt(acc->sumSquares / (double) acc->numFinite);
+    channelStats.dcOffset = acc->sum / (double) acc->numFinite;
+
+    return true;
+}
+
+
+uint32_t WavSignalStats::getNumChannels() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _numChannels;
+}
+
+
+WavSampleFormat WavSignalStats::getFormat() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return WAV_SAMPLE_FORMAT_INVALID;
+    }
+
+    return _format;
+}
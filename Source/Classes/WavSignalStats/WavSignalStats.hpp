@@ -0,0 +1,81 @@
+//WavSignalStats.hpp
+
+#ifndef __WAV_SIGNAL_STATS_HPP__
+#define __WAV_SIGNAL_STATS_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavSampleConverter.hpp"
+
+
+//Per-channel results; sample values are normalized to full scale [-1.0, 1.0)
+typedef struct {
+    uint64_t numValues;      //Number of values seen, including NaN/Inf
+    float min;               //Smallest finite value
+    float max;               //Largest finite value
+    float peak;              //max(|min|, |max|)
+    double rms;              //Root-mean-square of finite values
+    double dcOffset;         //Mean of finite values
+    uint64_t numClipped;     //Values at or beyond full scale
+    uint64_t numNaNs;
+    uint64_t numInfs;
+} WavChannelStats;
+
+
+//Accumulates peak/RMS/DC/clip/NaN/Inf statistics over wav-format sample data.
+//Attach to a WavReader or WavWriter to update it on the data as it passes through.
+class WavSignalStats {
+
+public:
+
+    WavSignalStats();
+
+    ~ WavSignalStats();
+
+    bool initialize(uint32_t numChannels,
+                    WavSampleFormat format);
+
+    void reset();
+
+    //Fold a block of interleaved wav-format frames into the running totals
+    bool accumulate(const uint8_t sampleData[], //wav-format bytes; whole frames only
+                    uint32_t sampleDataSize);
+
+    bool getChannelStats(uint32_t channel, WavChannelStats &channelStats);
+
+    uint32_t getNumChannels();
+
+    WavSampleFormat getFormat();
+
+
+private:
+
+    typedef struct {
+        uint64_t numValues;
+        float min;
+        float max;
+        double sum;
+        double sumSquares;
+        uint64_t numFinite;
+        uint64_t numClipped;
+        uint64_t numNaNs;
+        uint64_t numInfs;
+    } ChannelAccumulator;
+
+    void accumulateChannel(const float values[], uint32_t numFrames, ChannelAccumulator *acc);
+
+    void accumulateChannelSlow(const float values[], uint32_t numFrames, ChannelAccumulator *acc);
+
+    static const uint32_t SCRATCH_NUM_VALUES = 2048; //Decoded floats per pass; stays in L1
+
+    uint32_t _numChannels;
+    WavSampleFormat _format;
+    uint32_t _frameSize;
+    float _clipHigh; //Largest positive code of the format, normalized
+    ChannelAccumulator *_pAccumulators;
+    float _scratch[SCRATCH_NUM_VALUES];
+    bool _initialized;
+};
+
+
+#endif //__WAV_SIGNAL_STATS_HPP__
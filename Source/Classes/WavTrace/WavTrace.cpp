@@ -0,0 +1,268 @@
+//WavTrace.cpp
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h> //getpid()
+#endif
+
+#include "WavTrace.hpp"
+
+
+typedef struct {
+    const char *name;
+    const char *detail;
+    uint64_t numBytes;
+    uint64_t startNanos;
+    uint64_t durationNanos;
+} TraceEvent;
+
+
+//Written only by its owning thread; numEvents is published with release so writeJson() sees whole events
+typedef struct {
+    TraceEvent *pEvents;
+    uint32_t maxNumEvents;
+    uint32_t threadIndex;
+    std::atomic<uint32_t> numEvents;
+    std::atomic<uint64_t> numDropped;
+} ThreadBuffer;
+
+
+//Each thread's reference to its buffer; at thread exit, the buffer's unused capacity is freed
+struct ThreadBufferRef {
+    ThreadBuffer *pBuffer;
+    uint32_t generation;
+
+    ~ThreadBufferRef();
+};
+
+
+std::atomic<bool> WavTrace::_enabled(false);
+
+static std::mutex s_buffersMutex; //Guards s_buffers; taken once per thread per trace, not per event
+static std::vector<ThreadBuffer *> s_buffers;
+static std::atomic<uint32_t> s_generation(1); //Bumped by clear(), so threads drop stale buffer pointers
+static uint32_t s_nextThreadIndex = 1;
+static uint32_t s_maxEventsPerThread = WavTrace::DEFAULT_MAX_EVENTS_PER_THREAD;
+static uint64_t s_startNanos = 0;
+static thread_local ThreadBufferRef t_bufferRef = {nullptr, 0};
+
+
+//JSON string, escaping what JSON requires
+static void writeJsonString(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        const unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+
+//The thread's events are kept for writeJson(), but a buffer sized for maxEventsPerThread would
+//otherwise outlive every short-lived thread that recorded anything: shrink it to its events, or
+//free it if there are none
+ThreadBufferRef::~ThreadBufferRef() {
+
+    if (!pBuffer) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+    if (generation != s_generation.load(std::memory_order_relaxed)) {
+        return; //clear() has already freed it
+    }
+
+    const uint32_t numEvents = pBuffer->numEvents.load(std::memory_order_relaxed);
+    if (numEvents == 0 && pBuffer->numDropped.load(std::memory_order_relaxed) == 0) {
+        for (size_t b = 0; b < s_buffers.size(); b++) {
+            if (s_buffers[b] == pBuffer) {
+                s_buffers.erase(s_buffers.begin() + b);
+                break;
+            }
+        }
+        free(pBuffer->pEvents);
+        delete pBuffer;
+    } else if (numEvents < pBuffer->maxNumEvents) {
+        TraceEvent *pEvents = (TraceEvent *) realloc(pBuffer->pEvents, (numEvents ? numEvents : 1) * sizeof(TraceEvent));
+        if (pEvents) {
+            pBuffer->pEvents = pEvents;
+            pBuffer->maxNumEvents = numEvents;
+        }
+    }
+    pBuffer = nullptr;
+}
+
+
+static ThreadBuffer *threadBuffer() {
+
+    uint32_t generation = s_generation.load(std::memory_order_acquire);
+    if (t_bufferRef.pBuffer && t_bufferRef.generation == generation) {
+        return t_bufferRef.pBuffer;
+    }
+
+    ThreadBuffer *tb = new ThreadBuffer();
+    tb->pEvents = (TraceEvent *) malloc(s_maxEventsPerThread * sizeof(TraceEvent));
+    if (!tb->pEvents) {
+        delete tb;
+        return nullptr;
+    }
+    tb->maxNumEvents = s_maxEventsPerThread;
+    tb->numEvents.store(0, std::memory_order_relaxed);
+    tb->numDropped.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+    tb->threadIndex = s_nextThreadIndex++;
+    s_buffers.push_back(tb);
+    t_bufferRef.pBuffer = tb;
+    t_bufferRef.generation = generation;
+
+    return tb;
+}
+
+
+bool WavTrace::start(uint32_t maxEventsPerThread) {
+
+    if (_enabled.load(std::memory_order_relaxed)) {
+        fprintf(stderr, "Error: Tracing already started.\n");
+        return false;
+    }
+
+    if (maxEventsPerThread == 0) {
+        fprintf(stderr, "Error: maxEventsPerThread must be at least 1.\n");
+        return false;
+    }
+
+    //A new capacity only applies to threads that haven't recorded since the last clear()
+    s_maxEventsPerThread = maxEventsPerThread;
+    if (!s_startNanos) {
+        s_startNanos = now();
+    }
+    _enabled.store(true, std::memory_order_release);
+
+    return true;
+}
+
+
+void WavTrace::stop() {
+    _enabled.store(false, std::memory_order_release);
+}
+
+
+uint64_t WavTrace::now() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void WavTrace::record(const char *name,
+                      const char *detail,
+                      uint64_t numBytes,
+                      uint64_t startNanos,
+                      uint64_t endNanos) {
+
+    ThreadBuffer *tb = threadBuffer();
+    if (!tb) {
+        return;
+    }
+
+    uint32_t n = tb->numEvents.load(std::memory_order_relaxed);
+    if (n >= tb->maxNumEvents) {
+        tb->numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent *e = &tb->pEvents[n];
+    e->name = name;
+    e->detail = detail;
+    e->numBytes = numBytes;
+    e->startNanos = startNanos;
+    e->durationNanos = endNanos - startNanos;
+    tb->numEvents.store(n + 1, std::memory_order_release);
+}
+
+
+bool WavTrace::writeJson(const char *traceFilePath) {
+
+    FILE *f = fopen(traceFilePath, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Unable to open trace file: %s\n", traceFilePath);
+        return false;
+    }
+
+    const int pid = (int) getpid();
+    bool first = true;
+    fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+    for (size_t b = 0; b < s_buffers.size(); b++) {
+        ThreadBuffer *tb = s_buffers[b];
+        uint32_t numEvents = tb->numEvents.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < numEvents; i++) {
+            const TraceEvent *e = &tb->pEvents[i];
+            fprintf(f, "%s\n{\"name\": ", first ? "" : ",");
+            writeJsonString(f, e->name);
+            fprintf(f, ", \"cat\": \"wav\", \"ph\": \"X\", \"pid\": %d, \"tid\": %u, "
+                       "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"bytes\": %llu",
+                    pid, tb->threadIndex,
+                    (e->startNanos - s_startNanos) / 1000.0, e->durationNanos / 1000.0,
+                    (unsigned long long) e->numBytes);
+            if (e->detail) {
+                fprintf(f, ", \"detail\": ");
+                writeJsonString(f, e->detail);
+            }
+            fprintf(f, "}}");
+            first = false;
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Problem writing trace file: %s\n", traceFilePath);
+    }
+
+    return ok;
+}
+
+
+void WavTrace::clear() {
+
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+    for (size_t b = 0; b < s_buffers.size(); b++) {
+        free(s_buffers[b]->pEvents);
+        delete s_buffers[b];
+    }
+    s_buffers.clear();
+    s_nextThreadIndex = 1;
+    s_startNanos = 0;
+    s_generation.fetch_add(1, std::memory_order_release);
+}
+
+
+uint64_t WavTrace::getNumDroppedEvents() {
+
+    uint64_t numDropped = 0;
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+    for (size_t b = 0; b < s_buffers.size(); b++) {
+        numDropped += s_buffers[b]->numDropped.load(std::memory_order_relaxed);
+    }
+
+    return numDropped;
+}
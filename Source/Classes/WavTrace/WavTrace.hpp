@@ -0,0 +1,111 @@
+//WavTrace.hpp
+
+#ifndef __WAV_TRACE_HPP__
+#define __WAV_TRACE_HPP__
+
+#include <atomic>
+#include <cstdint> //For uint8_t, etc.
+
+
+//Timeline tracing of WavReader/WavWriter phases (open, header parse, subchunk searches, each
+//read/write block, conversion, finishWriting), written out as Chrome trace-event JSON for
+//chrome://tracing or Perfetto.
+//
+//Off unless built with WAV_ENABLE_TRACING=1 (CMake option of the same name); when off, the
+//WAV_TRACE_* macros expand to nothing. When built in, nothing is recorded between stop() and
+//start(), and each traced scope costs one relaxed load.
+//
+//Each thread appends to its own fixed-size buffer without locking; events past a buffer's
+//capacity are dropped and counted. When a thread exits, its buffer is trimmed to the events it
+//holds (or freed if it holds none). Buffers are merged when writeJson() is called.
+#ifndef WAV_ENABLE_TRACING
+#define WAV_ENABLE_TRACING 0
+#endif
+
+
+class WavTrace {
+
+public:
+
+    static const uint32_t DEFAULT_MAX_EVENTS_PER_THREAD = 1 << 16;
+
+    //Begin recording; timestamps are relative to this call
+    static bool start(uint32_t maxEventsPerThread = DEFAULT_MAX_EVENTS_PER_THREAD);
+
+    static void stop();
+
+    static inline bool isEnabled() {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    //Write every thread's events recorded since start(); call after stop()
+    static bool writeJson(const char *traceFilePath);
+
+    //Free all recorded events. No traced work may be running.
+    static void clear();
+
+    static uint64_t getNumDroppedEvents();
+
+    static uint64_t now();
+
+    //name and detail must be string literals (or otherwise outlive the trace); detail may be nullptr
+    static void record(const char *name,
+                       const char *detail,
+                       uint64_t numBytes,
+                       uint64_t startNanos,
+                       uint64_t endNanos);
+
+
+private:
+
+    static std::atomic<bool> _enabled;
+};
+
+
+//Records one complete event spanning its lifetime
+class WavTraceScope {
+
+public:
+
+    inline WavTraceScope(const char *name, const char *detail = nullptr, uint64_t numBytes = 0) {
+        _name = name;
+        _detail = detail;
+        _numBytes = numBytes;
+        _startNanos = WavTrace::isEnabled() ? WavTrace::now() : 0;
+    }
+
+    inline ~WavTraceScope() {
+        if (_startNanos) {
+            WavTrace::record(_name, _detail, _numBytes, _startNanos, WavTrace::now());
+        }
+    }
+
+    //For sizes only known once the work is done, e.g. bytes actually read
+    inline void setNumBytes(uint64_t numBytes) {
+        _numBytes = numBytes;
+    }
+
+private:
+
+    const char *_name;
+    const char *_detail;
+    uint64_t _numBytes;
+    uint64_t _startNanos;
+};
+
+
+#define WAV_TRACE_CONCAT_(a, b) a##b
+#define WAV_TRACE_CONCAT(a, b) WAV_TRACE_CONCAT_(a, b)
+
+#if WAV_ENABLE_TRACING
+#define WAV_TRACE_SCOPE(name) WavTraceScope WAV_TRACE_CONCAT(_wavTraceScope, __LINE__)(name)
+#define WAV_TRACE_SCOPE_DETAIL(name, detail) WavTraceScope WAV_TRACE_CONCAT(_wavTraceScope, __LINE__)(name, detail)
+#define WAV_TRACE_SCOPE_BYTES(name, numBytes) WavTraceScope WAV_TRACE_CONCAT(_wavTraceScope, __LINE__)(name, nullptr, numBytes)
+#else
+#define WAV_TRACE_SCOPE(name)
+#define WAV_TRACE_SCOPE_DETAIL(name, detail)
+#define WAV_TRACE_SCOPE_BYTES(name, numBytes)
+#endif
+
+
+#endif //__WAV_TRACE_HPP__
@@ -0,0 +1,217 @@
+//WavTranscoder.cpp
+
+
+#include <cstring> //strncmp()
+#include <cstdlib>
+#include <cstdio>
+
+#include "WavTranscoder.hpp"
+#include "WavSampleConverter.hpp"
+#include "WavMetadata.hpp"
+
+
+static const char *UNINITIALIZED_MSG = "Attempt to call WavTranscoder class method before calling initialize().\n";
+
+
+WavTranscoder::WavTranscoder() {
+    _pWavReader = nullptr;
+    _pWavWriter = nullptr;
+    _pBounceBuffer = nullptr;
+    _numSamplesTranscoded = 0;
+    _initialized = false;
+}
+
+
+WavTranscoder::~WavTranscoder() {
+    if (_pBounceBuffer) {
+        free(_pBounceBuffer);
+        _pBounceBuffer = nullptr;
+    }
+}
+
+
+bool WavTranscoder::initialize(WavReader *wavReader,
+                               WavWriter *wavWriter,
+                               bool copyMetadataSubchunks) {
+
+    if (!wavReader || !wavWriter) {
+        fprintf(stderr, "Error: WavReader and WavWriter must not be NULL.\n");
+        return false;
+    }
+
+    if (wavReader->getSampleFormat() == WAV_SAMPLE_FORMAT_INVALID ||
+        wavWriter->getSampleFormat() == WAV_SAMPLE_FORMAT_INVALID) {
+        fprintf(stderr, "Error: WavReader and WavWriter must both be initialized.\n");
+        return false;
+    }
+
+    if (wavReader->getNumChannels() != wavWriter->getNumChannels()) {
+        fprintf(stderr, "Error: Transcoding requires matching channel counts.\n");
+        return false;
+    }
+
+    if (wavReader->getSampleRate() != wavWriter->getSampleRate()) {
+        fprintf(stderr, "Error: Transcoding requires matching sample rates.\n");
+        return false;
+    }
+
+    if (!_pBounceBuffer) {
+        _pBounceBuffer = (uint8_t *) malloc(BOUNCE_BUFFER_SIZE);
+        if (!_pBounceBuffer) {
+            fprintf(stderr, "Error: Unable to allocate bounce buffer.\n");
+            return false;
+        }
+    }
+
+    this->_pWavReader = wavReader;
+    this->_pWavWriter = wavWriter;
+    this->_copyMetadataSubchunks = copyMetadataSubchunks;
+    this->_numSamplesTranscoded = 0;
+    this->_initialized = true;
+
+    return true;
+}
+
+
+//Walks the source's subchunks and queues everything but fmt/fact/data on the writer
+bool WavTranscoder::queueMetadataSubchunks() {
+
+    //The reader's header walk already knows where everything is; payloads are copied file to file
+    //as the writer starts, as they are (only the sizes follow the destination's byte order).
+    //Between RIFF and RIFX, payloads are read and their fields swapped instead.
+    const bool swapByteOrder = (_pWavReader->getIsBigEndian() != _pWavWriter->getIsBigEndian());
+    const uint32_t numSubchunks = _pWavReader->getNumSubchunks();
+    for (uint32_t i = 0; i < numSubchunks; i++) {
+
+        WavSubchunkInfo info;
+        if (!_pWavReader->getSubchunkInfo(i, &info)) {
+            return false;
+        }
+
+        if (!strncmp(info.subchunkId, "fmt ", 4) ||
+            !strncmp(info.subchunkId, "fact", 4) ||
+            !strncmp(info.subchunkId, "data", 4)) {
+            continue;
+        }
+
+        if (swapByteOrder) {
+            if (!queueSwappedSubchunk(&info)) {
+                return false;
+            }
+        } else if (!_pWavWriter->addSubchunkFromFile(info.subchunkId, _pWavReader->getReadFilePath(),
+                                                     info.dataOffset, info.dataSize)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//Subchunks whose layout isn't known are left out, rather than copied with their fields backwards
+bool WavTranscoder::queueSwappedSubchunk(const WavSubchunkInfo *info) {
+
+    uint8_t *subchunkData = (uint8_t *) malloc(info->dataSize + 1);
+    if (!subchunkData) {
+        fprintf(stderr, "Error: Unable to allocate metadata subchunk, while transcoding.\n");
+        return false;
+    }
+
+    bool ok = _pWavReader->readSubchunkData(info, subchunkData);
+    if (ok) {
+        if (wavSwapSubchunkByteOrder(info->subchunkId, subchunkData, info->dataSize, _pWavReader->getIsBigEndian())) {
+            ok = _pWavWriter->addSubchunk(info->subchunkId, subchunkData, info->dataSize);
+        } else {
+            fprintf(stderr, "Skipping '%.4s' subchunk: its byte order can't be converted.\n", info->subchunkId);
+        }
+    }
+    free(subchunkData);
+
+    return ok;
+}
+
+
+bool WavTranscoder::transcode() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (_copyMetadataSubchunks && !queueMetadataSubchunks()) {
+        return false;
+    }
+
+    if (!_pWavReader->prepareToRead()) {
+        fprintf(stderr, "Error: Problem preparing to read, while transcoding.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->startWriting(_pWavReader->getNumSamples())) {
+        fprintf(stderr, "Error: Problem starting writing, while transcoding.\n");
+        _pWavReader->finishReading();
+        return false;
+    }
+
+    const uint32_t numChannels = _pWavReader->getNumChannels();
+    const WavSampleFormat srcFormat = _pWavReader->getSampleFormat();
+    const WavSampleFormat destFormat = _pWavWriter->getSampleFormat();
+    const uint32_t srcFrameSize = numChannels * _pWavReader->getByteDepth();
+    const uint32_t destFrameSize = numChannels * _pWavWriter->getByteDepth();
+
+    //Source bytes land at the front of the bounce buffer. Same format: written straight back out.
+    //Otherwise converted into the back half, so each block is read, converted and written while hot.
+    const bool passthrough = (srcFormat == destFormat);
+    const uint32_t framesPerBlock = passthrough ?
+                                    BOUNCE_BUFFER_SIZE / srcFrameSize :
+                                    BOUNCE_BUFFER_SIZE / (srcFrameSize + destFrameSize);
+    uint8_t *srcBlock = _pBounceBuffer;
+    uint8_t *destBlock = passthrough ? _pBounceBuffer : _pBounceBuffer + framesPerBlock * srcFrameSize;
+
+    const uint32_t numSamples = _pWavReader->getNumSamples();
+    bool ok = true;
+    _numSamplesTranscoded = 0;
+    while (_numSamplesTranscoded < numSamples) {
+
+        const uint32_t numFrames = (numSamples - _numSamplesTranscoded < framesPerBlock) ?
+                                   numSamples - _numSamplesTranscoded : framesPerBlock;
+
+        if (!_pWavReader->readData(srcBlock, numFrames * srcFrameSize)) {
+            fprintf(stderr, "Error: Problem reading data, while transcoding.\n");
+            ok = false;
+            break;
+        }
+
+        if (!passthrough &&
+            !wavConvertSamples(srcBlock, srcFormat, destBlock, destFormat, numFrames * numChannels)) {
+            ok = false;
+            break;
+        }
+
+        if (!_pWavWriter->writeData(destBlock, numFrames * destFrameSize)) {
+            fprintf(stderr, "Error: Problem writing data, while transcoding.\n");
+            ok = false;
+            break;
+        }
+
+        _numSamplesTranscoded += numFrames;
+    }
+
+    _pWavReader->finishReading();
+    if (!_pWavWriter->finishWriting()) {
+        ok = false;
+    }
+
+    return ok;
+}
+
+
+uint32_t WavTranscoder::getNumSamplesTranscoded() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _numSamplesTranscoded;
+}
@@ -0,0 +1,52 @@
+//WavTranscoder.hpp
+
+#ifndef __WAV_TRANSCODER_HPP__
+#define __WAV_TRANSCODER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavReader.hpp"
+#include "WavWriter.hpp"
+
+
+//Streams sample data from a WavReader into a WavWriter, converting between any pair of
+//sample formats through one cache-sized bounce buffer. Sample rate and channel count
+//must match; metadata subchunks (LIST, bext, ...) are copied through by default, converted between
+//RIFF and RIFX byte order where their layout is known (see wavSwapSubchunkByteOrder()).
+class WavTranscoder {
+
+public:
+
+    WavTranscoder();
+
+    ~ WavTranscoder();
+
+    //wavReader and wavWriter must both be initialized; the writer must not have started writing
+    bool initialize(WavReader *wavReader,
+                    WavWriter *wavWriter,
+                    bool copyMetadataSubchunks = true);
+
+    //Reads, converts and writes all sample data, then finishes both reader and writer
+    bool transcode();
+
+    uint32_t getNumSamplesTranscoded();
+
+
+private:
+
+    bool queueMetadataSubchunks();
+
+    bool queueSwappedSubchunk(const WavSubchunkInfo *info);
+
+    static const uint32_t BOUNCE_BUFFER_SIZE = 256 * 1024; //Fits in L2 on everything we ship to
+
+    WavReader *_pWavReader;
+    WavWriter *_pWavWriter;
+    bool _copyMetadataSubchunks;
+    uint8_t *_pBounceBuffer;
+    uint32_t _numSamplesTranscoded;
+    bool _initialized;
+};
+
+
+#endif //__WAV_TRANSCODER_HPP__
@@ -1,23 +1,75 @@
 //WavWriter.cpp
 
 
+#include <chrono>
 #include <cstring> //memset()
+#include <cstdlib>
 #include <stdio.h>
 
 #include "WavWriter.hpp"
+#include "WavFileCopy.hpp"
+#include "WavFileIo.hpp"
+#include "WavSampleConverter.hpp"
+#include "WavTrace.hpp"
 
 
 static const char *UNINITIALIZED_MSG = "Attempt to call WavWriter class method before calling initialize().\n";
 
+
 static const uint64_t MAX_UINT32 = 4294967295;
+static const uint32_t CONVERT_WRITE_BLOCK_SIZE = 16384; //Max bytes converted per pass in writeDataFrom*()
+static const uint32_t PLANAR_WRITE_BLOCK_SIZE = 16384; //Max bytes converted per pass in writeFramesPlanar()
+static const uint32_t SWAP_WRITE_BLOCK_SIZE = 16384; //Max bytes byte-swapped per pass for RIFX files
+
+
+static uint64_t steadyMillis() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 
 WavWriter::WavWriter() {
     _initialized = false;
+    _numExtraSubchunks = 0;
+    _pSignalStats = nullptr;
+    _pAsyncEngine = nullptr;
+    _preallocated = false;
+    _checkpointIntervalMs = 0;
+    _checkpointIntervalBytes = 0;
+    _checkpointSyncData = false;
+    _lastCheckpointMs = 0;
+    _numBytesSinceCheckpoint = 0;
+    _pImaAdpcmBlock = nullptr;
+    _pImaAdpcmFrames = nullptr;
+    _numPendingFrames = 0;
+    _bigEndian = false;
 }
 
 
 WavWriter::~WavWriter() {
+    freeExtraSubchunks();
+    freeImaAdpcmBuffers();
+}
+
+
+void WavWriter::freeImaAdpcmBuffers() {
+    free(_pImaAdpcmBlock);
+    _pImaAdpcmBlock = nullptr;
+    free(_pImaAdpcmFrames);
+    _pImaAdpcmFrames = nullptr;
+    _numPendingFrames = 0;
+}
+
+
+void WavWriter::freeExtraSubchunks() {
+
+    for (uint32_t i = 0; i < _numExtraSubchunks; i++) {
+        free(_extraSubchunks[i].pSubchunkData);
+        _extraSubchunks[i].pSubchunkData = nullptr;
+        free(_extraSubchunks[i].pSrcFilePath);
+        _extraSubchunks[i].pSrcFilePath = nullptr;
+    }
+    _numExtraSubchunks = 0;
 }
 
 
@@ -67,8 +119,74 @@ bool WavWriter::initialize(const char *writeFilePath,
     this->_numChannels = numChannels;
     this->_samplesAreInts = samplesAreInts;
     this->_byteDepth = byteDepth;
+    this->_sampleFormat = wavSampleFormat(samplesAreInts, byteDepth);
+    this->_audioFormat = wavSampleFormatAudioFormat(_sampleFormat);
+    this->_bigEndian = false;
+    this->_blockAlign = numChannels * byteDepth;
+    this->_framesPerBlock = 1;
     this->_initialized = true;
     this->_numSamplesWritten = 0;
+    this->_headerSize = 0;
+    this->_preallocated = false;
+    this->_checkpointIntervalMs = 0;
+    this->_checkpointIntervalBytes = 0;
+    this->_checkpointSyncData = false;
+    freeExtraSubchunks();
+    freeImaAdpcmBuffers();
+
+    return true;
+}
+
+
+bool WavWriter::initialize(const char *writeFilePath,
+                           uint32_t sampleRate,
+                           uint32_t numChannels,
+                           WavSampleFormat sampleFormat) {
+
+    const bool samplesAreInts = sampleFormat != WAV_SAMPLE_FORMAT_FLOAT32 && sampleFormat != WAV_SAMPLE_FORMAT_FLOAT64;
+    if (!initialize(writeFilePath, sampleRate, numChannels, samplesAreInts, wavSampleFormatByteDepth(sampleFormat))) {
+        return false;
+    }
+
+    this->_sampleFormat = sampleFormat; //Distinguishes A-law/mu-law from 8-bit PCM
+    this->_audioFormat = wavSampleFormatAudioFormat(sampleFormat);
+
+    return true;
+}
+
+
+bool WavWriter::initializeImaAdpcm(const char *writeFilePath,
+                                   uint32_t sampleRate,
+                                   uint32_t numChannels,
+                                   uint32_t blockAlign) {
+
+    if (!initialize(writeFilePath, sampleRate, numChannels, true, 2)) {
+        return false;
+    }
+
+    if (blockAlign == 0) {
+        blockAlign = wavImaAdpcmDefaultBlockAlign(sampleRate, numChannels);
+    }
+    const uint32_t framesPerBlock = wavImaAdpcmFramesPerBlock(blockAlign, numChannels);
+    if (framesPerBlock == 0 || blockAlign > 65535) {
+        fprintf(stderr, "Error: IMA ADPCM block size must be a multiple of 4 bytes per channel, below 64KB.\n");
+        _initialized = false;
+        return false;
+    }
+
+    _pImaAdpcmBlock = (uint8_t *) malloc(blockAlign);
+    _pImaAdpcmFrames = (int16_t *) malloc((size_t) framesPerBlock * numChannels * sizeof(int16_t));
+    if (!_pImaAdpcmBlock || !_pImaAdpcmFrames) {
+        fprintf(stderr, "Error: Unable to allocate IMA ADPCM buffers.\n");
+        freeImaAdpcmBuffers();
+        _initialized = false;
+        return false;
+    }
+
+    //Callers keep passing 16-bit PCM; only the bytes on disk differ
+    this->_audioFormat = AUDIO_FORMAT_IMA_ADPCM;
+    this->_blockAlign = blockAlign;
+    this->_framesPerBlock = framesPerBlock;
 
     return true;
 }
@@ -81,6 +199,8 @@ bool WavWriter::openFile() {
         return false;
     }
 
+    WAV_TRACE_SCOPE("WavWriter::openFile");
+
     if (!_pWriteFile) {
         _pWriteFile = fopen(_writeFilePath, "w+b");
         if (_pWriteFile == NULL) {
@@ -88,8 +208,10 @@ bool WavWriter::openFile() {
             _pWriteFile = nullptr;
             return false;
         }
+        _counters.addOpen();
     } else {
         rewind(_pWriteFile);
+        _counters.addSeek();
     }
 
     return true;
@@ -134,11 +256,14 @@ bool WavWriter::findSubchunk(const char *subchunkId) {
         return false;
     }
 
+    WAV_TRACE_SCOPE_DETAIL("WavWriter::findSubchunk", subchunkId);
+
     if (!openFile()) {
         return false;
     }
 
     //Skip over RIFF header
+    _counters.addSeek();
     if (fseek(_pWriteFile, RIFF_HEADER_SIZE, SEEK_CUR)) {
         closeFile("Error: Problem while skipping over RIFF header.\n");
         return false;
@@ -149,7 +274,9 @@ bool WavWriter::findSubchunk(const char *subchunkId) {
         size_t numToRead = 1;
         size_t numRead = 0;
         uint8_t subchunkHeaderData[SUBCHUNK_HEADER_SIZE];
+        uint64_t startNanos = WavCounters::now();
         numRead = fread(subchunkHeaderData, SUBCHUNK_HEADER_SIZE, 1, _pWriteFile);
+        _counters.addRead(numRead * SUBCHUNK_HEADER_SIZE, startNanos);
         if (numRead < numToRead) {
             if (feof(_pWriteFile)) {
                 fprintf(stderr, "Error: Reached end of file without finding subchunk: %s\n", subchunkId);
@@ -165,6 +292,7 @@ bool WavWriter::findSubchunk(const char *subchunkId) {
         bool subchunkFound = !strncmp(sch->subchunkId, subchunkId, 4);
         if (subchunkFound) {
             //Rewind to the beginning of the subchunk, i.e. including the header
+            _counters.addSeek();
             if (fseek(_pWriteFile, -(int) SUBCHUNK_HEADER_SIZE, SEEK_CUR)) {
                 fprintf(stderr, "Error: Problem advancing to subchunk: %s\n", subchunkId);
                 closeFile();
@@ -173,8 +301,10 @@ bool WavWriter::findSubchunk(const char *subchunkId) {
             return true;
         }
 
-        //Subchunk not found; advance to next subchunk
-        if (fseek(_pWriteFile, sch->subchunkSize, SEEK_CUR)) {
+        //Subchunk not found; advance to next subchunk (RIFF pads odd-sized subchunks to an even length)
+        const uint32_t size = wavByteOrder32(sch->subchunkSize, _bigEndian);
+        _counters.addSeek();
+        if (fseek(_pWriteFile, size + (size & 1), SEEK_CUR)) {
             if (feof(_pWriteFile)) {
                 fprintf(stderr, "Error: End of file reached without finding subchunk: %s\n", subchunkId);
                 closeFile();
@@ -195,13 +325,143 @@ bool WavWriter::findSubchunk(const char *subchunkId) {
 
 
 
-bool WavWriter::startWriting() {
+//Checks shared by addSubchunk() and addSubchunkFromFile()
+bool WavWriter::queueExtraSubchunk(const char subchunkId[4]) {
+
+    if (!strncmp(subchunkId, "fmt ", 4) || !strncmp(subchunkId, "fact", 4) || !strncmp(subchunkId, "data", 4)) {
+        fprintf(stderr, "Error: The fmt, fact and data subchunks are written by WavWriter itself.\n");
+        return false;
+    }
+
+    if (_numExtraSubchunks >= MAX_NUM_EXTRA_SUBCHUNKS) {
+        fprintf(stderr, "Error: Too many extra subchunks.\n");
+        return false;
+    }
+
+    ExtraSubchunk *esc = &_extraSubchunks[_numExtraSubchunks];
+    memcpy(esc->subchunkId, subchunkId, 4);
+    esc->pSubchunkData = nullptr;
+    esc->pSrcFilePath = nullptr;
+    esc->srcOffset = 0;
+    esc->subchunkSize = 0;
+
+    return true;
+}
+
+
+bool WavWriter::addSubchunk(const char subchunkId[4],
+                            const uint8_t subchunkData[],
+                            uint32_t subchunkSize) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (!queueExtraSubchunk(subchunkId)) {
+        return false;
+    }
+
+    ExtraSubchunk *esc = &_extraSubchunks[_numExtraSubchunks];
+    esc->pSubchunkData = (uint8_t *) malloc(subchunkSize + 1);
+    if (!esc->pSubchunkData) {
+        fprintf(stderr, "Error: Unable to allocate extra subchunk.\n");
+        return false;
+    }
+    memcpy(esc->pSubchunkData, subchunkData, subchunkSize);
+    esc->subchunkSize = subchunkSize;
+    _numExtraSubchunks++;
+
+    return true;
+}
+
+
+bool WavWriter::addSubchunkFromFile(const char subchunkId[4],
+                                    const char *srcFilePath,
+                                    uint32_t srcOffset,
+                                    uint32_t subchunkSize) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (!queueExtraSubchunk(subchunkId)) {
+        return false;
+    }
+
+    ExtraSubchunk *esc = &_extraSubchunks[_numExtraSubchunks];
+    const size_t pathSize = strlen(srcFilePath) + 1;
+    esc->pSrcFilePath = (char *) malloc(pathSize);
+    if (!esc->pSrcFilePath) {
+        fprintf(stderr, "Error: Unable to allocate extra subchunk.\n");
+        return false;
+    }
+    memcpy(esc->pSrcFilePath, srcFilePath, pathSize);
+    esc->srcOffset = srcOffset;
+    esc->subchunkSize = subchunkSize;
+    _numExtraSubchunks++;
+
+    return true;
+}
+
+
+//Payload and pad byte of one extra subchunk, just after its header
+bool WavWriter::writeExtraSubchunkPayload(ExtraSubchunk *esc) {
+
+    const uint32_t paddedSize = esc->subchunkSize + (esc->subchunkSize & 1);
+
+    if (esc->pSubchunkData) {
+        esc->pSubchunkData[esc->subchunkSize] = 0; //Pad byte, if any
+        return fwrite(esc->pSubchunkData, 1, paddedSize, _pWriteFile) == paddedSize;
+    }
+
+    FILE *srcFile = fopen(esc->pSrcFilePath, "rb");
+    if (!srcFile) {
+        fprintf(stderr, "Error: Unable to open %s to copy subchunk: %.4s\n", esc->pSrcFilePath, esc->subchunkId);
+        return false;
+    }
+    long destOffset = ftell(_pWriteFile);
+    bool ok = destOffset >= 0 &&
+              wavCopyFileRange(srcFile, esc->srcOffset, _pWriteFile, (uint64_t) destOffset, esc->subchunkSize);
+    fclose(srcFile);
+
+    return ok && (paddedSize == esc->subchunkSize || fputc(0, _pWriteFile) != EOF);
+}
+
+
+bool WavWriter::setBigEndian(bool bigEndian) {
 
     if (!_initialized) {
         fprintf(stderr, "%s", UNINITIALIZED_MSG);
         return false;
     }
 
+    if (_pWriteFile) {
+        fprintf(stderr, "Error: Byte order must be set before startWriting().\n");
+        return false;
+    }
+
+    if (bigEndian && _audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        fprintf(stderr, "Error: IMA ADPCM is only supported in RIFF (little-endian) files.\n");
+        return false;
+    }
+
+    _bigEndian = bigEndian;
+
+    return true;
+}
+
+
+bool WavWriter::startWriting(uint32_t expectedNumSamples) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    WAV_TRACE_SCOPE("WavWriter::startWriting");
+
     if (!openFile()) {
         return false;
     }
@@ -212,7 +472,7 @@ bool WavWriter::startWriting() {
     rh->chunkId[0] = 'R';
     rh->chunkId[1] = 'I';
     rh->chunkId[2] = 'F';
-    rh->chunkId[3] = 'F';
+    rh->chunkId[3] = (_bigEndian) ? 'X' : 'F';
     rh->fileSizeLess8 = 0; //Unknown at outset; filled upon completion
     rh->formatName[0] = 'W';
     rh->formatName[1] = 'A';
@@ -220,7 +480,9 @@ bool WavWriter::startWriting() {
     rh->formatName[3] = 'E';
     size_t numToWrite = 1;
     size_t numWritten = 0;
+    uint64_t startNanos = WavCounters::now();
     numWritten = fwrite(riffHeaderData, RIFF_HEADER_SIZE, 1, _pWriteFile);
+    _counters.addWrite(numWritten * RIFF_HEADER_SIZE, startNanos);
     if (numWritten < numToWrite) {
         closeFile("Error: Problem writing RIFF header.");
         return false;
@@ -233,24 +495,41 @@ bool WavWriter::startWriting() {
     fsc->formatSubchunkId[1] = 'm';
     fsc->formatSubchunkId[2] = 't';
     fsc->formatSubchunkId[3] = ' ';
-    fsc->formatSubchunkSize = 16;
-    fsc->audioFormat = (_samplesAreInts) ? AUDIO_FORMAT_INT : AUDIO_FORMAT_FLOAT;
+    fsc->formatSubchunkSize = getFormatSubchunkSize() - SUBCHUNK_HEADER_SIZE;
+    fsc->audioFormat = _audioFormat;
     fsc->numChannels = _numChannels;
     fsc->sampleRate = _sampleRate;
-    fsc->byteRate = _sampleRate * _numChannels * _byteDepth;
-    fsc->blockAlign = _numChannels * _byteDepth;
-    fsc->bitsPerSample = _byteDepth * 8;
+    fsc->byteRate = (uint32_t) ((uint64_t) _sampleRate * _blockAlign / _framesPerBlock);
+    fsc->blockAlign = _blockAlign;
+    fsc->bitsPerSample = (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) ? 4 : _byteDepth * 8;
+    wavByteOrderFormatSubchunk(fsc, _bigEndian);
     numToWrite = 1;
     numWritten = 0;
+    startNanos = WavCounters::now();
     numWritten = fwrite(formatSubchunkData, FORMAT_SUBCHUNK_SIZE, 1, _pWriteFile);
+    _counters.addWrite(numWritten * FORMAT_SUBCHUNK_SIZE, startNanos);
     if (numWritten < numToWrite) {
         closeFile("Error: Problem writing format subchunk.");
         return false;
     }
+    if (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        ImaAdpcmFormatExtension extension;
+        extension.extraSize = sizeof(uint16_t);
+        extension.framesPerBlock = (uint16_t) _framesPerBlock;
+        startNanos = WavCounters::now();
+        numWritten = fwrite(&extension, IMA_ADPCM_FORMAT_EXTENSION_SIZE, 1, _pWriteFile);
+        _counters.addWrite(numWritten * IMA_ADPCM_FORMAT_EXTENSION_SIZE, startNanos);
+        if (numWritten < numToWrite) {
+            closeFile("Error: Problem writing format subchunk.");
+            return false;
+        }
+        _numPendingFrames = 0;
+        memset(_imaAdpcmStates, 0, sizeof(_imaAdpcmStates));
+    }
 
-    //"fact" subchunk; supposedly required for floating-point representation
+    //"fact" subchunk; supposedly required for floating-point (and any other non-PCM) representation
     //See: http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
-    if (!_samplesAreInts) {
+    if (hasFactSubchunk()) {
         //Write fact chunk
         uint8_t factSubchunkData[FACT_SUBCHUNK_SIZE];
         FactSubchunk *factsc = (FactSubchunk *) factSubchunkData;
@@ -258,17 +537,38 @@ bool WavWriter::startWriting() {
         factsc->factSubchunkId[1] = 'a';
         factsc->factSubchunkId[2] = 'c';
         factsc->factSubchunkId[3] = 't';
-        factsc->factSubchunkSize = 4;
+        factsc->factSubchunkSize = wavByteOrder32(4, _bigEndian);
         factsc->numSamplesPerChannel = 0; //Unknown at outset; filled upon completion
         numToWrite = 1;
         numWritten = 0;
+        startNanos = WavCounters::now();
         numWritten = fwrite(factSubchunkData, FACT_SUBCHUNK_SIZE, 1, _pWriteFile);
+        _counters.addWrite(numWritten * FACT_SUBCHUNK_SIZE, startNanos);
         if (numWritten < numToWrite) {
             closeFile("Error: Problem writing fact subchunk.");
             return false;
         }
     }
 
+    //Extra subchunks, each padded to an even length as RIFF requires
+    uint32_t extraSubchunksSize = 0;
+    for (uint32_t i = 0; i < _numExtraSubchunks; i++) {
+        ExtraSubchunk *esc = &_extraSubchunks[i];
+        uint8_t extraSubchunkHeader[SUBCHUNK_HEADER_SIZE];
+        SubchunkHeader *esh = (SubchunkHeader *) extraSubchunkHeader;
+        memcpy(esh->subchunkId, esc->subchunkId, 4);
+        esh->subchunkSize = wavByteOrder32(esc->subchunkSize, _bigEndian);
+        uint32_t paddedSize = esc->subchunkSize + (esc->subchunkSize & 1);
+        startNanos = WavCounters::now();
+        if (fwrite(extraSubchunkHeader, SUBCHUNK_HEADER_SIZE, 1, _pWriteFile) < 1 ||
+            !writeExtraSubchunkPayload(esc)) {
+            closeFile("Error: Problem writing extra subchunk.");
+            return false;
+        }
+        _counters.addWrite(SUBCHUNK_HEADER_SIZE + paddedSize, startNanos);
+        extraSubchunksSize += SUBCHUNK_HEADER_SIZE + paddedSize;
+    }
+
     uint8_t dataSubchunkHeader[SUBCHUNK_HEADER_SIZE];
     SubchunkHeader *dsh = (SubchunkHeader *) dataSubchunkHeader;
     dsh->subchunkId[0] = 'd';
@@ -278,12 +578,27 @@ bool WavWriter::startWriting() {
     dsh->subchunkSize = 0; //Unknown at outset; filled upon completion
     numToWrite = 1;
     numWritten = 0;
+    startNanos = WavCounters::now();
     numWritten = fwrite(dataSubchunkHeader, SUBCHUNK_HEADER_SIZE, 1, _pWriteFile);
+    _counters.addWrite(numWritten * SUBCHUNK_HEADER_SIZE, startNanos);
     if (numWritten < numToWrite) {
         closeFile("Error: Problem writing data subchunk header.");
         return false;
     }
 
+    _headerSize = RIFF_HEADER_SIZE +
+                  getFormatSubchunkSize() +
+                  ((hasFactSubchunk()) ? FACT_SUBCHUNK_SIZE : 0) +
+                  extraSubchunksSize +
+                  SUBCHUNK_HEADER_SIZE;
+
+    //Best effort; without it the file just grows one write at a time
+    _preallocated = expectedNumSamples > 0 &&
+                    wavPreallocateFile(_pWriteFile, _headerSize, getEncodedDataSize(expectedNumSamples));
+
+    _lastCheckpointMs = steadyMillis();
+    _numBytesSinceCheckpoint = 0;
+
     return true;
 }
 
@@ -296,6 +611,8 @@ bool WavWriter::writeData(const uint8_t sampleData[], //WAV format bytes
         return false;
     }
 
+    WAV_TRACE_SCOPE_BYTES("WavWriter::writeData", sampleDataSize);
+
     uint32_t sampleBlockSize = _byteDepth * _numChannels;
     if (sampleDataSize % sampleBlockSize) {
         fprintf(stderr, "Error: Sample data size doesn't divide evenly by sample block size.\n");
@@ -307,8 +624,21 @@ bool WavWriter::writeData(const uint8_t sampleData[], //WAV format bytes
     // 2) Header has already been written
     // 3) File pointer is at the right location for writing data
 
+    //Fold into statistics while the caller's bytes are still in cache
+    if (_pSignalStats) {
+        _pSignalStats->accumulate(sampleData, sampleDataSize);
+    }
+
     size_t numBytesWritten = 0;
-    numBytesWritten = fwrite(sampleData, 1, sampleDataSize, _pWriteFile);
+    if (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        numBytesWritten = writeImaAdpcmFrames(sampleData, sampleDataSize / sampleBlockSize) ? sampleDataSize : 0;
+    } else if (_bigEndian && _byteDepth > 1) {
+        numBytesWritten = writeSwappedData(sampleData, sampleDataSize);
+    } else {
+        uint64_t startNanos = WavCounters::now();
+        numBytesWritten = fwrite(sampleData, 1, sampleDataSize, _pWriteFile);
+        _counters.addWrite(numBytesWritten, startNanos);
+    }
 
     uint64_t newNumSamplesWritten = (uint64_t) _numSamplesWritten +
                                     (uint64_t) (numBytesWritten / (_byteDepth * _numChannels));
@@ -323,7 +653,74 @@ bool WavWriter::writeData(const uint8_t sampleData[], //WAV format bytes
         return false;
     }
 
-    return true;
+    return checkpointIfDue(sampleDataSize);
+}
+
+
+bool WavWriter::writeData(const WavBufferBlock *block) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (!block) {
+        fprintf(stderr, "Error: Block is NULL.\n");
+        return false;
+    }
+
+    return writeData(block->getData(), block->getSize());
+}
+
+
+bool WavWriter::writeDataFromFile(const char *srcFilePath,
+                                  uint64_t srcOffset,
+                                  uint32_t sampleDataSize) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    WAV_TRACE_SCOPE_BYTES("WavWriter::writeDataFromFile", sampleDataSize);
+
+    if (_audioFormat == AUDIO_FORMAT_IMA_ADPCM) {
+        fprintf(stderr, "Error: IMA ADPCM data has to be encoded; it can't be copied from a file.\n");
+        return false;
+    }
+
+    uint32_t sampleBlockSize = _byteDepth * _numChannels;
+    if (sampleDataSize % sampleBlockSize) {
+        fprintf(stderr, "Error: Sample data size doesn't divide evenly by sample block size.\n");
+        return false;
+    }
+
+    uint64_t newNumSamplesWritten = (uint64_t) _numSamplesWritten + (uint64_t) (sampleDataSize / sampleBlockSize);
+    if (newNumSamplesWritten > MAX_UINT32) {
+        closeFile("Error: Problem writing sample data - overflow.\n");
+        return false;
+    }
+
+    FILE *srcFile = fopen(srcFilePath, "rb");
+    if (!srcFile) {
+        fprintf(stderr, "Error: Unable to open source file for copying sample data.\n");
+        return false;
+    }
+
+    //Same precondition as writeData(): header written, file pointer at the end of the sample data
+    uint64_t startNanos = WavCounters::now();
+    long destOffset = ftell(_pWriteFile);
+    bool ok = destOffset >= 0 && wavCopyFileRange(srcFile, srcOffset, _pWriteFile, (uint64_t) destOffset, sampleDataSize);
+    fclose(srcFile);
+    _counters.addWrite(ok ? sampleDataSize : 0, startNanos);
+    if (!ok) {
+        closeFile("Error: Problem copying sample data from file.\n");
+        return false;
+    }
+
+    _numSamplesWritten = (uint32_t) newNumSamplesWritten;
+
+    return checkpointIfDue(sampleDataSize);
 }
 
 
@@ -336,25 +733,103 @@ bool WavWriter::writeDataFromInt16s(
         return false;
     }
 
+    WAV_TRACE_SCOPE("WavWriter::convertFromInt16s");
+    return writeDataConverted((const uint8_t *) int16Samples, WAV_SAMPLE_FORMAT_INT16, numInt16Samples);
+}
+
 
-    const uint32_t bufferSize = (_numChannels * _byteDepth);
-    uint8_t buffer[bufferSize];
-    for (uint32_t i = 0; i < numInt16Samples; i++) {
+bool WavWriter::writeDataFromInt32s(const int32_t int32Samples[], //channels interleaved; length = numFrames * numChannels
+                                    uint32_t numFrames) {
 
-        int16_t int16SampleCh1 = int16Samples[i * _numChannels];
-        int16_t int16SampleCh2 = (_numChannels == 2) ? int16Samples[i * _numChannels + 1] : 0;
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    WAV_TRACE_SCOPE("WavWriter::convertFromInt32s");
+    return writeDataConverted((const uint8_t *) int32Samples, WAV_SAMPLE_FORMAT_INT32, numFrames);
+}
 
-        writeInt16SampleToArray(int16SampleCh1,
-                                int16SampleCh2, //Irrelevant if only one channel
-                                0, //sampleIndex
-                                buffer,
-                                bufferSize);
 
-        bool ok = writeData(buffer, bufferSize);  // Updates numSamplesWritten
-        if (!ok) {
+bool WavWriter::writeDataFromFloats(const float floatSamples[], //channels interleaved; length = numFrames * numChannels
+                                    uint32_t numFrames) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    WAV_TRACE_SCOPE("WavWriter::convertFromFloats");
+    return writeDataConverted((const uint8_t *) floatSamples, WAV_SAMPLE_FORMAT_FLOAT32, numFrames);
+}
+
+
+bool WavWriter::writeDataConverted(const uint8_t srcSamples[], //channels interleaved, in srcFormat
+                                   WavSampleFormat srcFormat,
+                                   uint32_t numFrames) {
+
+    //Convert a block of frames at a time with one call, then write the block with one call
+    const WavSampleFormat format = _sampleFormat;
+    const uint32_t srcFrameSize = _numChannels * wavSampleFormatByteDepth(srcFormat);
+    const uint32_t frameSize = _numChannels * _byteDepth;
+    const uint32_t framesPerBlock = CONVERT_WRITE_BLOCK_SIZE / frameSize;
+    uint8_t sampleBytes[CONVERT_WRITE_BLOCK_SIZE];
+    uint32_t i = 0;
+    while (i < numFrames) {
+        const uint32_t numBlockFrames = (numFrames - i < framesPerBlock) ? numFrames - i : framesPerBlock;
+        uint64_t startNanos = WavCounters::now();
+        if (!wavConvertSamples(srcSamples + (uint64_t) i * srcFrameSize, srcFormat,
+                               sampleBytes, format,
+                               numBlockFrames * _numChannels)) {
+            return false;
+        }
+        _counters.addConversion(numBlockFrames, startNanos);
+
+        if (!writeData(sampleBytes, numBlockFrames * frameSize)) { // Updates numSamplesWritten
+            fprintf(stderr, "Error: Problem while writing data.\n");
+            return false;
+        }
+        i += numBlockFrames;
+    }
+
+    return true;
+}
+
+
+bool WavWriter::writeFramesPlanar(const float *const channels[], //one array of numFrames values per channel
+                                  uint32_t numFrames) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    //Interleave a block of frames at a time, then write the block with one call
+    const WavSampleFormat format = _sampleFormat;
+    const uint32_t frameSize = _numChannels * _byteDepth;
+    const uint32_t framesPerBlock = PLANAR_WRITE_BLOCK_SIZE / frameSize;
+    uint8_t sampleBytes[PLANAR_WRITE_BLOCK_SIZE];
+    const float *blockChannels[2];
+    uint32_t i = 0;
+    while (i < numFrames) {
+        const uint32_t numBlockFrames = (numFrames - i < framesPerBlock) ? numFrames - i : framesPerBlock;
+        {
+            WAV_TRACE_SCOPE_BYTES("WavWriter::convertFromPlanar", numBlockFrames * frameSize);
+            uint64_t startNanos = WavCounters::now();
+            for (uint32_t ch = 0; ch < _numChannels; ch++) {
+                blockChannels[ch] = channels[ch] + i;
+            }
+            if (!wavEncodeFromPlanarFloats(blockChannels, _numChannels, sampleBytes, format, numBlockFrames)) {
+                return false;
+            }
+            _counters.addConversion(numBlockFrames, startNanos);
+        }
+
+        if (!writeData(sampleBytes, numBlockFrames * frameSize)) { // Updates numSamplesWritten
             fprintf(stderr, "Error: Problem while writing data.\n");
             return false;
         }
+        i += numBlockFrames;
     }
 
     return true;
@@ -368,6 +843,24 @@ bool WavWriter::finishWriting() {
         return false;
     }
 
+    WAV_TRACE_SCOPE("WavWriter::finishWriting");
+
+    //Encode the last, partly filled IMA ADPCM block, padded with silence; the fact subchunk has the true length
+    if (_numPendingFrames > 0 && !flushImaAdpcmBlock()) {
+        return false;
+    }
+    const uint32_t dataSize = (uint32_t) getEncodedDataSize(_numSamplesWritten);
+
+    //Release whatever preallocated space went unused
+    if (_preallocated) {
+        uint64_t fileSize = (uint64_t) _headerSize + dataSize;
+        if (!wavTruncateFile(_pWriteFile, fileSize)) {
+            closeFile("Error: Problem trimming preallocated space.");
+            return false;
+        }
+        _preallocated = false;
+    }
+
     //Need to update:
     // 1. file length in "RIFF" chunk
     // 2. Subchunk length in data subchunk
@@ -379,28 +872,29 @@ bool WavWriter::finishWriting() {
 
     //Advance past "RIFF" chunk ID field
     int numOffsetBytes = 4;
+    _counters.addSeek();
     if (fseek(_pWriteFile, numOffsetBytes, SEEK_CUR) != 0) {
         closeFile("Error advancing to file size.");
         return false;
     }
 
     //Update RIFF chunk's fileSizeLess8 field
-    uint32_t fileSizeLess8 = 4 + //End of riff header
-                             FORMAT_SUBCHUNK_SIZE + //Format subchunk
-                             ((_samplesAreInts) ? 0 : FACT_SUBCHUNK_SIZE) + //Fact subchunk
-                             (8 + (_numSamplesWritten * _numChannels *
-                                   _byteDepth)); //Data subchunk - with numSamples actually written
+    uint32_t fileSizeLess8 = (_headerSize - 8) + //Everything after the RIFF size field, through the data subchunk header
+                             dataSize; //Sample data - with numSamples actually written
+    fileSizeLess8 = wavByteOrder32(fileSizeLess8, _bigEndian);
     uint8_t *bytes = (uint8_t *) (&fileSizeLess8);
     size_t numBytesWritten = 0;
     uint32_t numBytesToWrite = sizeof(uint32_t);
+    uint64_t startNanos = WavCounters::now();
     numBytesWritten = fwrite(bytes, 1, numBytesToWrite, _pWriteFile);
+    _counters.addWrite(numBytesWritten, startNanos);
     if (numBytesWritten < numBytesToWrite) {
         closeFile("Error: Unable to update riff chunk file length.");
         return false;
     }
 
-    //If floating-point samples...
-    if (!_samplesAreInts) {
+    //If floating-point (or other non-PCM) samples...
+    if (hasFactSubchunk()) {
 
         //Advance to fact subchunk
         if (!findSubchunk("fact")) {
@@ -415,11 +909,13 @@ bool WavWriter::finishWriting() {
         factsc->factSubchunkId[1] = 'a';
         factsc->factSubchunkId[2] = 'c';
         factsc->factSubchunkId[3] = 't';
-        factsc->factSubchunkSize = 4;
-        factsc->numSamplesPerChannel = _numSamplesWritten;
+        factsc->factSubchunkSize = wavByteOrder32(4, _bigEndian);
+        factsc->numSamplesPerChannel = wavByteOrder32(_numSamplesWritten, _bigEndian);
         numBytesToWrite = 1;
         numBytesWritten = 0;
+        startNanos = WavCounters::now();
         numBytesWritten = fwrite(factSubchunkData, FACT_SUBCHUNK_SIZE, 1, _pWriteFile);
+        _counters.addWrite(numBytesWritten * FACT_SUBCHUNK_SIZE, startNanos);
         if (numBytesWritten < numBytesToWrite) {
             closeFile("Error: Problem writing fact subchunk.");
             return false;
@@ -439,9 +935,11 @@ bool WavWriter::finishWriting() {
     dsh->subchunkId[1] = 'a';
     dsh->subchunkId[2] = 't';
     dsh->subchunkId[3] = 'a';
-    dsh->subchunkSize = (_numSamplesWritten * _numChannels * _byteDepth);
+    dsh->subchunkSize = wavByteOrder32(dataSize, _bigEndian);
     numBytesToWrite = SUBCHUNK_HEADER_SIZE;
+    startNanos = WavCounters::now();
     numBytesWritten = fwrite(dataSubchunkHeader, 1, numBytesToWrite, _pWriteFile);
+    _counters.addWrite(numBytesWritten, startNanos);
     if (numBytesWritten < numBytesToWrite) {
         perror("Error updating data subchunk header");
         closeFile("Error: Problem updating data subchunk header.");
@@ -452,6 +950,183 @@ bool WavWriter::finishWriting() {
 }
 
 
+bool WavWriter::setCheckpointPolicy(uint32_t intervalMs,
+                                    uint32_t intervalBytes,
+                                    bool syncData) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    _checkpointIntervalMs = intervalMs;
+    _checkpointIntervalBytes = intervalBytes;
+    _checkpointSyncData = syncData;
+    _lastCheckpointMs = steadyMillis();
+    _numBytesSinceCheckpoint = 0;
+
+    return true;
+}
+
+
+bool WavWriter::checkpoint() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (!_pWriteFile) {
+        fprintf(stderr, "Error: Can't checkpoint - not writing.\n");
+        return false;
+    }
+
+    WAV_TRACE_SCOPE("WavWriter::checkpoint");
+
+    //Sample data must reach the file before the sizes that cover it
+    if (fflush(_pWriteFile) != 0) {
+        closeFile("Error: Problem flushing sample data at checkpoint.");
+        return false;
+    }
+
+    //Header layout is fixed by startWriting(), so each size field's offset is known.
+    //Frames still waiting to fill an IMA ADPCM block aren't in the file yet.
+    const uint32_t numFramesInFile = _numSamplesWritten - _numPendingFrames;
+    const uint32_t dataSize = (uint32_t) getEncodedDataSize(numFramesInFile);
+    const uint32_t fileSizeLess8 = wavByteOrder32((_headerSize - 8) + dataSize, _bigEndian);
+    const uint32_t numFramesField = wavByteOrder32(numFramesInFile, _bigEndian);
+    const uint32_t dataSizeField = wavByteOrder32(dataSize, _bigEndian);
+    uint64_t startNanos = WavCounters::now();
+    bool ok = wavWriteAt(_pWriteFile, 4, &fileSizeLess8, sizeof(uint32_t));
+    if (ok && hasFactSubchunk()) {
+        ok = wavWriteAt(_pWriteFile, RIFF_HEADER_SIZE + getFormatSubchunkSize() + SUBCHUNK_HEADER_SIZE,
+                        &numFramesField, sizeof(uint32_t));
+    }
+    if (ok) {
+        ok = wavWriteAt(_pWriteFile, _headerSize - sizeof(uint32_t), &dataSizeField, sizeof(uint32_t));
+    }
+    _counters.addWrite(ok ? ((hasFactSubchunk()) ? 3 : 2) * sizeof(uint32_t) : 0, startNanos);
+    if (!ok) {
+        closeFile("Error: Problem updating header sizes at checkpoint.");
+        return false;
+    }
+
+    if (_checkpointSyncData && !wavSyncFileData(_pWriteFile)) {
+        closeFile("Error: Problem syncing file at checkpoint.");
+        return false;
+    }
+
+    _lastCheckpointMs = steadyMillis();
+    _numBytesSinceCheckpoint = 0;
+
+    return true;
+}
+
+
+bool WavWriter::checkpointIfDue(uint32_t numBytesWritten) {
+
+    if (!_checkpointIntervalMs && !_checkpointIntervalBytes) {
+        return true;
+    }
+
+    _numBytesSinceCheckpoint += numBytesWritten;
+    bool due = (_checkpointIntervalBytes && _numBytesSinceCheckpoint >= _checkpointIntervalBytes) ||
+               (_checkpointIntervalMs && steadyMillis() - _lastCheckpointMs >= _checkpointIntervalMs);
+
+    return !due || checkpoint();
+}
+
+
+//Every format but integer PCM carries a fact subchunk, always directly after the format subchunk
+bool WavWriter::hasFactSubchunk() {
+    return _audioFormat != AUDIO_FORMAT_INT;
+}
+
+
+//Including its header and, for IMA ADPCM, the frames-per-block extension
+uint32_t WavWriter::getFormatSubchunkSize() {
+    return FORMAT_SUBCHUNK_SIZE + ((_audioFormat == AUDIO_FORMAT_IMA_ADPCM) ? IMA_ADPCM_FORMAT_EXTENSION_SIZE : 0);
+}
+
+
+//Bytes on disk for numFrames frames; IMA ADPCM rounds up to whole blocks
+uint64_t WavWriter::getEncodedDataSize(uint64_t numFrames) {
+    return (numFrames + _framesPerBlock - 1) / _framesPerBlock * _blockAlign;
+}
+
+
+//RIFX: swap through a small buffer, as the caller's bytes are const; returns the number of bytes written
+size_t WavWriter::writeSwappedData(const uint8_t sampleData[],
+                                   uint32_t sampleDataSize) {
+
+    uint8_t swapped[SWAP_WRITE_BLOCK_SIZE];
+    const uint32_t blockSize = SWAP_WRITE_BLOCK_SIZE / _byteDepth * _byteDepth;
+    size_t numBytesWritten = 0;
+    while (numBytesWritten < sampleDataSize) {
+        const uint32_t n = (sampleDataSize - numBytesWritten < blockSize) ?
+                           (uint32_t) (sampleDataSize - numBytesWritten) : blockSize;
+        wavSwapSampleBytes(sampleData + numBytesWritten, _sampleFormat, swapped, n / _byteDepth);
+        uint64_t startNanos = WavCounters::now();
+        const size_t numWritten = fwrite(swapped, 1, n, _pWriteFile);
+        _counters.addWrite(numWritten, startNanos);
+        numBytesWritten += numWritten;
+        if (numWritten < n) {
+            break;
+        }
+    }
+
+    return numBytesWritten;
+}
+
+
+bool WavWriter::writeImaAdpcmFrames(const uint8_t sampleData[], //int16 frames
+                                    uint32_t numFrames) {
+
+    const uint32_t frameSize = _numChannels * sizeof(int16_t);
+    uint32_t numDone = 0;
+    while (numDone < numFrames) {
+        const uint32_t numFree = _framesPerBlock - _numPendingFrames;
+        const uint32_t n = (numFrames - numDone < numFree) ? numFrames - numDone : numFree;
+        memcpy(_pImaAdpcmFrames + (uint64_t) _numPendingFrames * _numChannels,
+               sampleData + (uint64_t) numDone * frameSize,
+               (size_t) n * frameSize);
+        _numPendingFrames += n;
+        numDone += n;
+        if (_numPendingFrames == _framesPerBlock && !flushImaAdpcmBlock()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool WavWriter::flushImaAdpcmBlock() {
+
+    WAV_TRACE_SCOPE_BYTES("WavWriter::encodeImaAdpcm", _blockAlign);
+
+    memset(_pImaAdpcmFrames + (uint64_t) _numPendingFrames * _numChannels, 0,
+           (size_t) (_framesPerBlock - _numPendingFrames) * _numChannels * sizeof(int16_t));
+    uint64_t startNanos = WavCounters::now();
+    if (!wavImaAdpcmEncodeBlock(_pImaAdpcmFrames, _numChannels, _imaAdpcmStates, _pImaAdpcmBlock, _blockAlign)) {
+        closeFile("Error: Problem encoding IMA ADPCM block.");
+        return false;
+    }
+    _counters.addConversion(_framesPerBlock, startNanos);
+
+    startNanos = WavCounters::now();
+    size_t numBytesWritten = fwrite(_pImaAdpcmBlock, 1, _blockAlign, _pWriteFile);
+    _counters.addWrite(numBytesWritten, startNanos);
+    if (numBytesWritten < _blockAlign) {
+        closeFile("Error: Problem writing IMA ADPCM block.");
+        return false;
+    }
+    _numPendingFrames = 0;
+
+    return true;
+}
+
+
 bool WavWriter::writeInt16SampleToArray(int16_t int16SampleCh1,
                                         int16_t int16SampleCh2,
                                         uint32_t sampleIndex,
@@ -463,14 +1138,60 @@ bool WavWriter::writeInt16SampleToArray(int16_t int16SampleCh1,
         return false;
     }
 
-    uint8_t srcBytes[sizeof(int16_t) * _numChannels];
-    ((int16_t *) srcBytes)[0] = int16SampleCh1;
-    if (_numChannels == 2) {
-        ((int16_t *) srcBytes)[1] = int16SampleCh2;
+    const uint32_t frameSize = _numChannels * _byteDepth;
+    if ((uint64_t) (sampleIndex + 1) * frameSize > sampleDataSize) {
+        fprintf(stderr, "Error: Sample index past end of sample data.\n");
+        return false;
     }
 
-    uint8_t *destBytes = (uint8_t *) (sampleData + (sampleIndex * _numChannels * _byteDepth));
-    memcpy(destBytes, srcBytes, (sizeof(int16_t) * _numChannels));
+    //Encode to this writer's sample format, not just copy the int16 bits
+    int16_t srcSamples[2] = {int16SampleCh1, int16SampleCh2};
+    uint8_t *destBytes = (uint8_t *) (sampleData + (sampleIndex * frameSize));
+    return wavConvertSamples((const uint8_t *) srcSamples, WAV_SAMPLE_FORMAT_INT16,
+                             destBytes, _sampleFormat,
+                             _numChannels);
+}
+
+
+
+bool WavWriter::getCounters(WavCounterSnapshot *snapshot) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    _counters.snapshot(snapshot);
+
+    return true;
+}
+
+
+bool WavWriter::setAsyncEngine(WavAsyncEngine *asyncEngine) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    _pAsyncEngine = asyncEngine;
+
+    return true;
+}
+
+
+bool WavWriter::setSignalStats(WavSignalStats *signalStats) {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    if (signalStats && !signalStats->initialize(_numChannels, _sampleFormat)) {
+        return false;
+    }
+
+    _pSignalStats = signalStats;
 
     return true;
 }
@@ -525,6 +1246,39 @@ bool WavWriter::getSamplesAreInts() {
 }
 
 
+WavSampleFormat WavWriter::getSampleFormat() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return WAV_SAMPLE_FORMAT_INVALID;
+    }
+
+    return _sampleFormat;
+}
+
+
+uint16_t WavWriter::getAudioFormat() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return 0;
+    }
+
+    return _audioFormat;
+}
+
+
+bool WavWriter::getIsBigEndian() {
+
+    if (!_initialized) {
+        fprintf(stderr, "%s", UNINITIALIZED_MSG);
+        return false;
+    }
+
+    return _bigEndian;
+}
+
+
 uint32_t WavWriter::getByteDepth() {
 
     if (!_initialized) {
@@ -8,6 +8,12 @@
 #include <cstdint> //For uint8_t, etc.
 
 #include "WavHeader.hpp"
+#include "WavSampleConverter.hpp"
+#include "WavSignalStats.hpp"
+#include "WavCounters.hpp"
+#include "WavBufferPool.hpp"
+#include "WavImaAdpcm.hpp"
+#include "WavAsync.hpp"
 
 
 class WavWriter {
@@ -23,24 +29,116 @@ public:
                     bool samplesAreInts, //False if samples are 32 or 64-bit floating point values
                     uint32_t byteDepth); //Number of bytes required to represent the value of a single channel of a sample
 
-    bool startWriting();
+    //As above, by sample format; the only way to write A-law or mu-law (8-bit G.711) files
+    bool initialize(const char *writeFilePath,
+                    uint32_t sampleRate,
+                    uint32_t numChannels,
+                    WavSampleFormat sampleFormat);
+
+    //Write an IMA ADPCM (4-bit, about 4:1) file. writeData() and the other write calls then take
+    //16-bit PCM, which is encoded a block at a time; blockAlign 0 picks the usual size for the rate.
+    bool initializeImaAdpcm(const char *writeFilePath,
+                            uint32_t sampleRate,
+                            uint32_t numChannels,
+                            uint32_t blockAlign = 0);
+
+    //Queue a chunk (e.g. LIST, bext) to be written between the format and data subchunks.
+    //Call after initialize() and before startWriting(); the data is copied.
+    bool addSubchunk(const char subchunkId[4],
+                     const uint8_t subchunkData[],
+                     uint32_t subchunkSize);
+
+    //As addSubchunk(), but the payload is subchunkSize bytes at srcOffset in another file (e.g. as
+    //located by WavReader::getSubchunkInfo()). It isn't read now: startWriting() copies it across
+    //with wavCopyFileRange(), so multi-megabyte iXML or coding history never passes through memory.
+    bool addSubchunkFromFile(const char subchunkId[4],
+                             const char *srcFilePath,
+                             uint32_t srcOffset,
+                             uint32_t subchunkSize);
+
+    //Write a RIFX file: header fields and samples big-endian. Call after initialize() and before
+    //startWriting(). The write calls still take RIFF (little-endian) order and swap as they write,
+    //except writeDataFromFile(), which copies bytes as they are.
+    bool setBigEndian(bool bigEndian);
+
+    //If the final length is known, pass it as expectedNumSamples: the data region is then
+    //preallocated (see wavPreallocateFile()) and finishWriting() trims any unused space
+    bool startWriting(uint32_t expectedNumSamples = 0);
 
     bool writeData(const uint8_t sampleData[], //WAV format bytes
                    uint32_t sampleDataSize);
 
+    //Write a pool block's valid bytes; the block stays owned by the caller
+    bool writeData(const WavBufferBlock *block);
+
+    //Append sample data straight from another file, e.g. another wav file's data subchunk.
+    //The bytes are copied kernel-side where possible and must already be in this writer's format.
+    //Attached signal statistics are not updated, since the bytes never pass through this process.
+    bool writeDataFromFile(const char *srcFilePath,
+                           uint64_t srcOffset,
+                           uint32_t sampleDataSize);
+
+    //Encode from int16, int32 or float32 (full scale [-1.0, 1.0)) to this writer's sample format,
+    //a block per conversion call; narrowing rounds and saturates
     bool
     writeDataFromInt16s(const int16_t int16Samples[], //channels interleaved; length = numInt16Samples * numChannels
                         uint32_t numInt16Samples);
 
+    bool writeDataFromInt32s(const int32_t int32Samples[], //channels interleaved; length = numFrames * numChannels
+                             uint32_t numFrames);
+
+    bool writeDataFromFloats(const float floatSamples[], //channels interleaved; length = numFrames * numChannels
+                             uint32_t numFrames);
+
+    //Encode one float array per channel straight into interleaved wav-format data; rounds and saturates
+    bool writeFramesPlanar(const float *const channels[], //numChannels arrays of numFrames values
+                           uint32_t numFrames);
+
     bool finishWriting(); //Verify, update header's data size field, close file
 
-    //Write sample to in-memory wav data array
+    //Crash safety for long recordings: every intervalMs milliseconds or intervalBytes bytes of
+    //sample data (0 disables either), writeData() calls checkpoint(). Off by default.
+    bool setCheckpointPolicy(uint32_t intervalMs,
+                             uint32_t intervalBytes,
+                             bool syncData); //Also fdatasync() at each checkpoint
+
+    //Flush, then patch the RIFF, fact and data size fields in place with positional writes,
+    //so the file is valid up to the samples written so far. No seeks or subchunk searches.
+    bool checkpoint();
+
+    //Write sample to in-memory wav data array, encoded to this writer's sample format
     bool writeInt16SampleToArray(int16_t int16SampleCh1,
                                  int16_t int16SampleCh2,
                                  uint32_t sampleIndex,
                                  const uint8_t sampleData[], //Wav format bytes; samples interleaved if multiple channels
                                  uint32_t sampleDataSize);
 
+    //Update signalStats on every block written from now on; nullptr detaches
+    bool setSignalStats(WavSignalStats *signalStats);
+
+    //I/O and conversion done by this writer so far; see WavCounters::global() for process-wide totals
+    bool getCounters(WavCounterSnapshot *snapshot);
+
+    //Engine for the async writes; nullptr (the default) runs them inline
+    bool setAsyncEngine(WavAsyncEngine *asyncEngine);
+
+#if defined(__cpp_impl_coroutine)
+    //C++20: bool ok = co_await wavWriter.writeAsync(...); writeData() and finishWriting() on the
+    //async engine. Await each call before making the next, as with the blocking calls.
+    WavAsyncOperation writeAsync(const uint8_t sampleData[], //WAV format bytes
+                                 uint32_t sampleDataSize) {
+        return WavAsyncOperation(_pAsyncEngine, [this, sampleData, sampleDataSize]() {
+            return writeData(sampleData, sampleDataSize);
+        });
+    }
+
+    WavAsyncOperation finishAsync() {
+        return WavAsyncOperation(_pAsyncEngine, [this]() {
+            return finishWriting();
+        });
+    }
+#endif
+
     const char *getWriteFilePath();
 
     uint32_t getSampleRate();
@@ -49,6 +147,13 @@ public:
 
     bool getSamplesAreInts();
 
+    WavSampleFormat getSampleFormat();
+
+    //The format subchunk's audioFormat, e.g. AUDIO_FORMAT_IMA_ADPCM
+    uint16_t getAudioFormat();
+
+    bool getIsBigEndian();
+
     uint32_t getByteDepth();
 
     uint32_t getNumSamplesWritten();
@@ -65,6 +170,44 @@ private:
 
     bool findSubchunk(const char *subchunkId);
 
+    void freeExtraSubchunks();
+
+    bool queueExtraSubchunk(const char subchunkId[4]);
+
+    bool checkpointIfDue(uint32_t numBytesWritten);
+
+    bool hasFactSubchunk();
+
+    uint32_t getFormatSubchunkSize();
+
+    uint64_t getEncodedDataSize(uint64_t numFrames);
+
+    size_t writeSwappedData(const uint8_t sampleData[],
+                            uint32_t sampleDataSize);
+
+    bool writeImaAdpcmFrames(const uint8_t sampleData[], //int16 frames
+                             uint32_t numFrames);
+
+    bool flushImaAdpcmBlock();
+
+    void freeImaAdpcmBuffers();
+
+    bool writeDataConverted(const uint8_t srcSamples[],
+                            WavSampleFormat srcFormat,
+                            uint32_t numFrames);
+
+    typedef struct {
+        char subchunkId[4];
+        uint8_t *pSubchunkData; //nullptr if the payload is copied from pSrcFilePath
+        char *pSrcFilePath;
+        uint32_t srcOffset;
+        uint32_t subchunkSize;
+    } ExtraSubchunk;
+
+    bool writeExtraSubchunkPayload(ExtraSubchunk *esc);
+
+    static const uint32_t MAX_NUM_EXTRA_SUBCHUNKS = 64;
+
     const char *_writeFilePath;
     FILE *_pWriteFile;
 
@@ -72,8 +215,29 @@ private:
     uint32_t _numChannels;
     bool _samplesAreInts; //False if samples are floating-point values, 32 or 64-bit
     uint32_t _byteDepth; //Number of significant bytes required a single channel of a sample
+    WavSampleFormat _sampleFormat;
+    bool _bigEndian; //RIFX rather than RIFF
+    uint16_t _audioFormat;
+    uint32_t _blockAlign; //Bytes per block: one frame, or one IMA ADPCM block
+    uint32_t _framesPerBlock;
+    uint8_t *_pImaAdpcmBlock; //Block being encoded
+    int16_t *_pImaAdpcmFrames; //Frames waiting to fill a block
+    uint32_t _numPendingFrames;
+    WavImaAdpcmState _imaAdpcmStates[2];
     bool _initialized;
     uint32_t _numSamplesWritten;
+    uint32_t _headerSize; //Bytes preceding the sample data, i.e. through the data subchunk header
+    bool _preallocated;
+    uint32_t _checkpointIntervalMs;
+    uint32_t _checkpointIntervalBytes;
+    bool _checkpointSyncData;
+    uint64_t _lastCheckpointMs;
+    uint64_t _numBytesSinceCheckpoint;
+    ExtraSubchunk _extraSubchunks[MAX_NUM_EXTRA_SUBCHUNKS];
+    uint32_t _numExtraSubchunks;
+    WavSignalStats *_pSignalStats;
+    WavAsyncEngine *_pAsyncEngine;
+    WavCounters _counters; //Not copyable, so neither is the writer
 };
 
 
@@ -0,0 +1,172 @@
+//WavAsyncTester.cpp
+//Awaited write/read roundtrips through the inline path (no engine) and WavThreadPoolEngine.
+//Built as C++20, apart from the C++11 library; see Source/Test/CMakeLists.txt.
+//Usage: wav_async_tester OutputDir
+
+
+#if !defined(__cpp_impl_coroutine)
+#error "WavAsyncTester needs a C++20 compiler with coroutine support"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "WavReader.hpp"
+#include "WavWriter.hpp"
+
+
+static const uint32_t NUM_CHANNELS = 2;
+static const uint32_t NUM_FRAMES = 48000;
+static const uint32_t NUM_FRAMES_PER_WRITE = 1000;
+static const uint32_t NUM_POOL_FILES = 16;
+
+
+//Starts running at once and runs to the end; the tester counts finished roundtrips in _numDone
+struct RoundtripTask {
+    struct promise_type {
+        RoundtripTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+
+static std::atomic<uint32_t> _numDone(0);
+static std::atomic<uint32_t> _numFailed(0);
+
+
+static void fail(const char *filePath, const char *message) {
+    fprintf(stderr, "Async roundtrip of %s failed: %s\n", filePath, message);
+    _numFailed++;
+}
+
+
+static RoundtripTask roundtrip(WavAsyncEngine *engine, const char *filePath, uint32_t seed) {
+
+    const uint32_t frameSize = NUM_CHANNELS * sizeof(int16_t);
+    std::vector<uint8_t> written(NUM_FRAMES * frameSize);
+    for (size_t i = 0; i < written.size(); i++) {
+        written[i] = (uint8_t) (i * 7 + seed);
+    }
+
+    WavWriter wavWriter;
+    if (!wavWriter.initialize(filePath, 48000, NUM_CHANNELS, WAV_SAMPLE_FORMAT_INT16) ||
+        !wavWriter.setAsyncEngine(engine) ||
+        !wavWriter.startWriting()) {
+        fail(filePath, "couldn't start writing");
+        _numDone++;
+        co_return;
+    }
+    for (uint32_t frame = 0; frame < NUM_FRAMES; frame += NUM_FRAMES_PER_WRITE) {
+        if (!co_await wavWriter.writeAsync(&written[frame * frameSize], NUM_FRAMES_PER_WRITE * frameSize)) {
+            fail(filePath, "writeAsync()");
+        }
+    }
+    if (!co_await wavWriter.finishAsync()) {
+        fail(filePath, "finishAsync()");
+    }
+
+    WavReader wavReader;
+    if (!wavReader.initialize(filePath) ||
+        !wavReader.setAsyncEngine(engine) ||
+        !wavReader.prepareToRead()) {
+        fail(filePath, "couldn't start reading");
+        _numDone++;
+        co_return;
+    }
+    if (wavReader.getNumSamples() != NUM_FRAMES) {
+        fail(filePath, "wrong number of frames");
+    }
+
+    std::vector<uint8_t> read(written.size());
+    if (!co_await wavReader.readFramesAsync(read.data(), NUM_FRAMES)) {
+        fail(filePath, "readFramesAsync() to bytes");
+    } else if (read != written) {
+        fail(filePath, "bytes read differ from those written");
+    }
+
+    //Planar float read of the same frames
+    if (!wavReader.prepareToRead()) {
+        fail(filePath, "couldn't restart reading");
+    }
+    std::vector<float> left(NUM_FRAMES);
+    std::vector<float> right(NUM_FRAMES);
+    float *const channels[NUM_CHANNELS] = {left.data(), right.data()};
+    if (!co_await wavReader.readFramesAsync(channels, NUM_FRAMES)) {
+        fail(filePath, "readFramesAsync() to channels");
+    } else {
+        for (uint32_t frame = 0; frame < NUM_FRAMES; frame++) {
+            const uint8_t *pFrame = &written[frame * frameSize];
+            int16_t leftSample = (int16_t) (pFrame[0] | pFrame[1] << 8);
+            int16_t rightSample = (int16_t) (pFrame[2] | pFrame[3] << 8);
+            if (left[frame] != leftSample / 32768.0f || right[frame] != rightSample / 32768.0f) {
+                fail(filePath, "float samples differ from those written");
+                break;
+            }
+        }
+    }
+    wavReader.finishReading();
+
+    _numDone++;
+}
+
+
+static bool waitForRoundtrips(uint32_t numRoundtrips) {
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    while (_numDone < numRoundtrips) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            fprintf(stderr, "Async roundtrips timed out: %u of %u done.\n", _numDone.load(), numRoundtrips);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    if (argc != 2) {
+        printf("Usage: wav_async_tester OutputDir\n");
+        return 1;
+    }
+    const char *outputDirectory = argv[1];
+    char filePath[1024];
+
+    //No engine: every call runs inline, so the coroutine has finished when roundtrip() returns
+    snprintf(filePath, sizeof(filePath), "%s/async-inline.wav", outputDirectory);
+    roundtrip(nullptr, filePath, 0);
+    if (_numDone != 1) {
+        fprintf(stderr, "Inline async roundtrip suspended.\n");
+        return 1;
+    }
+
+    //Thread pool: more files than threads, so some operations queue behind others
+    {
+        WavThreadPoolEngine engine;
+        if (!engine.initialize(4)) {
+            return 1;
+        }
+        std::vector<std::vector<char>> filePaths(NUM_POOL_FILES, std::vector<char>(1024));
+        _numDone = 0;
+        for (uint32_t i = 0; i < NUM_POOL_FILES; i++) {
+            snprintf(filePaths[i].data(), filePaths[i].size(), "%s/async-pool-%u.wav", outputDirectory, i);
+            roundtrip(&engine, filePaths[i].data(), i + 1);
+        }
+        if (!waitForRoundtrips(NUM_POOL_FILES)) {
+            return 1;
+        }
+    } //Joins the engine's threads
+
+    printf("Async roundtrips: %u failed\n", _numFailed.load());
+
+    return _numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+//WavBlockCacheTester.cpp
+
+
+#include <cmath> // M_PI
+#include <cstdio>
+#include <cstring> //memcmp()
+#include <sys/stat.h>
+#include <utime.h>
+#include <vector>
+
+#include "WavBlockCacheTester.hpp"
+#include "WavWriter.hpp"
+
+
+WavBlockCacheTester::WavBlockCacheTester() {
+    _pOutDirPath = nullptr;
+}
+
+
+WavBlockCacheTester::~WavBlockCacheTester() {
+}
+
+
+bool WavBlockCacheTester::initialize(const char *outDirPath) {
+
+    //Error-check outDirPath
+    if (!outDirPath) {
+        fprintf(stderr, "Error: Output directory path is NULL.\n");
+        return false;
+    }
+    char tempOutFilePath[MAX_PATH_LENGTH];
+    snprintf(tempOutFilePath, sizeof(tempOutFilePath), "%s/WavBlockCacheTesterTempFile.txt", outDirPath);
+    FILE *fp = fopen(tempOutFilePath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Invalid output directory path.\n");
+        return false;
+    }
+    fclose(fp);
+    if (remove(tempOutFilePath) != 0) {
+        fprintf(stderr, "Error: Unable to remove test file created to validate output directory path.\n");
+        return false;
+    }
+
+    _pOutDirPath = outDirPath;
+
+    //Full-scale 100-frame sine, the same in both channels
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+        int16_t int16Sample = (int16_t) (32767.0 * sin((2 * M_PI * i) / 100.0));
+        float floatSample = (float) sin((2 * M_PI * i) / 100.0);
+        _int16Samples[i * 2] = int16Sample;
+        _int16Samples[i * 2 + 1] = int16Sample;
+        _floatSamples[i * 2] = floatSample;
+        _floatSamples[i * 2 + 1] = floatSample;
+    }
+
+    return true;
+}
+
+
+bool WavBlockCacheTester::runWavBlockCacheTest() {
+
+    if (!_pOutDirPath) {
+        fprintf(stderr, "Attempt to call WavBlockCacheTester class method before calling initialize().\n");
+        return false;
+    }
+
+    printf("Running WavBlockCacheTest.\n");
+
+    printf("    Testing hits...\n");
+    if (!testHits()) {
+        fprintf(stderr, "runWavBlockCacheTest(): Error testing hits.\n");
+        return false;
+    }
+
+    printf("    Testing invalidation...\n");
+    if (!testInvalidation()) {
+        fprintf(stderr, "runWavBlockCacheTest(): Error testing invalidation.\n");
+        return false;
+    }
+
+    printf("    Testing eviction...\n");
+    if (!testEviction()) {
+        fprintf(stderr, "runWavBlockCacheTest(): Error testing eviction.\n");
+        return false;
+    }
+
+    printf("Done WavBlockCacheTest.\n\n");
+
+    return true;
+}
+
+
+//Repeat reads are served from the cache, and decoded blocks match the reader's own conversions
+bool WavBlockCacheTester::testHits() {
+
+    char int16FilePath[MAX_PATH_LENGTH];
+    char floatFilePath[MAX_PATH_LENGTH];
+    snprintf(int16FilePath, sizeof(int16FilePath), "%s/blockcache-hits-16i.wav", _pOutDirPath);
+    snprintf(floatFilePath, sizeof(floatFilePath), "%s/blockcache-hits-32f.wav", _pOutDirPath);
+    if (!writeFile(int16FilePath, _int16Samples, nullptr) ||
+        !writeFile(floatFilePath, nullptr, _floatSamples)) {
+        return false;
+    }
+
+    //Frames 100-1099 span blocks 0-4: five misses, then five hits
+    WavBlockCache cache;
+    WavBlockCacheStats stats;
+    WavReader wavReader;
+    std::vector<int16_t> int16Samples(NUM_SAMPLES * 2);
+    if (!cache.initialize(FRAMES_PER_BLOCK, 64 * BLOCK_SIZE, 4) ||
+        !wavReader.initialize(int16FilePath) ||
+        !wavReader.prepareToRead() ||
+        !cache.readFramesToInt16s(&wavReader, 100, 1000, int16Samples.data()) ||
+        memcmp(int16Samples.data(), &_int16Samples[100 * 2], 1000 * 2 * sizeof(int16_t)) ||
+        !cache.readFramesToInt16s(&wavReader, 100, 1000, int16Samples.data()) ||
+        memcmp(int16Samples.data(), &_int16Samples[100 * 2], 1000 * 2 * sizeof(int16_t)) ||
+        !cache.getStats(&stats) ||
+        stats.numMisses != 5 || stats.numHits != 5 || stats.numBlocks != 5 || stats.numBytes != 5 * BLOCK_SIZE) {
+        fprintf(stderr, "testHits(): Unexpected samples or hits reading through the cache.\n");
+        return false;
+    }
+
+    //Decoded blocks match the reader's own conversions exactly
+    WavReader floatReader;
+    std::vector<int16_t> readerInt16Samples(NUM_SAMPLES * 2);
+    if (!floatReader.initialize(floatFilePath) ||
+        !floatReader.prepareToRead() ||
+        !floatReader.readDataToInt16s(readerInt16Samples.data(), NUM_SAMPLES) ||
+        !floatReader.prepareToRead() ||
+        !cache.readFramesToInt16s(&floatReader, 0, NUM_SAMPLES, int16Samples.data()) ||
+        int16Samples != readerInt16Samples) {
+        fprintf(stderr, "testHits(): Cached int16 samples differ from readDataToInt16s().\n");
+        return false;
+    }
+    std::vector<float> floatSamples(NUM_SAMPLES * 2);
+    if (!cache.readFramesToFloats(&floatReader, 0, NUM_SAMPLES, floatSamples.data()) ||
+        memcmp(floatSamples.data(), _floatSamples, NUM_SAMPLES * 2 * sizeof(float))) {
+        fprintf(stderr, "testHits(): Cached float samples differ from the file's.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//invalidateFile() drops one file's blocks only, and a file rewritten in place is never served stale
+bool WavBlockCacheTester::testInvalidation() {
+
+    char int16FilePath[MAX_PATH_LENGTH];
+    char floatFilePath[MAX_PATH_LENGTH];
+    snprintf(int16FilePath, sizeof(int16FilePath), "%s/blockcache-invalidation-16i.wav", _pOutDirPath);
+    snprintf(floatFilePath, sizeof(floatFilePath), "%s/blockcache-invalidation-32f.wav", _pOutDirPath);
+    if (!writeFile(int16FilePath, _int16Samples, nullptr) ||
+        !writeFile(floatFilePath, nullptr, _floatSamples)) {
+        return false;
+    }
+
+    WavBlockCache cache;
+    WavBlockCacheStats stats;
+    WavBlockCacheStats afterStats;
+    WavReader wavReader;
+    WavReader floatReader;
+    std::vector<int16_t> int16Samples(NUM_SAMPLES * 2);
+    if (!cache.initialize(FRAMES_PER_BLOCK, 64 * BLOCK_SIZE, 4) ||
+        !wavReader.initialize(int16FilePath) ||
+        !wavReader.prepareToRead() ||
+        !cache.readFramesToInt16s(&wavReader, 100, 1000, int16Samples.data()) ||
+        !floatReader.initialize(floatFilePath) ||
+        !floatReader.prepareToRead() ||
+        !cache.readFramesToInt16s(&floatReader, 0, NUM_SAMPLES, int16Samples.data()) ||
+        !cache.getStats(&stats)) {
+        fprintf(stderr, "testInvalidation(): Problem filling the cache.\n");
+        return false;
+    }
+
+    cache.invalidateFile(int16FilePath);
+    if (!cache.getStats(&afterStats) ||
+        afterStats.numBlocks != stats.numBlocks - 5 ||
+        afterStats.numBytes != stats.numBytes - 5 * BLOCK_SIZE) {
+        fprintf(stderr, "testInvalidation(): invalidateFile() didn't drop exactly the file's blocks.\n");
+        return false;
+    }
+
+    //Rewritten in place with the same layout, and only the modification time to tell: the old
+    //blocks must not be served
+    struct stat st;
+    struct utimbuf times;
+    std::vector<int16_t> invertedSamples(NUM_SAMPLES * 2);
+    for (uint32_t i = 0; i < NUM_SAMPLES * 2; i++) {
+        invertedSamples[i] = (int16_t) -_int16Samples[i];
+    }
+    if (!wavReader.prepareToRead() ||
+        !cache.readFramesToInt16s(&wavReader, 0, FRAMES_PER_BLOCK, int16Samples.data()) ||
+        stat(int16FilePath, &st) != 0 ||
+        !writeFile(int16FilePath, invertedSamples.data(), nullptr)) {
+        fprintf(stderr, "testInvalidation(): Problem rewriting file.\n");
+        return false;
+    }
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime + 10; //Whatever the file system's timestamp resolution
+    WavReader rewrittenReader;
+    if (utime(int16FilePath, &times) != 0 ||
+        !rewrittenReader.initialize(int16FilePath) ||
+        !rewrittenReader.prepareToRead() ||
+        !cache.readFramesToInt16s(&rewrittenReader, 0, FRAMES_PER_BLOCK, int16Samples.data()) ||
+        memcmp(int16Samples.data(), invertedSamples.data(), FRAMES_PER_BLOCK * 2 * sizeof(int16_t))) {
+        fprintf(stderr, "testInvalidation(): Blocks of a rewritten file were served from the cache.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//A budget of two blocks per shard: reading eight blocks in order evicts the oldest six
+bool WavBlockCacheTester::testEviction() {
+
+    char int16FilePath[MAX_PATH_LENGTH];
+    snprintf(int16FilePath, sizeof(int16FilePath), "%s/blockcache-eviction-16i.wav", _pOutDirPath);
+    if (!writeFile(int16FilePath, _int16Samples, nullptr)) {
+        return false;
+    }
+
+    WavBlockCache cache;
+    WavBlockCacheStats stats;
+    WavReader wavReader;
+    std::vector<int16_t> int16Samples(NUM_SAMPLES * 2);
+    if (!cache.initialize(FRAMES_PER_BLOCK, 2 * BLOCK_SIZE, 1) ||
+        !wavReader.initialize(int16FilePath) ||
+        !wavReader.prepareToRead() ||
+        !cache.readFramesToInt16s(&wavReader, 0, NUM_SAMPLES, int16Samples.data()) ||
+        memcmp(int16Samples.data(), _int16Samples, NUM_SAMPLES * 2 * sizeof(int16_t)) ||
+        !cache.readFramesToInt16s(&wavReader, NUM_SAMPLES - 1, 1, int16Samples.data()) ||
+        !cache.readFramesToInt16s(&wavReader, 0, 1, int16Samples.data()) ||
+        !cache.getStats(&stats) ||
+        stats.numMisses != 9 || stats.numHits != 1 || stats.numEvictions != 7 ||
+        stats.numBlocks != 2 || stats.numBytes != 2 * BLOCK_SIZE) {
+        fprintf(stderr, "testEviction(): Unexpected eviction.\n");
+        return false;
+    }
+
+    //clear() empties the cache without counting evictions
+    cache.clear();
+    if (!cache.getStats(&stats) ||
+        stats.numBlocks != 0 || stats.numBytes != 0 || stats.numEvictions != 7) {
+        fprintf(stderr, "testEviction(): clear() left blocks in the cache.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavBlockCacheTester::writeFile(const char *filePath,
+                                    const int16_t int16Samples[],
+                                    const float floatSamples[]) {
+
+    WavWriter wavWriter;
+    bool ok = wavWriter.initialize(filePath,
+                                   SAMPLE_RATE,
+                                   2,
+                                   int16Samples ? WAV_SAMPLE_FORMAT_INT16 : WAV_SAMPLE_FORMAT_FLOAT32) &&
+              wavWriter.startWriting();
+    if (ok && int16Samples) {
+        ok = wavWriter.writeDataFromInt16s(int16Samples, NUM_SAMPLES);
+    } else if (ok) {
+        ok = wavWriter.writeDataFromFloats(floatSamples, NUM_SAMPLES);
+    }
+    if (!ok || !wavWriter.finishWriting()) {
+        fprintf(stderr, "writeFile(): Problem writing %s.\n", filePath);
+        return false;
+    }
+
+    return true;
+}
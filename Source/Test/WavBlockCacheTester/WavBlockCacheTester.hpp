@@ -0,0 +1,50 @@
+//WavBlockCacheTester.hpp
+
+#ifndef __WAV_BLOCK_CACHE_TESTER_HPP__
+#define __WAV_BLOCK_CACHE_TESTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavBlockCache.hpp"
+
+
+class WavBlockCacheTester {
+
+public:
+
+    WavBlockCacheTester();
+
+    ~ WavBlockCacheTester();
+
+    bool initialize(const char *outDirPath);
+
+    bool runWavBlockCacheTest();
+
+private:
+
+    bool testHits();
+
+    bool testInvalidation();
+
+    bool testEviction();
+
+    //Stereo int16 or float32 file of the given samples
+    bool writeFile(const char *filePath,
+                   const int16_t int16Samples[],
+                   const float floatSamples[]);
+
+    //Constants
+    static const uint32_t MAX_PATH_LENGTH = 2048;
+    static const uint32_t NUM_SAMPLES = 2048;
+    static const uint32_t SAMPLE_RATE = 44100;
+    static const uint32_t FRAMES_PER_BLOCK = 256;
+    static const uint32_t BLOCK_SIZE = FRAMES_PER_BLOCK * 2 * sizeof(int16_t); //Stereo int16
+
+    int16_t _int16Samples[NUM_SAMPLES * 2];
+    float _floatSamples[NUM_SAMPLES * 2];
+
+    const char *_pOutDirPath;
+};
+
+
+#endif //__WAV_BLOCK_CACHE_TESTER_HPP__
@@ -0,0 +1,298 @@
+//WavBufferPoolTester.cpp
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring> //memset()
+#include <thread>
+#include <vector>
+
+#include "WavBufferPoolTester.hpp"
+
+
+WavBufferPoolTester::WavBufferPoolTester() {
+}
+
+
+WavBufferPoolTester::~WavBufferPoolTester() {
+}
+
+
+bool WavBufferPoolTester::runWavBufferPoolTest() {
+
+    printf("Running WavBufferPoolTest.\n");
+
+    printf("    Testing block layout...\n");
+    if (!testLayout(false) || !testLayout(true)) {
+        fprintf(stderr, "runWavBufferPoolTest(): Error testing block layout.\n");
+        return false;
+    }
+
+    printf("    Testing reference counting...\n");
+    if (!testReferenceCounting()) {
+        fprintf(stderr, "runWavBufferPoolTest(): Error testing reference counting.\n");
+        return false;
+    }
+
+    printf("    Testing exhaustion...\n");
+    if (!testExhaustion()) {
+        fprintf(stderr, "runWavBufferPoolTest(): Error testing exhaustion.\n");
+        return false;
+    }
+
+    printf("    Testing waiting for a block...\n");
+    if (!testAcquireWait()) {
+        fprintf(stderr, "runWavBufferPoolTest(): Error testing waiting for a block.\n");
+        return false;
+    }
+
+    printf("    Testing re-initializing...\n");
+    if (!testReinitialize()) {
+        fprintf(stderr, "runWavBufferPoolTest(): Error testing re-initializing.\n");
+        return false;
+    }
+
+    printf("Done WavBufferPoolTest.\n\n");
+
+    return true;
+}
+
+
+//Every block page-aligned, with its full capacity writable and not overlapping the next
+bool WavBufferPoolTester::testLayout(bool useHugePages) {
+
+    WavBufferPool pool;
+    if (pool.initialize(0, NUM_BLOCKS) || pool.initialize(BLOCK_SIZE, 0)) {
+        fprintf(stderr, "testLayout(): Pool of empty blocks, or of no blocks, was initialized.\n");
+        return false;
+    }
+    if (!pool.initialize(BLOCK_SIZE, NUM_BLOCKS, useHugePages) ||
+        pool.getBlockSize() != BLOCK_SIZE ||
+        pool.getNumBlocks() != NUM_BLOCKS ||
+        pool.getNumFreeBlocks() != NUM_BLOCKS) {
+        fprintf(stderr, "testLayout(): Problem initializing pool.\n");
+        return false;
+    }
+
+    WavBufferBlock *blocks[NUM_BLOCKS];
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+        blocks[i] = pool.acquire();
+        if (!blocks[i] ||
+            blocks[i]->getCapacity() != BLOCK_SIZE ||
+            blocks[i]->getSize() != 0 ||
+            (uintptr_t) blocks[i]->getData() % PAGE_SIZE != 0) {
+            fprintf(stderr, "testLayout(): Block %u is missing or misaligned.\n", i);
+            return false;
+        }
+        memset(blocks[i]->getData(), (int) i + 1, BLOCK_SIZE);
+    }
+    bool ok = true;
+    for (uint32_t i = 0; i < NUM_BLOCKS && ok; i++) {
+        const uint8_t *pData = blocks[i]->getData();
+        for (uint32_t j = 0; j < BLOCK_SIZE; j++) {
+            if (pData[j] != i + 1) {
+                fprintf(stderr, "testLayout(): Block %u overlaps another.\n", i);
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    //Sizes up to the capacity are kept
+    if (ok && (!blocks[0]->setSize(BLOCK_SIZE) || blocks[0]->getSize() != BLOCK_SIZE ||
+               blocks[0]->setSize(BLOCK_SIZE + 1) || blocks[0]->getSize() != BLOCK_SIZE)) {
+        fprintf(stderr, "testLayout(): Block size isn't limited to its capacity.\n");
+        ok = false;
+    }
+
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+        blocks[i]->release();
+    }
+    if (ok && pool.getNumFreeBlocks() != NUM_BLOCKS) {
+        fprintf(stderr, "testLayout(): Released blocks weren't returned.\n");
+        ok = false;
+    }
+
+    return ok;
+}
+
+
+//A block goes back to the pool only with its last reference, and comes out again reset
+bool WavBufferPoolTester::testReferenceCounting() {
+
+    WavBufferPool pool;
+    if (!pool.initialize(BLOCK_SIZE, 1)) {
+        fprintf(stderr, "testReferenceCounting(): Problem initializing pool.\n");
+        return false;
+    }
+
+    WavBufferBlock *block = pool.acquire();
+    if (!block || !block->setSize(100)) {
+        fprintf(stderr, "testReferenceCounting(): Problem acquiring block.\n");
+        return false;
+    }
+    block->retain();
+    block->retain();
+    block->release();
+    block->release();
+    if (pool.getNumFreeBlocks() != 0) {
+        fprintf(stderr, "testReferenceCounting(): Block returned while still referenced.\n");
+        return false;
+    }
+    block->release();
+    if (pool.getNumFreeBlocks() != 1) {
+        fprintf(stderr, "testReferenceCounting(): Block not returned with its last reference.\n");
+        return false;
+    }
+
+    WavBufferBlock *again = pool.acquire();
+    if (again != block || again->getSize() != 0) {
+        fprintf(stderr, "testReferenceCounting(): Reacquired block wasn't reset.\n");
+        return false;
+    }
+
+    //A reference handed to another thread, released there last
+    again->retain();
+    std::thread holder([again]() { again->release(); });
+    again->release();
+    holder.join();
+    if (pool.getNumFreeBlocks() != 1) {
+        fprintf(stderr, "testReferenceCounting(): Block shared between threads not returned.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavBufferPoolTester::testExhaustion() {
+
+    WavBufferPool pool;
+    if (!pool.initialize(BLOCK_SIZE, NUM_BLOCKS)) {
+        fprintf(stderr, "testExhaustion(): Problem initializing pool.\n");
+        return false;
+    }
+
+    WavBufferBlock *blocks[NUM_BLOCKS];
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+        blocks[i] = pool.acquire();
+    }
+    WavBufferBlock *extra = pool.acquire();
+    if (extra || pool.getNumFreeBlocks() != 0) {
+        fprintf(stderr, "testExhaustion(): Acquired more blocks than the pool holds.\n");
+        if (extra) {
+            extra->release();
+        }
+        for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+            if (blocks[i]) {
+                blocks[i]->release();
+            }
+        }
+        return false;
+    }
+
+    //One released block can be acquired again, and only one
+    blocks[2]->release();
+    blocks[2] = pool.acquire();
+    extra = pool.acquire();
+    bool ok = blocks[2] && !extra;
+    if (!ok) {
+        fprintf(stderr, "testExhaustion(): Released block wasn't reused.\n");
+    }
+    if (extra) {
+        extra->release();
+    }
+
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+        if (blocks[i]) {
+            blocks[i]->release();
+        }
+    }
+
+    return ok;
+}
+
+
+//acquireWait() on an empty pool returns the block another thread releases
+bool WavBufferPoolTester::testAcquireWait() {
+
+    static const uint32_t NUM_WAITERS = 3;
+
+    WavBufferPool pool;
+    if (!pool.initialize(BLOCK_SIZE, 1)) {
+        fprintf(stderr, "testAcquireWait(): Problem initializing pool.\n");
+        return false;
+    }
+
+    WavBufferBlock *held = pool.acquire();
+    std::atomic<uint32_t> numAcquired(0);
+    std::vector<std::thread> waiters;
+    for (uint32_t i = 0; i < NUM_WAITERS; i++) {
+        waiters.push_back(std::thread([&pool, &numAcquired]() {
+            WavBufferBlock *block = pool.acquireWait();
+            if (block) {
+                numAcquired++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                block->release();
+            }
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool ok = numAcquired == 0;
+    if (!ok) {
+        fprintf(stderr, "testAcquireWait(): acquireWait() returned with every block in use.\n");
+    }
+
+    //Each waiter gets the one block in turn
+    held->release();
+    for (size_t i = 0; i < waiters.size(); i++) {
+        waiters[i].join();
+    }
+    if (ok && (numAcquired != NUM_WAITERS || pool.getNumFreeBlocks() != 1)) {
+        fprintf(stderr, "testAcquireWait(): %u of %u waiters got a block.\n", numAcquired.load(), NUM_WAITERS);
+        ok = false;
+    }
+
+    return ok;
+}
+
+
+bool WavBufferPoolTester::testReinitialize() {
+
+    WavBufferPool pool;
+    if (!pool.initialize(BLOCK_SIZE, NUM_BLOCKS)) {
+        fprintf(stderr, "testReinitialize(): Problem initializing pool.\n");
+        return false;
+    }
+
+    //Refused while a block is out, leaving that block and the pool as they were
+    WavBufferBlock *block = pool.acquire();
+    if (pool.initialize(BLOCK_SIZE * 2, 1) ||
+        pool.getBlockSize() != BLOCK_SIZE ||
+        pool.getNumBlocks() != NUM_BLOCKS ||
+        pool.getNumFreeBlocks() != NUM_BLOCKS - 1) {
+        fprintf(stderr, "testReinitialize(): Re-initialized with a block in use.\n");
+        block->release();
+        return false;
+    }
+    memset(block->getData(), 0, BLOCK_SIZE);
+    block->release();
+
+    if (!pool.initialize(BLOCK_SIZE * 2, 1) ||
+        pool.getBlockSize() != BLOCK_SIZE * 2 ||
+        pool.getNumBlocks() != 1 ||
+        pool.getNumFreeBlocks() != 1) {
+        fprintf(stderr, "testReinitialize(): Problem re-initializing with every block free.\n");
+        return false;
+    }
+    block = pool.acquire();
+    if (!block || block->getCapacity() != BLOCK_SIZE * 2) {
+        fprintf(stderr, "testReinitialize(): Re-initialized pool hands out old blocks.\n");
+        return false;
+    }
+    block->release();
+
+    return true;
+}
@@ -0,0 +1,40 @@
+//WavBufferPoolTester.hpp
+
+#ifndef __WAV_BUFFER_POOL_TESTER_HPP__
+#define __WAV_BUFFER_POOL_TESTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavBufferPool.hpp"
+
+
+class WavBufferPoolTester {
+
+public:
+
+    WavBufferPoolTester();
+
+    ~ WavBufferPoolTester();
+
+    bool runWavBufferPoolTest();
+
+private:
+
+    bool testLayout(bool useHugePages);
+
+    bool testReferenceCounting();
+
+    bool testExhaustion();
+
+    bool testAcquireWait();
+
+    bool testReinitialize();
+
+    //Constants
+    static const uint32_t BLOCK_SIZE = 10000; //Not a multiple of the page size
+    static const uint32_t NUM_BLOCKS = 4;
+    static const uint32_t PAGE_SIZE = 4096;
+};
+
+
+#endif //__WAV_BUFFER_POOL_TESTER_HPP__
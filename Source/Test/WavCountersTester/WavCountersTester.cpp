@@ -0,0 +1,182 @@
+//WavCountersTester.cpp
+
+
+#include <cmath> // M_PI
+#include <cstdio>
+
+#include "WavCountersTester.hpp"
+#include "WavReader.hpp"
+#include "WavWriter.hpp"
+
+
+WavCountersTester::WavCountersTester() {
+    _pOutDirPath = nullptr;
+}
+
+
+WavCountersTester::~WavCountersTester() {
+}
+
+
+bool WavCountersTester::initialize(const char *outDirPath) {
+
+    //Error-check outDirPath
+    if (!outDirPath) {
+        fprintf(stderr, "Error: Output directory path is NULL.\n");
+        return false;
+    }
+    char tempOutFilePath[MAX_PATH_LENGTH];
+    snprintf(tempOutFilePath, sizeof(tempOutFilePath), "%s/WavCountersTesterTempFile.txt", outDirPath);
+    FILE *fp = fopen(tempOutFilePath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Invalid output directory path.\n");
+        return false;
+    }
+    fclose(fp);
+    if (remove(tempOutFilePath) != 0) {
+        fprintf(stderr, "Error: Unable to remove test file created to validate output directory path.\n");
+        return false;
+    }
+
+    _pOutDirPath = outDirPath;
+
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+        _int16Samples[i] = (int16_t) (32767.0 * sin((2 * M_PI * i) / 100.0));
+    }
+
+    return true;
+}
+
+
+bool WavCountersTester::runWavCountersTest() {
+
+    if (!_pOutDirPath) {
+        fprintf(stderr, "Attempt to call WavCountersTester class method before calling initialize().\n");
+        return false;
+    }
+
+    printf("Running WavCountersTest.\n");
+
+    printf("    Testing reader, writer and global counts...\n");
+    if (!testInstanceCounts()) {
+        fprintf(stderr, "runWavCountersTest(): Error testing reader, writer and global counts.\n");
+        return false;
+    }
+
+    printf("    Testing failed opens...\n");
+    if (!testFailedOpens()) {
+        fprintf(stderr, "runWavCountersTest(): Error testing failed opens.\n");
+        return false;
+    }
+
+    printf("    Testing reset...\n");
+    if (!testReset()) {
+        fprintf(stderr, "runWavCountersTest(): Error testing reset.\n");
+        return false;
+    }
+
+    printf("Done WavCountersTest.\n\n");
+
+    return true;
+}
+
+
+//Per reader and writer, and process-wide across instances since destroyed
+bool WavCountersTester::testInstanceCounts() {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath, "%s/counters.wav", _pOutDirPath);
+
+    WavCounterSnapshot before;
+    WavCounterSnapshot writerCounts;
+    WavCounterSnapshot readerCounts;
+    WavCounterSnapshot after;
+    WavCounters::global()->snapshot(&before);
+    {
+        WavWriter wavWriter;
+        WavReader wavReader;
+        int16_t int16Samples[NUM_SAMPLES];
+        if (!wavWriter.initialize(outFilePath, SAMPLE_RATE, 1, true, 2) ||
+            !wavWriter.startWriting() ||
+            !wavWriter.writeDataFromInt16s(_int16Samples, NUM_SAMPLES) ||
+            !wavWriter.finishWriting() ||
+            !wavReader.initialize(outFilePath) ||
+            !wavReader.prepareToRead() ||
+            !wavReader.readDataToInt16s(int16Samples, NUM_SAMPLES) ||
+            !wavReader.finishReading() ||
+            !wavWriter.getCounters(&writerCounts) ||
+            !wavReader.getCounters(&readerCounts)) {
+            fprintf(stderr, "testInstanceCounts(): Problem writing and reading file.\n");
+            return false;
+        }
+    }
+    WavCounters::global()->snapshot(&after); //Both instances are gone, but their counts remain
+
+    if (writerCounts.bytesWritten < NUM_SAMPLES * 2 ||
+        writerCounts.framesConverted != NUM_SAMPLES ||
+        readerCounts.numOpens == 0 ||
+        readerCounts.bytesRead < NUM_SAMPLES * 2 ||
+        after.bytesWritten - before.bytesWritten != writerCounts.bytesWritten ||
+        after.bytesRead - before.bytesRead != readerCounts.bytesRead + writerCounts.bytesRead ||
+        after.numOpens - before.numOpens != readerCounts.numOpens + writerCounts.numOpens) {
+        fprintf(stderr, "testInstanceCounts(): Unexpected I/O counts.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//Only opens that succeed are counted: none for a missing file, one for a file that isn't a wav
+bool WavCountersTester::testFailedOpens() {
+
+    char notWavFilePath[MAX_PATH_LENGTH];
+    char missingFilePath[MAX_PATH_LENGTH];
+    sprintf(notWavFilePath, "%s/counters-notwav.wav", _pOutDirPath);
+    sprintf(missingFilePath, "%s/counters-missing.wav", _pOutDirPath);
+    remove(missingFilePath);
+    FILE *f = fopen(notWavFilePath, "wb");
+    if (!f || fputs("Not a wav file", f) < 0 || fclose(f) != 0) {
+        fprintf(stderr, "testFailedOpens(): Problem writing file.\n");
+        return false;
+    }
+    WavCounterSnapshot before;
+    WavCounterSnapshot after;
+    WavCounters::global()->snapshot(&before);
+    {
+        WavReader wavReader;
+        if (wavReader.initialize(missingFilePath) ||
+            wavReader.initialize(notWavFilePath)) {
+            fprintf(stderr, "testFailedOpens(): Reader initialized on a file that isn't a wav.\n");
+            return false;
+        }
+    }
+    WavCounters::global()->snapshot(&after);
+    if (after.numOpens - before.numOpens != 1) {
+        fprintf(stderr, "testFailedOpens(): Unexpected open count after failed initialize().\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//Global reset starts the totals over; resetting an instance doesn't take its counts back out
+bool WavCountersTester::testReset() {
+
+    WavCounterSnapshot counts;
+    WavCounterSnapshot after;
+    WavCounters counters;
+    counters.addSeek();
+    WavCounters::global()->reset();
+    counters.addSeek();
+    counters.reset();
+    counters.snapshot(&counts);
+    WavCounters::global()->snapshot(&after);
+    if (counts.numSeeks != 0 || after.numSeeks != 1) {
+        fprintf(stderr, "testReset(): Unexpected counts after reset.\n");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,42 @@
+//WavCountersTester.hpp
+
+#ifndef __WAV_COUNTERS_TESTER_HPP__
+#define __WAV_COUNTERS_TESTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavCounters.hpp"
+
+
+class WavCountersTester {
+
+public:
+
+    WavCountersTester();
+
+    ~ WavCountersTester();
+
+    bool initialize(const char *outDirPath);
+
+    bool runWavCountersTest();
+
+private:
+
+    bool testInstanceCounts();
+
+    bool testFailedOpens();
+
+    bool testReset();
+
+    //Constants
+    static const uint32_t MAX_PATH_LENGTH = 2048;
+    static const uint32_t NUM_SAMPLES = 2048;
+    static const uint32_t SAMPLE_RATE = 44100;
+
+    int16_t _int16Samples[NUM_SAMPLES];
+
+    const char *_pOutDirPath;
+};
+
+
+#endif //__WAV_COUNTERS_TESTER_HPP__
@@ -0,0 +1,270 @@
+//WavOverviewTester.cpp
+
+
+#include <cmath> // M_PI
+#include <cstdio>
+#include <cstring> //memcmp()
+#include <vector>
+
+#include "WavOverviewTester.hpp"
+#include "WavWriter.hpp"
+
+
+static const uint32_t FRAMES_PER_BIN[] = {16, 256};
+
+
+WavOverviewTester::WavOverviewTester() {
+    _pOutDirPath = nullptr;
+}
+
+
+WavOverviewTester::~WavOverviewTester() {
+}
+
+
+bool WavOverviewTester::initialize(const char *outDirPath) {
+
+    //Error-check outDirPath
+    if (!outDirPath) {
+        fprintf(stderr, "Error: Output directory path is NULL.\n");
+        return false;
+    }
+    char tempOutFilePath[MAX_PATH_LENGTH];
+    snprintf(tempOutFilePath, sizeof(tempOutFilePath), "%s/WavOverviewTesterTempFile.txt", outDirPath);
+    FILE *fp = fopen(tempOutFilePath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Invalid output directory path.\n");
+        return false;
+    }
+    fclose(fp);
+    if (remove(tempOutFilePath) != 0) {
+        fprintf(stderr, "Error: Unable to remove test file created to validate output directory path.\n");
+        return false;
+    }
+
+    _pOutDirPath = outDirPath;
+
+    //Full-scale 100-frame sine, the same in both channels
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+        float sample = (float) sin((2 * M_PI * i) / 100.0);
+        _floatSamples1Ch[i] = sample;
+        _floatSamples2Ch[i * 2] = sample;
+        _floatSamples2Ch[i * 2 + 1] = sample;
+    }
+
+    return true;
+}
+
+
+bool WavOverviewTester::runWavOverviewTest() {
+
+    if (!_pOutDirPath) {
+        fprintf(stderr, "Attempt to call WavOverviewTester class method before calling initialize().\n");
+        return false;
+    }
+
+    printf("Running WavOverviewTest.\n");
+
+    printf("    Testing building and querying...\n");
+    for (uint32_t numChannels = 1; numChannels <= MAX_NUM_CHANNELS; numChannels++) {
+        if (!testBuild(numChannels)) {
+            fprintf(stderr, "runWavOverviewTest(): Error testing building and querying.\n");
+            return false;
+        }
+    }
+
+    printf("    Testing sidecar files...\n");
+    for (uint32_t numChannels = 1; numChannels <= MAX_NUM_CHANNELS; numChannels++) {
+        if (!testSidecar(numChannels)) {
+            fprintf(stderr, "runWavOverviewTest(): Error testing sidecar files.\n");
+            return false;
+        }
+    }
+    if (!testInvalidSidecar()) {
+        fprintf(stderr, "runWavOverviewTest(): Error testing invalid sidecar files.\n");
+        return false;
+    }
+
+    printf("Done WavOverviewTest.\n\n");
+
+    return true;
+}
+
+
+bool WavOverviewTester::testBuild(uint32_t numChannels) {
+
+    WavOverview overview;
+    if (!buildOverview(numChannels, &overview)) {
+        return false;
+    }
+
+    if (overview.getNumChannels() != numChannels ||
+        overview.getSampleRate() != SAMPLE_RATE ||
+        overview.getNumFrames() != NUM_SAMPLES ||
+        overview.getNumLevels() != NUM_LEVELS ||
+        overview.getNumBins(0) != NUM_SAMPLES / FRAMES_PER_BIN[0] ||
+        overview.getNumBins(1) != NUM_SAMPLES / FRAMES_PER_BIN[1]) {
+        fprintf(stderr, "testBuild(): Unexpected overview layout.\n");
+        return false;
+    }
+
+    //Each pixel spans 256 frames, over two and a half cycles of the 100-frame sine
+    WavOverviewPoint points[NUM_PIXELS * MAX_NUM_CHANNELS];
+    if (!overview.query(0, NUM_SAMPLES, NUM_PIXELS, points)) {
+        fprintf(stderr, "testBuild(): Problem querying overview.\n");
+        return false;
+    }
+    for (uint32_t i = 0; i < NUM_PIXELS * numChannels; i++) {
+        if (fabs(points[i].min + 1.0) > 0.01 ||
+            fabs(points[i].max - 1.0) > 0.01 ||
+            fabs(points[i].rms - M_SQRT1_2) > 0.05) {
+            fprintf(stderr, "testBuild(): Unexpected overview of a full-scale sine.\n");
+            return false;
+        }
+    }
+
+    //Zoomed in to one 16-frame bin per pixel: the first quarter cycle only rises
+    WavOverviewPoint zoomedPoints[NUM_PIXELS * MAX_NUM_CHANNELS];
+    if (!overview.query(0, NUM_PIXELS * FRAMES_PER_BIN[0], NUM_PIXELS, zoomedPoints) ||
+        zoomedPoints[0].min != 0.0f ||
+        zoomedPoints[0].max >= zoomedPoints[numChannels].max) {
+        fprintf(stderr, "testBuild(): Unexpected zoomed-in overview.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//A sidecar read back answers every query exactly as the overview it was written from, and is
+//packed little-endian: file header, level headers, then 6 bytes per bin per channel
+bool WavOverviewTester::testSidecar(uint32_t numChannels) {
+
+    char overviewFilePath[MAX_PATH_LENGTH];
+    snprintf(overviewFilePath, sizeof(overviewFilePath), "%s/overview-%uch.wovw", _pOutDirPath, numChannels);
+
+    WavOverview overview;
+    WavOverview readOverview;
+    if (!buildOverview(numChannels, &overview) ||
+        !overview.writeToFile(overviewFilePath) ||
+        !readOverview.readFromFile(overviewFilePath) ||
+        readOverview.getNumChannels() != numChannels ||
+        readOverview.getSampleRate() != SAMPLE_RATE ||
+        readOverview.getNumFrames() != NUM_SAMPLES ||
+        readOverview.getNumLevels() != NUM_LEVELS ||
+        readOverview.getFramesPerBin(1) != FRAMES_PER_BIN[1]) {
+        fprintf(stderr, "testSidecar(): Problem round-tripping overview sidecar.\n");
+        return false;
+    }
+
+    WavOverviewPoint points[NUM_PIXELS * MAX_NUM_CHANNELS];
+    WavOverviewPoint readPoints[NUM_PIXELS * MAX_NUM_CHANNELS];
+    for (uint32_t level = 0; level < NUM_LEVELS; level++) {
+        const uint32_t numFrames = NUM_PIXELS * FRAMES_PER_BIN[level];
+        if (!overview.query(0, numFrames, NUM_PIXELS, points) ||
+            !readOverview.query(0, numFrames, NUM_PIXELS, readPoints) ||
+            memcmp(readPoints, points, NUM_PIXELS * numChannels * sizeof(WavOverviewPoint))) {
+            fprintf(stderr, "testSidecar(): Overview sidecar doesn't match the overview written.\n");
+            return false;
+        }
+    }
+
+    FILE *f = fopen(overviewFilePath, "rb");
+    uint8_t fileHeader[WAV_OVERVIEW_FILE_HEADER_SIZE];
+    long fileSize = -1;
+    if (f) {
+        if (fread(fileHeader, WAV_OVERVIEW_FILE_HEADER_SIZE, 1, f) == 1 && fseek(f, 0, SEEK_END) == 0) {
+            fileSize = ftell(f);
+        }
+        fclose(f);
+    }
+    const uint32_t numBins = NUM_SAMPLES / FRAMES_PER_BIN[0] + NUM_SAMPLES / FRAMES_PER_BIN[1];
+    if (fileSize != (long) (WAV_OVERVIEW_FILE_HEADER_SIZE + NUM_LEVELS * WAV_OVERVIEW_LEVEL_HEADER_SIZE +
+                            numBins * numChannels * WAV_OVERVIEW_BIN_SIZE) ||
+        memcmp(fileHeader, "WOVW", 4) ||
+        fileHeader[8] != numChannels || fileHeader[9] != 0 ||
+        fileHeader[12] != (SAMPLE_RATE & 0xFF) || fileHeader[13] != (SAMPLE_RATE >> 8)) {
+        fprintf(stderr, "testSidecar(): Overview sidecar isn't packed little-endian.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//A good sidecar cut short, or with the wrong magic, is refused
+bool WavOverviewTester::testInvalidSidecar() {
+
+    char overviewFilePath[MAX_PATH_LENGTH];
+    char truncatedFilePath[MAX_PATH_LENGTH];
+    char badMagicFilePath[MAX_PATH_LENGTH];
+    snprintf(overviewFilePath, sizeof(overviewFilePath), "%s/overview-2ch.wovw", _pOutDirPath);
+    snprintf(truncatedFilePath, sizeof(truncatedFilePath), "%s/overview-truncated.wovw", _pOutDirPath);
+    snprintf(badMagicFilePath, sizeof(badMagicFilePath), "%s/overview-bad-magic.wovw", _pOutDirPath);
+
+    std::vector<uint8_t> bytes;
+    FILE *f = fopen(overviewFilePath, "rb");
+    if (f) {
+        if (fseek(f, 0, SEEK_END) == 0 && ftell(f) > 0) {
+            bytes.resize((size_t) ftell(f));
+            if (fseek(f, 0, SEEK_SET) != 0 || fread(bytes.data(), 1, bytes.size(), f) != bytes.size()) {
+                bytes.clear();
+            }
+        }
+        fclose(f);
+    }
+    bool ok = bytes.size() > WAV_OVERVIEW_FILE_HEADER_SIZE;
+
+    f = fopen(truncatedFilePath, "wb");
+    ok = ok && f && fwrite(bytes.data(), 1, bytes.size() / 2, f) == bytes.size() / 2;
+    if (f) {
+        fclose(f);
+    }
+    f = fopen(badMagicFilePath, "wb");
+    if (ok) {
+        bytes[3] = 'X';
+    }
+    ok = ok && f && fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    if (f) {
+        fclose(f);
+    }
+    if (!ok) {
+        fprintf(stderr, "testInvalidSidecar(): Problem writing files.\n");
+        return false;
+    }
+
+    WavOverview overview;
+    if (overview.readFromFile(truncatedFilePath) ||
+        overview.readFromFile(badMagicFilePath)) {
+        fprintf(stderr, "testInvalidSidecar(): Invalid sidecar was read.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavOverviewTester::buildOverview(uint32_t numChannels,
+                                      WavOverview *overview) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    snprintf(outFilePath, sizeof(outFilePath), "%s/overview-%uch.wav", _pOutDirPath, numChannels);
+
+    WavWriter wavWriter;
+    if (!wavWriter.initialize(outFilePath, SAMPLE_RATE, numChannels, false, 4) ||
+        !wavWriter.startWriting() ||
+        !wavWriter.writeDataFromFloats((numChannels == 1) ? _floatSamples1Ch : _floatSamples2Ch, NUM_SAMPLES) ||
+        !wavWriter.finishWriting()) {
+        fprintf(stderr, "buildOverview(): Problem writing file.\n");
+        return false;
+    }
+
+    WavReader wavReader;
+    if (!wavReader.initialize(outFilePath) ||
+        !overview->build(&wavReader, FRAMES_PER_BIN, NUM_LEVELS)) {
+        fprintf(stderr, "buildOverview(): Problem building overview.\n");
+        return false;
+    }
+
+    return true;
+}
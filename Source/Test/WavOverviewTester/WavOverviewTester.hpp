@@ -0,0 +1,50 @@
+//WavOverviewTester.hpp
+
+#ifndef __WAV_OVERVIEW_TESTER_HPP__
+#define __WAV_OVERVIEW_TESTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavOverview.hpp"
+
+
+class WavOverviewTester {
+
+public:
+
+    WavOverviewTester();
+
+    ~ WavOverviewTester();
+
+    bool initialize(const char *outDirPath);
+
+    bool runWavOverviewTest();
+
+private:
+
+    bool testBuild(uint32_t numChannels);
+
+    bool testSidecar(uint32_t numChannels);
+
+    bool testInvalidSidecar();
+
+    //Write a float32 file of the test sine and build an overview of it with FRAMES_PER_BIN levels
+    bool buildOverview(uint32_t numChannels,
+                       WavOverview *overview);
+
+    //Constants
+    static const uint32_t MAX_PATH_LENGTH = 2048;
+    static const uint32_t NUM_SAMPLES = 2048;
+    static const uint32_t SAMPLE_RATE = 44100;
+    static const uint32_t MAX_NUM_CHANNELS = 2;
+    static const uint32_t NUM_LEVELS = 2;
+    static const uint32_t NUM_PIXELS = 8;
+
+    float _floatSamples1Ch[NUM_SAMPLES * 1];
+    float _floatSamples2Ch[NUM_SAMPLES * 2];
+
+    const char *_pOutDirPath;
+};
+
+
+#endif //__WAV_OVERVIEW_TESTER_HPP__
@@ -0,0 +1,543 @@
+//WavReaderCacheTester.cpp
+
+
+#include <atomic>
+#include <cstdio>
+#include <sys/stat.h>
+#include <thread>
+#include <utime.h>
+#include <vector>
+
+#include "WavReaderCacheTester.hpp"
+#include "WavWriter.hpp"
+
+
+WavReaderCacheTester::WavReaderCacheTester() {
+    _pOutDirPath = nullptr;
+}
+
+
+WavReaderCacheTester::~WavReaderCacheTester() {
+}
+
+
+bool WavReaderCacheTester::initialize(const char *outDirPath) {
+
+    //Error-check outDirPath
+    if (!outDirPath) {
+        fprintf(stderr, "Error: Output directory path is NULL.\n");
+        return false;
+    }
+    char tempOutFilePath[MAX_PATH_LENGTH];
+    snprintf(tempOutFilePath, sizeof(tempOutFilePath), "%s/WavReaderCacheTesterTempFile.txt", outDirPath);
+    FILE *fp = fopen(tempOutFilePath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Invalid output directory path.\n");
+        return false;
+    }
+    fclose(fp);
+    if (remove(tempOutFilePath) != 0) {
+        fprintf(stderr, "Error: Unable to remove test file created to validate output directory path.\n");
+        return false;
+    }
+
+    _pOutDirPath = outDirPath;
+
+    return true;
+}
+
+
+bool WavReaderCacheTester::runWavReaderCacheTest() {
+
+    if (!_pOutDirPath) {
+        fprintf(stderr, "Attempt to call WavReaderCacheTester class method before calling initialize().\n");
+        return false;
+    }
+
+    printf("Running WavReaderCacheTest.\n");
+
+    printf("    Testing hits...\n");
+    if (!testHits()) {
+        fprintf(stderr, "runWavReaderCacheTest(): Error testing hits.\n");
+        return false;
+    }
+
+    printf("    Testing invalidation...\n");
+    if (!testInvalidation()) {
+        fprintf(stderr, "runWavReaderCacheTest(): Error testing invalidation.\n");
+        return false;
+    }
+
+    printf("    Testing eviction...\n");
+    if (!testEviction()) {
+        fprintf(stderr, "runWavReaderCacheTest(): Error testing eviction.\n");
+        return false;
+    }
+
+    printf("    Testing every slot in use...\n");
+    if (!testSlotsInUse()) {
+        fprintf(stderr, "runWavReaderCacheTest(): Error testing every slot in use.\n");
+        return false;
+    }
+
+    printf("    Testing foreign release...\n");
+    if (!testForeignRelease()) {
+        fprintf(stderr, "runWavReaderCacheTest(): Error testing foreign release.\n");
+        return false;
+    }
+
+    printf("    Testing concurrent use...\n");
+    if (!testConcurrentUse()) {
+        fprintf(stderr, "runWavReaderCacheTest(): Error testing concurrent use.\n");
+        return false;
+    }
+
+    printf("Done WavReaderCacheTest.\n\n");
+
+    return true;
+}
+
+
+//An unchanged file comes back as the same reader, still readable
+bool WavReaderCacheTester::testHits() {
+
+    char filePath[MAX_PATH_LENGTH];
+    snprintf(filePath, sizeof(filePath), "%s/cache-hits.wav", _pOutDirPath);
+    if (!writeFile(filePath, NUM_FRAMES, 0)) {
+        return false;
+    }
+
+    WavReaderCache cache;
+    if (cache.initialize(0) || cache.acquire(filePath)) {
+        fprintf(stderr, "testHits(): Empty or uninitialized cache handed out a reader.\n");
+        return false;
+    }
+    if (!cache.initialize(2)) {
+        fprintf(stderr, "testHits(): Problem initializing cache.\n");
+        return false;
+    }
+
+    char missingFilePath[MAX_PATH_LENGTH];
+    snprintf(missingFilePath, sizeof(missingFilePath), "%s/cache-missing.wav", _pOutDirPath);
+    remove(missingFilePath);
+    if (cache.acquire(missingFilePath) || !statsMatch(&cache, 0, 0, 0, 0, 0, 0)) {
+        fprintf(stderr, "testHits(): Missing file was acquired or counted.\n");
+        return false;
+    }
+
+    WavReader *first = cache.acquire(filePath);
+    if (!first || !statsMatch(&cache, 0, 1, 0, 0, 1, 1) || !readsBack(first, NUM_FRAMES, 0)) {
+        fprintf(stderr, "testHits(): Problem with first acquire.\n");
+        return false;
+    }
+    cache.release(first);
+
+    for (uint32_t i = 1; i <= 3; i++) {
+        WavReader *again = cache.acquire(filePath);
+        if (again != first || !statsMatch(&cache, i, 1, 0, 0, 1, 1) || !readsBack(again, NUM_FRAMES, 0)) {
+            fprintf(stderr, "testHits(): Unchanged file wasn't a hit.\n");
+            return false;
+        }
+        cache.release(again);
+    }
+
+    //clear() closes idle readers, so the next acquire is a miss
+    cache.clear();
+    WavReader *afterClear = cache.acquire(filePath);
+    if (!afterClear || !statsMatch(&cache, 3, 2, 0, 0, 1, 1)) {
+        fprintf(stderr, "testHits(): clear() left a reader open.\n");
+        return false;
+    }
+    cache.release(afterClear);
+
+    return true;
+}
+
+
+//A change of size, or of mtime alone, drops the cached reader for a fresh one
+bool WavReaderCacheTester::testInvalidation() {
+
+    char filePath[MAX_PATH_LENGTH];
+    snprintf(filePath, sizeof(filePath), "%s/cache-invalidation.wav", _pOutDirPath);
+    if (!writeFile(filePath, NUM_FRAMES, 0)) {
+        return false;
+    }
+
+    WavReaderCache cache;
+    if (!cache.initialize(2)) {
+        fprintf(stderr, "testInvalidation(): Problem initializing cache.\n");
+        return false;
+    }
+    WavReader *wavReader = cache.acquire(filePath);
+    if (!wavReader) {
+        return false;
+    }
+    cache.release(wavReader);
+
+    //Size
+    if (!writeFile(filePath, NUM_FRAMES / 2, 100)) {
+        return false;
+    }
+    wavReader = cache.acquire(filePath);
+    if (!wavReader || !statsMatch(&cache, 0, 2, 1, 0, 1, 1) || !readsBack(wavReader, NUM_FRAMES / 2, 100)) {
+        fprintf(stderr, "testInvalidation(): Resized file wasn't reopened.\n");
+        return false;
+    }
+    cache.release(wavReader);
+
+    //mtime; the size is the same
+    struct stat st;
+    struct utimbuf times;
+    if (stat(filePath, &st) != 0) {
+        fprintf(stderr, "testInvalidation(): Problem getting file times.\n");
+        return false;
+    }
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime + 10;
+    if (utime(filePath, &times) != 0) {
+        fprintf(stderr, "testInvalidation(): Problem setting file times.\n");
+        return false;
+    }
+    wavReader = cache.acquire(filePath);
+    if (!wavReader || !statsMatch(&cache, 0, 3, 2, 0, 1, 1) || !readsBack(wavReader, NUM_FRAMES / 2, 100)) {
+        fprintf(stderr, "testInvalidation(): Touched file wasn't reopened.\n");
+        return false;
+    }
+    cache.release(wavReader);
+
+    //And then unchanged again
+    wavReader = cache.acquire(filePath);
+    if (!wavReader || !statsMatch(&cache, 1, 3, 2, 0, 1, 1)) {
+        fprintf(stderr, "testInvalidation(): Reopened reader wasn't cached.\n");
+        return false;
+    }
+    cache.release(wavReader);
+
+    return true;
+}
+
+
+//At maxNumOpenReaders, the least recently released idle reader makes room
+bool WavReaderCacheTester::testEviction() {
+
+    char filePaths[3][MAX_PATH_LENGTH];
+    for (uint32_t i = 0; i < 3; i++) {
+        snprintf(filePaths[i], sizeof(filePaths[i]), "%s/cache-eviction-%u.wav", _pOutDirPath, i);
+        if (!writeFile(filePaths[i], NUM_FRAMES, (int16_t) (i * 1000))) {
+            return false;
+        }
+    }
+
+    WavReaderCache cache;
+    if (!cache.initialize(2)) {
+        fprintf(stderr, "testEviction(): Problem initializing cache.\n");
+        return false;
+    }
+
+    //Released in the order 0, 1, then 0 again; 1 is now the least recently released
+    WavReader *reader0 = cache.acquire(filePaths[0]);
+    if (!reader0) {
+        return false;
+    }
+    cache.release(reader0);
+    WavReader *reader1 = cache.acquire(filePaths[1]);
+    if (!reader1) {
+        return false;
+    }
+    cache.release(reader1);
+    if (cache.acquire(filePaths[0]) != reader0) {
+        fprintf(stderr, "testEviction(): Idle reader wasn't a hit.\n");
+        return false;
+    }
+    cache.release(reader0);
+    if (!statsMatch(&cache, 1, 2, 0, 0, 2, 0)) {
+        return false;
+    }
+
+    WavReader *reader2 = cache.acquire(filePaths[2]);
+    if (!reader2 || !statsMatch(&cache, 1, 3, 0, 1, 2, 1) || !readsBack(reader2, NUM_FRAMES, 2000)) {
+        fprintf(stderr, "testEviction(): Full cache didn't make room.\n");
+        return false;
+    }
+    cache.release(reader2);
+
+    if (cache.acquire(filePaths[0]) != reader0 || !statsMatch(&cache, 2, 3, 0, 1, 2, 1)) {
+        fprintf(stderr, "testEviction(): Wrong reader was evicted.\n");
+        return false;
+    }
+    if (!readsBack(reader0, NUM_FRAMES, 0)) {
+        return false;
+    }
+    cache.release(reader0);
+
+    //Reader 2 is now the least recently released, so it goes to make room for 1
+    reader1 = cache.acquire(filePaths[1]);
+    if (!reader1 || !statsMatch(&cache, 2, 4, 0, 2, 2, 1) || !readsBack(reader1, NUM_FRAMES, 1000)) {
+        fprintf(stderr, "testEviction(): Evicted file wasn't reopened.\n");
+        return false;
+    }
+    cache.release(reader1);
+    if (cache.acquire(filePaths[0]) != reader0) {
+        fprintf(stderr, "testEviction(): Most recently used reader was evicted.\n");
+        return false;
+    }
+    cache.release(reader0);
+
+    return true;
+}
+
+
+//With every slot holding a reader in use, acquire() fails until one is released
+bool WavReaderCacheTester::testSlotsInUse() {
+
+    char filePaths[3][MAX_PATH_LENGTH];
+    for (uint32_t i = 0; i < 3; i++) {
+        snprintf(filePaths[i], sizeof(filePaths[i]), "%s/cache-slots-%u.wav", _pOutDirPath, i);
+        if (!writeFile(filePaths[i], NUM_FRAMES, (int16_t) (i * 1000))) {
+            return false;
+        }
+    }
+
+    WavReaderCache cache;
+    if (!cache.initialize(2)) {
+        fprintf(stderr, "testSlotsInUse(): Problem initializing cache.\n");
+        return false;
+    }
+
+    WavReader *reader0 = cache.acquire(filePaths[0]);
+    WavReader *reader1 = cache.acquire(filePaths[1]);
+    if (!reader0 || !reader1 || reader0 == reader1) {
+        fprintf(stderr, "testSlotsInUse(): Problem acquiring readers.\n");
+        return false;
+    }
+
+    //A busy path gets a second reader, which has no room either
+    WavReader *extra2 = cache.acquire(filePaths[2]);
+    WavReader *extra0 = cache.acquire(filePaths[0]);
+    bool ok = !extra2 && !extra0 && statsMatch(&cache, 0, 4, 0, 0, 2, 2);
+    if (!ok) {
+        fprintf(stderr, "testSlotsInUse(): Acquired a reader with every slot in use.\n");
+    }
+
+    //The held readers are unaffected
+    ok = ok && readsBack(reader0, NUM_FRAMES, 0) && readsBack(reader1, NUM_FRAMES, 1000);
+
+    cache.release(reader1);
+    WavReader *reader2 = ok ? cache.acquire(filePaths[2]) : nullptr;
+    if (ok && (!reader2 || !statsMatch(&cache, 0, 5, 0, 1, 2, 2) || !readsBack(reader2, NUM_FRAMES, 2000))) {
+        fprintf(stderr, "testSlotsInUse(): Released slot wasn't reused.\n");
+        ok = false;
+    }
+
+    cache.release(reader0);
+    if (reader2) {
+        cache.release(reader2);
+    }
+    if (ok && !statsMatch(&cache, 0, 5, 0, 1, 2, 0)) {
+        ok = false;
+    }
+
+    return ok;
+}
+
+
+//Readers from elsewhere, and readers released twice, are refused and change nothing
+bool WavReaderCacheTester::testForeignRelease() {
+
+    char filePath[MAX_PATH_LENGTH];
+    snprintf(filePath, sizeof(filePath), "%s/cache-foreign.wav", _pOutDirPath);
+    if (!writeFile(filePath, NUM_FRAMES, 0)) {
+        return false;
+    }
+
+    WavReaderCache cache;
+    WavReaderCache otherCache;
+    if (!cache.initialize(2) || !otherCache.initialize(2)) {
+        fprintf(stderr, "testForeignRelease(): Problem initializing caches.\n");
+        return false;
+    }
+
+    WavReader *wavReader = cache.acquire(filePath);
+    WavReader *otherReader = otherCache.acquire(filePath);
+    if (!wavReader || !otherReader) {
+        return false;
+    }
+
+    WavReader unownedReader;
+    cache.release(&unownedReader);
+    cache.release(otherReader);
+    cache.release(nullptr);
+    if (!statsMatch(&cache, 0, 1, 0, 0, 1, 1) || !statsMatch(&otherCache, 0, 1, 0, 0, 1, 1)) {
+        fprintf(stderr, "testForeignRelease(): Foreign reader was released.\n");
+        return false;
+    }
+
+    cache.release(wavReader);
+    cache.release(wavReader);
+    if (!statsMatch(&cache, 0, 1, 0, 0, 1, 0)) {
+        fprintf(stderr, "testForeignRelease(): Reader was released twice.\n");
+        return false;
+    }
+
+    //Still handed out once, not twice
+    WavReader *again = cache.acquire(filePath);
+    WavReader *second = cache.acquire(filePath);
+    bool ok = again == wavReader && second && second != wavReader && statsMatch(&cache, 1, 2, 0, 0, 2, 2);
+    if (!ok) {
+        fprintf(stderr, "testForeignRelease(): Reader released twice was handed out twice.\n");
+    }
+    if (again) {
+        cache.release(again);
+    }
+    if (second) {
+        cache.release(second);
+    }
+    otherCache.release(otherReader);
+
+    return ok;
+}
+
+
+//Threads sharing one cache each read back the file they asked for
+bool WavReaderCacheTester::testConcurrentUse() {
+
+    static const uint32_t NUM_THREADS = 4;
+    static const uint32_t NUM_FILES = 6;
+    static const uint32_t NUM_ACQUIRES_PER_THREAD = 200;
+
+    std::vector<std::vector<char>> filePaths(NUM_FILES, std::vector<char>(MAX_PATH_LENGTH));
+    for (uint32_t i = 0; i < NUM_FILES; i++) {
+        snprintf(filePaths[i].data(), filePaths[i].size(), "%s/cache-concurrent-%u.wav", _pOutDirPath, i);
+        if (!writeFile(filePaths[i].data(), NUM_FRAMES, (int16_t) (i * 1000))) {
+            return false;
+        }
+    }
+
+    //One slot per thread, so there's always an idle reader to evict and acquire() never fails
+    WavReaderCache cache;
+    if (!cache.initialize(NUM_THREADS)) {
+        fprintf(stderr, "testConcurrentUse(): Problem initializing cache.\n");
+        return false;
+    }
+
+    std::atomic<uint32_t> numFailed(0);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < NUM_THREADS; t++) {
+        threads.push_back(std::thread([this, &cache, &filePaths, &numFailed, t]() {
+            uint32_t state = t + 1;
+            for (uint32_t i = 0; i < NUM_ACQUIRES_PER_THREAD; i++) {
+                state = state * 1664525 + 1013904223;
+                uint32_t fileIndex = (state >> 16) % NUM_FILES;
+                WavReader *wavReader = cache.acquire(filePaths[fileIndex].data());
+                if (!wavReader) {
+                    numFailed++;
+                    continue;
+                }
+                if (!readsBack(wavReader, NUM_FRAMES, (int16_t) (fileIndex * 1000))) {
+                    numFailed++;
+                }
+                cache.release(wavReader);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    if (numFailed != 0) {
+        fprintf(stderr, "testConcurrentUse(): %u of %u acquires failed.\n",
+                numFailed.load(), NUM_THREADS * NUM_ACQUIRES_PER_THREAD);
+        return false;
+    }
+
+    WavReaderCacheStats stats;
+    if (!cache.getStats(&stats) ||
+        stats.numHits + stats.numMisses != NUM_THREADS * NUM_ACQUIRES_PER_THREAD ||
+        stats.numMisses < NUM_FILES ||
+        stats.numInvalidations != 0 ||
+        stats.numOpenReaders > NUM_THREADS ||
+        stats.numReadersInUse != 0) {
+        fprintf(stderr, "testConcurrentUse(): Statistics don't add up.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavReaderCacheTester::writeFile(const char *filePath,
+                                     uint32_t numFrames,
+                                     int16_t firstValue) {
+
+    std::vector<uint8_t> sampleData(numFrames * 2);
+    for (uint32_t i = 0; i < numFrames; i++) {
+        uint16_t value = (uint16_t) (firstValue + i);
+        sampleData[i * 2] = (uint8_t) (value & 0xFF);
+        sampleData[i * 2 + 1] = (uint8_t) (value >> 8);
+    }
+
+    WavWriter wavWriter;
+    if (!wavWriter.initialize(filePath, SAMPLE_RATE, 1, WAV_SAMPLE_FORMAT_INT16) ||
+        !wavWriter.startWriting() ||
+        !wavWriter.writeData(sampleData.data(), (uint32_t) sampleData.size()) ||
+        !wavWriter.finishWriting()) {
+        fprintf(stderr, "writeFile(): Problem writing %s.\n", filePath);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavReaderCacheTester::readsBack(WavReader *wavReader,
+                                     uint32_t numFrames,
+                                     int16_t firstValue) {
+
+    std::vector<int16_t> samples(numFrames);
+    if (wavReader->getNumSamples() != numFrames ||
+        !wavReader->prepareToRead() ||
+        !wavReader->readDataToInt16s(samples.data(), numFrames)) {
+        fprintf(stderr, "readsBack(): Problem reading cached reader.\n");
+        return false;
+    }
+    for (uint32_t i = 0; i < numFrames; i++) {
+        if (samples[i] != (int16_t) (firstValue + i)) {
+            fprintf(stderr, "readsBack(): Sample %u is %d, not %d.\n", i, samples[i], (int16_t) (firstValue + i));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool WavReaderCacheTester::statsMatch(WavReaderCache *cache,
+                                      uint64_t numHits,
+                                      uint64_t numMisses,
+                                      uint64_t numInvalidations,
+                                      uint64_t numEvictions,
+                                      uint32_t numOpenReaders,
+                                      uint32_t numReadersInUse) {
+
+    WavReaderCacheStats stats;
+    if (!cache->getStats(&stats)) {
+        return false;
+    }
+    if (stats.numHits != numHits ||
+        stats.numMisses != numMisses ||
+        stats.numInvalidations != numInvalidations ||
+        stats.numEvictions != numEvictions ||
+        stats.numOpenReaders != numOpenReaders ||
+        stats.numReadersInUse != numReadersInUse) {
+        fprintf(stderr, "statsMatch(): hits %llu misses %llu invalidations %llu evictions %llu open %u in use %u; "
+                        "expected %llu %llu %llu %llu %u %u.\n",
+                (unsigned long long) stats.numHits, (unsigned long long) stats.numMisses,
+                (unsigned long long) stats.numInvalidations, (unsigned long long) stats.numEvictions,
+                stats.numOpenReaders, stats.numReadersInUse,
+                (unsigned long long) numHits, (unsigned long long) numMisses,
+                (unsigned long long) numInvalidations, (unsigned long long) numEvictions,
+                numOpenReaders, numReadersInUse);
+        return false;
+    }
+
+    return true;
+}
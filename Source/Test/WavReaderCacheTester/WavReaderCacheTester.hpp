@@ -0,0 +1,64 @@
+//WavReaderCacheTester.hpp
+
+#ifndef __WAV_READER_CACHE_TESTER_HPP__
+#define __WAV_READER_CACHE_TESTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavReaderCache.hpp"
+
+
+class WavReaderCacheTester {
+
+public:
+
+    WavReaderCacheTester();
+
+    ~ WavReaderCacheTester();
+
+    bool initialize(const char *outDirPath);
+
+    bool runWavReaderCacheTest();
+
+private:
+
+    bool testHits();
+
+    bool testInvalidation();
+
+    bool testEviction();
+
+    bool testSlotsInUse();
+
+    bool testForeignRelease();
+
+    bool testConcurrentUse();
+
+    //Mono int16 file whose sample i is firstValue + i
+    bool writeFile(const char *filePath,
+                   uint32_t numFrames,
+                   int16_t firstValue);
+
+    //The reader, prepared, reads back what writeFile() wrote
+    bool readsBack(WavReader *wavReader,
+                   uint32_t numFrames,
+                   int16_t firstValue);
+
+    bool statsMatch(WavReaderCache *cache,
+                    uint64_t numHits,
+                    uint64_t numMisses,
+                    uint64_t numInvalidations,
+                    uint64_t numEvictions,
+                    uint32_t numOpenReaders,
+                    uint32_t numReadersInUse);
+
+    //Constants
+    static const uint32_t MAX_PATH_LENGTH = 2048;
+    static const uint32_t SAMPLE_RATE = 44100;
+    static const uint32_t NUM_FRAMES = 1000;
+
+    const char *_pOutDirPath;
+};
+
+
+#endif //__WAV_READER_CACHE_TESTER_HPP__
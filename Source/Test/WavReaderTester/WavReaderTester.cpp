@@ -1,18 +1,23 @@
 //WavReaderTester.cpp
 
 
+#include <algorithm> //std::min()
 #include <cmath>
+#include <cstring> //memcmp()
 
 #include "WavReaderTester.hpp"
 
 #include "WavHeader.hpp"
 #include "WavReader.hpp"
+#include "WavWriter.hpp"
 
 #include <stdlib.h> //malloc and free
+#include <vector>
 
 
 WavReaderTester::WavReaderTester() {
     _pInDirPath = nullptr;
+    _pOutDirPath = nullptr;
     _pSampleData = nullptr;
     _pInt16Samples = nullptr;
     _pWavReader = new WavReader();
@@ -35,30 +40,22 @@ WavReaderTester::~WavReaderTester() {
 }
 
 
-bool WavReaderTester::initialize(const char *inDirPath) {
+bool WavReaderTester::initialize(const char *inDirPath, const char *outDirPath) {
 
     //printf("Initializing WavReaderTester.\n\n");
 
     //Error-check inDirPath
-    if (!_pInDirPath) {
+    if (!inDirPath) {
         fprintf(stderr, "Error: Input directory path is NULL.\n");
         return false;
     }
-    char tempFilePath[MAX_PATH_LENGTH];
-    sprintf(tempFilePath, "%s/WavReaderTesterTempFile.txt", _pInDirPath);
-    FILE *fp = fopen(tempFilePath, "w");
-    if (!fp) {
-        fprintf(stderr, "Error: Unable to open temp file at path:\n%s.\n", tempFilePath);
+    if (!validatesDirectory(inDirPath) ||
+        (outDirPath && !validatesDirectory(outDirPath))) {
         return false;
     }
-    if (remove(tempFilePath) != 0) {
-        fprintf(stderr, "Error: Unable to remove test file created to validate directory path.\n");
-        fclose(fp);
-        return false;
-    }
-    fclose(fp);
 
     this->_pInDirPath = inDirPath;
+    this->_pOutDirPath = outDirPath;
 
     if (_pSampleData) {
         free(_pSampleData);
@@ -74,6 +71,27 @@ bool WavReaderTester::initialize(const char *inDirPath) {
 }
 
 
+//Check that a file can be created in dirPath
+bool WavReaderTester::validatesDirectory(const char *dirPath) {
+
+    char tempFilePath[MAX_PATH_LENGTH];
+    sprintf(tempFilePath, "%s/WavReaderTesterTempFile.txt", dirPath);
+    FILE *fp = fopen(tempFilePath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Unable to open temp file at path:\n%s.\n", tempFilePath);
+        return false;
+    }
+    if (remove(tempFilePath) != 0) {
+        fprintf(stderr, "Error: Unable to remove test file created to validate directory path.\n");
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    return true;
+}
+
+
 bool WavReaderTester::runWavReaderTest() {
 
     printf("Running WavReaderTest.\n");
@@ -99,6 +117,76 @@ bool WavReaderTester::runWavReaderTest() {
         }
     }
 
+    //Read files with signal statistics attached
+    printf("    Testing reading files with signal statistics...\n");
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        if (!testReadFileWithSignalStats(&inFileParamSets[i])) {
+            fprintf(stderr, "runWavReaderTest(): Error test-reading file with signal statistics.\n");
+            return false;
+        }
+    }
+
+    //Read files into buffer pool blocks
+    printf("    Testing reading files into pool blocks...\n");
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        if (!testReadFileIntoPoolBlock(&inFileParamSets[i])) {
+            fprintf(stderr, "runWavReaderTest(): Error test-reading file into a pool block.\n");
+            return false;
+        }
+    }
+
+    //Read files through blocks<T>(), with blocks that don't divide the file evenly, or span it all
+    printf("    Testing reading files in blocks...\n");
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        if (!testReadFileInBlocks(&inFileParamSets[i], 1000) ||
+            !testReadFileInBlocks(&inFileParamSets[i], 1) ||
+            !testReadFileInBlocks(&inFileParamSets[i], 1000000)) {
+            fprintf(stderr, "runWavReaderTest(): Error test-reading file in blocks.\n");
+            return false;
+        }
+    }
+
+    //Seek to frames in and on the edges of blocks; PCM reference files, then IMA ADPCM files
+    printf("    Testing seeking to frames...\n");
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        char inFilePath[MAX_PATH_LENGTH];
+        sprintf(inFilePath, "%s/%s", _pInDirPath, inFileParamSets[i].fileName);
+        if (!testSeekToFrames(inFilePath)) {
+            fprintf(stderr, "runWavReaderTest(): Error test-seeking in %s.\n", inFileParamSets[i].fileName);
+            return false;
+        }
+    }
+    if (_pOutDirPath) {
+        for (uint32_t numChannels = 1; numChannels < 3; numChannels++) {
+            if (!testSeekToImaAdpcmFrames(numChannels)) {
+                fprintf(stderr, "runWavReaderTest(): Error test-seeking in IMA ADPCM file.\n");
+                return false;
+            }
+        }
+    }
+
+    //Prefetch from the header, the start, the middle and the end of the sample data; PCM reference
+    //files, then the IMA ADPCM files written above
+    printf("    Testing prefetching...\n");
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        char inFilePath[MAX_PATH_LENGTH];
+        sprintf(inFilePath, "%s/%s", _pInDirPath, inFileParamSets[i].fileName);
+        if (!testPrefetch(inFilePath)) {
+            fprintf(stderr, "runWavReaderTest(): Error test-prefetching %s.\n", inFileParamSets[i].fileName);
+            return false;
+        }
+    }
+    if (_pOutDirPath) {
+        for (uint32_t numChannels = 1; numChannels < 3; numChannels++) {
+            char outFilePath[MAX_PATH_LENGTH];
+            sprintf(outFilePath, "%s/seekima-%dch.wav", _pOutDirPath, numChannels);
+            if (!testPrefetch(outFilePath)) {
+                fprintf(stderr, "runWavReaderTest(): Error test-prefetching IMA ADPCM file.\n");
+                return false;
+            }
+        }
+    }
+
     printf("Done WavReaderTest.\n\n");
 
     return true;
@@ -271,6 +359,296 @@ bool WavReaderTester::testReadFileToInt16s(const InFileParamSetDef *ifps) {
 }
 
 
+bool WavReaderTester::testReadFileWithSignalStats(const InFileParamSetDef *ifps) {
+
+    const char *fileName = ifps->fileName;
+
+    char inFilePath[MAX_PATH_LENGTH];
+    sprintf(inFilePath,
+            "%s/%s",
+            _pInDirPath,
+            fileName);
+
+    if (!_pWavReader->initialize(inFilePath)) {
+        fprintf(stderr, "testReadFileWithSignalStats(): Problem initializing WavReader.\n");
+        return false;
+    }
+
+    WavSignalStats signalStats;
+    if (!_pWavReader->setSignalStats(&signalStats)) {
+        fprintf(stderr, "testReadFileWithSignalStats(): Problem attaching signal statistics.\n");
+        return false;
+    }
+
+    if (!_pWavReader->prepareToRead()) {
+        fprintf(stderr, "testReadFileWithSignalStats(): Problem preparing to read.\n");
+        return false;
+    }
+
+    //Allocate int16 samples
+    const size_t numInt16SampleBytes = _pWavReader->getNumSamples() * _pWavReader->getNumChannels() * 2; //2 bytes in int16
+    if (_pInt16Samples) {
+        free(_pInt16Samples);
+        _pInt16Samples = nullptr;
+    }
+    _pInt16Samples = (int16_t *) malloc(numInt16SampleBytes);
+    if (!_pWavReader->readDataToInt16s(_pInt16Samples, _pWavReader->getNumSamples())) {
+        fprintf(stderr, "testReadFileWithSignalStats(): Problem reading data.\n");
+        return false;
+    }
+
+    _pWavReader->setSignalStats(nullptr);
+    if (!_pWavReader->finishReading()) {
+        fprintf(stderr, "testReadFileWithSignalStats(): Problem finishing reading.\n");
+        return false;
+    }
+
+    //Every reference file holds a full-scale sine: peak ~1.0, RMS ~1/sqrt(2), no DC
+    for (uint32_t ch = 0; ch < ifps->numChannels; ch++) {
+        WavChannelStats channelStats;
+        signalStats.getChannelStats(ch, channelStats);
+        if (channelStats.numValues != _pWavReader->getNumSamples() ||
+            channelStats.numNaNs != 0 ||
+            channelStats.numInfs != 0 ||
+            fabs(channelStats.peak - 1.0) > 0.01 ||
+            fabs(channelStats.rms - M_SQRT1_2) > 0.01 ||
+            fabs(channelStats.dcOffset) > 0.01) {
+            fprintf(stderr, "Error: Unexpected signal statistics for channel %d of %s.\n", ch + 1, fileName);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//The block gets the bytes readData() reads into an array, and its size; data that doesn't fit is refused
+bool WavReaderTester::testReadFileIntoPoolBlock(const InFileParamSetDef *ifps) {
+
+    char inFilePath[MAX_PATH_LENGTH];
+    sprintf(inFilePath,
+            "%s/%s",
+            _pInDirPath,
+            ifps->fileName);
+
+    if (!_pWavReader->initialize(inFilePath) ||
+        !_pWavReader->prepareToRead()) {
+        fprintf(stderr, "testReadFileIntoPoolBlock(): Problem initializing WavReader.\n");
+        return false;
+    }
+
+    //Allocate _pSampleData
+    const uint32_t sampleDataSize = _pWavReader->getSampleDataSize();
+    if (_pSampleData) {
+        free(_pSampleData);
+        _pSampleData = nullptr;
+    }
+    _pSampleData = (uint8_t *) malloc(sampleDataSize);
+
+    WavBufferPool pool;
+    if (!pool.initialize(sampleDataSize, 1)) {
+        fprintf(stderr, "testReadFileIntoPoolBlock(): Problem initializing buffer pool.\n");
+        return false;
+    }
+    WavBufferBlock *block = pool.acquire();
+    bool ok = _pWavReader->readData(_pSampleData, sampleDataSize) &&
+              _pWavReader->prepareToRead() &&
+              !_pWavReader->readData(block, sampleDataSize + 1) &&
+              _pWavReader->readData(block, sampleDataSize) &&
+              _pWavReader->finishReading();
+    if (!ok) {
+        fprintf(stderr, "testReadFileIntoPoolBlock(): Problem reading %s.\n", ifps->fileName);
+    } else if (block->getSize() != sampleDataSize || memcmp(block->getData(), _pSampleData, sampleDataSize) != 0) {
+        fprintf(stderr, "testReadFileIntoPoolBlock(): Block read from %s doesn't match.\n", ifps->fileName);
+        ok = false;
+    }
+    block->release();
+
+    return ok;
+}
+
+
+//Reads after seekToFrame() must match a sequential decode: within blocks, on both sides of block
+//boundaries, in the last (short) block and at the end, visited back to front
+bool WavReaderTester::testSeekToFrames(const char *filePath) {
+
+    if (!_pWavReader->initialize(filePath) ||
+        !_pWavReader->prepareToRead()) {
+        fprintf(stderr, "testSeekToFrames(): Problem initializing WavReader.\n");
+        return false;
+    }
+    const uint32_t numFrames = _pWavReader->getNumSamples();
+    const uint32_t numChannels = _pWavReader->getNumChannels();
+    const uint32_t framesPerBlock = _pWavReader->getFramesPerBlock();
+
+    //Allocate int16 samples
+    if (_pInt16Samples) {
+        free(_pInt16Samples);
+        _pInt16Samples = nullptr;
+    }
+    _pInt16Samples = (int16_t *) malloc((size_t) numFrames * numChannels * sizeof(int16_t));
+
+    if (!_pWavReader->readDataToInt16s(_pInt16Samples, numFrames)) {
+        fprintf(stderr, "testSeekToFrames(): Problem reading reference samples.\n");
+        return false;
+    }
+
+    const uint32_t lastBlockStart = (numFrames - 1) / framesPerBlock * framesPerBlock;
+    const uint32_t frames[] = {
+            0, 1, framesPerBlock / 2, framesPerBlock - 1, framesPerBlock, framesPerBlock + 1,
+            2 * framesPerBlock + framesPerBlock / 3, lastBlockStart - 1, lastBlockStart, lastBlockStart + 1,
+            numFrames / 3, numFrames / 2, numFrames - 1, numFrames
+    };
+    const uint32_t numFramesToRead = framesPerBlock + 10; //Across the next block boundary
+    std::vector<int16_t> seekSamples((size_t) numFramesToRead * numChannels);
+    for (int32_t i = (int32_t) (sizeof(frames) / sizeof(uint32_t)) - 1; i >= 0; i--) {
+        const uint32_t frame = frames[i];
+        if (frame > numFrames) {
+            continue;
+        }
+        if (!_pWavReader->seekToFrame(frame)) {
+            fprintf(stderr, "testSeekToFrames(): Problem seeking to frame %u.\n", frame);
+            return false;
+        }
+        const uint32_t numToRead = std::min(numFramesToRead, numFrames - frame);
+        if (numToRead == 0) {
+            continue;
+        }
+        if (!_pWavReader->readDataToInt16s(seekSamples.data(), numToRead) ||
+            memcmp(seekSamples.data(), _pInt16Samples + (size_t) frame * numChannels,
+                   (size_t) numToRead * numChannels * sizeof(int16_t)) != 0) {
+            fprintf(stderr, "testSeekToFrames(): Frames read after seeking to frame %u don't match.\n", frame);
+            return false;
+        }
+    }
+
+    //Past the end is refused, and the reader still seeks afterwards
+    if (_pWavReader->seekToFrame(numFrames + 1) ||
+        !_pWavReader->seekToFrame(0) ||
+        !_pWavReader->readDataToInt16s(seekSamples.data(), 1) ||
+        memcmp(seekSamples.data(), _pInt16Samples, numChannels * sizeof(int16_t)) != 0) {
+        fprintf(stderr, "testSeekToFrames(): Seeking past the end wasn't refused cleanly.\n");
+        return false;
+    }
+
+    return _pWavReader->finishReading();
+}
+
+
+//A sine, written to a number of frames that leaves the last block short
+bool WavReaderTester::testSeekToImaAdpcmFrames(uint32_t numChannels) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath, "%s/seekima-%dch.wav", _pOutDirPath, numChannels);
+
+    const uint32_t numFrames = 10000 + 7;
+    std::vector<int16_t> samples((size_t) numFrames * numChannels);
+    for (uint32_t i = 0; i < numFrames; i++) {
+        for (uint32_t ch = 0; ch < numChannels; ch++) {
+            samples[(size_t) i * numChannels + ch] =
+                    (int16_t) (30000.0 * sin(2.0 * M_PI * SINE_FREQUENCY * (ch + 1) * i / SAMPLE_RATE));
+        }
+    }
+
+    WavWriter wavWriter;
+    if (!wavWriter.initializeImaAdpcm(outFilePath, SAMPLE_RATE, numChannels) ||
+        !wavWriter.startWriting() ||
+        !wavWriter.writeDataFromInt16s(samples.data(), numFrames) ||
+        !wavWriter.finishWriting()) {
+        fprintf(stderr, "testSeekToImaAdpcmFrames(): Problem writing file.\n");
+        return false;
+    }
+
+    if (!_pWavReader->initialize(outFilePath) ||
+        _pWavReader->getFramesPerBlock() < 2 ||
+        numFrames % _pWavReader->getFramesPerBlock() == 0) {
+        fprintf(stderr, "testSeekToImaAdpcmFrames(): Unexpected block layout.\n");
+        return false;
+    }
+
+    return testSeekToFrames(outFilePath);
+}
+
+
+//prefetch() is advisory, so it must never move the read position: reads after it, whether it
+//succeeded or not, must match a plain sequential read. With nothing left to fetch, or before
+//prepareToRead(), it fails.
+bool WavReaderTester::testPrefetch(const char *filePath) {
+
+#if defined(__linux__) || defined(__APPLE__)
+    const bool canAdvise = true;
+#else
+    const bool canAdvise = false;
+#endif
+
+    if (!_pWavReader->initialize(filePath)) {
+        fprintf(stderr, "testPrefetch(): Problem initializing WavReader.\n");
+        return false;
+    }
+    const uint32_t numFrames = _pWavReader->getNumSamples();
+    const uint32_t numChannels = _pWavReader->getNumChannels();
+    const uint32_t frameSize = numChannels * _pWavReader->getByteDepth();
+
+    //The file is open, but still in the header
+    if (_pWavReader->prefetch(frameSize)) {
+        fprintf(stderr, "testPrefetch(): Prefetched before prepareToRead().\n");
+        return false;
+    }
+
+    //Allocate int16 samples
+    if (_pInt16Samples) {
+        free(_pInt16Samples);
+        _pInt16Samples = nullptr;
+    }
+    _pInt16Samples = (int16_t *) malloc((size_t) numFrames * numChannels * sizeof(int16_t));
+
+    if (!_pWavReader->prepareToRead() ||
+        !_pWavReader->readDataToInt16s(_pInt16Samples, numFrames)) {
+        fprintf(stderr, "testPrefetch(): Problem reading reference samples.\n");
+        return false;
+    }
+    if (_pWavReader->prefetch(frameSize)) {
+        fprintf(stderr, "testPrefetch(): Prefetched past the end of the sample data.\n");
+        return false;
+    }
+
+    //Nothing, then more than the whole file, from the start; then the rest, from the middle
+    const uint32_t numFirstFrames = numFrames / 3;
+    std::vector<int16_t> samples((size_t) numFrames * numChannels);
+    if (!_pWavReader->prepareToRead() ||
+        _pWavReader->prefetch(0) ||
+        _pWavReader->prefetch(numFrames * frameSize * 2) != canAdvise ||
+        !_pWavReader->readDataToInt16s(samples.data(), numFirstFrames) ||
+        _pWavReader->prefetch(numFrames * frameSize) != canAdvise ||
+        !_pWavReader->readDataToInt16s(samples.data() + (size_t) numFirstFrames * numChannels, numFrames - numFirstFrames) ||
+        memcmp(samples.data(), _pInt16Samples, samples.size() * sizeof(int16_t)) != 0) {
+        fprintf(stderr, "testPrefetch(): Frames read around prefetches don't match.\n");
+        return false;
+    }
+
+    //At the end after seeking there, too; the reader still seeks and reads afterwards
+    const uint32_t numLastFrames = std::min(numFrames, (uint32_t) 10);
+    if (!_pWavReader->seekToFrame(numFrames) ||
+        _pWavReader->prefetch(frameSize) ||
+        !_pWavReader->seekToFrame(numFrames - numLastFrames) ||
+        !_pWavReader->readDataToInt16s(samples.data(), numLastFrames) ||
+        memcmp(samples.data(), _pInt16Samples + (size_t) (numFrames - numLastFrames) * numChannels,
+               (size_t) numLastFrames * numChannels * sizeof(int16_t)) != 0) {
+        fprintf(stderr, "testPrefetch(): Reads after prefetching at the end don't match.\n");
+        return false;
+    }
+
+    //And with the file closed
+    if (!_pWavReader->finishReading() ||
+        _pWavReader->prefetch(frameSize)) {
+        fprintf(stderr, "testPrefetch(): Prefetched after finishReading().\n");
+        return false;
+    }
+
+    return true;
+}
+
+
 bool WavReaderTester::validates(const InFileParamSetDef *ifps, ValidationSource validationSource) {
 
     const char *fileName = ifps->fileName;
@@ -358,3 +736,112 @@ bool WavReaderTester::validates(const InFileParamSetDef *ifps, ValidationSource
 
     return true;
 }
+
+
+//Each block type must match the matching whole-file read: raw blocks readData(), int16 blocks
+//readDataToInt16s(), and float blocks the int16 samples to within int16 rounding
+bool WavReaderTester::testReadFileInBlocks(const InFileParamSetDef *ifps,
+                                           uint32_t numFramesPerBlock) {
+
+    char inFilePath[MAX_PATH_LENGTH];
+    sprintf(inFilePath,
+            "%s/%s",
+            _pInDirPath,
+            ifps->fileName);
+
+    if (!_pWavReader->initialize(inFilePath) ||
+        !_pWavReader->prepareToRead()) {
+        fprintf(stderr, "testReadFileInBlocks(): Problem initializing WavReader.\n");
+        return false;
+    }
+    const uint32_t numFrames = _pWavReader->getNumSamples();
+    const uint32_t numChannels = _pWavReader->getNumChannels();
+    const uint32_t frameSize = numChannels * _pWavReader->getByteDepth();
+
+    //Allocate _pSampleData and int16 samples
+    if (_pSampleData) {
+        free(_pSampleData);
+        _pSampleData = nullptr;
+    }
+    _pSampleData = (uint8_t *) malloc((size_t) numFrames * frameSize);
+    if (_pInt16Samples) {
+        free(_pInt16Samples);
+        _pInt16Samples = nullptr;
+    }
+    _pInt16Samples = (int16_t *) malloc((size_t) numFrames * numChannels * sizeof(int16_t));
+
+    if (!_pWavReader->readData(_pSampleData, numFrames * frameSize) ||
+        !_pWavReader->prepareToRead() ||
+        !_pWavReader->readDataToInt16s(_pInt16Samples, numFrames) ||
+        !_pWavReader->finishReading()) {
+        fprintf(stderr, "testReadFileInBlocks(): Problem reading reference samples.\n");
+        return false;
+    }
+    const uint32_t numBlocks = (numFrames + numFramesPerBlock - 1) / numFramesPerBlock;
+
+    //Raw
+    uint32_t nextFrame = 0;
+    uint32_t blockCount = 0;
+    WavFrameBlocks<uint8_t> rawBlocks = _pWavReader->blocks<uint8_t>(numFramesPerBlock);
+    for (auto block : rawBlocks) {
+        if (block.firstFrame != nextFrame || block.numChannels != numChannels ||
+            block.numFrames != std::min(numFramesPerBlock, numFrames - nextFrame) ||
+            memcmp(block.pSamples, _pSampleData + (size_t) nextFrame * frameSize, (size_t) block.numFrames * frameSize) != 0) {
+            fprintf(stderr, "testReadFileInBlocks(): Raw block at frame %u of %s doesn't match.\n", nextFrame, ifps->fileName);
+            return false;
+        }
+        nextFrame += block.numFrames;
+        blockCount++;
+    }
+    if (rawBlocks.getFailed() || nextFrame != numFrames || blockCount != numBlocks) {
+        fprintf(stderr, "testReadFileInBlocks(): Raw blocks of %s stopped at frame %u.\n", ifps->fileName, nextFrame);
+        return false;
+    }
+
+    //int16
+    nextFrame = 0;
+    blockCount = 0;
+    WavFrameBlocks<int16_t> int16Blocks = _pWavReader->blocks<int16_t>(numFramesPerBlock);
+    for (auto block : int16Blocks) {
+        if (block.firstFrame != nextFrame ||
+            block.numFrames != std::min(numFramesPerBlock, numFrames - nextFrame) ||
+            memcmp(block.pSamples, _pInt16Samples + (size_t) nextFrame * numChannels,
+                   (size_t) block.numFrames * numChannels * sizeof(int16_t)) != 0) {
+            fprintf(stderr, "testReadFileInBlocks(): int16 block at frame %u of %s doesn't match.\n", nextFrame, ifps->fileName);
+            return false;
+        }
+        nextFrame += block.numFrames;
+        blockCount++;
+    }
+    if (int16Blocks.getFailed() || nextFrame != numFrames || blockCount != numBlocks) {
+        fprintf(stderr, "testReadFileInBlocks(): int16 blocks of %s stopped at frame %u.\n", ifps->fileName, nextFrame);
+        return false;
+    }
+
+    //float
+    nextFrame = 0;
+    blockCount = 0;
+    WavFrameBlocks<float> floatBlocks = _pWavReader->blocks<float>(numFramesPerBlock);
+    for (auto block : floatBlocks) {
+        if (block.firstFrame != nextFrame ||
+            block.numFrames != std::min(numFramesPerBlock, numFrames - nextFrame)) {
+            fprintf(stderr, "testReadFileInBlocks(): float block at frame %u of %s is misplaced.\n", nextFrame, ifps->fileName);
+            return false;
+        }
+        const int16_t *pExpected = _pInt16Samples + (size_t) nextFrame * numChannels;
+        for (uint32_t i = 0; i < block.numFrames * numChannels; i++) {
+            if (fabs(block.pSamples[i] * 32768.0 - pExpected[i]) > 2.0) {
+                fprintf(stderr, "testReadFileInBlocks(): float block at frame %u of %s doesn't match.\n", nextFrame, ifps->fileName);
+                return false;
+            }
+        }
+        nextFrame += block.numFrames;
+        blockCount++;
+    }
+    if (floatBlocks.getFailed() || nextFrame != numFrames || blockCount != numBlocks) {
+        fprintf(stderr, "testReadFileInBlocks(): float blocks of %s stopped at frame %u.\n", ifps->fileName, nextFrame);
+        return false;
+    }
+
+    return true;
+}
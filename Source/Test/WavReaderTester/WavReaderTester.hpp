@@ -7,6 +7,8 @@
 
 #include "WavHeader.hpp" // Verifies that float and double correspond to f32 and f64 values
 #include "WavReader.hpp"
+#include "WavSignalStats.hpp"
+#include "WavBufferPool.hpp"
 
 
 typedef struct {
@@ -32,7 +34,9 @@ public:
 
     ~ WavReaderTester();
 
-    bool initialize(const char *inDirPath);
+    //Tests that need files written for them (IMA ADPCM seeking, ...) only run if outDirPath is given
+    bool initialize(const char *inDirPath,
+                    const char *outDirPath = nullptr);
 
     bool runWavReaderTest();
 
@@ -44,8 +48,23 @@ private:
 
     bool testReadFileToInt16s(const InFileParamSetDef *ifps);
 
+    bool testReadFileWithSignalStats(const InFileParamSetDef *ifps);
+
+    bool testReadFileIntoPoolBlock(const InFileParamSetDef *ifps);
+
+    bool testReadFileInBlocks(const InFileParamSetDef *ifps,
+                              uint32_t numFramesPerBlock);
+
+    bool testSeekToFrames(const char *filePath);
+
+    bool testSeekToImaAdpcmFrames(uint32_t numChannels);
+
+    bool testPrefetch(const char *filePath);
+
     bool validates(const InFileParamSetDef *ifps, ValidationSource validationSource);
 
+    bool validatesDirectory(const char *dirPath);
+
     //Constants
     static const uint32_t MAX_PATH_LENGTH = 2048;
     static const uint32_t MAX_FILE_NAME_LENGTH = 100;
@@ -161,6 +180,7 @@ private:
 
     WavReader* _pWavReader;
     const char * _pInDirPath;
+    const char * _pOutDirPath;
 };
 
 
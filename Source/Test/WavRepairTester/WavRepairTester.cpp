@@ -0,0 +1,380 @@
+//WavRepairTester.cpp
+
+
+#include <cmath> // M_PI
+#include <cstdio>
+#include <cstdlib> //abs()
+#include <sys/stat.h> //mkdir()
+#include <vector>
+
+#include "WavRepairTester.hpp"
+#include "WavFileIo.hpp"
+#include "WavReader.hpp"
+#include "WavWriter.hpp"
+
+
+WavRepairTester::WavRepairTester() {
+    _pOutDirPath = nullptr;
+}
+
+
+WavRepairTester::~WavRepairTester() {
+}
+
+
+bool WavRepairTester::initialize(const char *outDirPath) {
+
+    //Error-check outDirPath
+    if (!outDirPath) {
+        fprintf(stderr, "Error: Output directory path is NULL.\n");
+        return false;
+    }
+    char tempOutFilePath[MAX_PATH_LENGTH];
+    snprintf(tempOutFilePath, sizeof(tempOutFilePath), "%s/WavRepairTesterTempFile.txt", outDirPath);
+    FILE *fp = fopen(tempOutFilePath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Invalid output directory path.\n");
+        return false;
+    }
+    fclose(fp);
+    if (remove(tempOutFilePath) != 0) {
+        fprintf(stderr, "Error: Unable to remove test file created to validate output directory path.\n");
+        return false;
+    }
+
+    _pOutDirPath = outDirPath;
+
+    //Full-scale 100-frame sine, the same in both channels
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+        int16_t sample = (int16_t) (32767.0 * sin((2 * M_PI * i) / 100.0));
+        _int16Samples1Ch[i] = sample;
+        _int16Samples2Ch[i * 2] = sample;
+        _int16Samples2Ch[i * 2 + 1] = sample;
+    }
+
+    return true;
+}
+
+
+bool WavRepairTester::runWavRepairTest() {
+
+    if (!_pOutDirPath) {
+        fprintf(stderr, "Attempt to call WavRepairTester class method before calling initialize().\n");
+        return false;
+    }
+
+    printf("Running WavRepairTest.\n");
+
+    printf("    Testing finished files...\n");
+    if (!testFinishedFile(WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES) ||
+        !testFinishedFile(WAV_SAMPLE_FORMAT_INT24, 1, NUM_SAMPLES - 1)) {
+        fprintf(stderr, "runWavRepairTest(): Error testing finished files.\n");
+        return false;
+    }
+
+    //Odd-sized int24 mono data, with a pad byte; RIFX too
+    printf("    Testing zero-size files...\n");
+    if (!testZeroSizeFile(WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES, false) ||
+        !testZeroSizeFile(WAV_SAMPLE_FORMAT_INT24, 1, NUM_SAMPLES - 1, false) ||
+        !testZeroSizeFile(WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES, true)) {
+        fprintf(stderr, "runWavRepairTest(): Error testing zero-size files.\n");
+        return false;
+    }
+
+    printf("    Testing truncated files...\n");
+    if (!testTruncatedFile(WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES) ||
+        !testTruncatedFile(WAV_SAMPLE_FORMAT_INT24, 1, NUM_SAMPLES - 1)) {
+        fprintf(stderr, "runWavRepairTest(): Error testing truncated files.\n");
+        return false;
+    }
+
+    printf("    Testing subchunks after the data...\n");
+    if (!testTrailingSubchunks(WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES) ||
+        !testTrailingSubchunks(WAV_SAMPLE_FORMAT_INT24, 1, NUM_SAMPLES - 1)) {
+        fprintf(stderr, "runWavRepairTest(): Error testing subchunks after the data.\n");
+        return false;
+    }
+
+    printf("    Testing repairing a directory...\n");
+    if (!testRepairDirectory()) {
+        fprintf(stderr, "runWavRepairTest(): Error testing repairing a directory.\n");
+        return false;
+    }
+
+    printf("Done WavRepairTest.\n\n");
+
+    return true;
+}
+
+
+//Finished files are left alone
+bool WavRepairTester::testFinishedFile(WavSampleFormat sampleFormat,
+                                       uint32_t numChannels,
+                                       uint32_t numFrames) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    snprintf(outFilePath, sizeof(outFilePath), "%s/repair-finished-%uch.wav", _pOutDirPath, numChannels);
+
+    uint64_t dataOffset = 0;
+    WavRepairResult result;
+    if (!writeFile(outFilePath, sampleFormat, numChannels, numFrames, false, &dataOffset) ||
+        !WavRepair::repair(outFilePath, &result) ||
+        result.needsRepair || result.wasRepaired || result.numFrames != numFrames) {
+        fprintf(stderr, "testFinishedFile(): Finished file was repaired.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//As written by a recorder that never finalized; the data runs to end of file
+bool WavRepairTester::testZeroSizeFile(WavSampleFormat sampleFormat,
+                                       uint32_t numChannels,
+                                       uint32_t numFrames,
+                                       bool bigEndian) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    snprintf(outFilePath, sizeof(outFilePath), "%s/repair-zerosize-%uch%s.wav",
+             _pOutDirPath, numChannels, bigEndian ? "-rifx" : "");
+
+    //A dry run only reports
+    uint64_t dataOffset = 0;
+    WavRepairResult result;
+    if (!writeFile(outFilePath, sampleFormat, numChannels, numFrames, bigEndian, &dataOffset) ||
+        !zeroSizes(outFilePath, dataOffset) ||
+        !WavRepair::repair(outFilePath, &result, true) ||
+        !result.needsRepair || result.wasRepaired || result.oldDataSize != 0 ||
+        !WavRepair::repair(outFilePath, &result, true) || !result.needsRepair) {
+        fprintf(stderr, "testZeroSizeFile(): Dry run didn't report, or patched, a zero-size file.\n");
+        return false;
+    }
+
+    if (!WavRepair::repair(outFilePath, &result) || !result.wasRepaired || result.numFrames != numFrames ||
+        !WavRepair::repair(outFilePath, &result) || result.needsRepair ||
+        !readsBack(outFilePath, sampleFormat, numChannels, numFrames)) {
+        fprintf(stderr, "testZeroSizeFile(): Zero-size file wasn't repaired.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//Truncated mid-frame, with the stated sizes left too large; the partial frame is dropped
+bool WavRepairTester::testTruncatedFile(WavSampleFormat sampleFormat,
+                                        uint32_t numChannels,
+                                        uint32_t numFrames) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    snprintf(outFilePath, sizeof(outFilePath), "%s/repair-truncated-%uch.wav", _pOutDirPath, numChannels);
+
+    const uint32_t frameSize = numChannels * wavSampleFormatByteDepth(sampleFormat);
+    const uint32_t numKeptFrames = numFrames / 2;
+    uint64_t dataOffset = 0;
+    if (!writeFile(outFilePath, sampleFormat, numChannels, numFrames, false, &dataOffset)) {
+        return false;
+    }
+    FILE *f = fopen(outFilePath, "r+b");
+    bool ok = f && wavTruncateFile(f, dataOffset + numKeptFrames * frameSize + frameSize / 2);
+    if (f) {
+        fclose(f);
+    }
+
+    WavRepairResult result;
+    if (!ok ||
+        !WavRepair::repair(outFilePath, &result) || !result.wasRepaired || result.numFrames != numKeptFrames ||
+        !readsBack(outFilePath, sampleFormat, numChannels, numKeptFrames)) {
+        fprintf(stderr, "testTruncatedFile(): Truncated file wasn't repaired.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//Subchunks after the data, as some recorders write them: a fact with a stale count, then a LIST.
+//Appended after the data's pad byte, with the sizes zeroed.
+bool WavRepairTester::testTrailingSubchunks(WavSampleFormat sampleFormat,
+                                            uint32_t numChannels,
+                                            uint32_t numFrames) {
+
+    static const uint8_t TRAILING_SUBCHUNKS[] = {
+            'f', 'a', 'c', 't', 4, 0, 0, 0, 1, 0, 0, 0,
+            'L', 'I', 'S', 'T', 14, 0, 0, 0, 'I', 'N', 'F', 'O', 'I', 'N', 'A', 'M', 2, 0, 0, 0, 'a', 0
+    };
+
+    char outFilePath[MAX_PATH_LENGTH];
+    snprintf(outFilePath, sizeof(outFilePath), "%s/repair-trailing-%uch.wav", _pOutDirPath, numChannels);
+
+    const uint32_t dataSize = numFrames * numChannels * wavSampleFormatByteDepth(sampleFormat);
+    uint64_t dataOffset = 0;
+    if (!writeFile(outFilePath, sampleFormat, numChannels, numFrames, false, &dataOffset)) {
+        return false;
+    }
+    const uint64_t dataEnd = dataOffset + dataSize + (dataSize & 1);
+    const uint8_t padByte = 0;
+    FILE *f = fopen(outFilePath, "r+b");
+    bool ok = f &&
+              ((dataSize & 1) == 0 || wavWriteAt(f, dataEnd - 1, &padByte, 1)) &&
+              wavWriteAt(f, dataEnd, TRAILING_SUBCHUNKS, sizeof(TRAILING_SUBCHUNKS));
+    if (f) {
+        fclose(f);
+    }
+
+    WavRepairResult result;
+    WavReader repairedReader;
+    WavSubchunkInfo listInfo;
+    if (!ok ||
+        !zeroSizes(outFilePath, dataOffset) ||
+        !WavRepair::repair(outFilePath, &result) || !result.wasRepaired ||
+        result.newDataSize != dataSize || result.numFrames != numFrames ||
+        !repairedReader.initialize(outFilePath) ||
+        !repairedReader.findSubchunkInfo("LIST", "INFO", &listInfo) ||
+        !readsBack(outFilePath, sampleFormat, numChannels, numFrames)) {
+        fprintf(stderr, "testTrailingSubchunks(): File with trailing subchunks wasn't repaired to its data.\n");
+        return false;
+    }
+
+    //With the sizes right, the stale fact count after the data is still found and patched
+    uint32_t factNumFrames = 0;
+    f = fopen(outFilePath, "rb");
+    ok = f && wavReadAt(f, dataEnd + sizeof(SubchunkHeader), &factNumFrames, sizeof(uint32_t));
+    if (f) {
+        fclose(f);
+    }
+    if (!ok || factNumFrames != numFrames) {
+        fprintf(stderr, "testTrailingSubchunks(): Trailing fact subchunk wasn't patched.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//Only the .wav files that need it are patched; other files are skipped
+bool WavRepairTester::testRepairDirectory() {
+
+    char dirPath[MAX_PATH_LENGTH];
+    snprintf(dirPath, sizeof(dirPath), "%s/repair-dir", _pOutDirPath);
+
+#if defined(__unix__) || defined(__APPLE__)
+    char finishedFilePath[MAX_PATH_LENGTH + 32];
+    char zeroSizeFilePath[MAX_PATH_LENGTH + 32];
+    char notWavFilePath[MAX_PATH_LENGTH + 32];
+    snprintf(finishedFilePath, sizeof(finishedFilePath), "%s/finished.wav", dirPath);
+    snprintf(zeroSizeFilePath, sizeof(zeroSizeFilePath), "%s/zerosize.WAV", dirPath);
+    snprintf(notWavFilePath, sizeof(notWavFilePath), "%s/notes.txt", dirPath);
+
+    uint64_t dataOffset = 0;
+    mkdir(dirPath, 0755);
+    FILE *f = fopen(notWavFilePath, "wb");
+    if (!f || fputs("Not a wav file", f) < 0 || fclose(f) != 0 ||
+        !writeFile(finishedFilePath, WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES, false, &dataOffset) ||
+        !writeFile(zeroSizeFilePath, WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES, false, &dataOffset) ||
+        !zeroSizes(zeroSizeFilePath, dataOffset)) {
+        fprintf(stderr, "testRepairDirectory(): Problem writing files.\n");
+        return false;
+    }
+
+    uint32_t numRepaired = 0;
+    if (!WavRepair::repairDirectory(dirPath, &numRepaired, 2) ||
+        numRepaired != 1 ||
+        !readsBack(finishedFilePath, WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES) ||
+        !readsBack(zeroSizeFilePath, WAV_SAMPLE_FORMAT_INT16, 2, NUM_SAMPLES)) {
+        fprintf(stderr, "testRepairDirectory(): Directory wasn't repaired.\n");
+        return false;
+    }
+#else
+    if (WavRepair::repairDirectory(dirPath)) {
+        fprintf(stderr, "testRepairDirectory(): Directory walk claimed success without POSIX.\n");
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+
+bool WavRepairTester::writeFile(const char *filePath,
+                                WavSampleFormat sampleFormat,
+                                uint32_t numChannels,
+                                uint32_t numFrames,
+                                bool bigEndian,
+                                uint64_t *dataOffset) {
+
+    WavWriter wavWriter;
+    WavReader wavReader;
+    if (!wavWriter.initialize(filePath, SAMPLE_RATE, numChannels, sampleFormat) ||
+        !wavWriter.setBigEndian(bigEndian) ||
+        !wavWriter.startWriting() ||
+        !wavWriter.writeDataFromInt16s(samplesFor(numChannels), numFrames) ||
+        !wavWriter.finishWriting() ||
+        !wavReader.initialize(filePath)) {
+        fprintf(stderr, "writeFile(): Problem writing %s.\n", filePath);
+        return false;
+    }
+    *dataOffset = wavReader.getDataOffset();
+
+    return true;
+}
+
+
+//Zero is zero in either byte order, so RIFX files need nothing different
+bool WavRepairTester::zeroSizes(const char *filePath,
+                                uint64_t dataOffset) {
+
+    const uint32_t zero = 0;
+    FILE *f = fopen(filePath, "r+b");
+    bool ok = f &&
+              wavWriteAt(f, 4, &zero, sizeof(uint32_t)) &&
+              wavWriteAt(f, dataOffset - sizeof(uint32_t), &zero, sizeof(uint32_t));
+    if (f) {
+        fclose(f);
+    }
+    if (!ok) {
+        fprintf(stderr, "zeroSizes(): Problem patching %s.\n", filePath);
+    }
+
+    return ok;
+}
+
+
+bool WavRepairTester::readsBack(const char *filePath,
+                                WavSampleFormat sampleFormat,
+                                uint32_t numChannels,
+                                uint32_t numFrames) {
+
+    WavReader wavReader;
+    if (!wavReader.initialize(filePath) ||
+        wavReader.getSampleFormat() != sampleFormat ||
+        wavReader.getNumChannels() != numChannels ||
+        wavReader.getSampleRate() != SAMPLE_RATE ||
+        wavReader.getNumSamples() != numFrames) {
+        fprintf(stderr, "readsBack(): Format or length of %s doesn't match what was written.\n", filePath);
+        return false;
+    }
+
+    //int16 and int24 both hold the int16 samples exactly
+    std::vector<int16_t> int16Samples((size_t) numFrames * numChannels + 1);
+    if (!wavReader.prepareToRead() ||
+        !wavReader.readDataToInt16s(int16Samples.data(), numFrames) ||
+        !wavReader.finishReading()) {
+        fprintf(stderr, "readsBack(): Problem reading samples of %s.\n", filePath);
+        return false;
+    }
+    const int16_t *pExpected = samplesFor(numChannels);
+    for (uint32_t i = 0; i < numFrames * numChannels; i++) {
+        if (int16Samples[i] != pExpected[i]) {
+            fprintf(stderr, "readsBack(): Sample %u of %s doesn't match.\n", i, filePath);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+const int16_t *WavRepairTester::samplesFor(uint32_t numChannels) {
+    return (numChannels == 1) ? _int16Samples1Ch : _int16Samples2Ch;
+}
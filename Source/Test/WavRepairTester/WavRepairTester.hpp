@@ -0,0 +1,77 @@
+//WavRepairTester.hpp
+
+#ifndef __WAV_REPAIR_TESTER_HPP__
+#define __WAV_REPAIR_TESTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavRepair.hpp"
+#include "WavSampleConverter.hpp" //WavSampleFormat
+
+
+class WavRepairTester {
+
+public:
+
+    WavRepairTester();
+
+    ~ WavRepairTester();
+
+    bool initialize(const char *outDirPath);
+
+    bool runWavRepairTest();
+
+private:
+
+    bool testFinishedFile(WavSampleFormat sampleFormat,
+                          uint32_t numChannels,
+                          uint32_t numFrames);
+
+    bool testZeroSizeFile(WavSampleFormat sampleFormat,
+                          uint32_t numChannels,
+                          uint32_t numFrames,
+                          bool bigEndian);
+
+    bool testTruncatedFile(WavSampleFormat sampleFormat,
+                           uint32_t numChannels,
+                           uint32_t numFrames);
+
+    bool testTrailingSubchunks(WavSampleFormat sampleFormat,
+                               uint32_t numChannels,
+                               uint32_t numFrames);
+
+    bool testRepairDirectory();
+
+    //Write a finished file of the test sine, and note where its data subchunk's payload starts
+    bool writeFile(const char *filePath,
+                   WavSampleFormat sampleFormat,
+                   uint32_t numChannels,
+                   uint32_t numFrames,
+                   bool bigEndian,
+                   uint64_t *dataOffset);
+
+    //Zero the RIFF and data size fields, as a recorder that never finalized leaves them
+    bool zeroSizes(const char *filePath,
+                   uint64_t dataOffset);
+
+    //Re-open filePath and check its format and length, and that its samples are the test sine's
+    bool readsBack(const char *filePath,
+                   WavSampleFormat sampleFormat,
+                   uint32_t numChannels,
+                   uint32_t numFrames);
+
+    const int16_t *samplesFor(uint32_t numChannels);
+
+    //Constants
+    static const uint32_t MAX_PATH_LENGTH = 2048;
+    static const uint32_t NUM_SAMPLES = 2048;
+    static const uint32_t SAMPLE_RATE = 44100;
+
+    int16_t _int16Samples1Ch[NUM_SAMPLES * 1];
+    int16_t _int16Samples2Ch[NUM_SAMPLES * 2];
+
+    const char *_pOutDirPath;
+};
+
+
+#endif //__WAV_REPAIR_TESTER_HPP__
@@ -0,0 +1,172 @@
+//WavTraceTester.cpp
+
+
+#include <cstdio>
+#include <cstring> //strstr()
+#include <thread>
+#include <vector>
+
+#include "WavTraceTester.hpp"
+
+
+WavTraceTester::WavTraceTester() {
+    _pOutDirPath = nullptr;
+}
+
+
+WavTraceTester::~WavTraceTester() {
+}
+
+
+bool WavTraceTester::initialize(const char *outDirPath) {
+
+    //Error-check outDirPath
+    if (!outDirPath) {
+        fprintf(stderr, "Error: Output directory path is NULL.\n");
+        return false;
+    }
+    char tempOutFilePath[MAX_PATH_LENGTH];
+    snprintf(tempOutFilePath, sizeof(tempOutFilePath), "%s/WavTraceTesterTempFile.txt", outDirPath);
+    FILE *fp = fopen(tempOutFilePath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Invalid output directory path.\n");
+        return false;
+    }
+    fclose(fp);
+    if (remove(tempOutFilePath) != 0) {
+        fprintf(stderr, "Error: Unable to remove test file created to validate output directory path.\n");
+        return false;
+    }
+
+    _pOutDirPath = outDirPath;
+
+    return true;
+}
+
+
+bool WavTraceTester::runWavTraceTest() {
+
+    if (!_pOutDirPath) {
+        fprintf(stderr, "Attempt to call WavTraceTester class method before calling initialize().\n");
+        return false;
+    }
+
+    printf("Running WavTraceTest.\n");
+
+    printf("    Testing events from exited threads...\n");
+    if (!testExitedThreads()) {
+        fprintf(stderr, "runWavTraceTest(): Error testing events from exited threads.\n");
+        return false;
+    }
+
+    printf("    Testing dropped events...\n");
+    if (!testDroppedEvents()) {
+        fprintf(stderr, "runWavTraceTest(): Error testing dropped events.\n");
+        return false;
+    }
+
+    printf("Done WavTraceTest.\n\n");
+
+    return true;
+}
+
+
+//Events from short-lived threads, with details that need escaping in JSON
+bool WavTraceTester::testExitedThreads() {
+
+    static const uint32_t NUM_THREADS = 8;
+    static const char DETAIL[] = "\"quoted\" C:\\path\ttab";
+    static const char ESCAPED_DETAIL[] = "\"detail\": \"\\\"quoted\\\" C:\\\\path\\u0009tab\"";
+
+    char traceFilePath[MAX_PATH_LENGTH];
+    snprintf(traceFilePath, sizeof(traceFilePath), "%s/trace-threads.json", _pOutDirPath);
+
+    //Each thread records one event and exits; the others record nothing
+    WavTrace::clear();
+    if (!WavTrace::start(1024)) {
+        return false;
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < NUM_THREADS; i++) {
+        threads.push_back(std::thread([i]() {
+            if (i % 2 == 0) {
+                uint64_t startNanos = WavTrace::now();
+                WavTrace::record("testExitedThreads", DETAIL, i, startNanos, WavTrace::now());
+            }
+        }));
+    }
+    for (uint32_t i = 0; i < NUM_THREADS; i++) {
+        threads[i].join();
+    }
+    WavTrace::stop();
+    bool ok = WavTrace::writeJson(traceFilePath);
+    WavTrace::clear();
+
+    const int32_t numEvents = countInTraceFile(traceFilePath, "\"name\": \"testExitedThreads\"");
+    const int32_t numDetails = countInTraceFile(traceFilePath, ESCAPED_DETAIL);
+    const int32_t numTabs = countInTraceFile(traceFilePath, "\t");
+    if (!ok || numEvents != (int32_t) NUM_THREADS / 2 || numDetails != (int32_t) NUM_THREADS / 2 || numTabs != 0) {
+        fprintf(stderr, "testExitedThreads(): Trace doesn't hold every exited thread's events, escaped.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//Events past a thread's buffer are dropped and counted, even once that thread has exited
+bool WavTraceTester::testDroppedEvents() {
+
+    static const uint32_t MAX_EVENTS = 2;
+    static const uint32_t NUM_EVENTS = 5;
+
+    char traceFilePath[MAX_PATH_LENGTH];
+    snprintf(traceFilePath, sizeof(traceFilePath), "%s/trace-dropped.json", _pOutDirPath);
+
+    WavTrace::clear();
+    if (!WavTrace::start(MAX_EVENTS)) {
+        return false;
+    }
+    std::thread recorder([]() {
+        for (uint32_t i = 0; i < NUM_EVENTS; i++) {
+            uint64_t startNanos = WavTrace::now();
+            WavTrace::record("testDroppedEvents", nullptr, i, startNanos, WavTrace::now());
+        }
+    });
+    recorder.join();
+    WavTrace::stop();
+
+    const uint64_t numDropped = WavTrace::getNumDroppedEvents();
+    bool ok = WavTrace::writeJson(traceFilePath);
+    WavTrace::clear();
+    if (!ok ||
+        numDropped != NUM_EVENTS - MAX_EVENTS ||
+        countInTraceFile(traceFilePath, "\"name\": \"testDroppedEvents\"") != (int32_t) MAX_EVENTS ||
+        WavTrace::getNumDroppedEvents() != 0) {
+        fprintf(stderr, "testDroppedEvents(): Events past the buffer weren't dropped and counted.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+int32_t WavTraceTester::countInTraceFile(const char *traceFilePath,
+                                         const char *needle) {
+
+    char json[MAX_TRACE_FILE_SIZE];
+    FILE *f = fopen(traceFilePath, "rb");
+    if (!f) {
+        return -1;
+    }
+    size_t jsonSize = fread(json, 1, sizeof(json) - 1, f);
+    fclose(f);
+    json[jsonSize] = '\0';
+
+    int32_t count = 0;
+    for (const char *c = strstr(json, needle); c; c = strstr(c + 1, needle)) {
+        count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,41 @@
+//WavTraceTester.hpp
+
+#ifndef __WAV_TRACE_TESTER_HPP__
+#define __WAV_TRACE_TESTER_HPP__
+
+#include <cstdint> //For uint8_t, etc.
+
+#include "WavTrace.hpp"
+
+
+class WavTraceTester {
+
+public:
+
+    WavTraceTester();
+
+    ~ WavTraceTester();
+
+    bool initialize(const char *outDirPath);
+
+    bool runWavTraceTest();
+
+private:
+
+    bool testExitedThreads();
+
+    bool testDroppedEvents();
+
+    //Occurrences of needle in the trace file, or -1 if it can't be read
+    int32_t countInTraceFile(const char *traceFilePath,
+                             const char *needle);
+
+    //Constants
+    static const uint32_t MAX_PATH_LENGTH = 2048;
+    static const uint32_t MAX_TRACE_FILE_SIZE = 4096;
+
+    const char *_pOutDirPath;
+};
+
+
+#endif //__WAV_TRACE_TESTER_HPP__
@@ -0,0 +1,78 @@
+//WavUnitTester.cpp
+//Runs one tester, so ctest can report each on its own; see Source/Test/CMakeLists.txt.
+//Usage: wav_unit_tester TesterName ReferenceAudioDir OutputDir
+
+
+#include <cstdio>
+#include <cstring>
+
+#include "WavReaderTester.hpp"
+#include "WavWriterTester.hpp"
+#include "WavBufferPoolTester.hpp"
+#include "WavReaderCacheTester.hpp"
+#include "WavCountersTester.hpp"
+#include "WavTraceTester.hpp"
+#include "WavBlockCacheTester.hpp"
+#include "WavRepairTester.hpp"
+#include "WavOverviewTester.hpp"
+
+
+static bool runTester(const char *testerName,
+                      const char *referenceAudioDirectory,
+                      const char *outputDirectory) {
+
+    if (strcmp(testerName, "reader") == 0) {
+        WavReaderTester wrt;
+        return wrt.initialize(referenceAudioDirectory, outputDirectory) && wrt.runWavReaderTest();
+    }
+    if (strcmp(testerName, "writer") == 0) {
+        WavWriterTester wwt;
+        return wwt.initialize(outputDirectory) && wwt.runWavWriterTest();
+    }
+    if (strcmp(testerName, "buffer_pool") == 0) {
+        WavBufferPoolTester wbpt;
+        return wbpt.runWavBufferPoolTest();
+    }
+    if (strcmp(testerName, "reader_cache") == 0) {
+        WavReaderCacheTester wrct;
+        return wrct.initialize(outputDirectory) && wrct.runWavReaderCacheTest();
+    }
+    if (strcmp(testerName, "counters") == 0) {
+        WavCountersTester wct;
+        return wct.initialize(outputDirectory) && wct.runWavCountersTest();
+    }
+    if (strcmp(testerName, "trace") == 0) {
+        WavTraceTester wtt;
+        return wtt.initialize(outputDirectory) && wtt.runWavTraceTest();
+    }
+    if (strcmp(testerName, "block_cache") == 0) {
+        WavBlockCacheTester wbct;
+        return wbct.initialize(outputDirectory) && wbct.runWavBlockCacheTest();
+    }
+    if (strcmp(testerName, "repair") == 0) {
+        WavRepairTester wrt;
+        return wrt.initialize(outputDirectory) && wrt.runWavRepairTest();
+    }
+    if (strcmp(testerName, "overview") == 0) {
+        WavOverviewTester wot;
+        return wot.initialize(outputDirectory) && wot.runWavOverviewTest();
+    }
+
+    fprintf(stderr, "Unknown tester: %s\n", testerName);
+    return false;
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    if (argc != 4) {
+        printf("Usage: wav_unit_tester TesterName ReferenceAudioDir OutputDir\n\n");
+        printf("  TesterName: reader, writer, buffer_pool, reader_cache, counters, trace, block_cache, repair or overview\n");
+        printf("  ReferenceAudioDir: Reference audio directory for this project,\n");
+        printf("                     i.e: Source/Test/ReferenceAudio.\n");
+        printf("  OutputDir: An existing directory to write output wav files to\n");
+        return 1;
+    }
+
+    return runTester(argv[1], argv[2], argv[3]) ? 0 : 1;
+}
@@ -6,9 +6,17 @@
 
 #include "WavHeader.hpp" // Verifies that float and double correspond to f32 and f64 values
 #include "WavWriter.hpp"
+#include "WavReader.hpp"
+#include "WavFileCopy.hpp"
+#include "WavFileIo.hpp"
+#include "WavFileOps.hpp"
+#include "WavTranscoder.hpp"
 
+#include <algorithm> //std::min()
 #include <cmath> // M_PI
 #include <cstring>
+#include <sys/stat.h>
+#include <vector>
 
 
 WavWriterTester::WavWriterTester() {
@@ -126,15 +134,119 @@ bool WavWriterTester::runWavWriterTest() {
         }
     }
 
-    //Write files from int16 sample arrays
+    //Write files from int16 sample arrays, encoded to every format
     printf("    Writing files from int16s...\n");
-    for (int numChannels = 1; numChannels < 3; numChannels++) {
-        if (!writeFileFromInt16s(numChannels)) {
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        if (!writeFileFromInt16s(&outFileParamSets[i])) {
             fprintf(stderr, "runWavWriterTest(): Problem writing file from int16s.\n");
             return false;
         }
     }
 
+    //Write files from float32 sample arrays, encoded to every format
+    printf("    Writing files from floats...\n");
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        if (!writeFileFromFloats(&outFileParamSets[i])) {
+            fprintf(stderr, "runWavWriterTest(): Problem writing file from floats.\n");
+            return false;
+        }
+    }
+
+    //Write G.711 (A-law and mu-law) files from int16 sample arrays
+    printf("    Writing G.711 files...\n");
+    for (uint32_t numChannels = 1; numChannels < 3; numChannels++) {
+        if (!writeCompandedFile(WAV_SAMPLE_FORMAT_ALAW, numChannels) ||
+            !writeCompandedFile(WAV_SAMPLE_FORMAT_MULAW, numChannels)) {
+            fprintf(stderr, "runWavWriterTest(): Problem writing G.711 file.\n");
+            return false;
+        }
+    }
+
+    //Write IMA ADPCM files from int16 sample arrays
+    printf("    Writing IMA ADPCM files...\n");
+    for (uint32_t numChannels = 1; numChannels < 3; numChannels++) {
+        if (!writeImaAdpcmFile(numChannels)) {
+            fprintf(stderr, "runWavWriterTest(): Problem writing IMA ADPCM file.\n");
+            return false;
+        }
+    }
+
+    //Write RIFX (big-endian) files from float32 sample arrays, in every format
+    printf("    Writing RIFX files...\n");
+    for (uint32_t i = 0; i < NUM_FILE_PARAM_SETS; i++) {
+        if (!writeBigEndianFile(&outFileParamSets[i])) {
+            fprintf(stderr, "runWavWriterTest(): Problem writing RIFX file.\n");
+            return false;
+        }
+    }
+
+    //Write files with LIST/INFO and iXML subchunks, then copy the iXML file to file into another
+    printf("    Writing files with metadata subchunks...\n");
+    for (uint32_t numChannels = 1; numChannels < 3; numChannels++) {
+        if (!writeFileWithMetadata(numChannels)) {
+            fprintf(stderr, "runWavWriterTest(): Problem writing file with metadata subchunks.\n");
+            return false;
+        }
+    }
+
+    //Transcode a file with metadata subchunks to RIFX and back, converting their byte order
+    printf("    Transcoding metadata subchunks between byte orders...\n");
+    if (!transcodeMetadata()) {
+        fprintf(stderr, "runWavWriterTest(): Problem transcoding metadata subchunks.\n");
+        return false;
+    }
+
+    //Split a file at cue points, by frame ranges and by duration, and join files
+    printf("    Splitting and concatenating files...\n");
+    if (!splitFiles() || !concatenateFiles()) {
+        fprintf(stderr, "runWavWriterTest(): Problem splitting or concatenating files.\n");
+        return false;
+    }
+
+    //Copy byte ranges between files, kernel-side where possible and through a buffer
+    printf("    Copying file ranges...\n");
+    if (!copyFileRanges(false) || !copyFileRanges(true)) {
+        fprintf(stderr, "runWavWriterTest(): Problem copying file ranges.\n");
+        return false;
+    }
+
+    //Extract regions of a file into new files, one at a time and in parallel batches
+    printf("    Extracting regions...\n");
+    for (uint32_t numChannels = 1; numChannels < 3; numChannels++) {
+        if (!extractRegions(numChannels)) {
+            fprintf(stderr, "runWavWriterTest(): Problem extracting regions.\n");
+            return false;
+        }
+    }
+
+    //Write files with preallocated space: less than, exactly and more than what's written
+    printf("    Writing preallocated files...\n");
+    if (!writePreallocatedFile(NUM_SAMPLES / 2) ||
+        !writePreallocatedFile(NUM_SAMPLES) ||
+        !writePreallocatedFile(NUM_SAMPLES * 1000)) {
+        fprintf(stderr, "runWavWriterTest(): Problem writing preallocated file.\n");
+        return false;
+    }
+
+    //Write files that checkpoint their headers, and read them while they're still being written
+    printf("    Writing checkpointed files...\n");
+    if (!writeCheckpointedFile(WAV_SAMPLE_FORMAT_INT16) ||
+        !writeCheckpointedFile(WAV_SAMPLE_FORMAT_FLOAT32)) {
+        fprintf(stderr, "runWavWriterTest(): Problem writing checkpointed file.\n");
+        return false;
+    }
+
+    //Write one float array per channel and read them back the same way
+    printf("    Writing planar files...\n");
+    for (uint32_t numChannels = 1; numChannels < 3; numChannels++) {
+        if (!writePlanarFile(WAV_SAMPLE_FORMAT_INT16, numChannels) ||
+            !writePlanarFile(WAV_SAMPLE_FORMAT_INT24, numChannels) ||
+            !writePlanarFile(WAV_SAMPLE_FORMAT_FLOAT32, numChannels)) {
+            fprintf(stderr, "runWavWriterTest(): Problem writing planar file.\n");
+            return false;
+        }
+    }
+
     printf("Done WavWriterTest.\n");
 
     printf("    To verify written files, check contents of output directory:\n    %s/\n\n", _pOutDirPath);
@@ -254,16 +366,20 @@ bool WavWriterTester::writeFileIncrementally(const OutFileParamSetDef *ofps) {
 }
 
 
-bool WavWriterTester::writeFileFromInt16s(uint32_t numChannels) {
+bool WavWriterTester::writeFileFromInt16s(const OutFileParamSetDef *ofps) {
+
+    uint32_t numChannels = ofps->numChannels;
+    uint32_t byteDepth = ofps->byteDepth;
+    bool samplesAreInts = ofps->samplesAreInts;
 
     char outFilePath[MAX_PATH_LENGTH];
     sprintf(outFilePath,
-            "%s/int16write-%dch.wav",
+            "%s/int16write-%d%s%dch.wav",
             _pOutDirPath,
+            byteDepth * 8,
+            (samplesAreInts) ? "i" : "f",
             numChannels);
 
-    uint32_t byteDepth = 2;
-    bool samplesAreInts = true;
     int16_t *_pInt16Samples = (numChannels == 1) ? int16Samples1Ch : int16Samples2Ch;
 
     if (!_pWavWriter->initialize(outFilePath,
@@ -290,6 +406,1091 @@ bool WavWriterTester::writeFileFromInt16s(uint32_t numChannels) {
         return false;
     }
 
+    //8-bit keeps only the top byte; floats round-trip through the reader's 32767 scale
+    const int32_t tolerance = (byteDepth == 1) ? 255 : 1;
+    if (!readsBack(outFilePath, wavSampleFormat(samplesAreInts, byteDepth), numChannels,
+                   _pInt16Samples, NUM_SAMPLES, tolerance)) {
+        fprintf(stderr, "writeFileFromInt16s(): File doesn't read back as written.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::writeFileFromFloats(const OutFileParamSetDef *ofps) {
+
+    uint32_t numChannels = ofps->numChannels;
+    uint32_t byteDepth = ofps->byteDepth;
+    bool samplesAreInts = ofps->samplesAreInts;
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath,
+            "%s/floatwrite-%d%s%dch.wav",
+            _pOutDirPath,
+            byteDepth * 8,
+            (samplesAreInts) ? "i" : "f",
+            numChannels);
+
+    float *floatSamples = (numChannels == 1) ? float32Samples1Ch : float32Samples2Ch;
+
+    if (!_pWavWriter->initialize(outFilePath,
+                               SAMPLE_RATE,
+                               numChannels,
+                               samplesAreInts,
+                               byteDepth)) {
+        fprintf(stderr, "writeFileFromFloats(): Unable to initialize wavWriter.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->startWriting()) {
+        fprintf(stderr, "writeFileFromFloats(): Problem starting writing.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->writeDataFromFloats(floatSamples, NUM_SAMPLES)) {
+        fprintf(stderr, "writeFileFromFloats(): Problem writing data.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writeFileFromFloats(): Problem finishing writing.\n");
+        return false;
+    }
+
+    //The int16 reference truncates where the writer rounds; 8-bit keeps only the top byte
+    int16_t *pInt16Samples = (numChannels == 1) ? int16Samples1Ch : int16Samples2Ch;
+    const int32_t tolerance = (byteDepth == 1) ? 255 : 2;
+    if (!readsBack(outFilePath, wavSampleFormat(samplesAreInts, byteDepth), numChannels,
+                   pInt16Samples, NUM_SAMPLES, tolerance)) {
+        fprintf(stderr, "writeFileFromFloats(): File doesn't read back as written.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::writeCompandedFile(WavSampleFormat sampleFormat, uint32_t numChannels) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath,
+            "%s/g711write-%s%dch.wav",
+            _pOutDirPath,
+            (sampleFormat == WAV_SAMPLE_FORMAT_ALAW) ? "alaw" : "mulaw",
+            numChannels);
+
+    int16_t *_pInt16Samples = (numChannels == 1) ? int16Samples1Ch : int16Samples2Ch;
+
+    if (!_pWavWriter->initialize(outFilePath,
+                               SAMPLE_RATE,
+                               numChannels,
+                               sampleFormat)) {
+        fprintf(stderr, "writeCompandedFile(): Unable to initialize wavWriter.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->startWriting()) {
+        fprintf(stderr, "writeCompandedFile(): Problem starting writing.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->writeDataFromInt16s(_pInt16Samples, NUM_SAMPLES)) {
+        fprintf(stderr, "writeCompandedFile(): Problem writing data.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writeCompandedFile(): Problem finishing writing.\n");
+        return false;
+    }
+
+    //Lossy: within one quantization step of the loudest segment, 1024 in int16 for both laws
+    if (!readsBack(outFilePath, sampleFormat, numChannels, _pInt16Samples, NUM_SAMPLES, 1024)) {
+        fprintf(stderr, "writeCompandedFile(): File doesn't read back as written.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::writeImaAdpcmFile(uint32_t numChannels) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath,
+            "%s/adpcmwrite-%dch.wav",
+            _pOutDirPath,
+            numChannels);
+
+    int16_t *pInt16Samples = (numChannels == 1) ? int16Samples1Ch : int16Samples2Ch;
+
+    if (!_pWavWriter->initializeImaAdpcm(outFilePath,
+                                         SAMPLE_RATE,
+                                         numChannels)) {
+        fprintf(stderr, "writeImaAdpcmFile(): Unable to initialize wavWriter.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->startWriting()) {
+        fprintf(stderr, "writeImaAdpcmFile(): Problem starting writing.\n");
+        return false;
+    }
+
+    //The last block is only partly filled; finishWriting() pads it out
+    if (!_pWavWriter->writeDataFromInt16s(pInt16Samples, NUM_SAMPLES)) {
+        fprintf(stderr, "writeImaAdpcmFile(): Problem writing data.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writeImaAdpcmFile(): Problem finishing writing.\n");
+        return false;
+    }
+
+    WavReader wavReader;
+    if (!wavReader.initialize(outFilePath) ||
+        wavReader.getAudioFormat() != AUDIO_FORMAT_IMA_ADPCM) {
+        fprintf(stderr, "writeImaAdpcmFile(): File doesn't read back as IMA ADPCM.\n");
+        return false;
+    }
+
+    //The padded last block must read back as NUM_SAMPLES frames. The encoder's step size starts at
+    //its smallest and takes a few frames to reach a full-scale sine; after that the 4-bit codes
+    //stay well within 1024 of the source.
+    if (!readsBack(outFilePath, WAV_SAMPLE_FORMAT_INT16, numChannels, pInt16Samples, NUM_SAMPLES, 1024, 32)) {
+        fprintf(stderr, "writeImaAdpcmFile(): File doesn't read back as written.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::writeBigEndianFile(const OutFileParamSetDef *ofps) {
+
+    uint32_t numChannels = ofps->numChannels;
+    uint32_t byteDepth = ofps->byteDepth;
+    bool samplesAreInts = ofps->samplesAreInts;
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath,
+            "%s/rifxwrite-%d%s%dch.wav",
+            _pOutDirPath,
+            byteDepth * 8,
+            (samplesAreInts) ? "i" : "f",
+            numChannels);
+
+    float *floatSamples = (numChannels == 1) ? float32Samples1Ch : float32Samples2Ch;
+
+    if (!_pWavWriter->initialize(outFilePath,
+                               SAMPLE_RATE,
+                               numChannels,
+                               samplesAreInts,
+                               byteDepth)) {
+        fprintf(stderr, "writeBigEndianFile(): Unable to initialize wavWriter.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->setBigEndian(true)) {
+        fprintf(stderr, "writeBigEndianFile(): Problem setting byte order.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->startWriting()) {
+        fprintf(stderr, "writeBigEndianFile(): Problem starting writing.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->writeDataFromFloats(floatSamples, NUM_SAMPLES)) {
+        fprintf(stderr, "writeBigEndianFile(): Problem writing data.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writeBigEndianFile(): Problem finishing writing.\n");
+        return false;
+    }
+
+    WavReader wavReader;
+    if (!wavReader.initialize(outFilePath) ||
+        !wavReader.getIsBigEndian()) {
+        fprintf(stderr, "writeBigEndianFile(): File doesn't read back as RIFX.\n");
+        return false;
+    }
+
+    //Same tolerances as writeFileFromFloats(); a sample with its bytes swapped is far outside them
+    int16_t *pInt16Samples = (numChannels == 1) ? int16Samples1Ch : int16Samples2Ch;
+    const int32_t tolerance = (byteDepth == 1) ? 255 : 2;
+    if (!readsBack(outFilePath, wavSampleFormat(samplesAreInts, byteDepth), numChannels,
+                   pInt16Samples, NUM_SAMPLES, tolerance)) {
+        fprintf(stderr, "writeBigEndianFile(): File doesn't read back as written.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::writeFileWithMetadata(uint32_t numChannels) {
+
+    static const char TITLE[] = "440Hz Sine";
+    static const char IXML[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><BWFXML><IXML_VERSION>2.10</IXML_VERSION></BWFXML>";
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath,
+            "%s/metadatawrite-%dch.wav",
+            _pOutDirPath,
+            numChannels);
+    char copyFilePath[MAX_PATH_LENGTH];
+    sprintf(copyFilePath,
+            "%s/metadatacopy-%dch.wav",
+            _pOutDirPath,
+            numChannels);
+
+    int16_t *pInt16Samples = (numChannels == 1) ? int16Samples1Ch : int16Samples2Ch;
+
+    //LIST/INFO payload: list type, then one INAM subchunk (NUL-terminated, padded to even length)
+    uint8_t listData[4 + SUBCHUNK_HEADER_SIZE + sizeof(TITLE) + 1];
+    const uint32_t titleSize = sizeof(TITLE);
+    memcpy(listData, "INFO", 4);
+    memcpy(listData + 4, "INAM", 4);
+    memcpy(listData + 8, &titleSize, 4);
+    memset(listData + 12, 0, sizeof(listData) - 12);
+    memcpy(listData + 12, TITLE, sizeof(TITLE));
+    const uint32_t listSize = 4 + SUBCHUNK_HEADER_SIZE + titleSize + (titleSize & 1);
+
+    if (!_pWavWriter->initialize(outFilePath,
+                               SAMPLE_RATE,
+                               numChannels,
+                               true,
+                               2)) {
+        fprintf(stderr, "writeFileWithMetadata(): Unable to initialize wavWriter.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->addSubchunk("LIST", listData, listSize) ||
+        !_pWavWriter->addSubchunk("iXML", (const uint8_t *) IXML, sizeof(IXML) - 1)) {
+        fprintf(stderr, "writeFileWithMetadata(): Problem adding subchunks.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(pInt16Samples, NUM_SAMPLES) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writeFileWithMetadata(): Problem writing file.\n");
+        return false;
+    }
+
+    //Read the metadata back, and copy the iXML across by its location
+    WavReader wavReader;
+    char title[64];
+    WavSubchunkInfo ixmlInfo;
+    if (!wavReader.initialize(outFilePath) ||
+        !wavReader.getInfoText("INAM", title, sizeof(title)) ||
+        strcmp(title, TITLE) ||
+        !wavReader.findSubchunkInfo("iXML", nullptr, &ixmlInfo) ||
+        ixmlInfo.dataSize != sizeof(IXML) - 1) {
+        fprintf(stderr, "writeFileWithMetadata(): Metadata didn't read back as written.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->initialize(copyFilePath,
+                               SAMPLE_RATE,
+                               numChannels,
+                               true,
+                               2) ||
+        !_pWavWriter->addSubchunkFromFile("iXML", outFilePath, ixmlInfo.dataOffset, ixmlInfo.dataSize) ||
+        !_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(pInt16Samples, NUM_SAMPLES) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writeFileWithMetadata(): Problem writing file with copied subchunk.\n");
+        return false;
+    }
+
+    char xml[sizeof(IXML)];
+    WavReader copyReader;
+    if (!copyReader.initialize(copyFilePath) ||
+        !copyReader.readIXml(xml, sizeof(xml)) ||
+        strcmp(xml, IXML)) {
+        fprintf(stderr, "writeFileWithMetadata(): Copied iXML subchunk doesn't match.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//Little-endian (RIFF) field, appended to a subchunk payload being built
+static void appendUint32(std::vector<uint8_t> &data, uint32_t value) {
+    for (uint32_t i = 0; i < 4; i++) {
+        data.push_back((uint8_t) (value >> (i * 8)));
+    }
+}
+
+
+static void appendBytes(std::vector<uint8_t> &data, const char *bytes, uint32_t numBytes) {
+    data.insert(data.end(), bytes, bytes + numBytes);
+}
+
+
+bool WavWriterTester::transcodeMetadata() {
+
+    static const uint32_t NUM_SUBCHUNKS = 6;
+    static const char SUBCHUNK_IDS[NUM_SUBCHUNKS][5] = {"cue ", "LIST", "LIST", "bext", "smpl", "abcd"};
+    static const uint32_t NUM_CONVERTIBLE_SUBCHUNKS = 5; //"abcd" has no known layout, so is dropped
+
+    char riffFilePath[MAX_PATH_LENGTH];
+    char rifxFilePath[MAX_PATH_LENGTH];
+    char backFilePath[MAX_PATH_LENGTH];
+    sprintf(riffFilePath, "%s/transcodemeta-riff.wav", _pOutDirPath);
+    sprintf(rifxFilePath, "%s/transcodemeta-rifx.wav", _pOutDirPath);
+    sprintf(backFilePath, "%s/transcodemeta-back.wav", _pOutDirPath);
+
+    //Two cue points, labeled in LIST/adtl, and a title, BWF fields and a sampler loop
+    std::vector<uint8_t> payloads[NUM_SUBCHUNKS];
+    std::vector<uint8_t> *cue = &payloads[0];
+    appendUint32(*cue, 2);
+    for (uint32_t i = 1; i <= 2; i++) {
+        appendUint32(*cue, i); //dwName
+        appendUint32(*cue, i * 100); //dwPosition
+        appendBytes(*cue, "data", 4);
+        appendUint32(*cue, 0);
+        appendUint32(*cue, 0);
+        appendUint32(*cue, i * 100); //dwSampleOffset
+    }
+    std::vector<uint8_t> *adtl = &payloads[1];
+    appendBytes(*adtl, "adtl", 4);
+    appendBytes(*adtl, "labl", 4);
+    appendUint32(*adtl, 8);
+    appendUint32(*adtl, 1);
+    appendBytes(*adtl, "One", 4);
+    appendBytes(*adtl, "ltxt", 4);
+    appendUint32(*adtl, 20);
+    appendUint32(*adtl, 2);
+    appendUint32(*adtl, 50); //dwSampleLength
+    appendBytes(*adtl, "rgn ", 4);
+    appendUint32(*adtl, 0x00090001); //wCountry, wLanguage
+    appendUint32(*adtl, 0x04E40002); //wDialect, wCodePage
+    appendBytes(*adtl, "labl", 4);
+    appendUint32(*adtl, 8);
+    appendUint32(*adtl, 2);
+    appendBytes(*adtl, "Two", 4);
+    std::vector<uint8_t> *info = &payloads[2];
+    appendBytes(*info, "INFO", 4);
+    appendBytes(*info, "INAM", 4);
+    appendUint32(*info, 6);
+    appendBytes(*info, "Title", 6);
+    std::vector<uint8_t> *bext = &payloads[3];
+    bext->resize(BEXT_FIXED_SIZE, 0);
+    memcpy(bext->data(), "Description", 11);
+    const uint64_t timeReference = 0x123456789AULL;
+    const int16_t loudnessValue = -2300;
+    const uint16_t version = 2;
+    (*bext)[338] = (uint8_t) timeReference;
+    (*bext)[339] = (uint8_t) (timeReference >> 8);
+    (*bext)[340] = (uint8_t) (timeReference >> 16);
+    (*bext)[341] = (uint8_t) (timeReference >> 24);
+    (*bext)[342] = (uint8_t) (timeReference >> 32);
+    (*bext)[346] = (uint8_t) version;
+    (*bext)[412] = (uint8_t) loudnessValue;
+    (*bext)[413] = (uint8_t) ((uint16_t) loudnessValue >> 8);
+    appendBytes(*bext, "A=PCM\r\n", 7); //Coding history
+    std::vector<uint8_t> *smpl = &payloads[4];
+    for (uint32_t i = 0; i < 7; i++) {
+        appendUint32(*smpl, i + 1);
+    }
+    appendUint32(*smpl, 1); //dwSampleLoops
+    appendUint32(*smpl, 4); //cbSamplerData
+    for (uint32_t i = 0; i < 6; i++) {
+        appendUint32(*smpl, i * 10);
+    }
+    appendBytes(*smpl, "\x01\x02\x03\x04", 4);
+    appendUint32(payloads[5], 0x01020304);
+
+    if (!_pWavWriter->initialize(riffFilePath, SAMPLE_RATE, 2, WAV_SAMPLE_FORMAT_INT16)) {
+        fprintf(stderr, "transcodeMetadata(): Unable to initialize wavWriter.\n");
+        return false;
+    }
+    for (uint32_t i = 0; i < NUM_SUBCHUNKS; i++) {
+        if (!_pWavWriter->addSubchunk(SUBCHUNK_IDS[i], payloads[i].data(), (uint32_t) payloads[i].size())) {
+            fprintf(stderr, "transcodeMetadata(): Problem adding subchunks.\n");
+            return false;
+        }
+    }
+    if (!_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(int16Samples2Ch, NUM_SAMPLES) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "transcodeMetadata(): Problem writing file.\n");
+        return false;
+    }
+
+    //RIFF to RIFX (and int16 to float32)
+    WavReader riffReader;
+    WavWriter rifxWriter;
+    WavTranscoder toRifx;
+    if (!riffReader.initialize(riffFilePath) ||
+        !rifxWriter.initialize(rifxFilePath, SAMPLE_RATE, 2, WAV_SAMPLE_FORMAT_FLOAT32) ||
+        !rifxWriter.setBigEndian(true) ||
+        !toRifx.initialize(&riffReader, &rifxWriter) ||
+        !toRifx.transcode()) {
+        fprintf(stderr, "transcodeMetadata(): Problem transcoding to RIFX.\n");
+        return false;
+    }
+
+    //Each field reads back as written
+    WavReader rifxReader;
+    WavCuePoint cuePoints[4];
+    uint32_t numCuePoints = 0;
+    char title[16];
+    WavBroadcastExtension bextFields;
+    WavSubchunkInfo subchunkInfo;
+    if (!rifxReader.initialize(rifxFilePath) ||
+        !rifxReader.getIsBigEndian() ||
+        !rifxReader.getCuePoints(cuePoints, 4, &numCuePoints) ||
+        numCuePoints != 2 ||
+        cuePoints[0].cuePointId != 1 || cuePoints[0].frameIndex != 100 || strcmp(cuePoints[0].label, "One") ||
+        cuePoints[1].cuePointId != 2 || cuePoints[1].frameIndex != 200 || strcmp(cuePoints[1].label, "Two") ||
+        !rifxReader.getInfoText("INAM", title, sizeof(title)) ||
+        strcmp(title, "Title") ||
+        !rifxReader.getBroadcastExtension(&bextFields) ||
+        strcmp(bextFields.description, "Description") ||
+        bextFields.timeReference != timeReference ||
+        bextFields.version != version ||
+        bextFields.loudnessValue != loudnessValue ||
+        bextFields.codingHistorySize != 7 ||
+        rifxReader.findSubchunkInfo("abcd", nullptr, &subchunkInfo)) {
+        fprintf(stderr, "transcodeMetadata(): Metadata doesn't read back from RIFX as written.\n");
+        return false;
+    }
+
+    //The sampler loop count is a big-endian dword now
+    uint8_t smplData[128];
+    if (!rifxReader.findSubchunkInfo("smpl", nullptr, &subchunkInfo) ||
+        subchunkInfo.dataSize != smpl->size() ||
+        !rifxReader.readSubchunkData(&subchunkInfo, smplData) ||
+        smplData[28] != 0 || smplData[31] != 1) {
+        fprintf(stderr, "transcodeMetadata(): smpl subchunk wasn't converted to RIFX.\n");
+        return false;
+    }
+
+    //And back to RIFF: every converted payload is byte for byte what it started as
+    WavWriter backWriter;
+    WavTranscoder toRiff;
+    WavReader backReader;
+    if (!rifxReader.initialize(rifxFilePath) ||
+        !backWriter.initialize(backFilePath, SAMPLE_RATE, 2, WAV_SAMPLE_FORMAT_INT16) ||
+        !toRiff.initialize(&rifxReader, &backWriter) ||
+        !toRiff.transcode() ||
+        !backReader.initialize(backFilePath) ||
+        backReader.getIsBigEndian()) {
+        fprintf(stderr, "transcodeMetadata(): Problem transcoding back to RIFF.\n");
+        return false;
+    }
+    uint32_t numMatched = 0;
+    for (uint32_t i = 0; i < backReader.getNumSubchunks(); i++) {
+        if (!backReader.getSubchunkInfo(i, &subchunkInfo)) {
+            return false;
+        }
+        std::vector<uint8_t> subchunkData(subchunkInfo.dataSize + 1);
+        if (!backReader.readSubchunkData(&subchunkInfo, subchunkData.data())) {
+            return false;
+        }
+        for (uint32_t j = 0; j < NUM_CONVERTIBLE_SUBCHUNKS; j++) {
+            if (!memcmp(subchunkInfo.subchunkId, SUBCHUNK_IDS[j], 4) &&
+                subchunkInfo.dataSize == payloads[j].size() &&
+                !memcmp(subchunkData.data(), payloads[j].data(), payloads[j].size())) {
+                numMatched++;
+            }
+        }
+    }
+    if (numMatched != NUM_CONVERTIBLE_SUBCHUNKS) {
+        fprintf(stderr, "transcodeMetadata(): Metadata changed on the way to RIFX and back.\n");
+        return false;
+    }
+
+    return readsBack(backFilePath, WAV_SAMPLE_FORMAT_INT16, 2, int16Samples2Ch, NUM_SAMPLES, 1);
+}
+
+
+//Segments outFilePrefix0001.wav, ... hold exactly the ranges' frames of int16Samples2Ch, and
+//there's no segment after them
+bool WavWriterTester::segmentsMatch(const char *outFilePrefix,
+                                    const WavFrameRange ranges[],
+                                    uint32_t numRanges) {
+
+    char segmentFilePath[MAX_PATH_LENGTH];
+    for (uint32_t i = 0; i < numRanges; i++) {
+        sprintf(segmentFilePath, "%s%04u.wav", outFilePrefix, i + 1);
+        if (!readsBack(segmentFilePath, WAV_SAMPLE_FORMAT_INT16, 2,
+                       &int16Samples2Ch[ranges[i].startFrame * 2], ranges[i].numFrames, 0)) {
+            fprintf(stderr, "segmentsMatch(): Segment %s isn't frames %d-%d.\n", segmentFilePath,
+                    ranges[i].startFrame, ranges[i].startFrame + ranges[i].numFrames);
+            return false;
+        }
+    }
+
+    struct stat st;
+    sprintf(segmentFilePath, "%s%04u.wav", outFilePrefix, numRanges + 1);
+    if (stat(segmentFilePath, &st) == 0) {
+        fprintf(stderr, "segmentsMatch(): Unexpected extra segment %s.\n", segmentFilePath);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::splitFiles() {
+
+    static const uint32_t NUM_CUE_POINTS = 5;
+    static const char LABELS[NUM_CUE_POINTS][4] = {"B", "A", "Dup", "End", "Far"};
+
+    char srcFilePath[MAX_PATH_LENGTH];
+    char cueFilePath[MAX_PATH_LENGTH];
+    char outFilePrefix[MAX_PATH_LENGTH];
+    char manifestFilePath[MAX_PATH_LENGTH];
+    sprintf(srcFilePath, "%s/splitsrc.wav", _pOutDirPath);
+    sprintf(cueFilePath, "%s/splitcue.wav", _pOutDirPath);
+    sprintf(manifestFilePath, "%s/splitcue.json", _pOutDirPath);
+
+    if (!_pWavWriter->initialize(srcFilePath, SAMPLE_RATE, 2, WAV_SAMPLE_FORMAT_INT16) ||
+        !_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(int16Samples2Ch, NUM_SAMPLES) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "splitFiles(): Problem writing source file.\n");
+        return false;
+    }
+
+    //Cue points out of order, two at one frame, one at the end and one past it
+    const uint32_t cueFrames[NUM_CUE_POINTS] = {1000, 300, 1000, NUM_SAMPLES, NUM_SAMPLES + 1000};
+    std::vector<uint8_t> cue;
+    std::vector<uint8_t> adtl;
+    appendUint32(cue, NUM_CUE_POINTS);
+    appendBytes(adtl, "adtl", 4);
+    for (uint32_t i = 0; i < NUM_CUE_POINTS; i++) {
+        appendUint32(cue, i + 1);
+        appendUint32(cue, cueFrames[i]);
+        appendBytes(cue, "data", 4);
+        appendUint32(cue, 0);
+        appendUint32(cue, 0);
+        appendUint32(cue, cueFrames[i]);
+        appendBytes(adtl, "labl", 4);
+        appendUint32(adtl, 8);
+        appendUint32(adtl, i + 1);
+        appendBytes(adtl, LABELS[i], 4);
+    }
+    if (!_pWavWriter->initialize(cueFilePath, SAMPLE_RATE, 2, WAV_SAMPLE_FORMAT_INT16) ||
+        !_pWavWriter->addSubchunk("cue ", cue.data(), (uint32_t) cue.size()) ||
+        !_pWavWriter->addSubchunk("LIST", adtl.data(), (uint32_t) adtl.size()) ||
+        !_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(int16Samples2Ch, NUM_SAMPLES) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "splitFiles(): Problem writing file with cue points.\n");
+        return false;
+    }
+
+    //An unlabeled lead-in, then a segment per distinct cue frame before the end, the later of the
+    //two at frame 1000 labeling it
+    const WavFrameRange cueRanges[] = {{0, 300}, {300, 700}, {1000, NUM_SAMPLES - 1000}};
+    sprintf(outFilePrefix, "%s/splitcue-", _pOutDirPath);
+    if (!WavFileOps::splitAtCuePoints(cueFilePath, outFilePrefix, manifestFilePath, 2) ||
+        !segmentsMatch(outFilePrefix, cueRanges, 3)) {
+        fprintf(stderr, "splitFiles(): Split at cue points doesn't match the cue points.\n");
+        return false;
+    }
+    char manifest[2048];
+    FILE *f = fopen(manifestFilePath, "r");
+    const size_t manifestSize = f ? fread(manifest, 1, sizeof(manifest) - 1, f) : 0;
+    if (f) {
+        fclose(f);
+    }
+    manifest[manifestSize] = 0;
+    if (!strstr(manifest, "\"startFrame\": 0, \"numFrames\": 300, \"label\": \"\"") ||
+        !strstr(manifest, "\"startFrame\": 300, \"numFrames\": 700, \"label\": \"A\"") ||
+        !strstr(manifest, "\"startFrame\": 1000, \"numFrames\": 1048, \"label\": \"Dup\"")) {
+        fprintf(stderr, "splitFiles(): Cue split manifest doesn't list the segments.\n");
+        return false;
+    }
+
+    //No cue points: nothing to split at
+    sprintf(outFilePrefix, "%s/splitnocue-", _pOutDirPath);
+    if (WavFileOps::splitAtCuePoints(srcFilePath, outFilePrefix)) {
+        fprintf(stderr, "splitFiles(): Split of a file without cue points succeeded.\n");
+        return false;
+    }
+
+    //Frame ranges: the first and last frames alone, overlapping ranges and the whole file
+    const WavFrameRange ranges[] = {{0, 1}, {NUM_SAMPLES - 1, 1}, {100, 500}, {300, 500}, {0, NUM_SAMPLES}};
+    const uint32_t numRanges = sizeof(ranges) / sizeof(WavFrameRange);
+    sprintf(outFilePrefix, "%s/splitranges-", _pOutDirPath);
+    if (!WavFileOps::splitFrameRanges(srcFilePath, ranges, numRanges, outFilePrefix) ||
+        !segmentsMatch(outFilePrefix, ranges, numRanges)) {
+        fprintf(stderr, "splitFiles(): Split by frame ranges doesn't match the ranges.\n");
+        return false;
+    }
+
+    //A range one frame past the end fails the split
+    const WavFrameRange badRanges[] = {{0, 100}, {NUM_SAMPLES - 10, 11}};
+    sprintf(outFilePrefix, "%s/splitbadranges-", _pOutDirPath);
+    if (WavFileOps::splitFrameRanges(srcFilePath, badRanges, 2, outFilePrefix)) {
+        fprintf(stderr, "splitFiles(): Split with an out-of-range range succeeded.\n");
+        return false;
+    }
+
+    //Durations that divide the file evenly (no empty segment after), leave a short last segment,
+    //match it exactly or exceed it
+    const uint32_t durations[] = {512, 1000, NUM_SAMPLES, NUM_SAMPLES + 1};
+    for (uint32_t i = 0; i < sizeof(durations) / sizeof(uint32_t); i++) {
+        std::vector<WavFrameRange> expected;
+        for (uint32_t startFrame = 0; startFrame < NUM_SAMPLES; startFrame += durations[i]) {
+            expected.push_back({startFrame, std::min(durations[i], NUM_SAMPLES - startFrame)});
+        }
+        sprintf(outFilePrefix, "%s/splitduration%d-", _pOutDirPath, durations[i]);
+        if (!WavFileOps::splitFixedDuration(srcFilePath, durations[i], outFilePrefix) ||
+            !segmentsMatch(outFilePrefix, expected.data(), (uint32_t) expected.size())) {
+            fprintf(stderr, "splitFiles(): Split into %d-frame segments doesn't match.\n", durations[i]);
+            return false;
+        }
+    }
+    sprintf(outFilePrefix, "%s/splitduration0-", _pOutDirPath);
+    if (WavFileOps::splitFixedDuration(srcFilePath, 0, outFilePrefix)) {
+        fprintf(stderr, "splitFiles(): Split into empty segments succeeded.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::concatenateFiles() {
+
+    char firstFilePath[MAX_PATH_LENGTH];
+    char secondFilePath[MAX_PATH_LENGTH];
+    char outFilePath[MAX_PATH_LENGTH];
+    char aliasFilePath[MAX_PATH_LENGTH];
+    sprintf(firstFilePath, "%s/concat-1.wav", _pOutDirPath);
+    sprintf(secondFilePath, "%s/concat-2.wav", _pOutDirPath);
+    sprintf(outFilePath, "%s/concat-out.wav", _pOutDirPath);
+    sprintf(aliasFilePath, "%s/./concat-1.wav", _pOutDirPath);
+
+    const uint32_t numFirstFrames = 700;
+    if (!_pWavWriter->initialize(firstFilePath, SAMPLE_RATE, 2, WAV_SAMPLE_FORMAT_INT16) ||
+        !_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(int16Samples2Ch, numFirstFrames) ||
+        !_pWavWriter->finishWriting() ||
+        !_pWavWriter->initialize(secondFilePath, SAMPLE_RATE, 2, WAV_SAMPLE_FORMAT_INT16) ||
+        !_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(&int16Samples2Ch[numFirstFrames * 2], NUM_SAMPLES - numFirstFrames) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "concatenateFiles(): Problem writing input files.\n");
+        return false;
+    }
+
+    const char *inFilePaths[] = {firstFilePath, secondFilePath};
+    if (!WavFileOps::concatenate(inFilePaths, 2, outFilePath) ||
+        !readsBack(outFilePath, WAV_SAMPLE_FORMAT_INT16, 2, int16Samples2Ch, NUM_SAMPLES, 0)) {
+        fprintf(stderr, "concatenateFiles(): Concatenated file doesn't match its inputs.\n");
+        return false;
+    }
+
+    //Writing over an input, by the same path or another one, is refused and leaves it intact
+    if (WavFileOps::concatenate(inFilePaths, 2, firstFilePath) ||
+        WavFileOps::concatenate(inFilePaths, 2, aliasFilePath) ||
+        !readsBack(firstFilePath, WAV_SAMPLE_FORMAT_INT16, 2, int16Samples2Ch, numFirstFrames, 0)) {
+        fprintf(stderr, "concatenateFiles(): Concatenating onto an input wasn't refused.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::copyFileRanges(bool buffered) {
+
+    //Past 2 GB, so offsets that don't fit in 32 bits are exercised; both files are sparse
+    static const uint64_t SRC_OFFSET = 0x80000000ULL + 1000;
+    static const uint64_t DEST_OFFSET = 0x80000000ULL + 3000;
+    static const uint32_t NUM_BYTES = 3 * 1024 * 1024 + 17; //Several copy buffers, plus a partial one
+
+    char srcFilePath[MAX_PATH_LENGTH];
+    sprintf(srcFilePath, "%s/copyrange-src.bin", _pOutDirPath);
+    char destFilePath[MAX_PATH_LENGTH];
+    sprintf(destFilePath, "%s/copyrange-%s.bin", _pOutDirPath, buffered ? "buffered" : "kernel");
+
+    uint8_t *srcBytes = (uint8_t *) malloc(NUM_BYTES);
+    uint8_t *destBytes = (uint8_t *) malloc(NUM_BYTES);
+    FILE *srcFile = fopen(srcFilePath, "w+b");
+    FILE *destFile = fopen(destFilePath, "w+b");
+    bool ok = srcBytes && destBytes && srcFile && destFile;
+    for (uint32_t i = 0; ok && i < NUM_BYTES; i++) {
+        srcBytes[i] = (uint8_t) (i * 7 + (i >> 12));
+    }
+
+    //Buffered output at the start of the destination must be flushed before the copy lands
+    ok = ok &&
+         wavWriteAt(srcFile, SRC_OFFSET, srcBytes, NUM_BYTES) &&
+         fwrite("head", 1, 4, destFile) == 4;
+    if (ok) {
+        ok = buffered ?
+             wavCopyFileRangeBuffered(srcFile, SRC_OFFSET, destFile, DEST_OFFSET, NUM_BYTES) :
+             wavCopyFileRange(srcFile, SRC_OFFSET, destFile, DEST_OFFSET, NUM_BYTES);
+        if (!ok) {
+            fprintf(stderr, "copyFileRanges(): Problem copying range.\n");
+        }
+    }
+
+    //destFile is left just past the range, so this lands straight after it
+    char tail[4];
+    char head[4];
+    ok = ok &&
+         fwrite("tail", 1, 4, destFile) == 4 &&
+         fflush(destFile) == 0 &&
+         wavReadAt(destFile, DEST_OFFSET, destBytes, NUM_BYTES) &&
+         wavReadAt(destFile, DEST_OFFSET + NUM_BYTES, tail, 4) &&
+         wavReadAt(destFile, 0, head, 4);
+    if (ok && (memcmp(destBytes, srcBytes, NUM_BYTES) || memcmp(tail, "tail", 4) || memcmp(head, "head", 4))) {
+        fprintf(stderr, "copyFileRanges(): Copied range doesn't match.\n");
+        ok = false;
+    }
+
+    if (srcFile) {
+        fclose(srcFile);
+    }
+    if (destFile) {
+        fclose(destFile);
+    }
+    free(srcBytes);
+    free(destBytes);
+    remove(srcFilePath);
+    remove(destFilePath);
+
+    return ok;
+}
+
+
+bool WavWriterTester::extractRegions(uint32_t numChannels) {
+
+    static const uint32_t NUM_BATCH_REGIONS = 5;
+
+    char srcFilePath[MAX_PATH_LENGTH];
+    sprintf(srcFilePath, "%s/extractsrc-%dch.wav", _pOutDirPath, numChannels);
+
+    int16_t *pInt16Samples = (numChannels == 1) ? int16Samples1Ch : int16Samples2Ch;
+
+    if (!_pWavWriter->initialize(srcFilePath,
+                               SAMPLE_RATE,
+                               numChannels,
+                               true,
+                               2) ||
+        !_pWavWriter->startWriting() ||
+        !_pWavWriter->writeDataFromInt16s(pInt16Samples, NUM_SAMPLES) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "extractRegions(): Problem writing source file.\n");
+        return false;
+    }
+
+    //Single extracts: the first frame, the last frame, a middle region and the whole file
+    const WavFrameRange ranges[] = {{0, 1}, {NUM_SAMPLES - 1, 1}, {100, 500}, {0, NUM_SAMPLES}};
+    char outFilePath[MAX_PATH_LENGTH];
+    for (uint32_t i = 0; i < sizeof(ranges) / sizeof(WavFrameRange); i++) {
+        sprintf(outFilePath, "%s/extract-%dch-%d.wav", _pOutDirPath, numChannels, i);
+        if (!WavFileOps::extract(srcFilePath, outFilePath, ranges[i].startFrame, ranges[i].numFrames) ||
+            !readsBack(outFilePath,
+                       WAV_SAMPLE_FORMAT_INT16,
+                       numChannels,
+                       &pInt16Samples[ranges[i].startFrame * numChannels],
+                       ranges[i].numFrames,
+                       0)) {
+            fprintf(stderr, "extractRegions(): Extract of frames %d-%d doesn't match the source.\n",
+                    ranges[i].startFrame, ranges[i].startFrame + ranges[i].numFrames);
+            return false;
+        }
+    }
+
+    //One frame past the end is refused
+    sprintf(outFilePath, "%s/extract-%dch-outofrange.wav", _pOutDirPath, numChannels);
+    if (WavFileOps::extract(srcFilePath, outFilePath, NUM_SAMPLES - 10, 11)) {
+        fprintf(stderr, "extractRegions(): Out-of-range extract succeeded.\n");
+        return false;
+    }
+
+    //A batch reports the bad region, and still writes the rest
+    char batchFilePaths[NUM_BATCH_REGIONS][MAX_PATH_LENGTH];
+    WavExtractRegion regions[NUM_BATCH_REGIONS];
+    for (uint32_t i = 0; i < NUM_BATCH_REGIONS; i++) {
+        sprintf(batchFilePaths[i], "%s/extractbatch-%dch-%d.wav", _pOutDirPath, numChannels, i);
+        regions[i].outFilePath = batchFilePaths[i];
+        regions[i].startFrame = i * 400;
+        regions[i].numFrames = 400 + i;
+    }
+    regions[2].numFrames = NUM_SAMPLES;
+    if (WavFileOps::extractBatch(srcFilePath, regions, NUM_BATCH_REGIONS, 2)) {
+        fprintf(stderr, "extractRegions(): Batch with an out-of-range region succeeded.\n");
+        return false;
+    }
+    for (uint32_t i = 0; i < NUM_BATCH_REGIONS; i++) {
+        if (i != 2 &&
+            !readsBack(regions[i].outFilePath,
+                       WAV_SAMPLE_FORMAT_INT16,
+                       numChannels,
+                       &pInt16Samples[regions[i].startFrame * numChannels],
+                       regions[i].numFrames,
+                       0)) {
+            fprintf(stderr, "extractRegions(): Batch region %d doesn't match the source.\n", i);
+            return false;
+        }
+    }
+
+    //Extracting over the source, by the same path or another one, is refused and leaves it
+    //intact; so is a batch naming it, before any region is written, and a split whose first
+    //segment would land on it
+    char aliasFilePath[MAX_PATH_LENGTH];
+    char selfFilePath[MAX_PATH_LENGTH];
+    char selfFilePrefix[MAX_PATH_LENGTH];
+    sprintf(aliasFilePath, "%s/./extractsrc-%dch.wav", _pOutDirPath, numChannels);
+    sprintf(outFilePath, "%s/extractself-%dch-batch.wav", _pOutDirPath, numChannels);
+    sprintf(selfFilePrefix, "%s/extractself-%dch-", _pOutDirPath, numChannels);
+    sprintf(selfFilePath, "%s/extractself-%dch-0001.wav", _pOutDirPath, numChannels);
+    remove(outFilePath);
+    regions[0].outFilePath = outFilePath;
+    regions[0].numFrames = 400;
+    regions[1].outFilePath = aliasFilePath;
+    const WavFrameRange selfRanges[] = {{0, 100}};
+    if (WavFileOps::extract(srcFilePath, srcFilePath, 0, 100) ||
+        WavFileOps::extract(srcFilePath, aliasFilePath, 0, 100) ||
+        WavFileOps::extractBatch(srcFilePath, regions, 2, 1) ||
+        !readsBack(srcFilePath, WAV_SAMPLE_FORMAT_INT16, numChannels, pInt16Samples, NUM_SAMPLES, 0)) {
+        fprintf(stderr, "extractRegions(): Extracting over the source wasn't refused.\n");
+        return false;
+    }
+    FILE *f = fopen(outFilePath, "rb");
+    if (f) {
+        fclose(f);
+        fprintf(stderr, "extractRegions(): Refused batch still wrote a region.\n");
+        return false;
+    }
+    if (!WavFileOps::extract(srcFilePath, selfFilePath, 0, NUM_SAMPLES) ||
+        WavFileOps::splitFrameRanges(selfFilePath, selfRanges, 1, selfFilePrefix) ||
+        !readsBack(selfFilePath, WAV_SAMPLE_FORMAT_INT16, numChannels, pInt16Samples, NUM_SAMPLES, 0)) {
+        fprintf(stderr, "extractRegions(): Splitting onto the source wasn't refused.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::writePreallocatedFile(uint32_t expectedNumSamples) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath, "%s/prealloc-%d.wav", _pOutDirPath, expectedNumSamples);
+
+    if (!_pWavWriter->initialize(outFilePath,
+                               SAMPLE_RATE,
+                               2,
+                               true,
+                               2) ||
+        !_pWavWriter->startWriting(expectedNumSamples)) {
+        fprintf(stderr, "writePreallocatedFile(): Problem starting writing.\n");
+        return false;
+    }
+
+    //Space may or may not be reserved, depending on the filesystem; the file's size isn't changed
+    struct stat st;
+    const uint64_t numReservedBytes = (uint64_t) expectedNumSamples * 2 * 2;
+    if (stat(outFilePath, &st) != 0 || (uint64_t) st.st_size >= numReservedBytes) {
+        fprintf(stderr, "writePreallocatedFile(): Preallocation changed the file's size.\n");
+        return false;
+    }
+    const bool reserved = (uint64_t) st.st_blocks * 512 >= numReservedBytes;
+
+    if (!_pWavWriter->writeDataFromInt16s(int16Samples2Ch, NUM_SAMPLES) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writePreallocatedFile(): Problem writing data.\n");
+        return false;
+    }
+
+    //Whatever was reserved past the samples written is released again
+    WavReader wavReader;
+    if (!wavReader.initialize(outFilePath) ||
+        stat(outFilePath, &st) != 0 ||
+        (uint64_t) st.st_size != wavReader.getDataOffset() + NUM_SAMPLES * 2 * 2 ||
+        (reserved && expectedNumSamples > NUM_SAMPLES * 2 && (uint64_t) st.st_blocks * 512 >= numReservedBytes)) {
+        fprintf(stderr, "writePreallocatedFile(): File wasn't trimmed to the samples written.\n");
+        return false;
+    }
+
+    return readsBack(outFilePath, WAV_SAMPLE_FORMAT_INT16, 2, int16Samples2Ch, NUM_SAMPLES, 0);
+}
+
+
+bool WavWriterTester::writeCheckpointedFile(WavSampleFormat sampleFormat) {
+
+    static const uint32_t NUM_BLOCK_FRAMES = 100;
+    static const uint32_t CHECKPOINT_INTERVAL_FRAMES = 300;
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath, "%s/checkpoint-%s.wav", _pOutDirPath,
+            (sampleFormat == WAV_SAMPLE_FORMAT_INT16) ? "16i" : "32f");
+
+    const uint32_t frameSize = 2 * wavSampleFormatByteDepth(sampleFormat);
+    if (!_pWavWriter->initialize(outFilePath, SAMPLE_RATE, 2, sampleFormat) ||
+        !_pWavWriter->setCheckpointPolicy(0, CHECKPOINT_INTERVAL_FRAMES * frameSize, false) ||
+        !_pWavWriter->startWriting()) {
+        fprintf(stderr, "writeCheckpointedFile(): Problem starting writing.\n");
+        return false;
+    }
+
+    //Float files have a fact subchunk to keep up to date as well
+    uint32_t numFramesWritten = 0;
+    for (uint32_t i = 0; i < 5; i++) {
+        if (!_pWavWriter->writeDataFromInt16s(&int16Samples2Ch[numFramesWritten * 2], NUM_BLOCK_FRAMES)) {
+            fprintf(stderr, "writeCheckpointedFile(): Problem writing data.\n");
+            return false;
+        }
+        numFramesWritten += NUM_BLOCK_FRAMES;
+    }
+
+    //Mid-write, the file parses up to the last automatic checkpoint (at 300 of the 500 frames)
+    const int32_t tolerance = (sampleFormat == WAV_SAMPLE_FORMAT_INT16) ? 0 : 1;
+    if (!readsBack(outFilePath, sampleFormat, 2, int16Samples2Ch, CHECKPOINT_INTERVAL_FRAMES, tolerance)) {
+        fprintf(stderr, "writeCheckpointedFile(): File isn't readable to the last automatic checkpoint.\n");
+        return false;
+    }
+
+    //An explicit checkpoint brings it up to every frame written so far
+    if (!_pWavWriter->checkpoint() ||
+        !readsBack(outFilePath, sampleFormat, 2, int16Samples2Ch, numFramesWritten, tolerance)) {
+        fprintf(stderr, "writeCheckpointedFile(): File isn't readable to an explicit checkpoint.\n");
+        return false;
+    }
+
+    if (!_pWavWriter->writeDataFromInt16s(&int16Samples2Ch[numFramesWritten * 2], NUM_SAMPLES - numFramesWritten) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writeCheckpointedFile(): Problem finishing writing.\n");
+        return false;
+    }
+
+    return readsBack(outFilePath, sampleFormat, 2, int16Samples2Ch, NUM_SAMPLES, tolerance);
+}
+
+
+//Channels differ (the second is the first inverted), so a swapped or misinterleaved channel shows
+bool WavWriterTester::writePlanarFile(WavSampleFormat sampleFormat,
+                                      uint32_t numChannels) {
+
+    char outFilePath[MAX_PATH_LENGTH];
+    sprintf(outFilePath, "%s/planar-%dch-%dbit.wav", _pOutDirPath, numChannels,
+            wavSampleFormatByteDepth(sampleFormat) * 8);
+
+    std::vector<float> planarSamples[MAX_NUM_CHANNELS];
+    std::vector<float> readSamples[MAX_NUM_CHANNELS];
+    const float *channels[MAX_NUM_CHANNELS];
+    float *readChannels[MAX_NUM_CHANNELS];
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        planarSamples[ch].resize(NUM_SAMPLES);
+        readSamples[ch].resize(NUM_SAMPLES);
+        for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+            planarSamples[ch][i] = (ch == 0) ? float32Samples1Ch[i] : -float32Samples1Ch[i];
+        }
+        channels[ch] = planarSamples[ch].data();
+        readChannels[ch] = readSamples[ch].data();
+    }
+
+    //Written and read in two uneven calls
+    const uint32_t numFirstFrames = NUM_SAMPLES / 3;
+    const float *secondChannels[MAX_NUM_CHANNELS];
+    float *secondReadChannels[MAX_NUM_CHANNELS];
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        secondChannels[ch] = channels[ch] + numFirstFrames;
+        secondReadChannels[ch] = readChannels[ch] + numFirstFrames;
+    }
+    if (!_pWavWriter->initialize(outFilePath, SAMPLE_RATE, numChannels, sampleFormat) ||
+        !_pWavWriter->startWriting() ||
+        !_pWavWriter->writeFramesPlanar(channels, numFirstFrames) ||
+        !_pWavWriter->writeFramesPlanar(secondChannels, NUM_SAMPLES - numFirstFrames) ||
+        !_pWavWriter->finishWriting()) {
+        fprintf(stderr, "writePlanarFile(): Problem writing %s.\n", outFilePath);
+        return false;
+    }
+
+    WavReader wavReader;
+    std::vector<int16_t> int16Samples(NUM_SAMPLES * numChannels);
+    if (!wavReader.initialize(outFilePath) ||
+        wavReader.getSampleFormat() != sampleFormat ||
+        wavReader.getNumChannels() != numChannels ||
+        wavReader.getNumSamples() != NUM_SAMPLES ||
+        !wavReader.prepareToRead() ||
+        !wavReader.readFramesPlanar(readChannels, numFirstFrames) ||
+        !wavReader.readFramesPlanar(secondReadChannels, NUM_SAMPLES - numFirstFrames) ||
+        !wavReader.prepareToRead() ||
+        !wavReader.readDataToInt16s(int16Samples.data(), NUM_SAMPLES) ||
+        !wavReader.finishReading()) {
+        fprintf(stderr, "writePlanarFile(): Problem reading %s.\n", outFilePath);
+        return false;
+    }
+
+    //Exact for floats; within rounding (plus saturation at +1.0) for ints
+    const double tolerance = (sampleFormat == WAV_SAMPLE_FORMAT_FLOAT32) ? 0.0 :
+                             1.5 / (double) (1 << (wavSampleFormatByteDepth(sampleFormat) * 8 - 1));
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+            if (fabs(readSamples[ch][i] - planarSamples[ch][i]) > tolerance ||
+                fabs(int16Samples[i * numChannels + ch] - planarSamples[ch][i] * 32767.0) > 2.0) {
+                fprintf(stderr, "writePlanarFile(): Frame %d, channel %d of %s doesn't match.\n", i, ch + 1, outFilePath);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool WavWriterTester::readsBack(const char *filePath,
+                                WavSampleFormat sampleFormat,
+                                uint32_t numChannels,
+                                const int16_t expectedSamples[],
+                                uint32_t numFrames,
+                                int32_t tolerance,
+                                uint32_t firstComparedFrame) {
+
+    WavReader wavReader;
+    if (!wavReader.initialize(filePath)) {
+        fprintf(stderr, "readsBack(): Unable to read %s.\n", filePath);
+        return false;
+    }
+
+    if (wavReader.getSampleFormat() != sampleFormat ||
+        wavReader.getNumChannels() != numChannels ||
+        wavReader.getSampleRate() != SAMPLE_RATE ||
+        wavReader.getNumSamples() != numFrames) {
+        fprintf(stderr, "readsBack(): Format or length of %s doesn't match what was written.\n", filePath);
+        return false;
+    }
+
+    const uint32_t numValues = numFrames * numChannels;
+    int16_t *int16Samples = (int16_t *) malloc((numValues + 1) * sizeof(int16_t));
+    if (!int16Samples ||
+        !wavReader.prepareToRead() ||
+        !wavReader.readDataToInt16s(int16Samples, numFrames) ||
+        !wavReader.finishReading()) {
+        fprintf(stderr, "readsBack(): Problem reading samples of %s.\n", filePath);
+        free(int16Samples);
+        return false;
+    }
+
+    uint32_t i = firstComparedFrame * numChannels;
+    while (i < numValues && abs(int16Samples[i] - expectedSamples[i]) <= tolerance) {
+        i++;
+    }
+    free(int16Samples);
+    if (i < numValues) {
+        fprintf(stderr, "readsBack(): Sample %d of %s is off by more than %d.\n", i, filePath, tolerance);
+        return false;
+    }
+
     return true;
 }
 
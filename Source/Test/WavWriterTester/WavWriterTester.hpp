@@ -8,6 +8,7 @@
 
 #include "WavHeader.hpp" // Verifies that float and double correspond to f32 and f64 values
 #include "WavWriter.hpp"
+#include "WavFileOps.hpp" //WavFrameRange
 
 
 typedef struct {
@@ -37,7 +38,49 @@ private:
 
     bool writeFileIncrementally(const OutFileParamSetDef *ofps);
 
-    bool writeFileFromInt16s(uint32_t numChannels);
+    bool writeFileFromInt16s(const OutFileParamSetDef *ofps);
+
+    bool writeFileFromFloats(const OutFileParamSetDef *ofps);
+
+    bool writeCompandedFile(WavSampleFormat sampleFormat,
+                            uint32_t numChannels);
+
+    bool writeImaAdpcmFile(uint32_t numChannels);
+
+    bool writeBigEndianFile(const OutFileParamSetDef *ofps);
+
+    bool writeFileWithMetadata(uint32_t numChannels);
+
+    bool transcodeMetadata();
+
+    bool splitFiles();
+
+    bool concatenateFiles();
+
+    bool segmentsMatch(const char *outFilePrefix,
+                       const WavFrameRange ranges[],
+                       uint32_t numRanges);
+
+    bool copyFileRanges(bool buffered);
+
+    bool extractRegions(uint32_t numChannels);
+
+    bool writePreallocatedFile(uint32_t expectedNumSamples);
+
+    bool writeCheckpointedFile(WavSampleFormat sampleFormat);
+
+    bool writePlanarFile(WavSampleFormat sampleFormat,
+                         uint32_t numChannels);
+
+    //Re-open filePath and check its sample format, channel count and frame count, and that its
+    //samples, read as int16s, are each within tolerance of expectedSamples (channels interleaved)
+    bool readsBack(const char *filePath,
+                   WavSampleFormat sampleFormat,
+                   uint32_t numChannels,
+                   const int16_t expectedSamples[],
+                   uint32_t numFrames,
+                   int32_t tolerance,
+                   uint32_t firstComparedFrame = 0); //Earlier frames are only counted, e.g. while a codec settles
 
     //Writes samples to an array as held in wav-format data section
     bool setSampleData(uint32_t numChannels, uint32_t byteDepth, bool samplesAreInts);
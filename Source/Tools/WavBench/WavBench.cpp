@@ -0,0 +1,568 @@
+//WavBench.cpp
+//
+//Microbenchmarks for the WavReader/WavWriter read, write and conversion paths.
+//Covers all 12 format/channel combinations of the reference set, at three sizes:
+//  small:  1024 frames (per-call overhead dominates)
+//  cache:  256KB of sample data (fits in L2)
+//  large:  2GB of sample data (disk/page-cache bound; only with --large)
+//Results are written as JSON. With --perf (Linux), cycles, instructions and cache misses
+//per frame are read from perf_event_open() hardware counters.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "WavReader.hpp"
+#include "WavWriter.hpp"
+
+
+static const uint32_t SAMPLE_RATE = 44100;
+static const uint32_t IO_BLOCK_SIZE = 1024 * 1024; //Bytes per readData/writeData call for multi-block sizes
+static const double MIN_SECONDS_PER_CASE = 0.25;
+static const uint32_t MAX_ITERATIONS_PER_CASE = 100000;
+
+
+typedef struct {
+    const char *name;
+    bool samplesAreInts;
+    uint32_t byteDepth;
+} FormatDef;
+
+static const FormatDef FORMATS[] = {
+        {"uint8",   true,  1},
+        {"int16",   true,  2},
+        {"int24",   true,  3},
+        {"int32",   true,  4},
+        {"float32", false, 4},
+        {"float64", false, 8}
+};
+static const uint32_t NUM_FORMATS = sizeof(FORMATS) / sizeof(FormatDef);
+
+
+typedef struct {
+    const char *name;
+    uint64_t numFrames;      //Fixed frame count, or 0 to use numDataBytes
+    uint64_t numDataBytes;
+} SizeDef;
+
+static const SizeDef SIZES[] = {
+        {"small", 1024, 0},
+        {"cache", 0,    256 * 1024},
+        {"large", 0,    2048ULL * 1024 * 1024}
+};
+static const uint32_t NUM_SIZES = sizeof(SIZES) / sizeof(SizeDef);
+
+
+typedef struct {
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t cacheMisses;
+    bool valid;
+} PerfSample;
+
+
+//Optional hardware counters; a no-op wherever perf_event_open() isn't available or permitted
+class PerfCounters {
+
+public:
+
+    PerfCounters() {
+        _groupFd = -1;
+        for (int i = 0; i < NUM_COUNTERS; i++) {
+            _fds[i] = -1;
+        }
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int i = 0; i < NUM_COUNTERS; i++) {
+            if (_fds[i] >= 0) {
+                close(_fds[i]);
+            }
+        }
+#endif
+    }
+
+    bool open() {
+#if defined(__linux__)
+        const uint64_t configs[NUM_COUNTERS] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES
+        };
+        for (int i = 0; i < NUM_COUNTERS; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = (i == 0);
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            _fds[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, _groupFd, 0);
+            if (_fds[i] < 0) {
+                fprintf(stderr, "Warning: perf_event_open() unavailable; hardware counters disabled.\n");
+                return false;
+            }
+            if (i == 0) {
+                _groupFd = _fds[0];
+            }
+        }
+        return true;
+#else
+        fprintf(stderr, "Warning: Hardware counters are only supported on Linux.\n");
+        return false;
+#endif
+    }
+
+    void start() {
+#if defined(__linux__)
+        if (_groupFd >= 0) {
+            ioctl(_groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    PerfSample stop() {
+        PerfSample sample;
+        memset(&sample, 0, sizeof(sample));
+#if defined(__linux__)
+        if (_groupFd >= 0) {
+            ioctl(_groupFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            uint64_t values[1 + NUM_COUNTERS];
+            if (read(_groupFd, values, sizeof(values)) == (ssize_t) sizeof(values)) {
+                sample.cycles = values[1];
+                sample.instructions = values[2];
+                sample.cacheMisses = values[3];
+                sample.valid = true;
+            }
+        }
+#endif
+        return sample;
+    }
+
+private:
+
+    static const int NUM_COUNTERS = 3;
+    int _groupFd;
+    int _fds[NUM_COUNTERS];
+};
+
+
+typedef struct {
+    std::string caseName;
+    const FormatDef *format;
+    uint32_t numChannels;
+    const SizeDef *size;
+    uint64_t numFrames;
+    uint64_t numBytes;
+    uint32_t iterations;
+    double bestSeconds;
+    double meanSeconds;
+    PerfSample perf; //Totals over all iterations
+} BenchResult;
+
+
+typedef struct {
+    const char *workDir;
+    bool includeLarge;
+    bool usePerf;
+    const char *caseFilter;
+    const char *outPath;
+} BenchOptions;
+
+
+//One benchmark case. run() returns false on error; setUp/tearDown aren't timed.
+class BenchCase {
+
+public:
+
+    virtual ~BenchCase() {}
+
+    virtual const char *getName() = 0;
+
+    virtual bool setUp() { return true; }
+
+    virtual bool run() = 0;
+
+    virtual void tearDown() {}
+};
+
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//Shared state for the cases of one format/channels/size combination
+typedef struct {
+    const FormatDef *format;
+    uint32_t numChannels;
+    uint64_t numFrames;
+    uint32_t frameSize;
+    char readFilePath[2048];
+    char writeFilePath[2048];
+    uint8_t *pSampleData;    //One IO block of wav-format bytes
+    int16_t *pInt16Samples;  //One IO block worth of int16 frames
+    uint32_t blockNumFrames;
+} BenchContext;
+
+
+static bool writeSourceFile(BenchContext *ctx) {
+
+    WavWriter ww;
+    if (!ww.initialize(ctx->readFilePath, SAMPLE_RATE, ctx->numChannels,
+                       ctx->format->samplesAreInts, ctx->format->byteDepth) ||
+        !ww.startWriting()) {
+        return false;
+    }
+    uint64_t framesLeft = ctx->numFrames;
+    while (framesLeft > 0) {
+        uint32_t n = (framesLeft < ctx->blockNumFrames) ? (uint32_t) framesLeft : ctx->blockNumFrames;
+        if (!ww.writeData(ctx->pSampleData, n * ctx->frameSize)) {
+            return false;
+        }
+        framesLeft -= n;
+    }
+    return ww.finishWriting();
+}
+
+
+class HeaderParseCase : public BenchCase {
+public:
+    explicit HeaderParseCase(BenchContext *ctx) : _ctx(ctx) {}
+
+    const char *getName() { return "headerParse"; }
+
+    bool run() {
+        WavReader wr;
+        return wr.initialize(_ctx->readFilePath);
+    }
+
+private:
+    BenchContext *_ctx;
+};
+
+
+class ReadDataCase : public BenchCase {
+public:
+    ReadDataCase(BenchContext *ctx, bool toInt16s) : _ctx(ctx), _toInt16s(toInt16s) {}
+
+    const char *getName() { return _toInt16s ? "readDataToInt16s" : "readData"; }
+
+    bool setUp() { return _wr.initialize(_ctx->readFilePath); }
+
+    bool run() {
+        if (!_wr.prepareToRead()) {
+            return false;
+        }
+        uint64_t framesLeft = _ctx->numFrames;
+        while (framesLeft > 0) {
+            uint32_t n = (framesLeft < _ctx->blockNumFrames) ? (uint32_t) framesLeft : _ctx->blockNumFrames;
+            bool ok = _toInt16s ?
+                      _wr.readDataToInt16s(_ctx->pInt16Samples, n) :
+                      _wr.readData(_ctx->pSampleData, n * _ctx->frameSize);
+            if (!ok) {
+                return false;
+            }
+            framesLeft -= n;
+        }
+        return _wr.finishReading();
+    }
+
+private:
+    BenchContext *_ctx;
+    bool _toInt16s;
+    WavReader _wr;
+};
+
+
+class WriteDataCase : public BenchCase {
+public:
+    WriteDataCase(BenchContext *ctx, bool fromInt16s) : _ctx(ctx), _fromInt16s(fromInt16s) {}
+
+    const char *getName() { return _fromInt16s ? "writeDataFromInt16s" : "writeData"; }
+
+    bool run() {
+        WavWriter ww;
+        if (!ww.initialize(_ctx->writeFilePath, SAMPLE_RATE, _ctx->numChannels,
+                           _ctx->format->samplesAreInts, _ctx->format->byteDepth) ||
+            !ww.startWriting()) {
+            return false;
+        }
+        uint64_t framesLeft = _ctx->numFrames;
+        while (framesLeft > 0) {
+            uint32_t n = (framesLeft < _ctx->blockNumFrames) ? (uint32_t) framesLeft : _ctx->blockNumFrames;
+            bool ok = _fromInt16s ?
+                      ww.writeDataFromInt16s(_ctx->pInt16Samples, n) :
+                      ww.writeData(_ctx->pSampleData, n * _ctx->frameSize);
+            if (!ok) {
+                return false;
+            }
+            framesLeft -= n;
+        }
+        return ww.finishWriting();
+    }
+
+private:
+    BenchContext *_ctx;
+    bool _fromInt16s;
+};
+
+
+//Times finishWriting() alone; the data is written in setUp()
+class FinishWritingCase : public BenchCase {
+public:
+    explicit FinishWritingCase(BenchContext *ctx) : _ctx(ctx) {}
+
+    const char *getName() { return "finishWriting"; }
+
+    bool setUp() {
+        if (!_ww.initialize(_ctx->writeFilePath, SAMPLE_RATE, _ctx->numChannels,
+                            _ctx->format->samplesAreInts, _ctx->format->byteDepth) ||
+            !_ww.startWriting()) {
+            return false;
+        }
+        uint32_t n = (_ctx->numFrames < _ctx->blockNumFrames) ? (uint32_t) _ctx->numFrames : _ctx->blockNumFrames;
+        return _ww.writeData(_ctx->pSampleData, n * _ctx->frameSize);
+    }
+
+    bool run() { return _ww.finishWriting(); }
+
+private:
+    BenchContext *_ctx;
+    WavWriter _ww;
+};
+
+
+static bool runCase(BenchCase *bc, BenchContext *ctx, const SizeDef *size, PerfCounters *perf,
+                    std::vector<BenchResult> &results) {
+
+    BenchResult result;
+    result.caseName = bc->getName();
+    result.format = ctx->format;
+    result.numChannels = ctx->numChannels;
+    result.size = size;
+    result.numFrames = ctx->numFrames;
+    result.numBytes = ctx->numFrames * ctx->frameSize;
+    result.iterations = 0;
+    result.bestSeconds = 1e30;
+    result.meanSeconds = 0.0;
+    memset(&result.perf, 0, sizeof(PerfSample));
+
+    double totalSeconds = 0.0;
+    while (result.iterations < MAX_ITERATIONS_PER_CASE &&
+           (result.iterations < 3 || totalSeconds < MIN_SECONDS_PER_CASE)) {
+
+        if (!bc->setUp()) {
+            fprintf(stderr, "Error: Set-up failed for %s.\n", bc->getName());
+            return false;
+        }
+
+        perf->start();
+        double t0 = nowSeconds();
+        bool ok = bc->run();
+        double elapsed = nowSeconds() - t0;
+        PerfSample sample = perf->stop();
+        bc->tearDown();
+
+        if (!ok) {
+            fprintf(stderr, "Error: %s failed for %s %dch.\n", bc->getName(), ctx->format->name, ctx->numChannels);
+            return false;
+        }
+
+        totalSeconds += elapsed;
+        result.bestSeconds = (elapsed < result.bestSeconds) ? elapsed : result.bestSeconds;
+        result.iterations++;
+        if (sample.valid) {
+            result.perf.cycles += sample.cycles;
+            result.perf.instructions += sample.instructions;
+            result.perf.cacheMisses += sample.cacheMisses;
+            result.perf.valid = true;
+        }
+    }
+    result.meanSeconds = totalSeconds / result.iterations;
+    results.push_back(result);
+
+    fprintf(stderr, "  %-20s %-8s %dch %-6s %10.1f MB/s %8.2f ns/frame\n",
+            bc->getName(), ctx->format->name, ctx->numChannels, size->name,
+            (result.numBytes / result.bestSeconds) / 1e6,
+            (result.bestSeconds * 1e9) / result.numFrames);
+
+    return true;
+}
+
+
+static bool writeJson(const std::vector<BenchResult> &results, FILE *f) {
+
+    fprintf(f, "{\n  \"sampleRate\": %d,\n  \"benchmarks\": [", SAMPLE_RATE);
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"format\": \"%s\", \"channels\": %d, \"size\": \"%s\", "
+                   "\"frames\": %llu, \"bytes\": %llu, \"iterations\": %d, "
+                   "\"bestSeconds\": %.9f, \"meanSeconds\": %.9f, \"mbPerSecond\": %.3f, \"nsPerFrame\": %.4f",
+                (i == 0) ? "" : ",",
+                r.caseName.c_str(), r.format->name, r.numChannels, r.size->name,
+                (unsigned long long) r.numFrames, (unsigned long long) r.numBytes, r.iterations,
+                r.bestSeconds, r.meanSeconds,
+                (r.numBytes / r.bestSeconds) / 1e6,
+                (r.bestSeconds * 1e9) / r.numFrames);
+        if (r.perf.valid) {
+            double framesTotal = (double) r.numFrames * r.iterations;
+            fprintf(f, ", \"cyclesPerFrame\": %.4f, \"instructionsPerFrame\": %.4f, \"cacheMissesPerFrame\": %.6f",
+                    r.perf.cycles / framesTotal,
+                    r.perf.instructions / framesTotal,
+                    r.perf.cacheMisses / framesTotal);
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    return !ferror(f);
+}
+
+
+static void printUsage() {
+    printf("Usage: wav_bench [options]\n\n");
+    printf("  --dir PATH      Scratch directory for generated files (default: .)\n");
+    printf("  --out PATH      Write JSON results to PATH (default: stdout)\n");
+    printf("  --large         Include the 2GB size\n");
+    printf("  --perf          Collect hardware counters via perf_event_open() (Linux)\n");
+    printf("  --filter NAME   Only run cases whose name contains NAME\n\n");
+}
+
+
+static bool parseOptions(int argc, const char *argv[], BenchOptions *options) {
+
+    options->workDir = ".";
+    options->includeLarge = false;
+    options->usePerf = false;
+    options->caseFilter = nullptr;
+    options->outPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--dir") && i + 1 < argc) {
+            options->workDir = argv[++i];
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            options->outPath = argv[++i];
+        } else if (!strcmp(argv[i], "--large")) {
+            options->includeLarge = true;
+        } else if (!strcmp(argv[i], "--perf")) {
+            options->usePerf = true;
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            options->caseFilter = argv[++i];
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    BenchOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage();
+        return 1;
+    }
+
+    PerfCounters perf;
+    if (options.usePerf) {
+        perf.open();
+    }
+
+    std::vector<BenchResult> results;
+    BenchContext ctx;
+    ctx.pSampleData = (uint8_t *) malloc(IO_BLOCK_SIZE);
+    ctx.pInt16Samples = (int16_t *) malloc(IO_BLOCK_SIZE);
+    if (!ctx.pSampleData || !ctx.pInt16Samples) {
+        fprintf(stderr, "Error: Unable to allocate benchmark buffers.\n");
+        return 1;
+    }
+
+    //Deterministic, non-silent content: a ramp through the full byte range
+    for (uint32_t i = 0; i < IO_BLOCK_SIZE; i++) {
+        ctx.pSampleData[i] = (uint8_t) (i * 131);
+    }
+    for (uint32_t i = 0; i < IO_BLOCK_SIZE / sizeof(int16_t); i++) {
+        ctx.pInt16Samples[i] = (int16_t) (i * 257);
+    }
+
+    bool ok = true;
+    for (uint32_t s = 0; ok && s < NUM_SIZES; s++) {
+        const SizeDef *size = &SIZES[s];
+        if (!strcmp(size->name, "large") && !options.includeLarge) {
+            continue;
+        }
+
+        for (uint32_t f = 0; ok && f < NUM_FORMATS; f++) {
+            for (uint32_t numChannels = 1; ok && numChannels <= 2; numChannels++) {
+
+                ctx.format = &FORMATS[f];
+                ctx.numChannels = numChannels;
+                ctx.frameSize = numChannels * FORMATS[f].byteDepth;
+                ctx.numFrames = size->numFrames ? size->numFrames : size->numDataBytes / ctx.frameSize;
+                //int16 buffer must hold a block too; 2 bytes per value is never more than frameSize per value
+                ctx.blockNumFrames = IO_BLOCK_SIZE / (ctx.frameSize > 2 * numChannels ? ctx.frameSize : 2 * numChannels);
+                snprintf(ctx.readFilePath, sizeof(ctx.readFilePath), "%s/wav_bench_src_%s_%dch_%s.wav",
+                         options.workDir, ctx.format->name, numChannels, size->name);
+                snprintf(ctx.writeFilePath, sizeof(ctx.writeFilePath), "%s/wav_bench_dst_%s_%dch_%s.wav",
+                         options.workDir, ctx.format->name, numChannels, size->name);
+
+                if (!writeSourceFile(&ctx)) {
+                    fprintf(stderr, "Error: Unable to create source file %s.\n", ctx.readFilePath);
+                    ok = false;
+                    break;
+                }
+
+                HeaderParseCase headerParse(&ctx);
+                ReadDataCase readData(&ctx, false);
+                ReadDataCase readDataToInt16s(&ctx, true);
+                WriteDataCase writeData(&ctx, false);
+                WriteDataCase writeDataFromInt16s(&ctx, true);
+                FinishWritingCase finishWriting(&ctx);
+                BenchCase *cases[] = {
+                        &headerParse, &readData, &readDataToInt16s, &writeData, &writeDataFromInt16s, &finishWriting
+                };
+
+                for (uint32_t c = 0; ok && c < sizeof(cases) / sizeof(BenchCase *); c++) {
+                    if (options.caseFilter && !strstr(cases[c]->getName(), options.caseFilter)) {
+                        continue;
+                    }
+                    ok = runCase(cases[c], &ctx, size, &perf, results);
+                }
+
+                remove(ctx.readFilePath);
+                remove(ctx.writeFilePath);
+            }
+        }
+    }
+
+    free(ctx.pSampleData);
+    free(ctx.pInt16Samples);
+
+    FILE *out = options.outPath ? fopen(options.outPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Error: Unable to open output file %s.\n", options.outPath);
+        return 1;
+    }
+    writeJson(results, out);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,620 @@
+//WavConvert.cpp
+//
+//Batch conversion of wav files to a target sample format, sample rate and channel count.
+//
+//Work is scheduled on a work-stealing pool: each worker has its own deque, runs its newest task
+//first and, when out of work, steals the oldest task from another worker. Every input file
+//starts as one "plan" task that parses the header, writes the output header and then splits
+//the output into frame ranges of --split-frames frames, pushed back onto the planning worker's
+//deque. Idle workers steal ranges from it, so a single huge file doesn't leave one thread
+//working through the end of the batch alone.
+//
+//Each range is read and written with positional I/O straight into the (preallocated) output,
+//so ranges complete in any order. When a file's last range is done its header sizes are
+//patched from the file size (WavRepair), the same as repairing an unfinished recording.
+//
+//Rate conversion is linear interpolation, computed per output frame from exact integer source
+//positions, so output is identical for any --threads / --split-frames. Stereo to mono averages
+//the channels; mono to stereo duplicates. Same rate and channels converts formats directly.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <strings.h> //strcasecmp()
+#include <sys/stat.h>
+
+#include "WavReader.hpp"
+#include "WavWriter.hpp"
+#include "WavSampleConverter.hpp"
+#include "WavFileIo.hpp"
+#include "WavRepair.hpp"
+
+
+static const uint32_t BLOCK_NUM_FRAMES = 16384; //Output frames converted per pass within a range
+static const uint32_t MAX_BLOCK_IN_FRAMES = BLOCK_NUM_FRAMES * 8; //Source frames read per pass
+static const uint32_t MAX_NUM_CHANNELS = 2;
+static const uint32_t DEFAULT_SPLIT_FRAMES = 4 * 1024 * 1024;
+
+
+typedef struct {
+    const char *name;
+    WavSampleFormat format;
+} FormatDef;
+
+//In WavSampleFormat order
+static const FormatDef FORMATS[] = {
+        {"uint8",   WAV_SAMPLE_FORMAT_UINT8},
+        {"int16",   WAV_SAMPLE_FORMAT_INT16},
+        {"int24",   WAV_SAMPLE_FORMAT_INT24},
+        {"int32",   WAV_SAMPLE_FORMAT_INT32},
+        {"float32", WAV_SAMPLE_FORMAT_FLOAT32},
+        {"float64", WAV_SAMPLE_FORMAT_FLOAT64},
+        {"alaw",    WAV_SAMPLE_FORMAT_ALAW},
+        {"mulaw",   WAV_SAMPLE_FORMAT_MULAW}
+};
+static const uint32_t NUM_FORMATS = sizeof(FORMATS) / sizeof(FormatDef);
+
+
+typedef struct {
+    const char *outDirPath;
+    const FormatDef *format; //nullptr: keep each input's format
+    uint32_t sampleRate; //0: keep
+    uint32_t numChannels; //0: keep
+    uint32_t numThreads;
+    uint32_t splitFrames;
+    bool quiet;
+} ConvertOptions;
+
+
+//One input file; shared by its plan task and all of its range tasks
+typedef struct {
+    std::string inFilePath;
+    std::string outFilePath;
+    WavSampleFormat inFormat;
+    WavSampleFormat outFormat;
+    uint32_t inSampleRate;
+    uint32_t outSampleRate;
+    uint32_t inNumChannels;
+    uint32_t outNumChannels;
+    uint64_t inDataOffset;
+    bool inIsImaAdpcm; //Read through a WavReader, which decodes to int16
+    bool inIsBigEndian; //RIFX; samples are swapped in the read buffer before conversion
+    uint32_t inNumFrames;
+    uint32_t outNumFrames;
+    uint64_t outDataOffset;
+    FILE *outFile;
+    std::atomic<uint32_t> numRangesLeft;
+    std::atomic<bool> failed;
+    std::chrono::steady_clock::time_point start;
+} FileJob;
+
+
+typedef struct {
+    FileJob *job;
+    bool isPlan; //Else convert output frames [firstFrame, firstFrame + numFrames)
+    uint32_t firstFrame;
+    uint32_t numFrames;
+} ConvertTask;
+
+
+//Per-worker scratch, reused across tasks
+typedef struct {
+    uint8_t *pInData;
+    float *pInFloats;
+    float *pMixedFloats;
+    float *pOutFloats;
+    uint8_t *pOutData;
+} ConvertBuffers;
+
+
+typedef struct {
+    std::atomic<uint32_t> numFiles;
+    std::atomic<uint32_t> numFailed;
+    std::atomic<uint64_t> numBytesRead;
+    std::atomic<uint64_t> numBytesWritten;
+    std::atomic<uint64_t> numStolen;
+} ConvertTotals;
+
+
+class WorkStealingPool {
+
+public:
+
+    WorkStealingPool(uint32_t numWorkers) : _queues(numWorkers), _numPending(0), _numQueued(0) {
+    }
+
+    void push(uint32_t worker, const ConvertTask &task) {
+        {
+            std::lock_guard<std::mutex> lock(_queues[worker].mutex);
+            _queues[worker].tasks.push_back(task);
+            std::lock_guard<std::mutex> idleLock(_idleMutex);
+            _numPending++;
+            _numQueued++;
+        }
+        _workChanged.notify_one();
+    }
+
+    //Own deque newest-first (its data is likely still in cache); else steal oldest from others
+    bool pop(uint32_t worker, ConvertTask *task, bool *stolen) {
+        {
+            std::lock_guard<std::mutex> lock(_queues[worker].mutex);
+            if (!_queues[worker].tasks.empty()) {
+                *task = _queues[worker].tasks.back();
+                _queues[worker].tasks.pop_back();
+                *stolen = false;
+                taskTaken();
+                return true;
+            }
+        }
+        for (uint32_t i = 1; i < _queues.size(); i++) {
+            WorkerQueue *victim = &_queues[(worker + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock(victim->mutex);
+            if (!victim->tasks.empty()) {
+                *task = victim->tasks.front();
+                victim->tasks.pop_front();
+                *stolen = true;
+                taskTaken();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void taskDone() {
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(_idleMutex);
+            finished = (--_numPending == 0);
+        }
+        if (finished) {
+            _workChanged.notify_all();
+        }
+    }
+
+    //Sleep until a task is queued (true) or every task is done (false). Pending includes
+    //running tasks, which may still push more.
+    bool waitForWork() {
+        std::unique_lock<std::mutex> lock(_idleMutex);
+        _workChanged.wait(lock, [this]() { return _numQueued > 0 || _numPending == 0; });
+        return _numPending > 0;
+    }
+
+private:
+
+    typedef struct {
+        std::mutex mutex;
+        std::deque<ConvertTask> tasks;
+    } WorkerQueue;
+
+    void taskTaken() { //Call with the task's queue locked, as push() does
+        std::lock_guard<std::mutex> lock(_idleMutex);
+        _numQueued--;
+    }
+
+    std::vector<WorkerQueue> _queues;
+    std::mutex _idleMutex; //Taken after a queue's mutex, never before
+    std::condition_variable _workChanged;
+    uint64_t _numPending; //Queued or running
+    uint64_t _numQueued;
+};
+
+
+static const FormatDef *findFormat(const char *name) {
+    for (uint32_t i = 0; i < NUM_FORMATS; i++) {
+        if (!strcmp(FORMATS[i].name, name)) {
+            return &FORMATS[i];
+        }
+    }
+    return nullptr;
+}
+
+
+static const char *formatName(WavSampleFormat format) {
+    return (format < WAV_SAMPLE_FORMAT_INVALID) ? FORMATS[format].name : "invalid";
+}
+
+
+static void finishFile(FileJob *job, ConvertTotals *totals, const ConvertOptions *options) {
+
+    bool ok = !job->failed.load();
+    if (job->outFile) {
+        ok = (fclose(job->outFile) == 0) && ok;
+        job->outFile = nullptr;
+    }
+    //Data was written positionally, so the header still says zero; fill in sizes from the file size
+    ok = ok && WavRepair::repair(job->outFilePath.c_str());
+
+    const uint64_t inBytes = (uint64_t) job->inNumFrames * job->inNumChannels * wavSampleFormatByteDepth(job->inFormat);
+    const uint64_t outBytes = (uint64_t) job->outNumFrames * job->outNumChannels * wavSampleFormatByteDepth(job->outFormat);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job->start).count();
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to convert %s\n", job->inFilePath.c_str());
+        totals->numFailed++;
+    } else {
+        totals->numFiles++;
+        totals->numBytesRead += inBytes;
+        totals->numBytesWritten += outBytes;
+        if (!options->quiet) {
+            printf("%s -> %s: %u frames %s %u Hz %uch -> %s %u Hz %uch, %.3f s, %.1f MB/s\n",
+                   job->inFilePath.c_str(), job->outFilePath.c_str(), job->outNumFrames,
+                   formatName(job->inFormat), job->inSampleRate, job->inNumChannels,
+                   formatName(job->outFormat), job->outSampleRate, job->outNumChannels,
+                   seconds, seconds > 0.0 ? (inBytes / 1e6) / seconds : 0.0);
+        }
+    }
+    delete job;
+}
+
+
+//Parse the input, write the output header, reserve the output's space, queue its ranges
+static bool planFile(FileJob *job, const ConvertOptions *options, WorkStealingPool *pool, uint32_t worker) {
+
+    WavReader wr;
+    if (!wr.initialize(job->inFilePath.c_str())) {
+        return false;
+    }
+    job->inFormat = wr.getSampleFormat();
+    job->inSampleRate = wr.getSampleRate();
+    job->inNumChannels = wr.getNumChannels();
+    job->inDataOffset = wr.getDataOffset();
+    job->inIsImaAdpcm = wr.getAudioFormat() == AUDIO_FORMAT_IMA_ADPCM;
+    job->inIsBigEndian = wr.getIsBigEndian();
+    job->inNumFrames = wr.getNumSamples();
+    if (job->inFormat == WAV_SAMPLE_FORMAT_INVALID || job->inSampleRate == 0) {
+        return false;
+    }
+
+    //Never convert a file onto itself
+    struct stat inStat;
+    struct stat outStat;
+    if (stat(job->outFilePath.c_str(), &outStat) == 0 && stat(job->inFilePath.c_str(), &inStat) == 0 &&
+        outStat.st_dev == inStat.st_dev && outStat.st_ino == inStat.st_ino) {
+        fprintf(stderr, "Error: Output would overwrite input: %s\n", job->inFilePath.c_str());
+        return false;
+    }
+
+    job->outFormat = options->format ? options->format->format : job->inFormat;
+    const uint32_t outByteDepth = wavSampleFormatByteDepth(job->outFormat);
+    job->outSampleRate = options->sampleRate ? options->sampleRate : job->inSampleRate;
+    job->outNumChannels = options->numChannels ? options->numChannels : job->inNumChannels;
+    uint64_t outNumFrames = (uint64_t) job->inNumFrames * job->outSampleRate / job->inSampleRate;
+    if (outNumFrames * job->outNumChannels * outByteDepth > 4294967295ULL - 1024) {
+        fprintf(stderr, "Error: Converted data would exceed 4 GB: %s\n", job->inFilePath.c_str());
+        return false;
+    }
+    job->outNumFrames = (uint32_t) outNumFrames;
+
+    //Header only; the data region is filled in by the range tasks
+    WavWriter ww;
+    if (!ww.initialize(job->outFilePath.c_str(), job->outSampleRate, job->outNumChannels, job->outFormat) ||
+        !ww.startWriting() ||
+        !ww.finishWriting()) {
+        return false;
+    }
+
+    job->outFile = fopen(job->outFilePath.c_str(), "r+b");
+    uint64_t headerSize = 0;
+    if (!job->outFile || !wavGetFileSize(job->outFile, &headerSize) || headerSize == 0) {
+        return false;
+    }
+    job->outDataOffset = headerSize;
+    const uint64_t outDataSize = (uint64_t) job->outNumFrames * job->outNumChannels * outByteDepth;
+    wavPreallocateFile(job->outFile, job->outDataOffset, outDataSize); //Best effort
+    if (!wavTruncateFile(job->outFile, job->outDataOffset + outDataSize)) {
+        return false;
+    }
+
+    const uint32_t splitFrames = options->splitFrames;
+    const uint32_t numRanges = (job->outNumFrames + splitFrames - 1) / splitFrames;
+    job->numRangesLeft += numRanges; //Before any is queued, so none can finish the file early
+    for (uint32_t r = 0; r < numRanges; r++) {
+        //Last range pushed first, so the planning worker starts at the front of the file
+        ConvertTask task;
+        task.job = job;
+        task.isPlan = false;
+        task.firstFrame = (numRanges - 1 - r) * splitFrames;
+        task.numFrames = (job->outNumFrames - task.firstFrame < splitFrames) ? job->outNumFrames - task.firstFrame
+                                                                             : splitFrames;
+        pool->push(worker, task);
+    }
+
+    return true;
+}
+
+
+//decoder is set for IMA ADPCM input: it seeks to the block holding firstFrame and decodes from there
+static bool readFrames(FILE *inFile, WavReader *decoder, const FileJob *job, uint32_t firstFrame, uint32_t numFrames,
+                       uint8_t data[]) {
+    const uint32_t frameSize = job->inNumChannels * wavSampleFormatByteDepth(job->inFormat);
+    if (decoder) {
+        return decoder->seekToFrame(firstFrame) && decoder->readData(data, numFrames * frameSize);
+    }
+    if (!wavReadAt(inFile, job->inDataOffset + (uint64_t) firstFrame * frameSize, data, numFrames * frameSize)) {
+        return false;
+    }
+    return !job->inIsBigEndian ||
+           wavSwapSampleBytes(data, job->inFormat, data, numFrames * job->inNumChannels);
+}
+
+
+static bool convertRange(const ConvertTask *task, ConvertBuffers *buffers) {
+
+    FileJob *job = task->job;
+    FILE *inFile = fopen(job->inFilePath.c_str(), "rb");
+    if (!inFile) {
+        return false;
+    }
+    WavReader decoder;
+    if (job->inIsImaAdpcm && (!decoder.initialize(job->inFilePath.c_str()) || !decoder.prepareToRead())) {
+        fclose(inFile);
+        return false;
+    }
+    WavReader *pDecoder = job->inIsImaAdpcm ? &decoder : nullptr;
+
+    const uint32_t outFrameSize = job->outNumChannels * wavSampleFormatByteDepth(job->outFormat);
+    const bool sameLayout = job->inSampleRate == job->outSampleRate && job->inNumChannels == job->outNumChannels;
+
+    //Fewer output frames per pass when downsampling steeply, so the source frames still fit
+    uint64_t framesPerBlock = (uint64_t) (MAX_BLOCK_IN_FRAMES - 2) * job->outSampleRate / job->inSampleRate;
+    framesPerBlock = (framesPerBlock < 1) ? 1 : (framesPerBlock > BLOCK_NUM_FRAMES) ? BLOCK_NUM_FRAMES : framesPerBlock;
+
+    bool ok = true;
+    for (uint32_t done = 0; ok && done < task->numFrames; done += (uint32_t) framesPerBlock) {
+        const uint32_t firstFrame = task->firstFrame + done;
+        const uint32_t numFrames = (task->numFrames - done < framesPerBlock) ? task->numFrames - done
+                                                                            : (uint32_t) framesPerBlock;
+
+        if (sameLayout) {
+            ok = readFrames(inFile, pDecoder, job, firstFrame, numFrames, buffers->pInData) &&
+                 wavConvertSamples(buffers->pInData, job->inFormat, buffers->pOutData, job->outFormat,
+                                   numFrames * job->outNumChannels);
+        } else {
+            //Source frames spanned by this block's output frames, plus one for interpolation
+            const uint64_t inRate = job->inSampleRate;
+            const uint64_t outRate = job->outSampleRate;
+            const uint32_t lastInFrame = job->inNumFrames - 1;
+            const uint32_t inFirst = (uint32_t) ((uint64_t) firstFrame * inRate / outRate);
+            uint64_t inEnd = (uint64_t) (firstFrame + numFrames - 1) * inRate / outRate + 2;
+            if (inEnd > job->inNumFrames) {
+                inEnd = job->inNumFrames;
+            }
+            const uint32_t numInFrames = (uint32_t) inEnd - inFirst;
+            ok = readFrames(inFile, pDecoder, job, inFirst, numInFrames, buffers->pInData) &&
+                 wavDecodeToFloats(buffers->pInData, job->inFormat, buffers->pInFloats,
+                                   numInFrames * job->inNumChannels);
+            if (!ok) {
+                break;
+            }
+
+            //Channel layout first, on the (usually shorter) source frames
+            float *mixed = buffers->pInFloats;
+            if (job->inNumChannels == 2 && job->outNumChannels == 1) {
+                mixed = buffers->pMixedFloats;
+                for (uint32_t i = 0; i < numInFrames; i++) {
+                    mixed[i] = 0.5f * (buffers->pInFloats[2 * i] + buffers->pInFloats[2 * i + 1]);
+                }
+            } else if (job->inNumChannels == 1 && job->outNumChannels == 2) {
+                mixed = buffers->pMixedFloats;
+                for (uint32_t i = 0; i < numInFrames; i++) {
+                    mixed[2 * i] = mixed[2 * i + 1] = buffers->pInFloats[i];
+                }
+            }
+
+            const uint32_t numChannels = job->outNumChannels;
+            for (uint32_t k = 0; k < numFrames; k++) {
+                const uint64_t srcPosition = (uint64_t) (firstFrame + k) * inRate;
+                const uint32_t i0 = (uint32_t) (srcPosition / outRate);
+                const uint32_t i1 = (i0 < lastInFrame) ? i0 + 1 : lastInFrame;
+                const float frac = (float) (srcPosition % outRate) / (float) outRate;
+                const float *a = &mixed[(i0 - inFirst) * numChannels];
+                const float *b = &mixed[(i1 - inFirst) * numChannels];
+                for (uint32_t ch = 0; ch < numChannels; ch++) {
+                    buffers->pOutFloats[k * numChannels + ch] = a[ch] + frac * (b[ch] - a[ch]);
+                }
+            }
+            ok = wavConvertSamples((const uint8_t *) buffers->pOutFloats, WAV_SAMPLE_FORMAT_FLOAT32,
+                                   buffers->pOutData, job->outFormat, numFrames * numChannels);
+        }
+
+        ok = ok && wavWriteAt(job->outFile, job->outDataOffset + (uint64_t) firstFrame * outFrameSize,
+                              buffers->pOutData, numFrames * outFrameSize);
+    }
+
+    fclose(inFile);
+
+    return ok;
+}
+
+
+static void printUsage() {
+    printf("Usage: wav_convert --out DIR [options] PATH...\n\n");
+    printf("  --format F        uint8, int16, int24, int32, float32, float64, alaw or mulaw (default: keep)\n");
+    printf("  --rate HZ         Output sample rate; linear interpolation (default: keep)\n");
+    printf("  --channels N      1 or 2 (default: keep)\n");
+    printf("  --threads N       Worker threads (default: hardware concurrency)\n");
+    printf("  --split-frames N  Output frames per parallel range (default: %u)\n", DEFAULT_SPLIT_FRAMES);
+    printf("  --quiet           Aggregate throughput only\n\n");
+    printf("Each PATH is a wav file or a directory of them (not recursive).\n");
+    printf("Output files keep their input file names.\n\n");
+}
+
+
+static bool parseOptions(int argc, const char *argv[], ConvertOptions *options, std::vector<std::string> &inFilePaths) {
+
+    options->outDirPath = nullptr;
+    options->format = nullptr;
+    options->sampleRate = 0;
+    options->numChannels = 0;
+    options->numThreads = 0;
+    options->splitFrames = DEFAULT_SPLIT_FRAMES;
+    options->quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--out") && hasValue) {
+            options->outDirPath = argv[++i];
+        } else if (!strcmp(argv[i], "--format") && hasValue) {
+            options->format = findFormat(argv[++i]);
+            if (!options->format) {
+                fprintf(stderr, "Error: Unknown format: %s\n", argv[i]);
+                return false;
+            }
+        } else if (!strcmp(argv[i], "--rate") && hasValue) {
+            options->sampleRate = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--channels") && hasValue) {
+            options->numChannels = (uint32_t) atoi(argv[++i]);
+            if (options->numChannels < 1 || options->numChannels > MAX_NUM_CHANNELS) {
+                fprintf(stderr, "Error: Channels must be 1 or 2.\n");
+                return false;
+            }
+        } else if (!strcmp(argv[i], "--threads") && hasValue) {
+            options->numThreads = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--split-frames") && hasValue) {
+            options->splitFrames = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--quiet")) {
+            options->quiet = true;
+        } else if (argv[i][0] == '-') {
+            return false;
+        } else {
+            struct stat st;
+            if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+                DIR *dir = opendir(argv[i]);
+                for (struct dirent *entry = dir ? readdir(dir) : nullptr; entry; entry = readdir(dir)) {
+                    size_t nameLength = strlen(entry->d_name);
+                    if (nameLength >= 4 && strcasecmp(entry->d_name + nameLength - 4, ".wav") == 0) {
+                        inFilePaths.push_back(std::string(argv[i]) + "/" + entry->d_name);
+                    }
+                }
+                if (dir) {
+                    closedir(dir);
+                }
+            } else {
+                inFilePaths.push_back(argv[i]);
+            }
+        }
+    }
+
+    return options->outDirPath && options->splitFrames > 0 && !inFilePaths.empty();
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    ConvertOptions options;
+    std::vector<std::string> inFilePaths;
+    if (!parseOptions(argc, argv, &options, inFilePaths)) {
+        printUsage();
+        return 1;
+    }
+
+    uint32_t numThreads = options.numThreads ? options.numThreads : std::thread::hardware_concurrency();
+    if (numThreads == 0) {
+        numThreads = 1;
+    }
+
+    ConvertTotals totals;
+    totals.numFiles = 0;
+    totals.numFailed = 0;
+    totals.numBytesRead = 0;
+    totals.numBytesWritten = 0;
+    totals.numStolen = 0;
+
+    //Plans dealt round-robin; everything after that moves by stealing
+    WorkStealingPool pool(numThreads);
+    for (size_t i = 0; i < inFilePaths.size(); i++) {
+        const std::string &inFilePath = inFilePaths[i];
+        size_t slash = inFilePath.find_last_of('/');
+        FileJob *job = new FileJob();
+        job->inFilePath = inFilePath;
+        job->outFilePath = std::string(options.outDirPath) + "/" +
+                           ((slash == std::string::npos) ? inFilePath : inFilePath.substr(slash + 1));
+        job->outFile = nullptr;
+        job->failed.store(false);
+        job->numRangesLeft.store(1); //The plan task
+        ConvertTask task;
+        task.job = job;
+        task.isPlan = true;
+        task.firstFrame = 0;
+        task.numFrames = 0;
+        pool.push((uint32_t) (i % numThreads), task);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    auto worker = [&](uint32_t w) {
+        ConvertBuffers buffers;
+        const uint32_t maxInFrames = MAX_BLOCK_IN_FRAMES;
+        buffers.pInData = (uint8_t *) malloc(maxInFrames * MAX_NUM_CHANNELS * sizeof(double));
+        buffers.pInFloats = (float *) malloc(maxInFrames * MAX_NUM_CHANNELS * sizeof(float));
+        buffers.pMixedFloats = (float *) malloc(maxInFrames * MAX_NUM_CHANNELS * sizeof(float));
+        buffers.pOutFloats = (float *) malloc(BLOCK_NUM_FRAMES * MAX_NUM_CHANNELS * sizeof(float));
+        buffers.pOutData = (uint8_t *) malloc(BLOCK_NUM_FRAMES * MAX_NUM_CHANNELS * sizeof(double));
+        const bool haveBuffers = buffers.pInData && buffers.pInFloats && buffers.pMixedFloats &&
+                                 buffers.pOutFloats && buffers.pOutData;
+        if (!haveBuffers) {
+            fprintf(stderr, "Error: Unable to allocate conversion buffers.\n");
+        }
+
+        ConvertTask task;
+        bool stolen;
+        while (haveBuffers) { //Without buffers, leave the work to the others
+            if (!pool.pop(w, &task, &stolen)) {
+                if (!pool.waitForWork()) {
+                    break;
+                }
+                continue;
+            }
+            totals.numStolen += stolen ? 1 : 0;
+
+            FileJob *job = task.job;
+            bool ok;
+            if (task.isPlan) {
+                job->start = std::chrono::steady_clock::now();
+                ok = planFile(job, &options, &pool, w);
+            } else {
+                ok = convertRange(&task, &buffers);
+            }
+            if (!ok) {
+                job->failed.store(true);
+            }
+            //Whichever of the file's tasks (plan included) finishes last closes it
+            if (job->numRangesLeft.fetch_sub(1) == 1) {
+                finishFile(job, &totals, &options);
+            }
+            pool.taskDone();
+        }
+
+        free(buffers.pInData);
+        free(buffers.pInFloats);
+        free(buffers.pMixedFloats);
+        free(buffers.pOutFloats);
+        free(buffers.pOutData);
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < numThreads; t++) {
+        threads.push_back(std::thread(worker, t));
+    }
+    worker(0);
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Converted %u files in %.2f s (%.1f files/s): %.1f MB read (%.1f MB/s), %.1f MB written (%.1f MB/s), "
+           "%llu tasks stolen, %u threads; %u failed.\n",
+           totals.numFiles.load(), seconds, seconds > 0.0 ? totals.numFiles / seconds : 0.0,
+           totals.numBytesRead / 1e6, seconds > 0.0 ? (totals.numBytesRead / 1e6) / seconds : 0.0,
+           totals.numBytesWritten / 1e6, seconds > 0.0 ? (totals.numBytesWritten / 1e6) / seconds : 0.0,
+           (unsigned long long) totals.numStolen.load(), numThreads, totals.numFailed.load());
+
+    return totals.numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,569 @@
+//WavGen.cpp
+//
+//Deterministic synthetic wav corpus generator, for load and robustness testing.
+//Every file's parameters and content derive from --seed and the file's index alone, so the
+//same command line reproduces the same bytes regardless of --threads.
+//
+//Corpus sections:
+//  --encodings      One file per supported format/channel combination (12 files)
+//  --pathological   Each unusual-but-valid layout, for each format/channel combination:
+//                     list-before-fmt:   a large LIST/INFO chunk ahead of the fmt subchunk
+//                     odd-chunks:        several odd-sized chunks, each with its pad byte
+//                     data-before-fact:  the fact subchunk trails an (odd-sized, padded) data subchunk
+//  --small COUNT    COUNT short files with random rate/format/channels/duration
+//  --large COUNT    COUNT files of --large-mb each, cycling through the formats
+//
+//Canonical layouts are written with WavWriter. WavWriter always emits fmt, fact, extras, data
+//in that order, so list-before-fmt and data-before-fact are assembled from the WavHeader structs.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "WavHeader.hpp"
+#include "WavWriter.hpp"
+#include "WavSampleConverter.hpp"
+
+
+static const uint32_t BLOCK_NUM_FRAMES = 65536; //Frames generated and written per pass
+static const uint32_t MAX_NUM_CHANNELS = 2;
+static const uint32_t SMALL_SAMPLE_RATES[] = {8000, 16000, 22050, 44100, 48000, 96000};
+static const uint32_t NUM_SMALL_SAMPLE_RATES = sizeof(SMALL_SAMPLE_RATES) / sizeof(uint32_t);
+static const uint32_t LARGE_SAMPLE_RATE = 48000;
+static const uint32_t PATHOLOGICAL_NUM_FRAMES = 44101; //Odd, so uint8 mono data needs a pad byte
+
+
+typedef struct {
+    const char *name;
+    bool samplesAreInts;
+    uint32_t byteDepth;
+} FormatDef;
+
+static const FormatDef FORMATS[] = {
+        {"uint8",   true,  1},
+        {"int16",   true,  2},
+        {"int24",   true,  3},
+        {"int32",   true,  4},
+        {"float32", false, 4},
+        {"float64", false, 8}
+};
+static const uint32_t NUM_FORMATS = sizeof(FORMATS) / sizeof(FormatDef);
+
+
+typedef enum {
+    LAYOUT_CANONICAL = 0,
+    LAYOUT_LIST_BEFORE_FMT = 1,
+    LAYOUT_ODD_CHUNKS = 2,
+    LAYOUT_DATA_BEFORE_FACT = 3
+} Layout;
+
+static const char *LAYOUT_NAMES[] = {"canonical", "list-before-fmt", "odd-chunks", "data-before-fact"};
+
+
+typedef struct {
+    std::string filePath;
+    const FormatDef *format;
+    uint32_t numChannels;
+    uint32_t sampleRate;
+    uint64_t numFrames;
+    Layout layout;
+    uint64_t seed;
+} GenJob;
+
+
+typedef struct {
+    const char *outDirPath;
+    uint64_t seed;
+    uint32_t numThreads;
+    bool encodings;
+    bool pathological;
+    uint32_t numSmall;
+    uint32_t smallMaxMs;
+    uint32_t numLarge;
+    uint32_t largeMB;
+    uint32_t listKB;
+} GenOptions;
+
+
+//SplitMix64; used both to derive per-file seeds and as the per-file random source
+static uint64_t splitMix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double randomUnit(uint64_t *state) {
+    return (splitMix64(state) >> 11) * (1.0 / 9007199254740992.0); //[0, 1)
+}
+
+
+//Per-channel sine (a rotating phasor, renormalized per block) plus white noise.
+//Cheap enough per sample that generation keeps up with the disk.
+class SignalGenerator {
+
+public:
+
+    void initialize(uint64_t seed, uint32_t sampleRate, uint32_t numChannels) {
+        _state = seed;
+        _numChannels = numChannels;
+        for (uint32_t ch = 0; ch < numChannels; ch++) {
+            double freq = 50.0 + randomUnit(&_state) * 4950.0;
+            double w = 2.0 * M_PI * freq / sampleRate;
+            _rotCos[ch] = cos(w);
+            _rotSin[ch] = sin(w);
+            _phaseCos[ch] = 1.0;
+            _phaseSin[ch] = 0.0;
+            _amplitude[ch] = 0.1 + randomUnit(&_state) * 0.8;
+            _noiseAmplitude[ch] = randomUnit(&_state) * 0.05;
+        }
+        _noiseState = (uint32_t) splitMix64(&_state) | 1;
+    }
+
+    void generate(float floatSamples[], uint32_t numFrames) {
+        for (uint32_t ch = 0; ch < _numChannels; ch++) {
+            double c = _phaseCos[ch];
+            double s = _phaseSin[ch];
+            const double rc = _rotCos[ch];
+            const double rs = _rotSin[ch];
+            const float amplitude = (float) _amplitude[ch];
+            const float noiseScale = (float) (_noiseAmplitude[ch] / 2147483648.0);
+            uint32_t x = _noiseState;
+            for (uint32_t i = 0; i < numFrames; i++) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                floatSamples[i * _numChannels + ch] = amplitude * (float) s + noiseScale * (float) (int32_t) x;
+                double nc = c * rc - s * rs;
+                s = c * rs + s * rc;
+                c = nc;
+            }
+            _noiseState = x;
+            double norm = 1.0 / sqrt(c * c + s * s);
+            _phaseCos[ch] = c * norm;
+            _phaseSin[ch] = s * norm;
+        }
+    }
+
+private:
+
+    uint64_t _state;
+    uint32_t _noiseState;
+    uint32_t _numChannels;
+    double _rotCos[MAX_NUM_CHANNELS];
+    double _rotSin[MAX_NUM_CHANNELS];
+    double _phaseCos[MAX_NUM_CHANNELS];
+    double _phaseSin[MAX_NUM_CHANNELS];
+    double _amplitude[MAX_NUM_CHANNELS];
+    double _noiseAmplitude[MAX_NUM_CHANNELS];
+};
+
+
+//Per-worker scratch, reused across jobs
+typedef struct {
+    float *pFloatSamples;
+    uint8_t *pSampleData;
+    uint8_t *pChunkData;
+    uint32_t chunkDataSize;
+} GenBuffers;
+
+
+//Deterministic filler for metadata chunks
+static void fillText(uint8_t data[], uint32_t size, uint64_t seed) {
+    static const char WORDS[] = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor ";
+    uint32_t offset = (uint32_t) (seed % (sizeof(WORDS) - 1));
+    for (uint32_t i = 0; i < size; i++) {
+        data[i] = (uint8_t) WORDS[(offset + i) % (sizeof(WORDS) - 1)];
+    }
+}
+
+
+//Generate and encode the next numFrames frames into buffers->pSampleData
+static bool generateBlock(SignalGenerator *gen, const GenJob *job, GenBuffers *buffers, uint32_t numFrames) {
+
+    gen->generate(buffers->pFloatSamples, numFrames);
+    return wavConvertSamples((const uint8_t *) buffers->pFloatSamples, WAV_SAMPLE_FORMAT_FLOAT32,
+                             buffers->pSampleData,
+                             wavSampleFormat(job->format->samplesAreInts, job->format->byteDepth),
+                             numFrames * job->numChannels);
+}
+
+
+static bool writeCanonical(const GenJob *job, GenBuffers *buffers) {
+
+    WavWriter ww;
+    if (!ww.initialize(job->filePath.c_str(), job->sampleRate, job->numChannels,
+                       job->format->samplesAreInts, job->format->byteDepth)) {
+        return false;
+    }
+
+    if (job->layout == LAYOUT_ODD_CHUNKS) {
+        //Odd sizes, including a 1-byte chunk; WavWriter pads each to an even length
+        static const uint32_t ODD_SIZES[] = {1, 333, 4097};
+        const char *ids[] = {"junk", "note", "smpl"};
+        for (uint32_t i = 0; i < sizeof(ODD_SIZES) / sizeof(uint32_t); i++) {
+            fillText(buffers->pChunkData, ODD_SIZES[i], job->seed + i);
+            if (!ww.addSubchunk(ids[i], buffers->pChunkData, ODD_SIZES[i])) {
+                return false;
+            }
+        }
+    }
+
+    if (!ww.startWriting((uint32_t) job->numFrames)) {
+        return false;
+    }
+
+    SignalGenerator gen;
+    gen.initialize(job->seed, job->sampleRate, job->numChannels);
+    const uint32_t frameSize = job->numChannels * job->format->byteDepth;
+    uint64_t framesLeft = job->numFrames;
+    while (framesLeft > 0) {
+        uint32_t n = (framesLeft < BLOCK_NUM_FRAMES) ? (uint32_t) framesLeft : BLOCK_NUM_FRAMES;
+        if (!generateBlock(&gen, job, buffers, n) || !ww.writeData(buffers->pSampleData, n * frameSize)) {
+            return false;
+        }
+        framesLeft -= n;
+    }
+
+    return ww.finishWriting();
+}
+
+
+static bool writeSubchunk(FILE *f, const char id[4], const uint8_t data[], uint32_t size) {
+
+    uint8_t subchunkHeaderData[SUBCHUNK_HEADER_SIZE];
+    SubchunkHeader *sch = (SubchunkHeader *) subchunkHeaderData;
+    memcpy(sch->subchunkId, id, 4);
+    sch->subchunkSize = size;
+    const uint8_t pad = 0;
+    return fwrite(subchunkHeaderData, SUBCHUNK_HEADER_SIZE, 1, f) == 1 &&
+           (size == 0 || fwrite(data, 1, size, f) == size) &&
+           (!(size & 1) || fwrite(&pad, 1, 1, f) == 1);
+}
+
+
+//Layouts WavWriter can't produce; sizes are known up front, so the header is written once
+static bool writePathological(const GenJob *job, GenBuffers *buffers) {
+
+    const uint32_t frameSize = job->numChannels * job->format->byteDepth;
+    const uint64_t dataSize64 = job->numFrames * frameSize;
+    if (dataSize64 > 0xFFFFFFF0ULL - buffers->chunkDataSize) {
+        fprintf(stderr, "Error: Generated file would exceed the RIFF size limit.\n");
+        return false;
+    }
+    const uint32_t dataSize = (uint32_t) dataSize64;
+
+    //LIST/INFO with a single ICMT (comment) entry filling the requested size
+    uint32_t listSize = 0;
+    if (job->layout == LAYOUT_LIST_BEFORE_FMT) {
+        const uint32_t commentSize = buffers->chunkDataSize - 4 - SUBCHUNK_HEADER_SIZE;
+        uint8_t *p = buffers->pChunkData;
+        memcpy(p, "INFO", 4);
+        SubchunkHeader *icmt = (SubchunkHeader *) (p + 4);
+        memcpy(icmt->subchunkId, "ICMT", 4);
+        icmt->subchunkSize = commentSize;
+        fillText(p + 4 + SUBCHUNK_HEADER_SIZE, commentSize, job->seed);
+        p[4 + SUBCHUNK_HEADER_SIZE + commentSize - 1] = 0; //INFO strings are NUL-terminated
+        listSize = buffers->chunkDataSize;
+    }
+
+    uint8_t riffHeaderData[RIFF_HEADER_SIZE];
+    RiffHeader *rh = (RiffHeader *) riffHeaderData;
+    memcpy(rh->chunkId, "RIFF", 4);
+    memcpy(rh->formatName, "WAVE", 4);
+    rh->fileSizeLess8 = 4 +
+                        (listSize ? SUBCHUNK_HEADER_SIZE + listSize + (listSize & 1) : 0) +
+                        FORMAT_SUBCHUNK_SIZE +
+                        FACT_SUBCHUNK_SIZE +
+                        SUBCHUNK_HEADER_SIZE + dataSize + (dataSize & 1);
+
+    uint8_t formatSubchunkData[FORMAT_SUBCHUNK_SIZE];
+    FormatSubchunk *fsc = (FormatSubchunk *) formatSubchunkData;
+    memcpy(fsc->formatSubchunkId, "fmt ", 4);
+    fsc->formatSubchunkSize = 16;
+    fsc->audioFormat = job->format->samplesAreInts ? AUDIO_FORMAT_INT : AUDIO_FORMAT_FLOAT;
+    fsc->numChannels = (uint16_t) job->numChannels;
+    fsc->sampleRate = job->sampleRate;
+    fsc->byteRate = job->sampleRate * frameSize;
+    fsc->blockAlign = (uint16_t) frameSize;
+    fsc->bitsPerSample = (uint16_t) (job->format->byteDepth * 8);
+
+    //Written for int formats too; a fact subchunk is optional there, but legal
+    uint8_t factSubchunkData[FACT_SUBCHUNK_SIZE];
+    FactSubchunk *factsc = (FactSubchunk *) factSubchunkData;
+    memcpy(factsc->factSubchunkId, "fact", 4);
+    factsc->factSubchunkSize = 4;
+    factsc->numSamplesPerChannel = (uint32_t) job->numFrames;
+
+    FILE *f = fopen(job->filePath.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "Error: Unable to open output file: %s\n", job->filePath.c_str());
+        return false;
+    }
+
+    bool ok = fwrite(riffHeaderData, RIFF_HEADER_SIZE, 1, f) == 1;
+    if (ok && listSize) {
+        ok = writeSubchunk(f, "LIST", buffers->pChunkData, listSize);
+    }
+    ok = ok && fwrite(formatSubchunkData, FORMAT_SUBCHUNK_SIZE, 1, f) == 1;
+    if (ok && job->layout != LAYOUT_DATA_BEFORE_FACT) {
+        ok = fwrite(factSubchunkData, FACT_SUBCHUNK_SIZE, 1, f) == 1;
+    }
+
+    uint8_t dataSubchunkHeader[SUBCHUNK_HEADER_SIZE];
+    SubchunkHeader *dsh = (SubchunkHeader *) dataSubchunkHeader;
+    memcpy(dsh->subchunkId, "data", 4);
+    dsh->subchunkSize = dataSize;
+    ok = ok && fwrite(dataSubchunkHeader, SUBCHUNK_HEADER_SIZE, 1, f) == 1;
+
+    SignalGenerator gen;
+    gen.initialize(job->seed, job->sampleRate, job->numChannels);
+    uint64_t framesLeft = job->numFrames;
+    while (ok && framesLeft > 0) {
+        uint32_t n = (framesLeft < BLOCK_NUM_FRAMES) ? (uint32_t) framesLeft : BLOCK_NUM_FRAMES;
+        ok = generateBlock(&gen, job, buffers, n) &&
+             fwrite(buffers->pSampleData, 1, n * frameSize, f) == n * frameSize;
+        framesLeft -= n;
+    }
+    if (ok && (dataSize & 1)) {
+        const uint8_t pad = 0;
+        ok = fwrite(&pad, 1, 1, f) == 1;
+    }
+
+    if (ok && job->layout == LAYOUT_DATA_BEFORE_FACT) {
+        ok = fwrite(factSubchunkData, FACT_SUBCHUNK_SIZE, 1, f) == 1;
+    }
+
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Problem writing file: %s\n", job->filePath.c_str());
+    }
+
+    return ok;
+}
+
+
+static bool runJob(const GenJob *job, GenBuffers *buffers) {
+
+    switch (job->layout) {
+        case LAYOUT_CANONICAL:
+        case LAYOUT_ODD_CHUNKS:
+            return writeCanonical(job, buffers);
+        case LAYOUT_LIST_BEFORE_FMT:
+        case LAYOUT_DATA_BEFORE_FACT:
+            return writePathological(job, buffers);
+    }
+
+    return false;
+}
+
+
+static void addJob(std::vector<GenJob> &jobs, const GenOptions *options, const char *fileName,
+                   const FormatDef *format, uint32_t numChannels, uint32_t sampleRate, uint64_t numFrames,
+                   Layout layout) {
+
+    GenJob job;
+    job.filePath = std::string(options->outDirPath) + "/" + fileName;
+    job.format = format;
+    job.numChannels = numChannels;
+    job.sampleRate = sampleRate;
+    job.numFrames = numFrames;
+    job.layout = layout;
+    //Content depends only on the master seed and the job's position in the (deterministic) job list
+    uint64_t state = options->seed ^ (jobs.size() * 0xD1B54A32D192ED03ULL);
+    job.seed = splitMix64(&state);
+    jobs.push_back(job);
+}
+
+
+static void buildJobs(const GenOptions *options, std::vector<GenJob> &jobs) {
+
+    char fileName[256];
+
+    if (options->encodings) {
+        for (uint32_t f = 0; f < NUM_FORMATS; f++) {
+            for (uint32_t numChannels = 1; numChannels <= 2; numChannels++) {
+                snprintf(fileName, sizeof(fileName), "enc_%s_%dch.wav", FORMATS[f].name, numChannels);
+                addJob(jobs, options, fileName, &FORMATS[f], numChannels, 44100, 44100, LAYOUT_CANONICAL);
+            }
+        }
+    }
+
+    if (options->pathological) {
+        for (uint32_t l = LAYOUT_LIST_BEFORE_FMT; l <= LAYOUT_DATA_BEFORE_FACT; l++) {
+            for (uint32_t f = 0; f < NUM_FORMATS; f++) {
+                for (uint32_t numChannels = 1; numChannels <= 2; numChannels++) {
+                    snprintf(fileName, sizeof(fileName), "path_%s_%s_%dch.wav",
+                             LAYOUT_NAMES[l], FORMATS[f].name, numChannels);
+                    addJob(jobs, options, fileName, &FORMATS[f], numChannels, 44100, PATHOLOGICAL_NUM_FRAMES,
+                           (Layout) l);
+                }
+            }
+        }
+    }
+
+    //Random parameters come from one sequential stream, so they don't depend on thread scheduling
+    uint64_t state = options->seed;
+    for (uint32_t i = 0; i < options->numSmall; i++) {
+        const FormatDef *format = &FORMATS[splitMix64(&state) % NUM_FORMATS];
+        uint32_t numChannels = 1 + (uint32_t) (splitMix64(&state) & 1);
+        uint32_t sampleRate = SMALL_SAMPLE_RATES[splitMix64(&state) % NUM_SMALL_SAMPLE_RATES];
+        uint64_t durationMs = 1 + splitMix64(&state) % options->smallMaxMs;
+        snprintf(fileName, sizeof(fileName), "small_%07u.wav", i);
+        addJob(jobs, options, fileName, format, numChannels, sampleRate, 1 + durationMs * sampleRate / 1000,
+               LAYOUT_CANONICAL);
+    }
+
+    for (uint32_t i = 0; i < options->numLarge; i++) {
+        const FormatDef *format = &FORMATS[i % NUM_FORMATS];
+        uint32_t numChannels = 1 + (i / NUM_FORMATS) % 2;
+        uint64_t numFrames = ((uint64_t) options->largeMB * 1024 * 1024) / (numChannels * format->byteDepth);
+        snprintf(fileName, sizeof(fileName), "large_%04u_%s_%dch.wav", i, format->name, numChannels);
+        addJob(jobs, options, fileName, format, numChannels, LARGE_SAMPLE_RATE, numFrames, LAYOUT_CANONICAL);
+    }
+}
+
+
+static void printUsage() {
+    printf("Usage: wav_gen --out DIR [options]\n\n");
+    printf("  --seed N          Master seed (default: 1)\n");
+    printf("  --threads N       Worker threads (default: hardware concurrency)\n");
+    printf("  --encodings       One file per format/channel combination\n");
+    printf("  --pathological    Unusual chunk layouts, for every format/channel combination\n");
+    printf("  --small COUNT     COUNT short files with random parameters\n");
+    printf("  --small-max-ms MS Longest small file (default: 2000)\n");
+    printf("  --large COUNT     COUNT large files\n");
+    printf("  --large-mb MB     Sample data per large file (default: 1024, max: 4000)\n");
+    printf("  --list-kb KB      LIST chunk size for list-before-fmt (default: 1024)\n\n");
+    printf("With no corpus sections given: --encodings --pathological --small 100\n\n");
+}
+
+
+static bool parseOptions(int argc, const char *argv[], GenOptions *options) {
+
+    options->outDirPath = nullptr;
+    options->seed = 1;
+    options->numThreads = 0;
+    options->encodings = false;
+    options->pathological = false;
+    options->numSmall = 0;
+    options->smallMaxMs = 2000;
+    options->numLarge = 0;
+    options->largeMB = 1024;
+    options->listKB = 1024;
+
+    bool anySection = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--out") && hasValue) {
+            options->outDirPath = argv[++i];
+        } else if (!strcmp(argv[i], "--seed") && hasValue) {
+            options->seed = strtoull(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--threads") && hasValue) {
+            options->numThreads = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--encodings")) {
+            options->encodings = anySection = true;
+        } else if (!strcmp(argv[i], "--pathological")) {
+            options->pathological = anySection = true;
+        } else if (!strcmp(argv[i], "--small") && hasValue) {
+            options->numSmall = (uint32_t) atoi(argv[++i]);
+            anySection = true;
+        } else if (!strcmp(argv[i], "--small-max-ms") && hasValue) {
+            options->smallMaxMs = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--large") && hasValue) {
+            options->numLarge = (uint32_t) atoi(argv[++i]);
+            anySection = true;
+        } else if (!strcmp(argv[i], "--large-mb") && hasValue) {
+            options->largeMB = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--list-kb") && hasValue) {
+            options->listKB = (uint32_t) atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+
+    if (!anySection) {
+        options->encodings = true;
+        options->pathological = true;
+        options->numSmall = 100;
+    }
+
+    if (!options->outDirPath || options->smallMaxMs == 0 || options->listKB == 0 ||
+        options->largeMB == 0 || options->largeMB > 4000) {
+        return false;
+    }
+
+    return true;
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    GenOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<GenJob> jobs;
+    buildJobs(&options, jobs);
+
+    uint32_t numThreads = options.numThreads ? options.numThreads : std::thread::hardware_concurrency();
+    if (numThreads == 0 || numThreads > jobs.size()) {
+        numThreads = jobs.empty() ? 1 : (uint32_t) jobs.size();
+    }
+
+    const uint32_t chunkDataSize = options.listKB * 1024;
+    std::atomic<uint32_t> nextJob(0);
+    std::atomic<uint32_t> numFailed(0);
+    std::atomic<uint64_t> numBytes(0);
+    auto worker = [&]() {
+        GenBuffers buffers;
+        buffers.pFloatSamples = (float *) malloc(BLOCK_NUM_FRAMES * MAX_NUM_CHANNELS * sizeof(float));
+        buffers.pSampleData = (uint8_t *) malloc(BLOCK_NUM_FRAMES * MAX_NUM_CHANNELS * sizeof(double));
+        buffers.pChunkData = (uint8_t *) malloc(chunkDataSize > 4097 ? chunkDataSize : 4097);
+        buffers.chunkDataSize = chunkDataSize;
+        if (!buffers.pFloatSamples || !buffers.pSampleData || !buffers.pChunkData) {
+            fprintf(stderr, "Error: Unable to allocate generator buffers.\n");
+            numFailed++;
+        } else {
+            for (uint32_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+                if (runJob(&jobs[i], &buffers)) {
+                    numBytes += jobs[i].numFrames * jobs[i].numChannels * jobs[i].format->byteDepth;
+                } else {
+                    fprintf(stderr, "Error: Failed to generate %s (%s).\n",
+                            jobs[i].filePath.c_str(), LAYOUT_NAMES[jobs[i].layout]);
+                    numFailed++;
+                }
+            }
+        }
+        free(buffers.pFloatSamples);
+        free(buffers.pSampleData);
+        free(buffers.pChunkData);
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < numThreads; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Generated %u files, %.1f MB of sample data in %.2f s (%.1f MB/s, %u threads); %u failed.\n",
+           (uint32_t) jobs.size() - numFailed.load(), numBytes / 1e6, seconds,
+           seconds > 0.0 ? (numBytes / 1e6) / seconds : 0.0, numThreads, numFailed.load());
+
+    return numFailed == 0 ? 0 : 1;
+}
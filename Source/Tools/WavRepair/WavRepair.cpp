@@ -0,0 +1,81 @@
+//WavRepair.cpp
+//
+//Fixes the header of wav files that were never finalized (crash, power loss, killed recorder):
+//the RIFF and data (and fact) sizes are recomputed from the file size and patched in place.
+//Each PATH may be a file or a directory; directories are repaired in parallel, not recursively.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "WavRepair.hpp"
+
+
+static void printUsage() {
+    printf("Usage: wav_repair [options] PATH...\n\n");
+    printf("  --dry-run    Report what would be patched; don't write\n");
+    printf("  --threads N  Files repaired at once per directory (default: hardware concurrency)\n\n");
+}
+
+
+static bool repairFile(const char *filePath, bool dryRun) {
+
+    WavRepairResult r;
+    if (!WavRepair::repair(filePath, &r, dryRun)) {
+        return false;
+    }
+
+    if (!r.needsRepair) {
+        printf("%s: OK, %u frames\n", filePath, r.numFrames);
+    } else {
+        printf("%s: data size %u -> %u, %u frames%s\n", filePath, r.oldDataSize, r.newDataSize,
+               r.numFrames, dryRun ? " (dry run)" : "");
+    }
+
+    return true;
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    bool dryRun = false;
+    uint32_t numThreads = 0;
+    int firstPath = argc;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--dry-run")) {
+            dryRun = true;
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            numThreads = (uint32_t) atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            firstPath = i;
+            break;
+        }
+    }
+    if (firstPath == argc) {
+        printUsage();
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = firstPath; i < argc; i++) {
+        struct stat st;
+        if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+            uint32_t numRepaired = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool dirOk = WavRepair::repairDirectory(argv[i], &numRepaired, numThreads, dryRun);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf("%s: %u files %s in %.3f s%s\n", argv[i], numRepaired,
+                   dryRun ? "need repair" : "repaired", seconds, dirOk ? "" : "; some files failed");
+            ok = ok && dirOk;
+        } else {
+            ok = repairFile(argv[i], dryRun) && ok;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
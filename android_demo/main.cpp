@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include "WavReader.hpp"
+#include "WavBufferPool.hpp"
 
 int main() {
     WavReader* wr = new WavReader();
@@ -20,11 +21,18 @@ int main() {
 
 
     printf("%s : channel:%d sampleData:%d samples:%d\n", file.c_str(), wr->getNumChannels(), wr->getSampleDataSize(), wr->getNumSamples());
-    uint8_t sampleData[1024*1024] = {"\0"};
+    //Sample data goes in a heap block from the pool, not on the stack
+    WavBufferPool pool;
+    if( !pool.initialize(wr->getSampleDataSize(), 1) ) {
+        printf("buffer pool initialize failed \n");
+        return -1 ;
+    }
+    WavBufferBlock* block = pool.acquire();
 
     printf("sample data size:%d\n", wr->getSampleDataSize());
-    wr->readData(sampleData, wr->getSampleDataSize());
+    wr->readData(block, wr->getSampleDataSize());
     wr->finishReading();
+    block->release();
 
 
     return 0;